@@ -126,6 +126,8 @@ class GLCanon(Translated, ArcsToSegmentsMixin):
         self.notify = 0
         self.notify_message = ""
         self.highlight_line = None
+        # native vertex arrays of the lists above, see toolpath()
+        self.toolpaths = {}
 
     def comment(self, arg):
         if arg.startswith("AXIS,"):
@@ -164,8 +166,16 @@ class GLCanon(Translated, ArcsToSegmentsMixin):
         self.state = st
         self.lineno = self.state.sequence_number
 
+    def toolpath(self, lines, geometry):
+        # built once per list and geometry, and again if the list grew
+        key = id(lines), geometry
+        path = self.toolpaths.get(key)
+        if path is None or path.segments != len(lines):
+            path = self.toolpaths[key] = linuxcnc.toolpath(geometry, lines)
+        return path
+
     def draw_lines(self, lines, for_selection, j=0, geometry=None):
-        return linuxcnc.draw_lines(geometry or self.geometry, lines, for_selection)
+        return self.toolpath(lines, geometry or self.geometry).draw(for_selection)
 
     def colored_lines(self, color, lines, for_selection, j=0):
         if self.is_foam:
@@ -187,7 +197,11 @@ class GLCanon(Translated, ArcsToSegmentsMixin):
             self.draw_lines(lines, for_selection, j)
 
     def draw_dwells(self, dwells, alpha, for_selection, j0=0):
-        return linuxcnc.draw_dwells(self.geometry, dwells, alpha, for_selection, self.is_lathe())
+        key = id(dwells), alpha
+        marks = self.toolpaths.get(key)
+        if marks is None or marks.count != len(dwells):
+            marks = self.toolpaths[key] = linuxcnc.dwells(dwells, alpha, self.is_lathe())
+        return marks.draw(for_selection)
 
     def calc_extents(self):
         self.min_extents, self.max_extents, self.min_extents_notool, self.max_extents_notool = gcode.calc_extents(self.arcfeed, self.feed, self.traverse)
@@ -284,33 +298,18 @@ class GLCanon(Translated, ArcsToSegmentsMixin):
         glLineWidth(3)
         c = self.colors['selected']
         glColor3f(*c)
-        glBegin(GL_LINES)
-        coords = []
-        for line in self.traverse:
-            if line[0] != lineno: continue
-            linuxcnc.line9(geometry, line[1], line[2])
-            coords.append(line[1][:3])
-            coords.append(line[2][:3])
-        for line in self.arcfeed:
-            if line[0] != lineno: continue
-            linuxcnc.line9(geometry, line[1], line[2])
-            coords.append(line[1][:3])
-            coords.append(line[2][:3])
-        for line in self.feed:
-            if line[0] != lineno: continue
-            linuxcnc.line9(geometry, line[1], line[2])
-            coords.append(line[1][:3])
-            coords.append(line[2][:3])
-        glEnd()
+        n = 0
+        x = y = z = 0.0
+        for lines in self.traverse, self.arcfeed, self.feed:
+            k, sx, sy, sz = self.toolpath(lines, geometry).highlight(lineno)
+            n += k; x += sx; y += sy; z += sz
         for line in self.dwells:
             if line[0] != lineno: continue
-            self.draw_dwells([(line[0], c) + line[2:]], 2, 0)
-            coords.append(line[2:5])
+            linuxcnc.draw_dwells(self.geometry, [(line[0], c) + line[2:]], 2, 0, self.is_lathe())
+            n += 1; x += line[2]; y += line[3]; z += line[4]
         glLineWidth(1)
-        if coords:
-            x = reduce(lambda x,y:x+y, [c[0] for c in coords]) / len(coords)
-            y = reduce(lambda x,y:x+y, [c[1] for c in coords]) / len(coords)
-            z = reduce(lambda x,y:x+y, [c[2] for c in coords]) / len(coords)
+        if n:
+            x, y, z = x / n, y / n, z / n
         else:
             x = (self.min_extents[0] + self.max_extents[0])/2
             y = (self.min_extents[1] + self.max_extents[1])/2
@@ -506,8 +505,8 @@ class GlCanonDraw:
             glPushName(0)
 
             if self.get_show_rapids():
-                glCallList(self.dlist('select_rapids', gen=self.make_selection_list))
-            glCallList(self.dlist('select_norapids', gen=self.make_selection_list))
+                self.canon.draw(1, False)
+            self.canon.draw(1, True)
 
             try:
                 buffer = list(glRenderMode(GL_RENDER))
@@ -1102,9 +1101,12 @@ class GlCanonDraw:
                 glEnable(GL_BLEND)
                 glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
 
-            if self.get_show_rapids():
-                glCallList(self.dlist('program_rapids', gen=self.make_main_list))
-            glCallList(self.dlist('program_norapids', gen=self.make_main_list))
+            # drawn straight from the vertex arrays, not from a display
+            # list, so the level of detail follows the zoom
+            if self.canon:
+                if self.get_show_rapids():
+                    self.canon.draw(0, False)
+                self.canon.draw(0, True)
             glCallList(self.dlist('highlight'))
 
             if self.get_program_alpha():
@@ -1800,27 +1802,6 @@ class GlCanonDraw:
             size = [3, 3, 3]
         return mid, size
 
-    def make_selection_list(self, unused=None):
-        select_rapids = self.dlist('select_rapids')
-        select_program = self.dlist('select_norapids')
-        glNewList(select_rapids, GL_COMPILE)
-        if self.canon: self.canon.draw(1, False)
-        glEndList()
-        glNewList(select_program, GL_COMPILE)
-        if self.canon: self.canon.draw(1, True)
-        glEndList()
-
-    def make_main_list(self, unused=None):
-        program = self.dlist('program_norapids')
-        rapids = self.dlist('program_rapids')
-        glNewList(program, GL_COMPILE)
-        if self.canon: self.canon.draw(0, True)
-        glEndList()
-
-        glNewList(rapids, GL_COMPILE)
-        if self.canon: self.canon.draw(0, False)
-        glEndList()
-
     def load_preview(self, f, canon, *args):
         self.set_canon(canon)
         result, seq = gcode.parse(f, canon, *args)
@@ -1828,10 +1809,6 @@ class GlCanonDraw:
         if result <= gcode.MIN_ERROR:
             self.canon.progress.nextphase(1)
             canon.calc_extents()
-            self.stale_dlist('program_rapids')
-            self.stale_dlist('program_norapids')
-            self.stale_dlist('select_rapids')
-            self.stale_dlist('select_norapids')
 
         return result, seq
 
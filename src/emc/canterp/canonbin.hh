@@ -0,0 +1,213 @@
+/********************************************************************
+* Description: canonbin.hh
+*   Layout of a compiled canon stream: the canonical calls made while
+*   interpreting a program, written by 'rs274 -c' and replayed by
+*   canterp without parsing anything.
+*
+*   The file starts with a canonbin_header and is followed by records,
+*   each a canonbin_record, its doubles, its ints and, for the calls
+*   that take a string, a u32 length and the string with its NUL.
+*   Doubles that are zero at the end of the argument list are left out,
+*   so the unused axes of a move take no space.  Records are padded to
+*   8 bytes.  A CB_END record closes the stream;
+*   after it comes an index with one canonbin_index per run of records
+*   of the same top level source line, and a canonbin_footer at the very
+*   end of the file locates the index.
+*
+*   Values are stored in host byte order; the magic in the header and
+*   footer catches files from a machine of the other byte order.
+*
+* License: GPL Version 2
+********************************************************************/
+#ifndef CANONBIN_HH
+#define CANONBIN_HH
+
+#include <stdint.h>
+
+#define CANONBIN_MAGIC "LCNCCANB"
+#define CANONBIN_INDEX_MAGIC "LCNCCIDX"
+#define CANONBIN_VERSION 1
+
+#define CANONBIN_MAX_DOUBLES 12
+#define CANONBIN_MAX_INTS 3
+
+struct canonbin_header {
+    char magic[8];		/* CANONBIN_MAGIC */
+    uint32_t version;		/* CANONBIN_VERSION */
+    uint32_t size;		/* sizeof(canonbin_header) */
+};
+
+struct canonbin_record {
+    uint8_t op;			/* CB_* */
+    uint8_t level;		/* call level of the interpreter */
+    uint8_t ndoubles;		/* stored, the rest are zero */
+    uint8_t nints;
+    int32_t line;		/* source line of the interpreter */
+};
+
+struct canonbin_index {
+    int32_t line;		/* top level source line */
+    uint32_t pad;
+    uint64_t offset;		/* of its first record */
+};
+
+struct canonbin_footer {
+    uint64_t index_offset;
+    uint32_t index_count;
+    uint32_t pad;
+    char magic[8];		/* CANONBIN_INDEX_MAGIC */
+};
+
+enum canonbin_op {
+    CB_END,
+    CB_SYNCH,			/* the interpreter returned INTERP_EXECUTE_FINISH */
+    CB_INIT_CANON,
+    CB_SET_G5X_OFFSET,
+    CB_SET_G92_OFFSET,
+    CB_SET_XY_ROTATION,
+    CB_USE_LENGTH_UNITS,
+    CB_SELECT_PLANE,
+    CB_SET_TRAVERSE_RATE,
+    CB_STRAIGHT_TRAVERSE,
+    CB_SET_FEED_RATE,
+    CB_SET_FEED_REFERENCE,
+    CB_SET_FEED_MODE,
+    CB_SET_MOTION_CONTROL_MODE,
+    CB_SET_NAIVECAM_TOLERANCE,
+    CB_START_SPEED_FEED_SYNCH,
+    CB_STOP_SPEED_FEED_SYNCH,
+    CB_ARC_FEED,
+    CB_STRAIGHT_FEED,
+    CB_RIGID_TAP,
+    CB_DWELL,
+    CB_SET_SPINDLE_MODE,
+    CB_START_SPINDLE_CLOCKWISE,
+    CB_START_SPINDLE_COUNTERCLOCKWISE,
+    CB_SET_SPINDLE_SPEED,
+    CB_STOP_SPINDLE_TURNING,
+    CB_ORIENT_SPINDLE,
+    CB_WAIT_SPINDLE_ORIENT_COMPLETE,
+    CB_SET_TOOL_TABLE_ENTRY,
+    CB_USE_TOOL_LENGTH_OFFSET,
+    CB_CHANGE_TOOL,
+    CB_SELECT_POCKET,
+    CB_CHANGE_TOOL_NUMBER,
+    CB_COMMENT,
+    CB_MESSAGE,
+    CB_DISABLE_ADAPTIVE_FEED,
+    CB_ENABLE_ADAPTIVE_FEED,
+    CB_DISABLE_FEED_HOLD,
+    CB_ENABLE_FEED_HOLD,
+    CB_DISABLE_FEED_OVERRIDE,
+    CB_ENABLE_FEED_OVERRIDE,
+    CB_DISABLE_SPEED_OVERRIDE,
+    CB_ENABLE_SPEED_OVERRIDE,
+    CB_FLOOD_OFF,
+    CB_FLOOD_ON,
+    CB_MIST_OFF,
+    CB_MIST_ON,
+    CB_PALLET_SHUTTLE,
+    CB_TURN_PROBE_OFF,
+    CB_TURN_PROBE_ON,
+    CB_PROGRAM_STOP,
+    CB_OPTIONAL_PROGRAM_STOP,
+    CB_PROGRAM_END,
+    CB_SET_MOTION_OUTPUT_BIT,
+    CB_CLEAR_MOTION_OUTPUT_BIT,
+    CB_SET_AUX_OUTPUT_BIT,
+    CB_CLEAR_AUX_OUTPUT_BIT,
+    CB_SET_MOTION_OUTPUT_VALUE,
+    CB_SET_AUX_OUTPUT_VALUE,
+    CB_SET_FEED_LIMIT,
+    CB_NUM_OPS
+};
+
+/* Shape of each record.  'settings' marks the calls that are still
+   made when seeking to a line: everything but motion, dwells, stops and
+   messages, which is what task keeps of the lines it steps over when
+   running from a line with rs274ngc. */
+struct canonbin_op_info {
+    const char *name;
+    uint8_t ndoubles;
+    uint8_t nints;
+    uint8_t string;
+    uint8_t settings;
+};
+
+static const canonbin_op_info canonbin_ops[CB_NUM_OPS] = {
+    /* name                          d   i  s  settings */
+    { "END",                         0,  0, 0, 0 },
+    { "SYNCH",                       0,  0, 0, 0 },
+    { "INIT_CANON",                  0,  0, 0, 1 },
+    { "SET_G5X_OFFSET",              9,  1, 0, 1 },
+    { "SET_G92_OFFSET",              9,  0, 0, 1 },
+    { "SET_XY_ROTATION",             1,  0, 0, 1 },
+    { "USE_LENGTH_UNITS",            0,  1, 0, 1 },
+    { "SELECT_PLANE",                0,  1, 0, 1 },
+    { "SET_TRAVERSE_RATE",           1,  0, 0, 1 },
+    { "STRAIGHT_TRAVERSE",           9,  1, 0, 0 },
+    { "SET_FEED_RATE",               1,  0, 0, 1 },
+    { "SET_FEED_REFERENCE",          0,  1, 0, 1 },
+    { "SET_FEED_MODE",               0,  2, 0, 1 },
+    { "SET_MOTION_CONTROL_MODE",     1,  1, 0, 1 },
+    { "SET_NAIVECAM_TOLERANCE",      1,  0, 0, 1 },
+    { "START_SPEED_FEED_SYNCH",      1,  2, 0, 1 },
+    { "STOP_SPEED_FEED_SYNCH",       0,  0, 0, 1 },
+    { "ARC_FEED",                   11,  2, 0, 0 },
+    { "STRAIGHT_FEED",               9,  1, 0, 0 },
+    { "RIGID_TAP",                   4,  1, 0, 0 },
+    { "DWELL",                       1,  0, 0, 0 },
+    { "SET_SPINDLE_MODE",            1,  1, 0, 1 },
+    { "START_SPINDLE_CLOCKWISE",     0,  2, 0, 1 },
+    { "START_SPINDLE_COUNTERCLOCKWISE", 0, 2, 0, 1 },
+    { "SET_SPINDLE_SPEED",           1,  1, 0, 1 },
+    { "STOP_SPINDLE_TURNING",        0,  1, 0, 1 },
+    { "ORIENT_SPINDLE",              1,  2, 0, 1 },
+    { "WAIT_SPINDLE_ORIENT_COMPLETE", 1, 1, 0, 1 },
+    { "SET_TOOL_TABLE_ENTRY",       12,  3, 0, 1 },
+    { "USE_TOOL_LENGTH_OFFSET",      9,  0, 0, 1 },
+    { "CHANGE_TOOL",                 0,  1, 0, 1 },
+    { "SELECT_POCKET",               0,  2, 0, 1 },
+    { "CHANGE_TOOL_NUMBER",          0,  1, 0, 1 },
+    { "COMMENT",                     0,  0, 1, 0 },
+    { "MESSAGE",                     0,  0, 1, 0 },
+    { "DISABLE_ADAPTIVE_FEED",       0,  0, 0, 1 },
+    { "ENABLE_ADAPTIVE_FEED",        0,  0, 0, 1 },
+    { "DISABLE_FEED_HOLD",           0,  0, 0, 1 },
+    { "ENABLE_FEED_HOLD",            0,  0, 0, 1 },
+    { "DISABLE_FEED_OVERRIDE",       0,  0, 0, 1 },
+    { "ENABLE_FEED_OVERRIDE",        0,  0, 0, 1 },
+    { "DISABLE_SPEED_OVERRIDE",      0,  1, 0, 1 },
+    { "ENABLE_SPEED_OVERRIDE",       0,  1, 0, 1 },
+    { "FLOOD_OFF",                   0,  0, 0, 1 },
+    { "FLOOD_ON",                    0,  0, 0, 1 },
+    { "MIST_OFF",                    0,  0, 0, 1 },
+    { "MIST_ON",                     0,  0, 0, 1 },
+    { "PALLET_SHUTTLE",              0,  0, 0, 0 },
+    { "TURN_PROBE_OFF",              0,  0, 0, 1 },
+    { "TURN_PROBE_ON",               0,  0, 0, 1 },
+    { "PROGRAM_STOP",                0,  0, 0, 0 },
+    { "OPTIONAL_PROGRAM_STOP",       0,  0, 0, 0 },
+    { "PROGRAM_END",                 0,  0, 0, 0 },
+    { "SET_MOTION_OUTPUT_BIT",       0,  1, 0, 1 },
+    { "CLEAR_MOTION_OUTPUT_BIT",     0,  1, 0, 1 },
+    { "SET_AUX_OUTPUT_BIT",          0,  1, 0, 1 },
+    { "CLEAR_AUX_OUTPUT_BIT",        0,  1, 0, 1 },
+    { "SET_MOTION_OUTPUT_VALUE",     1,  1, 0, 1 },
+    { "SET_AUX_OUTPUT_VALUE",        1,  1, 0, 1 },
+    { "SET_FEED_LIMIT",              1,  0, 0, 1 },
+};
+
+/* bytes taken by a record with the given string length, padding
+   included */
+static inline uint64_t canonbin_record_size(const canonbin_record &r,
+					    uint32_t string_length)
+{
+    uint64_t size = sizeof(canonbin_record)
+	+ r.ndoubles * sizeof(double) + r.nints * sizeof(int32_t);
+    if (canonbin_ops[r.op].string)
+	size += sizeof(uint32_t) + string_length + 1;
+    return (size + 7) & ~(uint64_t) 7;
+}
+
+#endif
@@ -47,17 +47,28 @@
   which typically come out of one of Tom Kramer's interpreters.
   The first two columns are ignored, the rest is converted to
   equivalent canonical calls.
+
+  A file that starts with CANONBIN_MAGIC is a compiled canon stream
+  written by 'rs274 -c' (see canonbin.hh) instead.  It is mapped into
+  memory and each read() takes the records of one source line, so
+  line() and call_level() report what rs274ngc would have, and task can
+  run it from a line.  Lines without records are read as empty lines.
 */
 
 #include <stdio.h>		// FILE, fopen(), fclose()
 #include <string.h>		// strcpy()
 #include <ctype.h>		// isspace()
 #include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <algorithm>
 #include "config.h"
 #include "emc/nml_intf/interp_return.hh"
 #include "emc/nml_intf/canon.hh"
 #include "emc/rs274ngc/interp_base.hh"
+#include "canonbin.hh"
 
 static char the_command[LINELEN] = { 0 };	// our current command
 static char the_command_name[LINELEN] = { 0 };	// just the name part
@@ -65,7 +76,7 @@ static char the_command_args[LINELEN] = { 0 };	// just the args part
 
 class Canterp : public InterpBase {
 public:
-    Canterp () : f(0) {}
+    Canterp () : f(0), bin(0), bin_size(0) {}
     char *error_text(int errcode, char *buf, size_t buflen);
     char *stack_name(int index, char *buf, size_t buflen);
     char *line_text(char *buf, size_t buflen);
@@ -94,8 +105,24 @@ public:
     void active_settings(double active_settings[ACTIVE_SETTINGS]);
     void set_loglevel(int level);
     void set_loop_on_main_m99(bool state);
+    int seek_line(int line);
     FILE *f;
     char filename[PATH_MAX];
+
+    // compiled canon stream, if that is what was opened
+    int bin_open(int fd, const char *name);
+    void bin_close();
+    int bin_read();
+    int bin_execute();
+    int bin_call(const canonbin_record *r, bool settings_only);
+    const char *bin;
+    size_t bin_size;
+    size_t bin_end;		// offset of the CB_END record
+    const canonbin_index *bin_index;
+    uint32_t bin_index_count;
+    size_t pos;			// next record to read
+    size_t block_begin, block_end;	// records of the line read last
+    int cur_line, cur_level;
 };
 
 char *Canterp::error_text(int errcode, char *buf, size_t buflen) {
@@ -241,6 +268,7 @@ int Canterp::read(const char *line) {
 
 int Canterp::read() {
     char buf[LINELEN];
+    if(bin) return bin_read();
     if(!f) return INTERP_ERROR;
     if(!fgets(buf, sizeof(buf), f)) return INTERP_ENDFILE;
     return canterp_parse(buf);
@@ -396,6 +424,14 @@ int Canterp::execute(const char *line) {
 	return 0;
     }
 
+    if (!strcmp(the_command_name, "SET_FEED_LIMIT")) {
+	if (1 != sscanf(the_command_args, "%lf", &d1)) {
+	    return INTERP_ERROR;
+	}
+	SET_FEED_LIMIT(d1);
+	return 0;
+    }
+
 #if 0
     if (!strcmp(the_command_name, "SET_TRAVERSE_RATE")) {
 	if (1 != sscanf(the_command_args, "%lf", &d1)) {
@@ -686,14 +722,273 @@ int Canterp::execute(const char *line, int line_number) {
 }
 
 int Canterp::execute() {
+    if(bin) return bin_execute();
     return execute(0);
 }
 
 int Canterp::open(const char *newfilename) {
+    char magic[sizeof(CANONBIN_MAGIC) - 1];
     if(f) fclose(f);
-    f = fopen(newfilename, "r");
-    if(f) snprintf(filename, sizeof(filename), "%s", newfilename);
-    return f ? INTERP_OK : INTERP_ERROR;
+    f = 0;
+    bin_close();
+    int fd = ::open(newfilename, O_RDONLY);
+    if(fd < 0) return INTERP_ERROR;
+    if(pread(fd, magic, sizeof(magic), 0) == sizeof(magic)
+	    && !memcmp(magic, CANONBIN_MAGIC, sizeof(magic))) {
+	int retval = bin_open(fd, newfilename);
+	::close(fd);
+	if(retval != INTERP_OK) return retval;
+    } else {
+	f = fdopen(fd, "r");
+	if(!f) {
+	    ::close(fd);
+	    return INTERP_ERROR;
+	}
+    }
+    snprintf(filename, sizeof(filename), "%s", newfilename);
+    return INTERP_OK;
+}
+
+int Canterp::bin_open(int fd, const char *name) {
+    struct stat st;
+    canonbin_header h;
+    canonbin_footer ft;
+
+    if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(h) + sizeof(ft))
+	return INTERP_ERROR;
+    void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map == MAP_FAILED) return INTERP_ERROR;
+    madvise(map, st.st_size, MADV_WILLNEED);
+    bin = (const char *)map;
+    bin_size = st.st_size;
+
+    memcpy(&h, bin, sizeof(h));
+    memcpy(&ft, bin + bin_size - sizeof(ft), sizeof(ft));
+    if(h.version != CANONBIN_VERSION || h.size != sizeof(h)
+	    || memcmp(ft.magic, CANONBIN_INDEX_MAGIC, sizeof(ft.magic))
+	    || ft.index_offset < h.size + sizeof(canonbin_record)
+	    || ft.index_offset % 8
+	    || (bin_size - sizeof(ft) - ft.index_offset) / sizeof(canonbin_index)
+		!= ft.index_count) {
+	fprintf(stderr, "canterp: %s is not a compiled canon stream of version %d\n",
+		name, CANONBIN_VERSION);
+	bin_close();
+	return INTERP_ERROR;
+    }
+    bin_index = (const canonbin_index *)(bin + ft.index_offset);
+    bin_index_count = ft.index_count;
+
+    // check every record once, so reading never runs off the end
+    size_t p = h.size;
+    for(;;) {
+	const canonbin_record *r = (const canonbin_record *)(bin + p);
+	if(p + sizeof(*r) > ft.index_offset || r->op >= CB_NUM_OPS) break;
+	const canonbin_op_info &info = canonbin_ops[r->op];
+	if(r->ndoubles > info.ndoubles || r->nints != info.nints) break;
+	uint32_t length = 0;
+	if(info.string) {
+	    size_t at = p + sizeof(*r) + r->ndoubles * sizeof(double)
+		+ r->nints * sizeof(int32_t);
+	    if(at + sizeof(length) > ft.index_offset) break;
+	    memcpy(&length, bin + at, sizeof(length));
+	    if(length >= ft.index_offset - at - sizeof(length)
+		    || bin[at + sizeof(length) + length]) break;
+	}
+	uint64_t size = canonbin_record_size(*r, length);
+	if(p + size > ft.index_offset) break;
+	if(r->op == CB_END) {
+	    bin_end = p;
+	    pos = block_begin = block_end = h.size;
+	    cur_line = cur_level = 0;
+	    return INTERP_OK;
+	}
+	p += size;
+    }
+    fprintf(stderr, "canterp: %s: bad record at offset %zu\n", name, p);
+    bin_close();
+    return INTERP_ERROR;
+}
+
+void Canterp::bin_close() {
+    if(bin) munmap((void *)bin, bin_size);
+    bin = 0;
+    bin_size = 0;
+}
+
+static uint64_t record_size(const canonbin_record *r) {
+    uint32_t length = 0;
+    if(canonbin_ops[r->op].string)
+	memcpy(&length, (const char *)(r + 1) + r->ndoubles * sizeof(double)
+		+ r->nints * sizeof(int32_t), sizeof(length));
+    return canonbin_record_size(*r, length);
+}
+
+/* Take the records of the next source line.  Top level lines that made
+   no canon calls are returned as empty lines so that task, which counts
+   lines while running from a line, sees each of them. */
+int Canterp::bin_read() {
+    const canonbin_record *r = (const canonbin_record *)(bin + pos);
+    if(pos == bin_end) return INTERP_ENDFILE;
+    if(r->level == 0 && cur_level == 0 && r->line > cur_line + 1) {
+	cur_line++;
+	block_begin = block_end = pos;
+	return INTERP_OK;
+    }
+    cur_line = r->line;
+    cur_level = r->level;
+    block_begin = pos;
+    while(pos != bin_end && r->line == cur_line && r->level == cur_level) {
+	pos += record_size(r);
+	r = (const canonbin_record *)(bin + pos);
+    }
+    block_end = pos;
+    return INTERP_OK;
+}
+
+int Canterp::bin_execute() {
+    int retval = INTERP_OK;
+    for(size_t p = block_begin; p != block_end; ) {
+	const canonbin_record *r = (const canonbin_record *)(bin + p);
+	if(bin_call(r, false) == INTERP_EXECUTE_FINISH)
+	    retval = INTERP_EXECUTE_FINISH;
+	p += record_size(r);
+    }
+    block_begin = block_end;
+    return retval;
+}
+
+/* Make the canon call of one record.  With settings_only, calls that
+   move or stop the machine or talk to the operator are left out. */
+int Canterp::bin_call(const canonbin_record *r, bool settings_only) {
+    double d[CANONBIN_MAX_DOUBLES] = {0};
+    int32_t i[CANONBIN_MAX_INTS];
+    const char *data = (const char *)(r + 1);
+
+    if(settings_only && !canonbin_ops[r->op].settings) return INTERP_OK;
+    memcpy(d, data, r->ndoubles * sizeof(double));
+    data += r->ndoubles * sizeof(double);
+    memcpy(i, data, r->nints * sizeof(int32_t));
+    data += r->nints * sizeof(int32_t);
+    char *s = (char *)data + sizeof(uint32_t);
+
+    switch(r->op) {
+    case CB_END: break;
+    case CB_SYNCH: return INTERP_EXECUTE_FINISH;
+    case CB_INIT_CANON: INIT_CANON(); break;
+    case CB_SET_G5X_OFFSET:
+	SET_G5X_OFFSET(i[0], d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+	break;
+    case CB_SET_G92_OFFSET:
+	SET_G92_OFFSET(d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+	break;
+    case CB_SET_XY_ROTATION: SET_XY_ROTATION(d[0]); break;
+    case CB_USE_LENGTH_UNITS: USE_LENGTH_UNITS((CANON_UNITS)i[0]); break;
+    case CB_SELECT_PLANE: SELECT_PLANE((CANON_PLANE)i[0]); break;
+    case CB_SET_TRAVERSE_RATE: SET_TRAVERSE_RATE(d[0]); break;
+    case CB_STRAIGHT_TRAVERSE:
+	STRAIGHT_TRAVERSE(i[0], d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+	break;
+    case CB_SET_FEED_RATE: SET_FEED_RATE(d[0]); break;
+    case CB_SET_FEED_REFERENCE:
+	SET_FEED_REFERENCE((CANON_FEED_REFERENCE)i[0]);
+	break;
+    case CB_SET_FEED_MODE: SET_FEED_MODE(i[0], i[1]); break;
+    case CB_SET_MOTION_CONTROL_MODE:
+	SET_MOTION_CONTROL_MODE((CANON_MOTION_MODE)i[0], d[0]);
+	break;
+    case CB_SET_NAIVECAM_TOLERANCE: SET_NAIVECAM_TOLERANCE(d[0]); break;
+    case CB_START_SPEED_FEED_SYNCH: START_SPEED_FEED_SYNCH(i[0], d[0], i[1]); break;
+    case CB_STOP_SPEED_FEED_SYNCH: STOP_SPEED_FEED_SYNCH(); break;
+    case CB_ARC_FEED:
+	ARC_FEED(i[0], d[0], d[1], d[2], d[3], i[1], d[4],
+		d[5], d[6], d[7], d[8], d[9], d[10]);
+	break;
+    case CB_STRAIGHT_FEED:
+	STRAIGHT_FEED(i[0], d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8]);
+	break;
+    case CB_RIGID_TAP: RIGID_TAP(i[0], d[0], d[1], d[2], d[3]); break;
+    case CB_DWELL: DWELL(d[0]); break;
+    case CB_SET_SPINDLE_MODE: SET_SPINDLE_MODE(i[0], d[0]); break;
+    case CB_START_SPINDLE_CLOCKWISE: START_SPINDLE_CLOCKWISE(i[0], i[1]); break;
+    case CB_START_SPINDLE_COUNTERCLOCKWISE:
+	START_SPINDLE_COUNTERCLOCKWISE(i[0], i[1]);
+	break;
+    case CB_SET_SPINDLE_SPEED: SET_SPINDLE_SPEED(i[0], d[0]); break;
+    case CB_STOP_SPINDLE_TURNING: STOP_SPINDLE_TURNING(i[0]); break;
+    case CB_ORIENT_SPINDLE: ORIENT_SPINDLE(i[0], d[0], i[1]); break;
+    case CB_WAIT_SPINDLE_ORIENT_COMPLETE:
+	WAIT_SPINDLE_ORIENT_COMPLETE(i[0], d[0]);
+	break;
+    case CB_SET_TOOL_TABLE_ENTRY:
+    case CB_USE_TOOL_LENGTH_OFFSET: {
+	EmcPose offset;
+	offset.tran.x = d[0]; offset.tran.y = d[1]; offset.tran.z = d[2];
+	offset.a = d[3]; offset.b = d[4]; offset.c = d[5];
+	offset.u = d[6]; offset.v = d[7]; offset.w = d[8];
+	if(r->op == CB_USE_TOOL_LENGTH_OFFSET)
+	    USE_TOOL_LENGTH_OFFSET(offset);
+	else
+	    SET_TOOL_TABLE_ENTRY(i[0], i[1], offset, d[9], d[10], d[11], i[2]);
+	break;
+    }
+    case CB_CHANGE_TOOL: CHANGE_TOOL(i[0]); break;
+    case CB_SELECT_POCKET: SELECT_POCKET(i[0], i[1]); break;
+    case CB_CHANGE_TOOL_NUMBER: CHANGE_TOOL_NUMBER(i[0]); break;
+    case CB_COMMENT: COMMENT(s); break;
+    case CB_MESSAGE: MESSAGE(s); break;
+    case CB_DISABLE_ADAPTIVE_FEED: DISABLE_ADAPTIVE_FEED(); break;
+    case CB_ENABLE_ADAPTIVE_FEED: ENABLE_ADAPTIVE_FEED(); break;
+    case CB_DISABLE_FEED_HOLD: DISABLE_FEED_HOLD(); break;
+    case CB_ENABLE_FEED_HOLD: ENABLE_FEED_HOLD(); break;
+    case CB_DISABLE_FEED_OVERRIDE: DISABLE_FEED_OVERRIDE(); break;
+    case CB_ENABLE_FEED_OVERRIDE: ENABLE_FEED_OVERRIDE(); break;
+    case CB_DISABLE_SPEED_OVERRIDE: DISABLE_SPEED_OVERRIDE(i[0]); break;
+    case CB_ENABLE_SPEED_OVERRIDE: ENABLE_SPEED_OVERRIDE(i[0]); break;
+    case CB_FLOOD_OFF: FLOOD_OFF(); break;
+    case CB_FLOOD_ON: FLOOD_ON(); break;
+    case CB_MIST_OFF: MIST_OFF(); break;
+    case CB_MIST_ON: MIST_ON(); break;
+    case CB_PALLET_SHUTTLE: PALLET_SHUTTLE(); break;
+    case CB_TURN_PROBE_OFF: TURN_PROBE_OFF(); break;
+    case CB_TURN_PROBE_ON: TURN_PROBE_ON(); break;
+    case CB_PROGRAM_STOP: PROGRAM_STOP(); break;
+    case CB_OPTIONAL_PROGRAM_STOP: OPTIONAL_PROGRAM_STOP(); break;
+    case CB_PROGRAM_END: PROGRAM_END(); break;
+    case CB_SET_MOTION_OUTPUT_BIT: SET_MOTION_OUTPUT_BIT(i[0]); break;
+    case CB_CLEAR_MOTION_OUTPUT_BIT: CLEAR_MOTION_OUTPUT_BIT(i[0]); break;
+    case CB_SET_AUX_OUTPUT_BIT: SET_AUX_OUTPUT_BIT(i[0]); break;
+    case CB_CLEAR_AUX_OUTPUT_BIT: CLEAR_AUX_OUTPUT_BIT(i[0]); break;
+    case CB_SET_MOTION_OUTPUT_VALUE: SET_MOTION_OUTPUT_VALUE(i[0], d[0]); break;
+    case CB_SET_AUX_OUTPUT_VALUE: SET_AUX_OUTPUT_VALUE(i[0], d[0]); break;
+    case CB_SET_FEED_LIMIT: SET_FEED_LIMIT(d[0]); break;
+    }
+    return INTERP_OK;
+}
+
+/* Position the stream so that the next read() returns the line before
+   'line', as task expects when it steps up to the start line.  All the
+   records before it are skipped, except that the calls which only set
+   up the machine are still made, which leaves canon where rs274ngc
+   would have left it. */
+int Canterp::seek_line(int line) {
+    uint32_t k;
+
+    if(!bin) return INTERP_ERROR;
+    for(k = 0; k < bin_index_count; k++)
+	if(bin_index[k].line >= line - 1) break;
+    if(k == bin_index_count) return INTERP_ERROR;
+
+    size_t p = ((const canonbin_header *)bin)->size;
+    while(p < bin_index[k].offset && p < bin_end) {
+	const canonbin_record *r = (const canonbin_record *)(bin + p);
+	bin_call(r, true);
+	p += record_size(r);
+    }
+    if(p != bin_index[k].offset) return INTERP_ERROR;
+    pos = block_begin = block_end = p;
+    cur_line = line - 2;
+    cur_level = 0;
+    return INTERP_OK;
 }
 
 int Canterp::close() {
@@ -703,8 +998,8 @@ int Canterp::close() {
 int Canterp::exit() { return 0; }
 int Canterp::synch() { return 0; }
 int Canterp::reset() { return 0; }
-int Canterp::line() { return 0; }
-int Canterp::call_level() { return 0; }
+int Canterp::line() { return bin ? cur_line : 0; }
+int Canterp::call_level() { return bin ? cur_level : 0; }
 
 char *Canterp::line_text(char *buf, size_t bufsize) {
    snprintf(buf, bufsize, "<Canterp::line_text>");
@@ -732,7 +1027,7 @@ size_t Canterp::line_length() {
    return 0;
 }
 int Canterp::sequence_number() {
-   return -1;
+   return bin ? cur_line : -1;
 }
 int Canterp::init() { return INTERP_OK; }
 void Canterp::active_g_codes(int gees[]) { std::fill(gees, gees + ACTIVE_G_CODES, 0); }
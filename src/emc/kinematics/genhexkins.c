@@ -106,7 +106,7 @@
  ----------------------------------------------------------------------------*/
 
 #include "rtapi_math.h"
-#include "posemath.h"
+#include "posemath_inline.h"
 #include "genhexkins.h"
 #include "kinematics.h"             /* these decls, KINEMATICS_FORWARD_FLAGS */
 #include "hal.h"
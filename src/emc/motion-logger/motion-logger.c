@@ -55,6 +55,7 @@ struct emcmot_error_t *emcmotError = 0;
 int mot_comp_id;
 
 emcmot_joint_t joint_array[EMCMOT_MAX_JOINTS];
+static emcmot_comp_table_t comp_array[EMCMOT_MAX_JOINTS];
 int num_joints = EMCMOT_MAX_JOINTS;
 emcmot_joint_t *joints = 0;
 int num_spindles = EMCMOT_MAX_SPINDLES;
@@ -150,6 +151,7 @@ static int init_comm_buffers(void) {
 	joint->min_ferror = 0.01;
 	joint->max_ferror = 1.0;
 
+	joint->comp.array = comp_array[joint_num];
 	joint->comp.entry = &(joint->comp.array[0]);
 	/* the compensation code has -DBL_MAX at one end of the table
 	   and +DBL_MAX at the other so _all_ commanded positions are
@@ -577,6 +579,10 @@ int main(int argc, char* argv[]) {
                 log_print("SET_TERM_COND termCond=%d, tolerance=%.6f\n", c->termCond, c->tolerance);
                 break;
 
+            case EMCMOT_SET_FEED_LIMIT:
+                log_print("SET_FEED_LIMIT vel=%.6f\n", c->vel);
+                break;
+
             case EMCMOT_SET_NUM_JOINTS:
                 log_print("SET_NUM_JOINTS %d\n", c->joint);
                 num_joints = c->joint;
@@ -1092,6 +1092,14 @@ void emcmotCommandHandler(void *arg, long period)
 	    tpSetTermCond(&emcmotDebug->coord_tp, emcmotCommand->termCond, emcmotCommand->tolerance);
 	    break;
 
+	case EMCMOT_SET_FEED_LIMIT:
+	    /* sets the external feed limit for subsequent moves, 0 for none */
+	    rtapi_print_msg(RTAPI_MSG_DBG, "SET_FEED_LIMIT");
+	    if (tpSetFeedLimit(&emcmotDebug->coord_tp, emcmotCommand->vel) != TP_ERR_OK) {
+		emcmotStatus->commandStatus = EMCMOT_COMMAND_INVALID_PARAMS;
+	    }
+	    break;
+
 	case EMCMOT_SET_SPINDLESYNC:
 		tpSetSpindleSync(&emcmotDebug->coord_tp, emcmotCommand->spindle, emcmotCommand->spindlesync, emcmotCommand->flags);
 		break;
@@ -80,6 +80,12 @@ static double *pcmd_p[EMCMOT_MAX_AXIS];
 */
 static void process_inputs(void);
 
+/* the joint position feedback of the kinematic joints as
+   kinematicsForward() takes it, filled in by process_inputs() in its
+   joint loop so that do_forward_kins() need not walk the joints again.
+   The extra joints stay 0. */
+static double kins_pos_fb[EMCMOT_MAX_JOINTS];
+
 /* 'do forward kins()' takes the position feedback in joint coords
    and applies the forward kinematics to it to generate feedback
    in Cartesean coordinates.  It has code to handle machines that
@@ -144,10 +150,12 @@ static void handle_ajogwheels(void);
 static void get_pos_cmds(long period);
 
 /* 'compute_screw_comp()' is responsible for calculating backlash and
-   lead screw error compensation.  (Leadscrew error compensation is
+   lead screw error compensation of one active joint; output_to_hal()
+   calls it in its joint loop, just before the compensation is applied.
+   (Leadscrew error compensation is
    a more sophisticated version that includes backlash comp.)  It uses
    the velocity in emcmotStatus->joint_vel_cmd to determine which way
-   each joint is moving, and the position in emcmotStatus->joint_pos_cmd
+   the joint is moving, and the position in emcmotStatus->joint_pos_cmd
    to determine where the joint is at.  That information is used to
    create the compensation value that is added to the joint_pos_cmd
    to create motor_pos_cmd, and is subtracted from motor_pos_fb to
@@ -157,7 +165,7 @@ static void get_pos_cmds(long period);
    the direction reverses.  backlash_filt is a ramped version, and
    that is the one that is later added/subtracted from the position.
 */
-static void compute_screw_comp(void);
+static void compute_screw_comp(emcmot_joint_t *joint);
 
 /* 'output_to_hal()' writes the handles the final stages of the
    control function.  It applies screw comp and writes the
@@ -251,7 +259,6 @@ void emcmotController(void *arg, long period)
     do_homing_sequence();
     do_homing();
     get_pos_cmds(period);
-    compute_screw_comp();
     plan_external_offsets();
     output_to_hal();
     write_homing_out_pins(ALL_JOINTS);
@@ -368,7 +375,11 @@ static void process_inputs(void)
 	/* point to joint data */
 	joint = &joints[joint_num];
 	if (!GET_JOINT_ACTIVE_FLAG(joint)) {
-	    /* if joint is not active, skip it */
+	    /* if joint is not active, skip it; the kins still get
+	       its last feedback */
+	    if (!IS_EXTRA_JOINT(joint_num)) {
+		kins_pos_fb[joint_num] = joint->pos_fb;
+	    }
 	    continue;
 	}
 	/* copy data from HAL to joint structure */
@@ -387,6 +398,9 @@ static void process_inputs(void)
 	    joint->pos_fb = joint->motor_pos_fb -
 		(joint->backlash_filt + joint->motor_offset);
 	}
+	if (!IS_EXTRA_JOINT(joint_num)) {
+	    kins_pos_fb[joint_num] = joint->pos_fb;
+	}
 	/* calculate following error */
 	if ( IS_EXTRA_JOINT(joint_num) && get_homed(joint_num) ) {
 	    joint->ferror = 0; // not relevant for homed extrajoints
@@ -514,21 +528,13 @@ static void do_forward_kins(void)
 /*! \todo FIXME FIXME FIXME - need to put a rate divider in here, run it
    at the traj rate */
 
-    double joint_pos[EMCMOT_MAX_JOINTS] = {0,};
-    int joint_num, result;
-    emcmot_joint_t *joint;
-
-    /* copy joint position feedback to local array */
-    for (joint_num = 0; joint_num < NO_OF_KINS_JOINTS; joint_num++) {
-	/* point to joint struct */
-	joint = &joints[joint_num];
-	/* copy feedback */
-	joint_pos[joint_num] = joint->pos_fb;
-    }
+    /* the joint position feedback is in kins_pos_fb already, copied
+       there by process_inputs() */
+    int result;
     switch (emcmotConfig->kinType) {
 
     case KINEMATICS_IDENTITY:
-	kinematicsForward(joint_pos, &emcmotStatus->carte_pos_fb, &fflags,
+	kinematicsForward(kins_pos_fb, &emcmotStatus->carte_pos_fb, &fflags,
 	    &iflags);
 	if (checkAllHomed()) {
 	    emcmotStatus->carte_pos_fb_ok = 1;
@@ -546,7 +552,7 @@ static void do_forward_kins(void)
 	    }
 	    /* calculate Cartesean position feedback from joint pos fb */
 	    result =
-		kinematicsForward(joint_pos, &emcmotStatus->carte_pos_fb,
+		kinematicsForward(kins_pos_fb, &emcmotStatus->carte_pos_fb,
 		&fflags, &iflags);
 	    /* check to make sure kinematics converged */
 	    if (result < 0) {
@@ -1631,188 +1637,178 @@ Their exact contents and meaning are as follows:
 
 */
 
-static void compute_screw_comp(void)
+static void compute_screw_comp(emcmot_joint_t *joint)
 {
-    int joint_num;
-    emcmot_joint_t *joint;
     emcmot_comp_t *comp;
     double dpos;
     double a_max, v_max, v, s_to_go, ds_stop, ds_vel, ds_acc, dv_acc;
 
 
     /* compute the correction */
-    for (joint_num = 0; joint_num < ALL_JOINTS; joint_num++) {
-        /* point to joint struct */
-        joint = &joints[joint_num];
-	if (!GET_JOINT_ACTIVE_FLAG(joint)) {
-	    /* if joint is not active, skip it */
-	    continue;
+    /* point to compensation data */
+    comp = &(joint->comp);
+    if ( comp->entries > 0 ) {
+	/* there is data in the comp table, use it */
+	/* first make sure we're in the right spot in the table */
+	while ( joint->pos_cmd < comp->entry->nominal ) {
+	    comp->entry--;
 	}
-	/* point to compensation data */
-	comp = &(joint->comp);
-	if ( comp->entries > 0 ) {
-	    /* there is data in the comp table, use it */
-	    /* first make sure we're in the right spot in the table */
-	    while ( joint->pos_cmd < comp->entry->nominal ) {
-		comp->entry--;
-	    }
-	    while ( joint->pos_cmd >= (comp->entry+1)->nominal ) {
-		comp->entry++;
-	    }
-	    /* now interpolate */
-	    dpos = joint->pos_cmd - comp->entry->nominal;
-	    if (joint->vel_cmd > 0.0) {
-	        /* moving "up". apply forward screw comp */
-		joint->backlash_corr = comp->entry->fwd_trim + 
-					comp->entry->fwd_slope * dpos;
-	    } else if (joint->vel_cmd < 0.0) {
-	        /* moving "down". apply reverse screw comp */
-		joint->backlash_corr = comp->entry->rev_trim +
-					comp->entry->rev_slope * dpos;
+	while ( joint->pos_cmd >= (comp->entry+1)->nominal ) {
+	    comp->entry++;
+	}
+	/* now interpolate */
+	dpos = joint->pos_cmd - comp->entry->nominal;
+	if (joint->vel_cmd > 0.0) {
+	    /* moving "up". apply forward screw comp */
+	    joint->backlash_corr = comp->entry->fwd_trim + 
+				    comp->entry->fwd_slope * dpos;
+	} else if (joint->vel_cmd < 0.0) {
+	    /* moving "down". apply reverse screw comp */
+	    joint->backlash_corr = comp->entry->rev_trim +
+				    comp->entry->rev_slope * dpos;
+	} else {
+	    /* not moving, use whatever was there before */
+	}
+    } else {
+	/* no compensation data, just use +/- 1/2 of backlash */
+	/** FIXME: this can actually be removed - if the user space code
+	    sends a single compensation entry with any nominal value,
+	    and with fwd_trim = +0.5 times the backlash value, and 
+	    rev_trim = -0.5 times backlash, the above screw comp code
+	    will give exactly the same result as this code. */
+	/* determine which way the compensation should be applied */
+	if (joint->vel_cmd > 0.0) {
+	    /* moving "up". apply positive backlash comp */
+	    joint->backlash_corr = 0.5 * joint->backlash;
+	} else if (joint->vel_cmd < 0.0) {
+	    /* moving "down". apply negative backlash comp */
+	    joint->backlash_corr = -0.5 * joint->backlash;
+	} else {
+	    /* not moving, use whatever was there before */
+	}
+    }
+    /* at this point, the correction has been computed, but
+       the value may make abrupt jumps on direction reversal */
+/*
+ * 07/09/2005 - S-curve implementation by Bas Laarhoven
+ *
+ * Implementation:
+ *   Generate a ramped velocity profile for backlash or screw error comp.
+ *   The velocity is ramped up to the maximum speed setting (if possible),
+ *   using the maximum acceleration setting.
+ *   At the end, the speed is ramped dowm using the same acceleration.
+ *   The algorithm keeps looking ahead. Depending on the distance to go,
+ *   the speed is increased, kept constant or decreased.
+ *   
+ * Limitations:
+ *   Since the compensation adds up to the normal movement, total
+ *   accelleration and total velocity may exceed maximum settings!
+ *   Currently this is limited to 150% by implementation.
+ *   To fix this, the calculations in get_pos_cmd should include
+ *   information from the backlash corection. This makes things
+ *   rather complicated and it might be better to implement the
+ *   backlash compensation at another place to prevent this kind
+ *   of interaction.
+ *   More testing under different circumstances will show if this
+ *   needs a more complicate solution.
+ *   For now this implementation seems to generate smoother
+ *   movements and less following errors than the original code.
+ */
+
+    /* Limit maximum accelleration and velocity 'overshoot'
+     * to 150% of the maximum settings.
+     * The TP and backlash shouldn't use more than 100%
+     * (together) but this requires some interaction that
+     * isn't implemented yet.
+     */ 
+    v_max = 0.5 * joint->vel_limit * emcmotStatus->net_feed_scale;
+    a_max = 0.5 * joint->acc_limit;
+    v = joint->backlash_vel;
+    if (joint->backlash_corr >= joint->backlash_filt) {
+	s_to_go = joint->backlash_corr - joint->backlash_filt; /* abs val */
+	if (s_to_go > 0) {
+	    // off target, need to move
+	    ds_vel  = v * servo_period;           /* abs val */
+	    dv_acc  = a_max * servo_period;       /* abs val */
+	    ds_stop = 0.5 * (v + dv_acc) *
+			    (v + dv_acc) / a_max; /* abs val */
+	    if (s_to_go <= ds_stop + ds_vel) {
+		// ramp down
+		if (v > dv_acc) {
+		    // decellerate one period
+		    ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
+		    joint->backlash_vel  -= dv_acc;
+		    joint->backlash_filt += ds_vel - ds_acc;
+		} else {
+		    // last step to target
+		    joint->backlash_vel  = 0.0;
+		    joint->backlash_filt = joint->backlash_corr;
+		}
 	    } else {
-		/* not moving, use whatever was there before */
+		if (v + dv_acc > v_max) {
+		    dv_acc = v_max - v;                /* abs val */
+		}
+		ds_acc  = 0.5 * dv_acc * servo_period; /* abs val */
+		ds_stop = 0.5 * (v + dv_acc) *
+				(v + dv_acc) / a_max;  /* abs val */
+		if (s_to_go > ds_stop + ds_vel + ds_acc) {
+		    // ramp up
+		   joint->backlash_vel  += dv_acc;
+		   joint->backlash_filt += ds_vel + ds_acc;
+		} else {
+		   // constant velocity
+		   joint->backlash_filt += ds_vel;
+		}
 	    }
-	} else {
-	    /* no compensation data, just use +/- 1/2 of backlash */
-	    /** FIXME: this can actually be removed - if the user space code
-		sends a single compensation entry with any nominal value,
-		and with fwd_trim = +0.5 times the backlash value, and 
-		rev_trim = -0.5 times backlash, the above screw comp code
-		will give exactly the same result as this code. */
-	    /* determine which way the compensation should be applied */
-	    if (joint->vel_cmd > 0.0) {
-	        /* moving "up". apply positive backlash comp */
-		joint->backlash_corr = 0.5 * joint->backlash;
-	    } else if (joint->vel_cmd < 0.0) {
-	        /* moving "down". apply negative backlash comp */
-		joint->backlash_corr = -0.5 * joint->backlash;
+	} else if (s_to_go < 0) {
+	    // safely handle overshoot (should not occur)
+	   joint->backlash_vel = 0.0;
+	   joint->backlash_filt = joint->backlash_corr;
+	}
+    } else {  /* joint->backlash_corr < 0.0 */
+	s_to_go = joint->backlash_filt - joint->backlash_corr; /* abs val */
+	if (s_to_go > 0) {
+	    // off target, need to move
+	    ds_vel  = -v * servo_period;          /* abs val */
+	    dv_acc  = a_max * servo_period;       /* abs val */
+	    ds_stop = 0.5 * (v - dv_acc) *
+			    (v - dv_acc) / a_max; /* abs val */
+	    if (s_to_go <= ds_stop + ds_vel) {
+		// ramp down
+		if (-v > dv_acc) {
+		    // decellerate one period
+		    ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
+		    joint->backlash_vel  += dv_acc;   /* decrease */
+		    joint->backlash_filt -= ds_vel - ds_acc;
+		} else {
+		    // last step to target
+		    joint->backlash_vel = 0.0;
+		    joint->backlash_filt = joint->backlash_corr;
+		}
 	    } else {
-		/* not moving, use whatever was there before */
+		if (-v + dv_acc > v_max) {
+		    dv_acc = v_max + v;               /* abs val */
+		}
+		ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
+		ds_stop = 0.5 * (v - dv_acc) *
+				(v - dv_acc) / a_max; /* abs val */
+		if (s_to_go > ds_stop + ds_vel + ds_acc) {
+		    // ramp up
+		    joint->backlash_vel  -= dv_acc;   /* increase */
+		    joint->backlash_filt -= ds_vel + ds_acc;
+		} else {
+		    // constant velocity
+		    joint->backlash_filt -= ds_vel;
+		}
 	    }
+	} else if (s_to_go < 0) {
+	    // safely handle overshoot (should not occur)
+	    joint->backlash_vel = 0.0;
+	    joint->backlash_filt = joint->backlash_corr;
 	}
-	/* at this point, the correction has been computed, but
-	   the value may make abrupt jumps on direction reversal */
-    /*
-     * 07/09/2005 - S-curve implementation by Bas Laarhoven
-     *
-     * Implementation:
-     *   Generate a ramped velocity profile for backlash or screw error comp.
-     *   The velocity is ramped up to the maximum speed setting (if possible),
-     *   using the maximum acceleration setting.
-     *   At the end, the speed is ramped dowm using the same acceleration.
-     *   The algorithm keeps looking ahead. Depending on the distance to go,
-     *   the speed is increased, kept constant or decreased.
-     *   
-     * Limitations:
-     *   Since the compensation adds up to the normal movement, total
-     *   accelleration and total velocity may exceed maximum settings!
-     *   Currently this is limited to 150% by implementation.
-     *   To fix this, the calculations in get_pos_cmd should include
-     *   information from the backlash corection. This makes things
-     *   rather complicated and it might be better to implement the
-     *   backlash compensation at another place to prevent this kind
-     *   of interaction.
-     *   More testing under different circumstances will show if this
-     *   needs a more complicate solution.
-     *   For now this implementation seems to generate smoother
-     *   movements and less following errors than the original code.
-     */
-
-	/* Limit maximum accelleration and velocity 'overshoot'
-	 * to 150% of the maximum settings.
-	 * The TP and backlash shouldn't use more than 100%
-	 * (together) but this requires some interaction that
-	 * isn't implemented yet.
-	 */ 
-        v_max = 0.5 * joint->vel_limit * emcmotStatus->net_feed_scale;
-        a_max = 0.5 * joint->acc_limit;
-        v = joint->backlash_vel;
-        if (joint->backlash_corr >= joint->backlash_filt) {
-            s_to_go = joint->backlash_corr - joint->backlash_filt; /* abs val */
-            if (s_to_go > 0) {
-                // off target, need to move
-                ds_vel  = v * servo_period;           /* abs val */
-                dv_acc  = a_max * servo_period;       /* abs val */
-                ds_stop = 0.5 * (v + dv_acc) *
-		                (v + dv_acc) / a_max; /* abs val */
-                if (s_to_go <= ds_stop + ds_vel) {
-                    // ramp down
-                    if (v > dv_acc) {
-                        // decellerate one period
-                        ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
-                        joint->backlash_vel  -= dv_acc;
-                        joint->backlash_filt += ds_vel - ds_acc;
-                    } else {
-                        // last step to target
-                        joint->backlash_vel  = 0.0;
-                        joint->backlash_filt = joint->backlash_corr;
-                    }
-                } else {
-                    if (v + dv_acc > v_max) {
-                        dv_acc = v_max - v;                /* abs val */
-                    }
-                    ds_acc  = 0.5 * dv_acc * servo_period; /* abs val */
-                    ds_stop = 0.5 * (v + dv_acc) *
-                                    (v + dv_acc) / a_max;  /* abs val */
-                    if (s_to_go > ds_stop + ds_vel + ds_acc) {
-                        // ramp up
-                       joint->backlash_vel  += dv_acc;
-                       joint->backlash_filt += ds_vel + ds_acc;
-                    } else {
-                       // constant velocity
-                       joint->backlash_filt += ds_vel;
-                    }
-                }
-            } else if (s_to_go < 0) {
-                // safely handle overshoot (should not occur)
-               joint->backlash_vel = 0.0;
-               joint->backlash_filt = joint->backlash_corr;
-            }
-        } else {  /* joint->backlash_corr < 0.0 */
-            s_to_go = joint->backlash_filt - joint->backlash_corr; /* abs val */
-            if (s_to_go > 0) {
-                // off target, need to move
-                ds_vel  = -v * servo_period;          /* abs val */
-                dv_acc  = a_max * servo_period;       /* abs val */
-                ds_stop = 0.5 * (v - dv_acc) *
-			        (v - dv_acc) / a_max; /* abs val */
-                if (s_to_go <= ds_stop + ds_vel) {
-                    // ramp down
-                    if (-v > dv_acc) {
-                        // decellerate one period
-                        ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
-                        joint->backlash_vel  += dv_acc;   /* decrease */
-                        joint->backlash_filt -= ds_vel - ds_acc;
-                    } else {
-                        // last step to target
-                        joint->backlash_vel = 0.0;
-                        joint->backlash_filt = joint->backlash_corr;
-                    }
-                } else {
-                    if (-v + dv_acc > v_max) {
-                        dv_acc = v_max + v;               /* abs val */
-                    }
-                    ds_acc = 0.5 * dv_acc * servo_period; /* abs val */
-                    ds_stop = 0.5 * (v - dv_acc) *
-                                    (v - dv_acc) / a_max; /* abs val */
-                    if (s_to_go > ds_stop + ds_vel + ds_acc) {
-                        // ramp up
-                        joint->backlash_vel  -= dv_acc;   /* increase */
-                        joint->backlash_filt -= ds_vel + ds_acc;
-                    } else {
-                        // constant velocity
-                        joint->backlash_filt -= ds_vel;
-                    }
-                }
-            } else if (s_to_go < 0) {
-                // safely handle overshoot (should not occur)
-                joint->backlash_vel = 0.0;
-                joint->backlash_filt = joint->backlash_corr;
-            }
-        }
-        /* backlash (and motor offset) will be applied to output later */
-        /* end of joint loop */
     }
+    /* backlash (and motor offset) will be applied to output by
+       the caller */
 }
 
 /*! \todo FIXME - once the HAL refactor is done so that metadata isn't stored
@@ -1964,6 +1960,10 @@ static void output_to_hal(void)
 	joint = &joints[joint_num];
 	joint_data = &(emcmot_hal_data->joint[joint_num]);
 
+	if (GET_JOINT_ACTIVE_FLAG(joint)) {
+	    /* compute backlash and screw comp of this joint */
+	    compute_screw_comp(joint);
+	}
 	/* apply backlash and motor offset to output */
 	joint->motor_pos_cmd =
 	    joint->pos_cmd + joint->backlash_filt + joint->motor_offset;
@@ -2124,6 +2124,10 @@ static void update_status(void)
     emcmotStatus->motionType = tpGetMotionType(&emcmotDebug->coord_tp);
     emcmotStatus->queueFull = tcqFull(&emcmotDebug->coord_tp.queue);
 
+    emcmotTraceSample(emcmotTrace, &emcmotStatus->carte_pos_cmd,
+	emcmotStatus->motionType, emcmotStatus->id,
+	emcmot_hal_data->trace_tolerance);
+
     /* check to see if we should pause in order to implement
        single emcmotDebug->stepping */
 
@@ -46,6 +46,7 @@
   values need to be computed, since operating system does this for us
   */
 #define DEFAULT_SHMEM_KEY 100
+#define DEFAULT_TRACE_SHMEM_KEY 101	/* position trace, see postrace.h */
 
 /* default comm timeout, in seconds */
 #define DEFAULT_EMCMOT_COMM_TIMEOUT 1.0
@@ -58,6 +59,10 @@
 #define DEFAULT_MAX_LIMIT 1000
 #define DEFAULT_MIN_LIMIT -1000
 
+/* default path deviation between position trace points, in machine
+   units */
+#define DEFAULT_TRACE_TOLERANCE 0.001
+
 /* default number of motion io pins */
 #define DEFAULT_DIO 4
 #define DEFAULT_AIO 4
@@ -28,6 +28,7 @@
 
 /* joint data */
 #include "hal.h"
+#include "postrace.h"
 #include "../motion/motion.h"
 
 typedef struct {
@@ -173,6 +174,9 @@ typedef struct {
     hal_float_t debug_float_3;	/* RPA: generic param, for debugging */
     hal_s32_t debug_s32_0;	/* RPA: generic param, for debugging */
     hal_s32_t debug_s32_1;	/* RPA: generic param, for debugging */
+
+    hal_float_t trace_tolerance; /* RPA: path deviation allowed between
+				    position trace points */
     
     hal_bit_t *synch_do[EMCMOT_MAX_DIO]; /* WPI array: output pins for motion synched IO */
     hal_bit_t *synch_di[EMCMOT_MAX_DIO]; /* RPI array: input pins for motion synched IO */
@@ -238,6 +242,7 @@ extern struct emcmot_status_t *emcmotStatus;
 extern struct emcmot_config_t *emcmotConfig;
 extern struct emcmot_debug_t *emcmotDebug;
 extern struct emcmot_error_t *emcmotError;
+extern emcmot_trace_t *emcmotTrace;
 
 
 // total number of joints (typically set with [KINS]JOINTS)
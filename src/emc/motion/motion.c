@@ -39,6 +39,8 @@ MODULE_LICENSE("GPL");
 /* RTAPI shmem key - for comms with higher level user space stuff */
 static int key = DEFAULT_SHMEM_KEY;	/* the shared memory key, default value */
 RTAPI_MP_INT(key, "shared memory key");
+static int trace_key = DEFAULT_TRACE_SHMEM_KEY;	/* position trace key */
+RTAPI_MP_INT(trace_key, "position trace shared memory key");
 static long base_period_nsec = 0;	/* fastest thread period */
 RTAPI_MP_LONG(base_period_nsec, "fastest thread period (nsecs)");
 int base_thread_fp = 0;	/* default is no floating point in base thread */
@@ -77,6 +79,8 @@ emcmot_axis_t *axes = 0;
 #ifndef STRUCTS_IN_SHMEM
 /* allocate array for joint data */
 emcmot_joint_t joint_array[EMCMOT_MAX_JOINTS];
+/* allocate the comp tables of the joints */
+static emcmot_comp_table_t comp_array[EMCMOT_MAX_JOINTS];
 /* allocate array for axis data */
 emcmot_axis_t axis_array[EMCMOT_MAX_AXIS];
 #endif
@@ -100,6 +104,7 @@ struct emcmot_status_t *emcmotStatus = 0;
 struct emcmot_config_t *emcmotConfig = 0;
 struct emcmot_debug_t *emcmotDebug = 0;
 struct emcmot_error_t *emcmotError = 0;	/* unused for RT_FIFO */
+emcmot_trace_t *emcmotTrace = 0;	/* position trace, own shmem */
 
 /***********************************************************************
 *                  LOCAL VARIABLE DECLARATIONS                         *
@@ -107,6 +112,7 @@ struct emcmot_error_t *emcmotError = 0;	/* unused for RT_FIFO */
 
 /* RTAPI shmem ID - for comms with higher level user space stuff */
 static int emc_shmem_id;	/* the shared memory ID */
+static int trace_shmem_id;	/* the position trace shared memory ID */
 
 static int mot_comp_id;	/* component ID for motion module */
 
@@ -310,7 +316,15 @@ void rtapi_app_exit(void)
 	rtapi_print_msg(RTAPI_MSG_ERR,
 	    _("MOTION: hal_stop_threads() failed, returned %d\n"), retval);
     }
-    /* free shared memory */
+    /* free shared memory; readers of the trace see the magic go away */
+    if (emcmotTrace) {
+	emcmotTrace->magic = 0;
+	retval = rtapi_shmem_delete(trace_shmem_id, mot_comp_id);
+	if (retval < 0) {
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		_("MOTION: rtapi_shmem_delete() failed, returned %d\n"), retval);
+	}
+    }
     retval = rtapi_shmem_delete(emc_shmem_id, mot_comp_id);
     if (retval < 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -395,6 +409,7 @@ static int init_hal_io(void)
     if ((retval = hal_param_float_newf(HAL_RO, &(emcmot_hal_data->debug_float_3), mot_comp_id, "motion.debug-float-3")) != 0) goto error;
     if ((retval = hal_param_s32_newf(HAL_RO, &(emcmot_hal_data->debug_s32_0), mot_comp_id, "motion.debug-s32-0")) != 0) goto error;
     if ((retval = hal_param_s32_newf(HAL_RO, &(emcmot_hal_data->debug_s32_1), mot_comp_id, "motion.debug-s32-1")) != 0) goto error;
+    if ((retval = hal_param_float_newf(HAL_RW, &(emcmot_hal_data->trace_tolerance), mot_comp_id, "motion.trace-tolerance")) != 0) goto error;
 
     // FIXME - debug only, remove later
     // export HAL parameters for some trajectory planner internal variables
@@ -467,6 +482,8 @@ static int init_hal_io(void)
     emcmot_hal_data->debug_float_2 = 0.0;
     emcmot_hal_data->debug_float_3 = 0.0;
 
+    emcmot_hal_data->trace_tolerance = DEFAULT_TRACE_TOLERANCE;
+
     *(emcmot_hal_data->last_period) = 0;
 
     /* export spindle pins and params */
@@ -724,6 +741,23 @@ static int init_comm_buffers(void)
     /* zero shared memory before doing anything else. */
     memset(emcmotStruct, 0, sizeof(emcmot_struct_t));
 
+    /* the position trace has its own segment, so GUIs can map it
+       without the rest of the motion structures */
+    trace_shmem_id = rtapi_shmem_new(trace_key, mot_comp_id,
+	sizeof(emcmot_trace_t));
+    if (trace_shmem_id < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_new failed, returned %d\n", trace_shmem_id);
+	return -1;
+    }
+    retval = rtapi_shmem_getptr(trace_shmem_id, (void **) &emcmotTrace);
+    if (retval < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "MOTION: rtapi_shmem_getptr failed, returned %d\n", retval);
+	return -1;
+    }
+    emcmotTraceInit(emcmotTrace);
+
     /* we'll reference emcmotStruct directly */
     emcmotCommand = &emcmotStruct->command;
     emcmotStatus = &emcmotStruct->status;
@@ -823,6 +857,11 @@ static int init_comm_buffers(void)
 	joint->backlash = 0.0;
 
 	joint->comp.entries = 0;
+#ifdef STRUCTS_IN_SHMEM
+	joint->comp.array = emcmotDebug->comp[joint_num];
+#else
+	joint->comp.array = comp_array[joint_num];
+#endif
 	joint->comp.entry = &(joint->comp.array[0]);
 	/* the compensation code has -DBL_MAX at one end of the table
 	   and +DBL_MAX at the other so _all_ commanded positions are
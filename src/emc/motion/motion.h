@@ -139,6 +139,7 @@ extern "C" {
 	EMCMOT_SET_VEL_LIMIT,	/* set the max vel for all moves (tooltip) */
 	EMCMOT_SET_ACC,		/* set the max accel for moves (tooltip) */
 	EMCMOT_SET_TERM_COND,	/* set termination condition (stop, blend) */
+	EMCMOT_SET_FEED_LIMIT,	/* set the feed limit for subsequent moves */
 	EMCMOT_SET_NUM_JOINTS,	/* set the number of joints */
 	EMCMOT_SET_NUM_SPINDLES, /* set the number of spindles */
 	EMCMOT_SET_WORLD_HOME,	/* set pose for world home */
@@ -401,10 +402,17 @@ Suggestion: Split this in to an Error and a Status flag register..
     typedef struct {
 	int entries;		/* number of entries in the array */
 	emcmot_comp_entry_t *entry;  /* current entry in array */
-	emcmot_comp_entry_t array[EMCMOT_COMP_SIZE+2];
-	/* +2 because array has -HUGE_VAL and +HUGE_VAL entries at the ends */
+	emcmot_comp_entry_t *array;
+	/* EMCMOT_COMP_SIZE+2 entries, +2 because array has -HUGE_VAL and
+	   +HUGE_VAL entries at the ends.  The table is kept apart from
+	   the joint struct, see emcmot_comp_table_t. */
     } emcmot_comp_t;
 
+/* the storage of one comp table.  It is not part of emcmot_joint_t, where
+   its 6kB would put the joints that the servo thread walks through every
+   period pages apart. */
+    typedef emcmot_comp_entry_t emcmot_comp_table_t[EMCMOT_COMP_SIZE+2];
+
 /* motion controller states */
 
     typedef enum {
@@ -479,6 +487,8 @@ Suggestion: Split this in to an Error and a Status flag register..
 	double motor_pos_cmd;	/* commanded position, with comp */
 	double motor_pos_fb;	/* position feedback, with comp */
 	double pos_fb;		/* position feedback, comp removed */
+	double motor_offset;	/* diff between internal and motor pos, used
+				   to set position to zero during homing */
 	double ferror;		/* following error */
 	double ferror_limit;	/* limit depends on speed */
 	double ferror_high_mark;	/* max following error */
@@ -493,8 +503,6 @@ Suggestion: Split this in to an Error and a Status flag register..
 	int on_pos_limit;	/* non-zero if on limit */
 	int on_neg_limit;	/* non-zero if on limit */
 
-	double motor_offset;	/* diff between internal and motor pos, used
-				   to set position to zero during homing */
 	int old_jjog_counts;	/* prior value, used for deltas */
 	double big_vel;		/* used for "debouncing" velocity */
     } emcmot_joint_t;
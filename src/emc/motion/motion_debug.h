@@ -66,6 +66,7 @@ typedef struct emcmot_debug_t {
 
 #ifdef STRUCTS_IN_SHMEM
 	emcmot_joint_t joints[EMCMOT_MAX_JOINTS];	/* joint data */
+	emcmot_comp_table_t comp[EMCMOT_MAX_JOINTS];	/* their comp tables */
 	emcmot_axis_t axes[EMCMOT_MAX_AXIS];	        /* axis data */
 #endif
 
@@ -0,0 +1,147 @@
+/********************************************************************
+* Description: postrace.c
+*   Realtime writer of the position trace, see postrace.h.
+*
+*   Every servo cycle the commanded position is compared with the
+*   straight line from the last point emitted.  The previous sample is
+*   emitted as a new point as soon as any sample since the last point
+*   lies further than the tolerance from that line, or when the motion
+*   type changes or the machine stops, so a straight move costs two
+*   points and an arc as many as its chord error requires.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+********************************************************************/
+
+#include "rtapi.h"
+#include "rtapi_atomic.h"
+#include "rtapi_string.h"
+#include "postrace.h"
+
+static emcmot_trace_point_t prev;	/* the previous sample */
+static int prev_emitted;		/* prev is the last point emitted */
+static int started;
+static double last[9];			/* the last point emitted */
+/* samples since 'last' that were not emitted, prev among them */
+static double span[EMCMOT_TRACE_SPAN][9];
+static int nspan;
+
+static void pose_to_array(const EmcPose *p, double a[9])
+{
+    a[0] = p->tran.x; a[1] = p->tran.y; a[2] = p->tran.z;
+    a[3] = p->a; a[4] = p->b; a[5] = p->c;
+    a[6] = p->u; a[7] = p->v; a[8] = p->w;
+}
+
+static int pose_equal(const EmcPose *p, const EmcPose *q)
+{
+    return p->tran.x == q->tran.x && p->tran.y == q->tran.y
+	&& p->tran.z == q->tran.z && p->a == q->a && p->b == q->b
+	&& p->c == q->c && p->u == q->u && p->v == q->v && p->w == q->w;
+}
+
+/* does any sample in span lie further than 'tolerance' from the segment
+   from 'last' to 'pos'? */
+static int span_deviates(const double b[9], double tolerance)
+{
+    const double *a = last;
+    double ab[9];
+    double ab2 = 0, tol2 = tolerance * tolerance;
+    int i, k;
+
+    for (k = 0; k < 9; k++) {
+	ab[k] = b[k] - a[k];
+	ab2 += ab[k] * ab[k];
+    }
+    for (i = 0; i < nspan; i++) {
+	const double *s = span[i];
+	double t = 0, d2 = 0;
+	if (ab2 > 0) {
+	    for (k = 0; k < 9; k++)
+		t += (s[k] - a[k]) * ab[k];
+	    t /= ab2;
+	    if (t < 0) t = 0;
+	    if (t > 1) t = 1;
+	}
+	for (k = 0; k < 9; k++) {
+	    double d = s[k] - a[k] - t * ab[k];
+	    d2 += d * d;
+	}
+	if (d2 > tol2)
+	    return 1;
+    }
+    return 0;
+}
+
+static void emit(emcmot_trace_t *trace, const emcmot_trace_point_t *pt)
+{
+    unsigned int serial = trace->head + 1;
+    emcmot_trace_point_t *p;
+
+    if (serial == 0)
+	serial = 1;
+    p = &trace->point[serial & (EMCMOT_TRACE_SIZE - 1)];
+    atomic_store_explicit(&p->serial, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    p->motion_type = pt->motion_type;
+    p->id = pt->id;
+    p->pos = pt->pos;
+    atomic_store_explicit(&p->serial, serial, memory_order_release);
+    atomic_store_explicit(&trace->head, serial, memory_order_release);
+
+    pose_to_array(&pt->pos, last);
+    nspan = 0;
+}
+
+void emcmotTraceInit(emcmot_trace_t *trace)
+{
+    memset(trace, 0, sizeof(*trace));
+    trace->size = EMCMOT_TRACE_SIZE;
+    started = 0;
+    nspan = 0;
+    atomic_store_explicit(&trace->magic, EMCMOT_TRACE_MAGIC,
+	memory_order_release);
+}
+
+void emcmotTraceSample(emcmot_trace_t *trace, const EmcPose *pos,
+    int motion_type, int id, double tolerance)
+{
+    emcmot_trace_point_t cur;
+    double b[9];
+    unsigned int seq;
+
+    cur.serial = 0;
+    cur.motion_type = motion_type;
+    cur.id = id;
+    cur.pad = 0;
+    cur.pos = *pos;
+
+    if (!started) {
+	emit(trace, &cur);
+	prev_emitted = 1;
+	started = 1;
+    } else if (pose_equal(pos, &prev.pos)) {
+	/* standing still, the plot must reach the stop point */
+	if (!prev_emitted)
+	    emit(trace, &prev);
+	prev_emitted = 1;
+    } else {
+	pose_to_array(pos, b);
+	if (!prev_emitted && (motion_type != prev.motion_type
+		|| nspan == EMCMOT_TRACE_SPAN || tolerance <= 0
+		|| span_deviates(b, tolerance)))
+	    emit(trace, &prev);
+	memcpy(span[nspan++], b, sizeof(b));
+	prev_emitted = 0;
+    }
+    prev = cur;
+
+    seq = trace->live_seq;
+    atomic_store_explicit(&trace->live_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    trace->live = cur;
+    trace->live.serial = trace->head;
+    atomic_store_explicit(&trace->live_seq, seq + 2, memory_order_release);
+}
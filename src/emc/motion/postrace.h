@@ -0,0 +1,127 @@
+/********************************************************************
+* Description: postrace.h
+*   Position trace: the commanded position of every servo cycle,
+*   thinned in realtime to the points a backplot needs and published in
+*   a shared memory ring that any number of user space readers can
+*   follow without locking and without slowing motion down.
+*
+*   The writer never waits for readers.  Each point carries its serial
+*   number, which is cleared while the point is being written, so a
+*   reader that falls more than EMCMOT_TRACE_SIZE points behind sees
+*   the serial change and knows what it missed.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+********************************************************************/
+#ifndef POSTRACE_H
+#define POSTRACE_H
+
+#include "emcpos.h"		/* EmcPose */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EMCMOT_TRACE_MAGIC 0x54524345	/* "TRCE" */
+#define EMCMOT_TRACE_SIZE 8192		/* points in the ring, a power of 2 */
+
+/* points kept back while the path is straight; when this many pile up
+   the last one is emitted anyway */
+#define EMCMOT_TRACE_SPAN 32
+
+typedef struct {
+    unsigned int serial;	/* of the point, 0 while it is being written */
+    int motion_type;		/* EMC_MOTION_TYPE_*, 0 when not moving */
+    int id;			/* motion id, the program line */
+    int pad;
+    EmcPose pos;		/* carte_pos_cmd */
+} emcmot_trace_point_t;
+
+typedef struct {
+    unsigned int magic;		/* EMCMOT_TRACE_MAGIC once initialized */
+    unsigned int size;		/* EMCMOT_TRACE_SIZE */
+    unsigned int head;		/* serial of the newest point, 0 if none */
+    unsigned int live_seq;	/* odd while 'live' is being written */
+    /* the position of the latest servo cycle, and the head at the
+       time; emitted points are never newer than it */
+    emcmot_trace_point_t live;
+    emcmot_trace_point_t point[EMCMOT_TRACE_SIZE];
+} emcmot_trace_t;
+
+/* Realtime side, in postrace.c.  emcmotTraceInit() clears the ring;
+   emcmotTraceSample() is called once per servo cycle with the commanded
+   position and emits a point whenever the path since the last point
+   strays more than 'tolerance' from a straight line, changes motion
+   type or stops. */
+extern void emcmotTraceInit(emcmot_trace_t *trace);
+extern void emcmotTraceSample(emcmot_trace_t *trace, const EmcPose *pos,
+    int motion_type, int id, double tolerance);
+
+/* User space side.  A reader attaches read-only, checks the magic and
+   size, sets 'next' one past the head and calls emcmotTraceRead() as
+   often as it likes.  It copies points from 'next' up to the head of
+   the latest live sample into 'out', at most 'max', advancing 'next',
+   and returns their number.  When that is less than 'max' the reader
+   has caught up and the live sample, which comes after the points
+   copied, is in '*live'.  Points that were overwritten before they
+   could be read are added to '*lost'.  Returns -1 if the ring is not
+   valid (motion was unloaded) or the live sample could not be read. */
+static inline int emcmotTraceRead(const emcmot_trace_t *trace,
+    unsigned int *next, emcmot_trace_point_t *out, int max,
+    emcmot_trace_point_t *live, unsigned int *lost)
+{
+    emcmot_trace_point_t l;
+    unsigned int seq, end, serial;
+    int n = 0, tries = 0;
+
+    if (__atomic_load_n(&trace->magic, __ATOMIC_ACQUIRE) !=
+	    EMCMOT_TRACE_MAGIC)
+	return -1;
+    /* the live sample, under its seqlock */
+    for (;;) {
+	seq = __atomic_load_n(&trace->live_seq, __ATOMIC_ACQUIRE);
+	l = trace->live;
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (!(seq & 1) && seq == __atomic_load_n(&trace->live_seq,
+		__ATOMIC_RELAXED))
+	    break;
+	if (++tries == 1000)
+	    return -1;
+    }
+    end = l.serial;
+
+    if ((int) (end + 1 - *next) < 0) {
+	/* ahead of the writer, the ring was cleared */
+	*next = end + 1;
+    } else if (end + 1 - *next > EMCMOT_TRACE_SIZE) {
+	/* fell behind by more than the ring */
+	*lost += end + 1 - EMCMOT_TRACE_SIZE - *next;
+	*next = end + 1 - EMCMOT_TRACE_SIZE;
+    }
+    for (; n < max && *next != end + 1; (*next)++) {
+	const emcmot_trace_point_t *p;
+	if (*next == 0)
+	    continue;		/* serial 0 is never used */
+	p = &trace->point[*next & (EMCMOT_TRACE_SIZE - 1)];
+	serial = __atomic_load_n(&p->serial, __ATOMIC_ACQUIRE);
+	out[n] = *p;
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (serial != *next
+		|| __atomic_load_n(&p->serial, __ATOMIC_RELAXED) != serial) {
+	    /* overwritten while we looked */
+	    (*lost)++;
+	    continue;
+	}
+	n++;
+    }
+    if (*next == end + 1)
+	*live = l;
+    return n;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
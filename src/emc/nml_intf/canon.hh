@@ -169,6 +169,8 @@ typedef struct CanonConfig_t {
    almost any deviation trying to keep speed up. */
    double motionTolerance;
    double naivecamTolerance;
+/* external feed limit of the moves that follow, in mm/sec, 0 for none */
+   double feedLimit;
    int feed_mode;
    int spindle_num; //current spindle for spindle-synch motion
    CanonSpindle_t spindle[EMCMOT_MAX_SPINDLES];
@@ -362,6 +364,16 @@ extern void SET_MOTION_CONTROL_MODE(CANON_MOTION_MODE mode, double tolerance);
 
 extern void SET_NAIVECAM_TOLERANCE(double tolerance);
 
+extern void SET_FEED_LIMIT(double limit);
+
+/* This limits the feed of the moves that follow to 'limit', in the units
+of SET_FEED_RATE; 0 removes the limit.  Unlike the feed rate, the limit
+is not scaled by feed override: the trajectory planner treats it like
+a machine velocity limit and slows down ahead of the limited moves.  It
+is meant for limits the program cannot know when it is written, like
+the spindle load of a cut, set from a remap or a Python plugin.  The
+limit is removed at the end of the program. */
+
 /*
 
 This sets the motion control mode to one of: CANON_EXACT_STOP,
@@ -453,6 +453,9 @@ int emcFormat(NMLTYPE type, void *buffer, CMS * cms)
     case EMC_TRAJ_SET_TERM_COND_TYPE:
 	((EMC_TRAJ_SET_TERM_COND *) buffer)->update(cms);
 	break;
+    case EMC_TRAJ_SET_FEED_LIMIT_TYPE:
+	((EMC_TRAJ_SET_FEED_LIMIT *) buffer)->update(cms);
+	break;
     case EMC_TRAJ_SET_SPINDLESYNC_TYPE:
         ((EMC_TRAJ_SET_SPINDLESYNC *) buffer)->update(cms);
         break;
@@ -751,6 +754,8 @@ const char *emc_symbol_lookup(uint32_t type)
 	return "EMC_TRAJ_SET_TELEOP_ENABLE";
     case EMC_TRAJ_SET_TERM_COND_TYPE:
 	return "EMC_TRAJ_SET_TERM_COND";
+    case EMC_TRAJ_SET_FEED_LIMIT_TYPE:
+	return "EMC_TRAJ_SET_FEED_LIMIT";
     case EMC_TRAJ_SET_SPINDLESYNC_TYPE:
 	return "EMC_TRAJ_SET_SPINDLESYNC";
     case EMC_TRAJ_SET_UNITS_TYPE:
@@ -1567,6 +1572,14 @@ void EMC_TRAJ_SET_TERM_COND::update(CMS * cms)
 
 }
 
+void EMC_TRAJ_SET_FEED_LIMIT::update(CMS * cms)
+{
+
+    EMC_TRAJ_CMD_MSG::update(cms);
+    cms->update(limit);
+
+}
+
 void EMC_TRAJ_SET_SPINDLESYNC::update(CMS * cms)
 {
     EMC_TRAJ_CMD_MSG::update(cms);
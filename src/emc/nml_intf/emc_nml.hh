@@ -878,6 +878,19 @@ class EMC_TRAJ_SET_TERM_COND:public EMC_TRAJ_CMD_MSG {
 
     int cond;
     double tolerance; // used to set the precision/tolerance of path deviation 
+};
+
+class EMC_TRAJ_SET_FEED_LIMIT:public EMC_TRAJ_CMD_MSG {
+  public:
+    EMC_TRAJ_SET_FEED_LIMIT():EMC_TRAJ_CMD_MSG(EMC_TRAJ_SET_FEED_LIMIT_TYPE,
+					       sizeof
+					       (EMC_TRAJ_SET_FEED_LIMIT)) {
+    };
+
+    // For internal NML/CMS use only.
+    void update(CMS * cms);
+
+    double limit;	// for the moves that follow, in user units/sec, 0 for none
 		      // during CONTINUOUS motion mode. 
 };
 
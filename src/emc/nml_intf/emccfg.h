@@ -27,6 +27,9 @@ extern "C" {
 /* default name of EMC NML file */
 #define DEFAULT_EMC_NMLFILE EMC2_DEFAULT_NMLFILE
 
+/* SysV shared memory key of the EMC_STAT mirror published by task */
+#define DEFAULT_EMC_STAT_MIRROR_KEY 1010
+
 /* cycle time for emctask, in seconds */
 #define DEFAULT_EMC_TASK_CYCLE_TIME 0.100
 
@@ -0,0 +1,245 @@
+/********************************************************************
+* Description: emcstatmirror.cc
+*   Lock-free shared memory mirror of EMC_STAT.
+*
+*   The region holds a copy of the EMC_STAT image written by task,
+*   split into sections.  Each publish bumps a global generation to an
+*   odd value, copies the sections that changed and bumps their
+*   versions, then makes the generation even again.  Readers copy the
+*   sections whose version differs from what they last saw and retry if
+*   the generation moved meanwhile, so they never block task and never
+*   see a torn update.  The segment is attached read-only by readers.
+*
+* Author:
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+*
+* Last change:
+********************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <sched.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "rcs_print.hh"
+#include "emc.hh"
+#include "emc_nml.hh"
+#include "emcstatmirror.hh"
+
+#define EMC_STAT_MIRROR_MAGIC 0x454d5354	/* "EMST" */
+
+// how often a reader retries while task is publishing
+#define EMC_STAT_MIRROR_RETRIES 1000
+
+struct emc_stat_mirror_section {
+    unsigned int version;
+    unsigned int offset;	// into the EMC_STAT image
+    unsigned int size;
+    unsigned int pad;
+};
+
+struct emc_stat_mirror_shm {
+    unsigned int magic;		// 0 once task has exited
+    unsigned int stat_size;	// sizeof(EMC_STAT) in task
+    unsigned int generation;	// odd while task is publishing
+    unsigned int pad;
+    emc_stat_mirror_section section[EMC_STAT_MIRROR_SECTIONS];
+    // followed by the EMC_STAT image
+};
+
+static char *mirror_image(emc_stat_mirror_shm *mem)
+{
+    return (char *) (mem + 1);
+}
+
+// Section boundaries within 'stat'; bound[i] to bound[i+1] is section i.
+static void mirror_bounds(const EMC_STAT *stat,
+			  const char *bound[EMC_STAT_MIRROR_SECTIONS + 1])
+{
+    bound[EMC_STAT_MIRROR_TOP] = (const char *) stat;
+    bound[EMC_STAT_MIRROR_TASK] = (const char *) &stat->task;
+    bound[EMC_STAT_MIRROR_MOTION] = (const char *) &stat->motion;
+    bound[EMC_STAT_MIRROR_JOINTS] = (const char *) &stat->motion.joint[0];
+    bound[EMC_STAT_MIRROR_AXES] = (const char *) &stat->motion.axis[0];
+    bound[EMC_STAT_MIRROR_SPINDLES] = (const char *) &stat->motion.spindle[0];
+    bound[EMC_STAT_MIRROR_MOTION_IO] = (const char *) &stat->motion.synch_di[0];
+    bound[EMC_STAT_MIRROR_IO] = (const char *) &stat->io;
+    bound[EMC_STAT_MIRROR_SECTIONS] = (const char *) stat + sizeof(EMC_STAT);
+}
+
+EMC_STAT_MIRROR::EMC_STAT_MIRROR(int id, emc_stat_mirror_shm *m, bool o):
+shmid(id), mem(m), owner(o)
+{
+    invalidate();
+}
+
+EMC_STAT_MIRROR *EMC_STAT_MIRROR::create(key_t key)
+{
+    size_t size = sizeof(emc_stat_mirror_shm) + sizeof(EMC_STAT);
+    int id = shmget(key, size, IPC_CREAT | 0666);
+
+    if (id == -1 && errno == EINVAL) {
+	// left over from a build with a smaller EMC_STAT, replace it
+	id = shmget(key, 0, 0);
+	if (id != -1) {
+	    shmctl(id, IPC_RMID, 0);
+	}
+	id = shmget(key, size, IPC_CREAT | 0666);
+    }
+    if (id == -1) {
+	rcs_print_error("emcStatMirror: shmget(%d) failed: %s\n",
+			(int) key, strerror(errno));
+	return 0;
+    }
+
+    void *addr = shmat(id, 0, 0);
+    if (addr == (void *) -1) {
+	rcs_print_error("emcStatMirror: shmat failed: %s\n", strerror(errno));
+	return 0;
+    }
+
+    emc_stat_mirror_shm *mem = (emc_stat_mirror_shm *) addr;
+    __atomic_store_n(&mem->magic, 0, __ATOMIC_RELEASE);
+    memset(addr, 0, size);
+    mem->stat_size = sizeof(EMC_STAT);
+    __atomic_store_n(&mem->magic, EMC_STAT_MIRROR_MAGIC, __ATOMIC_RELEASE);
+
+    return new EMC_STAT_MIRROR(id, mem, true);
+}
+
+EMC_STAT_MIRROR *EMC_STAT_MIRROR::attach(key_t key)
+{
+    int id = shmget(key, 0, 0);
+    if (id == -1) {
+	return 0;
+    }
+
+    void *addr = shmat(id, 0, SHM_RDONLY);
+    if (addr == (void *) -1) {
+	return 0;
+    }
+
+    emc_stat_mirror_shm *mem = (emc_stat_mirror_shm *) addr;
+    if (__atomic_load_n(&mem->magic, __ATOMIC_ACQUIRE) != EMC_STAT_MIRROR_MAGIC
+	|| mem->stat_size != sizeof(EMC_STAT)) {
+	shmdt(addr);
+	return 0;
+    }
+
+    return new EMC_STAT_MIRROR(id, mem, false);
+}
+
+EMC_STAT_MIRROR::~EMC_STAT_MIRROR()
+{
+    if (owner) {
+	// tell readers to go back to NML, the segment goes away once
+	// the last of them has detached
+	__atomic_store_n(&mem->magic, 0, __ATOMIC_RELEASE);
+	shmctl(shmid, IPC_RMID, 0);
+    }
+    shmdt(mem);
+}
+
+void EMC_STAT_MIRROR::invalidate()
+{
+    generation_seen = 1;	// odd, never matches a finished publish
+    for (int i = 0; i < EMC_STAT_MIRROR_SECTIONS; i++) {
+	version_seen[i] = 0;
+    }
+}
+
+void EMC_STAT_MIRROR::publish(const EMC_STAT *stat)
+{
+    const char *bound[EMC_STAT_MIRROR_SECTIONS + 1];
+    char *image = mirror_image(mem);
+    unsigned int generation = mem->generation;
+    bool publishing = false;
+
+    mirror_bounds(stat, bound);
+
+    for (int i = 0; i < EMC_STAT_MIRROR_SECTIONS; i++) {
+	emc_stat_mirror_section *section = &mem->section[i];
+	unsigned int offset = bound[i] - bound[0];
+	unsigned int size = bound[i + 1] - bound[i];
+
+	if (section->size == size
+	    && !memcmp(image + offset, bound[i], size)) {
+	    continue;
+	}
+
+	if (!publishing) {
+	    __atomic_store_n(&mem->generation, generation + 1,
+			     __ATOMIC_RELAXED);
+	    __atomic_thread_fence(__ATOMIC_RELEASE);
+	    publishing = true;
+	}
+	section->offset = offset;
+	section->size = size;
+	memcpy(image + offset, bound[i], size);
+	// version 0 means "never published", skip it on wraparound
+	unsigned int version = section->version + 1;
+	__atomic_store_n(&section->version, version ? version : 1,
+			 __ATOMIC_RELAXED);
+    }
+
+    if (publishing) {
+	__atomic_store_n(&mem->generation, generation + 2, __ATOMIC_RELEASE);
+    }
+}
+
+int EMC_STAT_MIRROR::read(EMC_STAT *stat)
+{
+    const char *image = mirror_image(mem);
+    unsigned int version[EMC_STAT_MIRROR_SECTIONS];
+
+    for (int tries = 0; tries < EMC_STAT_MIRROR_RETRIES; tries++) {
+	if (__atomic_load_n(&mem->magic, __ATOMIC_ACQUIRE) !=
+	    EMC_STAT_MIRROR_MAGIC) {
+	    break;
+	}
+
+	unsigned int generation =
+	    __atomic_load_n(&mem->generation, __ATOMIC_ACQUIRE);
+	if (generation & 1) {
+	    sched_yield();
+	    continue;
+	}
+	if (generation == generation_seen) {
+	    return 0;
+	}
+
+	int mask = 0;
+	for (int i = 0; i < EMC_STAT_MIRROR_SECTIONS; i++) {
+	    const emc_stat_mirror_section *section = &mem->section[i];
+	    version[i] = __atomic_load_n(&section->version, __ATOMIC_RELAXED);
+	    if (version[i] == version_seen[i]) {
+		continue;
+	    }
+	    unsigned int offset = section->offset, size = section->size;
+	    if (offset + size > sizeof(EMC_STAT)) {
+		continue;	// torn, the generation check catches it
+	    }
+	    memcpy((char *) stat + offset, image + offset, size);
+	    mask |= 1 << i;
+	}
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&mem->generation, __ATOMIC_RELAXED) != generation) {
+	    continue;
+	}
+
+	generation_seen = generation;
+	for (int i = 0; i < EMC_STAT_MIRROR_SECTIONS; i++) {
+	    version_seen[i] = version[i];
+	}
+	return mask;
+    }
+
+    // 'stat' may hold part of an update; copy everything next time
+    invalidate();
+    return -1;
+}
@@ -0,0 +1,73 @@
+/********************************************************************
+* Description: emcstatmirror.hh
+*   Lock-free shared memory mirror of EMC_STAT.  Task publishes the
+*   status it writes to the emcStatus NML channel into a seqlock
+*   protected region; local readers map the region and copy only the
+*   sections whose version changed since their last read.
+*
+* Author:
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+*
+* Last change:
+********************************************************************/
+#ifndef EMC_STAT_MIRROR_HH
+#define EMC_STAT_MIRROR_HH
+
+#include <sys/types.h>		/* key_t */
+
+class EMC_STAT;
+struct emc_stat_mirror_shm;
+
+/* sections of EMC_STAT, versioned separately */
+enum EMC_STAT_MIRROR_SECTION {
+    EMC_STAT_MIRROR_TOP,	// RCS_STAT_MSG header fields
+    EMC_STAT_MIRROR_TASK,	// task
+    EMC_STAT_MIRROR_MOTION,	// motion header and motion.traj
+    EMC_STAT_MIRROR_JOINTS,	// motion.joint[]
+    EMC_STAT_MIRROR_AXES,	// motion.axis[]
+    EMC_STAT_MIRROR_SPINDLES,	// motion.spindle[]
+    EMC_STAT_MIRROR_MOTION_IO,	// motion.synch_di[] through the end of motion
+    EMC_STAT_MIRROR_IO,		// io and debug
+    EMC_STAT_MIRROR_SECTIONS
+};
+
+class EMC_STAT_MIRROR {
+  public:
+    // Create the region; used by task, the only writer.  Returns 0 if
+    // the shared memory could not be created.
+    static EMC_STAT_MIRROR *create(key_t key);
+    // Attach to an existing region.  Returns 0 without printing anything
+    // if there is none, so callers can quietly fall back to NML.
+    static EMC_STAT_MIRROR *attach(key_t key);
+    ~EMC_STAT_MIRROR();
+
+    // Copy 'stat' into the region, bumping the version of each section
+    // whose contents changed.
+    void publish(const EMC_STAT *stat);
+
+    // Copy every section changed since the previous call into 'stat'.
+    // Returns a bit mask of the sections copied (0 if nothing changed),
+    // or -1 if the region is not valid (task exited or stuck in an
+    // update).  After -1 'stat' may be partly updated and should be
+    // refreshed from NML; the next successful read copies everything.
+    int read(EMC_STAT *stat);
+
+    // Forget the versions seen so the next read() copies everything,
+    // e.g. after 'stat' was overwritten from another source.
+    void invalidate();
+
+  private:
+    EMC_STAT_MIRROR(int id, emc_stat_mirror_shm *mem, bool owner);
+    EMC_STAT_MIRROR(const EMC_STAT_MIRROR &);	// Don't copy me.
+
+    int shmid;
+    emc_stat_mirror_shm *mem;
+    bool owner;
+    unsigned int generation_seen;
+    unsigned int version_seen[EMC_STAT_MIRROR_SECTIONS];
+};
+
+#endif
@@ -22,6 +22,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
 #include <set>
 
 #define BOOST_PYTHON_MAX_ARITY 4
@@ -113,12 +117,58 @@ int PythonPlugin::call_method(bp::object method, bp::object &retval)
 
 }
 
+int PythonPlugin::resolve(const char *module, const char *callable)
+{
+    if (callable == NULL)
+	return -1;
+
+    std::string key = std::string(module ? module : "") + "." + callable;
+    std::map<std::string, int>::iterator it = handle_index.find(key);
+    if (it != handle_index.end())
+	return it->second;
+
+    callable_handle h;
+    h.module = module ? module : "";
+    h.callable = callable;
+    h.generation = 0;   // never matches, looked up on first call
+    handles.push_back(h);
+    return handle_index[key] = handles.size() - 1;
+}
+
+// fetch the function object for a handle, going through the namespace
+// only if the toplevel module was (re)initialized since the last lookup
+void PythonPlugin::lookup(int handle, bp::object &function)
+{
+    callable_handle &h = handles[handle];
+
+    if (h.generation != generation) {
+	if (h.module.empty()) {  // default to function in toplevel module
+	    h.function = main_namespace[h.callable];
+	} else {
+	    bp::object submod =  main_namespace[h.module];
+	    bp::object submod_namespace = submod.attr("__dict__");
+	    h.function = submod_namespace[h.callable];
+	}
+	h.generation = generation;
+    }
+    function = h.function;
+}
+
 int PythonPlugin::call(const char *module, const char *callable,
 		       bp::object tupleargs, bp::object kwargs, bp::object &retval)
+{
+    if (callable == NULL)
+	return PLUGIN_NO_CALLABLE;
+
+    return call(resolve(module, callable), tupleargs, kwargs, retval);
+}
+
+int PythonPlugin::call(int handle,
+		       bp::object tupleargs, bp::object kwargs, bp::object &retval)
 {
     bp::object function;
 
-    if (callable == NULL)
+    if ((handle < 0) || (handle >= (int) handles.size()))
 	return PLUGIN_NO_CALLABLE;
 
     reload();
@@ -127,13 +177,8 @@ int PythonPlugin::call(const char *module, const char *callable,
 	return status;
 
     try {
-	if (module == NULL) {  // default to function in toplevel module
-	    function = main_namespace[callable];
-	} else {
-	    bp::object submod =  main_namespace[module];
-	    bp::object submod_namespace = submod.attr("__dict__");
-	    function = submod_namespace[callable];
-	}
+	lookup(handle, function);
+
 	// this wont work with boost-python1.34 - needs 1.40
 	//retval = function(*tupleargs, **kwargs);
 
@@ -157,10 +202,12 @@ int PythonPlugin::call(const char *module, const char *callable,
 	PyErr_Clear();
     }
     if (status == PLUGIN_EXCEPTION) {
+	// the call may have resolved further handles, so index again
+	const callable_handle &h = handles[handle];
 	logPP(0, "call(%s%s%s): \n%s",
-	      module ? module : "",
-	      module ? "." : "",
-	      callable, exception_msg.c_str());
+	      h.module.c_str(),
+	      h.module.empty() ? "" : ".",
+	      h.callable.c_str(), exception_msg.c_str());
     }
     return status;
 }
@@ -209,19 +256,75 @@ bool PythonPlugin::is_callable(const char *module,
     return result;
 }
 
-// this should be moved to an inotify-based solution and be done with it
+// watch the directory holding the toplevel module rather than the file:
+// editors commonly save by writing a new file and renaming it over the old
+// one, which would leave a watch on the file itself pointing nowhere
+int PythonPlugin::watch()
+{
+    std::string dir(abs_path);
+    size_t slash = dir.rfind('/');
+
+    if (slash == std::string::npos)
+	return -1;
+    watched_name = dir.substr(slash + 1);
+    dir.erase(slash ? slash : 1);
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+	logPP(1, "watch: inotify_init1() returned %s, falling back to stat()",
+	      strerror(errno));
+	return -1;
+    }
+    if (inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+	logPP(1, "watch: inotify_add_watch(%s) returned %s, falling back to stat()",
+	      dir.c_str(), strerror(errno));
+	close(inotify_fd);
+	inotify_fd = -1;
+	return -1;
+    }
+    return 0;
+}
+
+// drain pending inotify events, true if any of them was for the toplevel module
+bool PythonPlugin::changed()
+{
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    bool hit = false;
+    ssize_t n;
+
+    while ((n = read(inotify_fd, buf, sizeof(buf))) > 0) {
+	for (char *p = buf; p < buf + n; ) {
+	    struct inotify_event *ev = (struct inotify_event *) p;
+	    if ((ev->mask & IN_Q_OVERFLOW) ||
+		(ev->len && (watched_name == ev->name)))
+		hit = true;
+	    p += sizeof(struct inotify_event) + ev->len;
+	}
+    }
+    return hit;
+}
+
+// with an inotify watch in place this costs one non-blocking read() per
+// call; stat() is only used if the watch could not be set up
 int PythonPlugin::reload()
 {
     struct stat st;
     if (!reload_on_change)
 	return PLUGIN_OK;
 
+    if ((inotify_fd >= 0) && !changed()) {
+	logPP(5, "reload: no-op");
+	status = PLUGIN_OK;
+	return status;
+    }
+
     if (stat(abs_path, &st)) {
 	logPP(0, "reload: stat(%s) returned %s", abs_path, strerror(errno));
 	status = PLUGIN_STAT_FAILED;
 	return status;
     }
-    if (st.st_mtime > module_mtime) {
+    // an inotify event is authoritative, mtime has only second resolution
+    if ((inotify_fd >= 0) || (st.st_mtime > module_mtime)) {
 	module_mtime = st.st_mtime;
 	initialize();
 	logPP(1, "reload():  %s reloaded, status=%d", toplevel, status);
@@ -256,6 +359,8 @@ std::string handle_pyerror()
 int PythonPlugin::initialize()
 {
     std::string msg;
+
+    generation++;      // invalidates all resolved callable handles
     if (Py_IsInitialized()) {
 	try {
 	    bp::object module = bp::import("__main__");
@@ -296,7 +401,9 @@ PythonPlugin::PythonPlugin(struct _inittab *inittab) :
     reload_on_change(0),
     toplevel(0),
     abs_path(0),
-    log_level(0)
+    log_level(0),
+    generation(0),
+    inotify_fd(-1)
 {
     Py_SetProgramName((char *) abs_path);
 
@@ -354,6 +461,8 @@ int PythonPlugin::configure(const char *iniFilename,
 	}
 	abs_path = strstore(real_path);
 	module_mtime = st.st_mtime;      // record timestamp
+	if (reload_on_change)
+	    watch();
 
     } else {
         if (getcwd(real_path, PATH_MAX) == NULL) {
@@ -25,6 +25,7 @@
 #include <boost/python/object.hpp>
 
 #include <vector>
+#include <map>
 #include <string>
 #include <sys/types.h>
 
@@ -64,6 +65,13 @@ public:
     bool is_callable(const char *module, const char *funcname);
     int call(const char *module,const char *callable,
 	     boost::python::object tupleargs, boost::python::object kwargs, boost::python::object &retval);
+
+    // callable handles: resolve() binds [module.]callable once and returns
+    // a handle for call(), or -1 if callable is NULL. The function object
+    // is looked up on first use and again only after a reload.
+    int resolve(const char *module, const char *callable);
+    int call(int handle,
+	     boost::python::object tupleargs, boost::python::object kwargs, boost::python::object &retval);
     int run_string(const char *cmd, boost::python::object &retval, bool as_file = false);
     int call_method(boost::python::object method, boost::python::object &retval);
 
@@ -81,6 +89,10 @@ private:
     ~PythonPlugin() {};
 
     int reload();
+    int watch();
+    bool changed();
+    void lookup(int handle, boost::python::object &function);
+
     std::vector<std::string> inittab_entries;
     int status;
     time_t module_mtime;                  // toplevel module - last modification time
@@ -91,6 +103,18 @@ private:
     std::string exception_msg;
     std::string error_msg;
     int log_level;
+
+    struct callable_handle {
+	std::string module;               // empty for the toplevel namespace
+	std::string callable;
+	boost::python::object function;   // valid if generation matches
+	unsigned generation;
+    };
+    std::vector<callable_handle> handles;
+    std::map<std::string, int> handle_index; // "module.callable" -> handle
+    unsigned generation;                  // bumped by initialize()
+    int inotify_fd;                       // watches the toplevel's directory, or -1
+    std::string watched_name;             // basename of the toplevel module
 };
 
 #endif
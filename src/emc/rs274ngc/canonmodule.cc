@@ -205,6 +205,7 @@ BOOST_PYTHON_MODULE(emccanon) {
     def("SET_BLOCK_DELETE",&SET_BLOCK_DELETE);
     def("SET_CUTTER_RADIUS_COMPENSATION",&SET_CUTTER_RADIUS_COMPENSATION);
     def("SET_FEED_MODE",&SET_FEED_MODE);
+    def("SET_FEED_LIMIT",&SET_FEED_LIMIT);
     def("SET_FEED_RATE",&SET_FEED_RATE);
     //    def("SET_FEED_REFERENCE",&SET_FEED_REFERENCE);
     def("SET_G5X_OFFSET",&SET_G5X_OFFSET);
@@ -20,9 +20,12 @@
 #include <limits.h>
 #include <config.h>
 #include <stdio.h>
+#include "interp_return.hh"
 
 InterpBase::~InterpBase() {}
 
+int InterpBase::seek_line(int line) { return INTERP_ERROR; }
+
 InterpBase *interp_from_shlib(const char *shlib) {
     fprintf(stderr, "interp_from_shlib(%s)\n", shlib);
     dlopen(NULL, RTLD_GLOBAL);
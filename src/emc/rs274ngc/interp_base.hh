@@ -58,6 +58,10 @@ public:
     virtual void active_settings(double active_settings[ACTIVE_SETTINGS]) = 0;
     virtual void set_loglevel(int level) = 0;
     virtual void set_loop_on_main_m99(bool state) = 0;
+    // position the open program so that the next read() returns the
+    // line before 'line', to run it from that line; task reads its way
+    // there instead if this returns INTERP_ERROR
+    virtual int seek_line(int line);
 };
 
 InterpBase *interp_from_shlib(const char *shlib);
@@ -0,0 +1,941 @@
+/********************************************************************
+* Description: interp_checkpoint.cc
+*   Taking and restoring checkpoints of the interpreter state, reading
+*   and writing the checkpoint index of a program, and seeking to a
+*   line with it.  See interp_checkpoint.hh.
+*
+* License: GPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+********************************************************************/
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include "rs274ngc.hh"
+#include "rs274ngc_return.hh"
+#include "interp_return.hh"
+#include "interp_internal.hh"
+#include "rs274ngc_interp.hh"
+#include "interp_checkpoint.hh"
+
+bool operator==(const interp_checkpoint &a, const interp_checkpoint &b)
+{
+    size_t i;
+
+    if (memcmp(&a.state.position, &b.state.position,
+	    sizeof(a.state) - offsetof(interp_checkpoint_state, position)))
+	return false;
+    if (a.params != b.params || a.globals.size() != b.globals.size())
+	return false;
+    for (i = 0; i < a.globals.size(); i++) {
+	if (a.globals[i].name != b.globals[i].name
+		|| a.globals[i].value != b.globals[i].value
+		|| a.globals[i].attr != b.globals[i].attr)
+	    return false;
+    }
+    return true;
+}
+
+bool interp_in_block(const std::vector<std::pair<int, int> > &blocks,
+	int line)
+{
+    size_t i;
+
+    for (i = 0; i < blocks.size(); i++) {
+	if (line >= blocks[i].first && line <= blocks[i].second)
+	    return true;
+    }
+    return false;
+}
+
+/* The letter and number words of a line squeezed the way read_text()
+   does it, without comments and named parameters. */
+static void scan_words(const char *t, std::vector<std::pair<char, double> > &words)
+{
+    while (*t) {
+	if (*t == '<') {
+	    t = strchr(t, '>');
+	    if (!t)
+		return;
+	    t++;
+	} else if (isalpha(*t) && (isdigit(t[1]) || t[1] == '.')) {
+	    char *end;
+	    double v = strtod(t + 1, &end);
+	    words.push_back(std::make_pair(*t, v));
+	    t = end;
+	} else {
+	    t++;
+	}
+    }
+}
+
+static bool starts_with(const char *s, const char *prefix)
+{
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+/* Finds the lines of a program and its o-word blocks without
+   interpreting it.  Returns -1 if the program cannot be read; a
+   program the index cannot be used for is described in
+   s.unsupported. */
+int interp_scan_program(const char *filename, interp_program_structure &s)
+{
+    static const char *keywords[] = {
+	"endsub", "endwhile", "endrepeat", "endif", "elseif", "else",
+	"sub", "call", "do", "while", "if", "repeat", "return", "break",
+	"continue", NULL
+    };
+    std::vector<std::pair<std::string, std::string> > stack;
+    std::vector<int64_t> ends;	/* of each physical line, [0] is 0 */
+    char line[LINELEN];
+    int base = -1, open_line = 0;
+    FILE *f;
+
+    s.first = 0;
+    s.lines = 0;
+    s.offsets.clear();
+    s.blocks.clear();
+    s.tool_changes.clear();
+    s.subs = false;
+    s.unsupported.clear();
+
+    f = fopen(filename, "r");
+    if (!f)
+	return -1;
+    ends.push_back(0);
+    while (fgets(line, sizeof(line), f)) {
+	std::vector<std::pair<char, double> > words;
+	std::string t;
+	bool comment = false;
+	size_t len = strlen(line);
+	int seq, depth;
+	const char *p;
+
+	if (len == sizeof(line) - 1 && line[len - 1] != '\n') {
+	    s.unsupported = "a line is too long";
+	    break;
+	}
+	ends.push_back(ftell(f));
+	for (p = line; *p; p++) {
+	    if (comment) {
+		if (*p == ')')
+		    comment = false;
+	    } else if (*p == '(') {
+		comment = true;
+		if (strncasecmp(p, "(py,", 4) == 0)
+		    s.unsupported = "it runs python code in comments";
+	    } else if (*p == ';') {
+		break;
+	    } else if (!isspace(*p)) {
+		t += tolower(*p);
+	    }
+	}
+	if (base < 0) {
+	    /* open() skips blank lines before a leading %, and the %
+	       line is line 1 */
+	    if (t.empty() && len == strspn(line, " \t\r\n"))
+		continue;
+	    if (t == "%") {
+		base = ends.size() - 2;
+		s.first = 1;
+		continue;
+	    }
+	    base = 0;
+	}
+	seq = ends.size() - 1 - base;
+	if (s.first && t == "%")
+	    break;			/* the end of the program */
+	s.lines = seq;
+	if (t.find("_hal[") != std::string::npos)
+	    s.unsupported = "it reads HAL pins";
+
+	depth = stack.size();
+	p = t.c_str();
+	if (*p == '/')
+	    p++;
+	if (*p == 'n')
+	    for (p++; isdigit(*p) || *p == '.'; p++);
+	if (*p == 'o') {
+	    std::string name;
+	    const char *q = ++p;
+	    int k;
+	    if (*p == '<')
+		p = strchr(p, '>');
+	    else if (*p == '[')
+		p = strchr(p, ']');
+	    else
+		for (p--; isdigit(p[1]); p++);
+	    if (!p) {
+		s.unsupported = "an o-word is not closed";
+		break;
+	    }
+	    p++;
+	    name.assign(q, p - q);
+	    for (k = 0; keywords[k]; k++)
+		if (starts_with(p, keywords[k]))
+		    break;
+	    if (!keywords[k]) {
+		s.unsupported = "it has Fanuc style subroutines";
+		break;
+	    }
+	    std::string kw = keywords[k];
+	    if (kw == "sub" || kw == "do" || kw == "if" || kw == "repeat") {
+		stack.push_back(std::make_pair(name, kw));
+		if (kw == "sub")
+		    s.subs = true;
+	    } else if (kw == "while") {
+		if (!stack.empty() && stack.back().first == name
+			&& stack.back().second == "do")
+		    stack.pop_back();
+		else
+		    stack.push_back(std::make_pair(name, kw));
+	    } else if (kw == "endsub" || kw == "endwhile"
+		    || kw == "endrepeat" || kw == "endif") {
+		if (stack.empty() || stack.back().first != name
+			|| stack.back().second != kw.substr(3)) {
+		    s.unsupported = "its o-word blocks do not match";
+		    break;
+		}
+		stack.pop_back();
+	    }
+	}
+
+	scan_words(t.c_str(), words);
+	for (size_t i = 0; i < words.size(); i++) {
+	    char c = words[i].first;
+	    double v = words[i].second;
+	    if (c == 'm' && (v == 98 || v == 99))
+		s.unsupported = "it has Fanuc style subroutines";
+	    else if (c == 'm' && v == 66)
+		s.unsupported = "it waits for inputs";
+	    else if (c == 'g' && v >= 38 && v < 39)
+		s.unsupported = "it probes";
+	    else if (c == 'm' && v == 6 && depth == 0 && stack.empty())
+		s.tool_changes.push_back(seq);
+	}
+
+	if (depth == 0 && !stack.empty())
+	    open_line = seq;
+	else if (depth > 0 && stack.empty())
+	    s.blocks.push_back(std::make_pair(open_line, seq - 1));
+    }
+    if (!stack.empty() && s.unsupported.empty())
+	s.blocks.push_back(std::make_pair(open_line, s.lines));
+    if (ferror(f))
+	s.unsupported = "it could not be read";
+    fclose(f);
+    if (base < 0)
+	base = 0;
+    s.offsets.assign(ends.begin() + base, ends.end());
+    return 0;
+}
+
+std::string interp_checkpoint_file(const char *program)
+{
+    return std::string(program) + ".ckpt";
+}
+
+static int write_string(FILE *f, const std::string &s)
+{
+    uint32_t len = s.size() + 1;
+
+    if (fwrite(&len, sizeof(len), 1, f) != 1
+	    || fwrite(s.c_str(), len, 1, f) != 1)
+	return -1;
+    return 0;
+}
+
+static int read_string(FILE *f, std::string &s)
+{
+    char buf[LINELEN];
+    uint32_t len;
+
+    if (fread(&len, sizeof(len), 1, f) != 1 || len == 0
+	    || len > sizeof(buf) || fread(buf, len, 1, f) != 1
+	    || buf[len - 1] != 0)
+	return -1;
+    s = buf;
+    return 0;
+}
+
+int interp_checkpoint_write_one(FILE *f, const interp_checkpoint &c)
+{
+    uint32_t n;
+    size_t i;
+
+    if (fwrite(&c.state, sizeof(c.state), 1, f) != 1)
+	return -1;
+    n = c.params.size();
+    if (fwrite(&n, sizeof(n), 1, f) != 1)
+	return -1;
+    for (i = 0; i < c.params.size(); i++) {
+	int32_t number = c.params[i].first;
+	if (fwrite(&number, sizeof(number), 1, f) != 1
+		|| fwrite(&c.params[i].second, sizeof(double), 1, f) != 1)
+	    return -1;
+    }
+    n = c.globals.size();
+    if (fwrite(&n, sizeof(n), 1, f) != 1)
+	return -1;
+    for (i = 0; i < c.globals.size(); i++) {
+	uint32_t attr = c.globals[i].attr;
+	if (write_string(f, c.globals[i].name)
+		|| fwrite(&c.globals[i].value, sizeof(double), 1, f) != 1
+		|| fwrite(&attr, sizeof(attr), 1, f) != 1)
+	    return -1;
+    }
+    return 0;
+}
+
+int interp_checkpoint_read_one(FILE *f, interp_checkpoint &c)
+{
+    uint32_t n, i;
+
+    c.params.clear();
+    c.globals.clear();
+    if (fread(&c.state, sizeof(c.state), 1, f) != 1
+	    || fread(&n, sizeof(n), 1, f) != 1
+	    || n > interp_param_global::RS274NGC_MAX_PARAMETERS)
+	return -1;
+    for (i = 0; i < n; i++) {
+	int32_t number;
+	double value;
+	if (fread(&number, sizeof(number), 1, f) != 1
+		|| fread(&value, sizeof(value), 1, f) != 1
+		|| number < 0
+		|| number >= interp_param_global::RS274NGC_MAX_PARAMETERS)
+	    return -1;
+	c.params.push_back(std::make_pair((int) number, value));
+    }
+    if (fread(&n, sizeof(n), 1, f) != 1)
+	return -1;
+    for (i = 0; i < n; i++) {
+	interp_checkpoint_global g;
+	uint32_t attr;
+	if (read_string(f, g.name)
+		|| fread(&g.value, sizeof(g.value), 1, f) != 1
+		|| fread(&attr, sizeof(attr), 1, f) != 1)
+	    return -1;
+	g.attr = attr;
+	c.globals.push_back(g);
+    }
+    return 0;
+}
+
+int interp_checkpoint_write_sub(FILE *f, const interp_checkpoint_sub &s)
+{
+    int32_t ints[2] = { s.sequence_number, s.type };
+
+    if (write_string(f, s.name)
+	    || fwrite(&s.offset, sizeof(s.offset), 1, f) != 1
+	    || fwrite(ints, sizeof(ints), 1, f) != 1)
+	return -1;
+    return 0;
+}
+
+int interp_checkpoint_read_sub(FILE *f, interp_checkpoint_sub &s)
+{
+    int32_t ints[2];
+
+    if (read_string(f, s.name)
+	    || fread(&s.offset, sizeof(s.offset), 1, f) != 1
+	    || fread(ints, sizeof(ints), 1, f) != 1)
+	return -1;
+    s.sequence_number = ints[0];
+    s.type = ints[1];
+    return 0;
+}
+
+int interp_checkpoint_write(const char *filename,
+	const interp_checkpoint_index &index)
+{
+    interp_checkpoint_header h = index.header;
+    std::string tmp = std::string(filename) + ".tmp";
+    size_t i;
+    int bad = 0;
+    FILE *f;
+
+    memcpy(h.magic, INTERP_CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.version = INTERP_CHECKPOINT_VERSION;
+    h.size = sizeof(interp_checkpoint_state);
+    h.count = index.checkpoints.size();
+    h.nblocks = index.blocks.size();
+    h.nsubs = index.subs.size();
+    h.pad = 0;
+
+    f = fopen(tmp.c_str(), "w");
+    if (!f)
+	return -1;
+    bad = fwrite(&h, sizeof(h), 1, f) != 1;
+    for (i = 0; !bad && i < index.checkpoints.size(); i++)
+	bad = interp_checkpoint_write_one(f, index.checkpoints[i]);
+    for (i = 0; !bad && i < index.blocks.size(); i++) {
+	int32_t lines[2] = { index.blocks[i].first, index.blocks[i].second };
+	bad = fwrite(lines, sizeof(lines), 1, f) != 1;
+    }
+    for (i = 0; !bad && i < index.subs.size(); i++)
+	bad = interp_checkpoint_write_sub(f, index.subs[i]);
+    if (fclose(f) != 0)
+	bad = 1;
+    if (bad || rename(tmp.c_str(), filename) != 0) {
+	unlink(tmp.c_str());
+	return -1;
+    }
+    return 0;
+}
+
+int interp_checkpoint_read(const char *filename,
+	interp_checkpoint_index &index)
+{
+    interp_checkpoint_header &h = index.header;
+    uint32_t i;
+    int bad;
+    FILE *f;
+
+    index.checkpoints.clear();
+    index.blocks.clear();
+    index.subs.clear();
+    f = fopen(filename, "r");
+    if (!f)
+	return -1;
+    bad = fread(&h, sizeof(h), 1, f) != 1
+	|| memcmp(h.magic, INTERP_CHECKPOINT_MAGIC, sizeof(h.magic))
+	|| h.version != INTERP_CHECKPOINT_VERSION
+	|| h.size != sizeof(interp_checkpoint_state);
+    for (i = 0; !bad && i < h.count; i++) {
+	interp_checkpoint c;
+	bad = interp_checkpoint_read_one(f, c);
+	index.checkpoints.push_back(c);
+    }
+    for (i = 0; !bad && i < h.nblocks; i++) {
+	int32_t lines[2];
+	bad = fread(lines, sizeof(lines), 1, f) != 1;
+	index.blocks.push_back(std::make_pair((int) lines[0], (int) lines[1]));
+    }
+    for (i = 0; !bad && i < h.nsubs; i++) {
+	interp_checkpoint_sub s;
+	bad = interp_checkpoint_read_sub(f, s);
+	index.subs.push_back(s);
+    }
+    fclose(f);
+    return bad ? -1 : 0;
+}
+
+/****************************************************************************/
+
+/* The numbered parameters a checkpoint keeps: not the ones computed
+   from the machine state when they are read. */
+static bool checkpoint_param(Interp *interp, int i)
+{
+    return i > 0 && i != 5399 && i != 5600 && i != 5601
+	&& !interp->isreadonly(i);
+}
+
+/* named parameters of the main program that are plain values */
+static bool checkpoint_global(const parameter_value &pv)
+{
+    return !(pv.attr & (PA_READONLY | PA_USE_LOOKUP | PA_FROM_INI | PA_PYTHON));
+}
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t n)
+{
+    const unsigned char *p = (const unsigned char *) data;
+
+    while (n--) {
+	h ^= *p++;
+	h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/*! Interp::checkpoint_safe
+
+Returned Value: bool
+   Whether a checkpoint taken now would hold all of the state.
+
+Outside of subroutines, remaps and o-word skipping, with cutter
+compensation off (its queue holds moves not yet made), nothing waiting
+for the machine, and spindles in RPM mode except that the first one may
+run: the interpreter does not keep the maximum speed of constant
+surface speed mode.
+
+*/
+
+bool Interp::checkpoint_safe()
+{
+    int i;
+
+    if (_setup.call_level != 0 || _setup.remap_level != 0
+	    || _setup.defining_sub || _setup.skipping_o
+	    || _setup.skipping_to_sub || _setup.cutter_comp_side
+	    || _setup.probe_flag || _setup.input_flag
+	    || _setup.toolchange_flag)
+	return false;
+    for (i = 0; i < _setup.num_spindles; i++) {
+	if (_setup.spindle_mode[i] != CONSTANT_RPM)
+	    return false;
+	if (i > 0 && (_setup.spindle_turning[i] != CANON_STOPPED
+		|| _setup.speed[i] != 0))
+	    return false;
+    }
+    return true;
+}
+
+/*! Interp::checkpoint_start_hash
+
+Returned Value: uint64_t
+   A hash of what a program starts with that checkpoints depend on: the
+   numbered parameters a checkpoint keeps, the named parameters of the
+   main program and the tool table.
+
+The checkpoints of a program only hold the parameters that differ from
+the start of the program, so they are only good for a start that hashes
+the same.
+
+*/
+
+uint64_t Interp::checkpoint_start_hash()
+{
+    uint64_t h = 14695981039346656037ULL, tools = 0;
+    parameter_map_iterator it;
+    int i;
+
+    for (i = 0; i < interp_param_global::RS274NGC_MAX_PARAMETERS; i++) {
+	if (!checkpoint_param(this, i))
+	    continue;
+	h = fnv1a(h, &i, sizeof(i));
+	h = fnv1a(h, &_setup.parameters[i], sizeof(double));
+    }
+    for (it = _setup.sub_context[0].named_params.begin();
+	    it != _setup.sub_context[0].named_params.end(); it++) {
+	if (!checkpoint_global(it->second))
+	    continue;
+	h = fnv1a(h, it->first, strlen(it->first));
+	h = fnv1a(h, &it->second.value, sizeof(double));
+    }
+    /* by tool, not by pocket, and without the spindle */
+    for (i = 1; i < _setup.pockets_max && i < CANON_POCKETS_MAX; i++) {
+	const CANON_TOOL_TABLE &t = _setup.tool_table[i];
+	uint64_t th = 14695981039346656037ULL;
+	if (t.toolno <= 0)
+	    continue;
+	th = fnv1a(th, &t.toolno, sizeof(t.toolno));
+	th = fnv1a(th, &t.offset, sizeof(t.offset));
+	th = fnv1a(th, &t.diameter, sizeof(t.diameter));
+	th = fnv1a(th, &t.frontangle, sizeof(t.frontangle));
+	th = fnv1a(th, &t.backangle, sizeof(t.backangle));
+	th = fnv1a(th, &t.orientation, sizeof(t.orientation));
+	tools += th;
+    }
+    return fnv1a(h, &tools, sizeof(tools));
+}
+
+/*! Interp::save_checkpoint
+
+Returned Value: int (INTERP_OK)
+
+Side Effects:
+   c is set to the current state.  The active_* arrays are updated.
+
+Called By: rs274 -x
+
+'start' is the parameters array at the start of the program; only the
+parameters that differ from it are kept.
+
+*/
+
+int Interp::save_checkpoint(interp_checkpoint &c, const double *start)
+{
+    interp_checkpoint_state &s = c.state;
+    parameter_map_iterator it;
+    int i;
+
+    memset(&s, 0, sizeof(s));
+    s.line = _setup.sequence_number;
+    s.offset = _setup.file_pointer ? ftell(_setup.file_pointer) : -1;
+    s.position[0] = _setup.current_x;
+    s.position[1] = _setup.current_y;
+    s.position[2] = _setup.current_z;
+    s.position[3] = _setup.AA_current;
+    s.position[4] = _setup.BB_current;
+    s.position[5] = _setup.CC_current;
+    s.position[6] = _setup.u_current;
+    s.position[7] = _setup.v_current;
+    s.position[8] = _setup.w_current;
+
+    write_g_codes((block_pointer) NULL, &_setup);
+    write_m_codes((block_pointer) NULL, &_setup);
+    write_settings(&_setup);
+    for (i = 1; i < ACTIVE_G_CODES; i++)
+	s.g_codes[i] = _setup.active_g_codes[i];
+    for (i = 1; i < ACTIVE_M_CODES; i++)
+	s.m_codes[i] = _setup.active_m_codes[i];
+
+    s.feed_rate = _setup.feed_rate;
+    s.speed = _setup.speed[0];
+    s.tolerance = GET_EXTERNAL_MOTION_CONTROL_TOLERANCE();
+    s.tool_offset[0] = _setup.tool_offset.tran.x;
+    s.tool_offset[1] = _setup.tool_offset.tran.y;
+    s.tool_offset[2] = _setup.tool_offset.tran.z;
+    s.tool_offset[3] = _setup.tool_offset.a;
+    s.tool_offset[4] = _setup.tool_offset.b;
+    s.tool_offset[5] = _setup.tool_offset.c;
+    s.tool_offset[6] = _setup.tool_offset.u;
+    s.tool_offset[7] = _setup.tool_offset.v;
+    s.tool_offset[8] = _setup.tool_offset.w;
+    s.cycle[0] = _setup.cycle_cc;
+    s.cycle[1] = _setup.cycle_i;
+    s.cycle[2] = _setup.cycle_j;
+    s.cycle[3] = _setup.cycle_k;
+    s.cycle[4] = _setup.cycle_p;
+    s.cycle[5] = _setup.cycle_q;
+    s.cycle[6] = _setup.cycle_r;
+    s.cycle[7] = _setup.cycle_il;
+    s.return_value = _setup.return_value;
+    s.motion_mode = _setup.motion_mode;
+    s.cycle_l = _setup.cycle_l;
+    s.cycle_il_flag = _setup.cycle_il_flag;
+    s.tool = _setup.tool_table[0].toolno;
+    s.selected_tool = _setup.selected_tool;
+    s.selected_pocket = _setup.selected_pocket;
+    s.arc_not_allowed = _setup.arc_not_allowed;
+    s.value_returned = _setup.value_returned;
+
+    c.params.clear();
+    for (i = 0; i < interp_param_global::RS274NGC_MAX_PARAMETERS; i++) {
+	if (checkpoint_param(this, i) && _setup.parameters[i] != start[i])
+	    c.params.push_back(std::make_pair(i, _setup.parameters[i]));
+    }
+    c.globals.clear();
+    for (it = _setup.sub_context[0].named_params.begin();
+	    it != _setup.sub_context[0].named_params.end(); it++) {
+	if (!checkpoint_global(it->second))
+	    continue;
+	interp_checkpoint_global g;
+	g.name = it->first;
+	g.value = it->second.value;
+	g.attr = it->second.attr;
+	c.globals.push_back(g);
+    }
+    return INTERP_OK;
+}
+
+/* runs one line of the G-code that restores a checkpoint */
+int Interp::checkpoint_execute(const char *line)
+{
+    int status = execute(line);
+
+    if (status != INTERP_OK && status != INTERP_EXECUTE_FINISH) {
+	char currentError[LINELEN+1];
+	strcpy(currentError, getSavedError());
+	ERS(_("restoring checkpoint failed executing: '%s': %s"), line,
+	    currentError);
+    }
+    return INTERP_OK;
+}
+
+static void format_g(char *buf, size_t size, int val)
+{
+    if (val % 10)
+	snprintf(buf, size, " G%d.%d", val / 10, val % 10);
+    else
+	snprintf(buf, size, " G%d", val / 10);
+}
+
+/*! Interp::restore_checkpoint
+
+Returned Value: int
+   If executing the G-code that restores the state fails, the error of
+   that.  Otherwise INTERP_OK.
+
+Side Effects:
+   The state is set to that of c, except for the file position.  The
+   o-word offsets known are forgotten.
+
+Called By:
+   Interp::seek_line
+   rs274 -x
+
+As in restore_settings(), what canon has to know is set by executing
+G-code, the rest is set directly.  The parameters come first, so that
+selecting the coordinate system and G92.3 take their offsets from them.
+With 'tool' false the tool in the spindle is left as it is, for task
+to synch with the machine.
+
+*/
+
+int Interp::restore_checkpoint(const interp_checkpoint &c, bool tool)
+{
+    const interp_checkpoint_state &s = c.state;
+    int current[ACTIVE_G_CODES], saved[ACTIVE_G_CODES];
+    int saved_m[ACTIVE_M_CODES];
+    char buf[LINELEN];
+    std::string cmd;
+    size_t i;
+    int k;
+
+    CHKS((_setup.call_level != 0),
+	 _("cannot restore a checkpoint in a subroutine"));
+    for (i = 0; i < c.params.size(); i++)
+	_setup.parameters[c.params[i].first] = c.params[i].second;
+    for (i = 0; i < c.globals.size(); i++) {
+	parameter_value pv;
+	pv.value = c.globals[i].value;
+	pv.attr = c.globals[i].attr;
+	_setup.sub_context[0].named_params[strstore(c.globals[i].name.c_str())] = pv;
+    }
+    _setup.offset_map.clear();
+
+    write_g_codes((block_pointer) NULL, &_setup);
+    write_m_codes((block_pointer) NULL, &_setup);
+    snprintf(buf, sizeof(buf), "G%d", s.g_codes[5] / 10);
+    CHP(checkpoint_execute(buf));
+
+    if (tool && s.tool != _setup.tool_table[0].toolno) {
+	snprintf(buf, sizeof(buf), "M61 Q%d", s.tool);
+	CHP(checkpoint_execute(buf));
+	// the state after the next read, without taking the position
+	// from canon
+	_setup.toolchange_flag = false;
+	CHP(load_tool_table());
+    }
+    _setup.selected_tool = s.selected_tool;
+    _setup.selected_pocket = s.selected_pocket;
+
+    for (k = 0; k < ACTIVE_G_CODES; k++) {
+	current[k] = _setup.active_g_codes[k];
+	saved[k] = s.g_codes[k];
+    }
+    // the coordinate system, the tool length offset and the control
+    // mode are done below
+    current[8] = saved[8];
+    current[9] = saved[9];
+    current[11] = saved[11];
+    gen_g_codes(current, saved, cmd);
+    // selected even when active, to apply the offsets just restored
+    format_g(buf, sizeof(buf), s.g_codes[8]);
+    cmd += buf;
+    CHP(checkpoint_execute(cmd.c_str()));
+    CHP(checkpoint_execute(_setup.parameters[5210] ? "G92.3" : "G92.2"));
+
+    if (s.g_codes[9] == G_43) {
+	static const char axes[] = "XYZABCUVW";
+	cmd = "G43.1";
+	for (k = 0; k < 9; k++) {
+	    if (s.tool_offset[k] == 0)
+		continue;
+	    snprintf(buf, sizeof(buf), " %c%.17g", axes[k], s.tool_offset[k]);
+	    cmd += buf;
+	}
+	CHP(checkpoint_execute(cmd.c_str()));
+    } else {
+	CHP(checkpoint_execute("G49"));
+    }
+
+    if (s.g_codes[11] == G_64 && s.tolerance > 0)
+	snprintf(buf, sizeof(buf), "G64 P%.17g", s.tolerance);
+    else
+	format_g(buf, sizeof(buf), s.g_codes[11]);
+    CHP(checkpoint_execute(buf));
+
+    snprintf(buf, sizeof(buf), "F%.17g S%.17g", s.feed_rate, s.speed);
+    CHP(checkpoint_execute(buf));
+
+    cmd.clear();
+    for (k = 0; k < ACTIVE_M_CODES; k++)
+	saved_m[k] = s.m_codes[k];
+    write_m_codes((block_pointer) NULL, &_setup);
+    gen_m_codes(_setup.active_m_codes, saved_m, cmd);
+    if (!cmd.empty()) {
+	char mbuf[cmd.size() + 1];
+	char *last = mbuf;
+	char *m;
+	strcpy(mbuf, cmd.c_str());
+	while ((m = strtok_r(last, "\n", &last)) != NULL)
+	    CHP(checkpoint_execute(m));
+    }
+
+    // what G-code would not restore exactly, or not at all
+    _setup.feed_rate = s.feed_rate;
+    _setup.speed[0] = s.speed;
+    _setup.motion_mode = s.motion_mode;
+    _setup.cycle_cc = s.cycle[0];
+    _setup.cycle_i = s.cycle[1];
+    _setup.cycle_j = s.cycle[2];
+    _setup.cycle_k = s.cycle[3];
+    _setup.cycle_p = s.cycle[4];
+    _setup.cycle_q = s.cycle[5];
+    _setup.cycle_r = s.cycle[6];
+    _setup.cycle_il = s.cycle[7];
+    _setup.cycle_l = s.cycle_l;
+    _setup.cycle_il_flag = s.cycle_il_flag;
+    _setup.return_value = s.return_value;
+    _setup.value_returned = s.value_returned;
+    _setup.arc_not_allowed = s.arc_not_allowed;
+    _setup.current_x = s.position[0];
+    _setup.current_y = s.position[1];
+    _setup.current_z = s.position[2];
+    _setup.AA_current = s.position[3];
+    _setup.BB_current = s.position[4];
+    _setup.CC_current = s.position[5];
+    _setup.u_current = s.position[6];
+    _setup.v_current = s.position[7];
+    _setup.w_current = s.position[8];
+
+    write_g_codes((block_pointer) NULL, &_setup);
+    write_m_codes((block_pointer) NULL, &_setup);
+    write_settings(&_setup);
+    return INTERP_OK;
+}
+
+/* the o-word subroutines of the open program that are defined */
+void Interp::save_checkpoint_subs(std::vector<interp_checkpoint_sub> &subs)
+{
+    offset_map_iterator it;
+
+    for (it = _setup.offset_map.begin(); it != _setup.offset_map.end(); it++) {
+	if (it->second.type != O_sub
+		|| strcmp(it->second.filename, _setup.filename) != 0)
+	    continue;
+	interp_checkpoint_sub s;
+	s.name = it->first;
+	s.offset = it->second.offset;
+	s.sequence_number = it->second.sequence_number;
+	s.type = it->second.type;
+	subs.push_back(s);
+    }
+}
+
+/* define the subroutines of the open program that come before 'line' */
+void Interp::restore_checkpoint_subs(
+	const std::vector<interp_checkpoint_sub> &subs, int line)
+{
+    size_t i;
+
+    for (i = 0; i < subs.size(); i++) {
+	if (subs[i].sequence_number >= line)
+	    continue;
+	offset o;
+	o.type = subs[i].type;
+	o.filename = strstore(_setup.filename);
+	o.offset = subs[i].offset;
+	o.sequence_number = subs[i].sequence_number;
+	o.repeat_count = -1;
+	_setup.offset_map[strstore(subs[i].name.c_str())] = o;
+    }
+}
+
+/*! Interp::seek_sequence
+
+Returned Value: int
+   NCE_FILE_NOT_OPEN if no program is open, INTERP_ERROR if the file
+   cannot seek.  Otherwise INTERP_OK.
+
+Side Effects:
+   The next read() reads from 'offset' as line sequence_number + 1.
+
+*/
+
+int Interp::seek_sequence(int sequence_number, long offset)
+{
+    CHKS((_setup.file_pointer == NULL), NCE_FILE_NOT_OPEN);
+    CHKS((fseek(_setup.file_pointer, offset, SEEK_SET) != 0),
+	 _("cannot seek to line %d of %s"), sequence_number + 1,
+	 _setup.filename);
+    _setup.sequence_number = sequence_number;
+    return INTERP_OK;
+}
+
+/*! Interp::seek_line
+
+Returned Value: int
+   INTERP_OK if the next read() returns line - 1 with the state the
+   program has there.  Otherwise INTERP_ERROR, and the program is at
+   its start with the state it had before.
+
+Called By: task, to run from a line
+
+Restores the last checkpoint in the index of the program, written by
+'rs274 -x', that comes before line - 1 and interprets the lines from
+there up to line - 2.  The index is not used if the program, the
+parameters or the tool table it starts with, or the block delete
+switch have changed since, or if line - 2 is inside an o-word block.
+Task clears what the lines interpreted here queued, as it does for the
+lines it steps over.
+
+*/
+
+int Interp::seek_line(int line)
+{
+    interp_checkpoint_index index;
+    char filename[PATH_MAX];
+    struct stat st;
+    int target = line - 2;	// the line last read when done
+    int k, status;
+
+    if (_setup.file_pointer == NULL || _setup.call_level != 0
+	    || target < 1)
+	return INTERP_ERROR;
+    strcpy(filename, _setup.filename);
+    if (interp_checkpoint_read(interp_checkpoint_file(filename).c_str(),
+	    index) != 0)
+	return INTERP_ERROR;
+    if (stat(filename, &st) != 0
+	    || st.st_size != index.header.program_size
+	    || st.st_mtime != index.header.program_mtime
+	    || index.header.block_delete != (GET_BLOCK_DELETE() ? 1 : 0)
+	    || index.header.start_hash != checkpoint_start_hash()
+	    || target > index.header.lines
+	    || interp_in_block(index.blocks, target))
+	return INTERP_ERROR;
+    for (k = index.checkpoints.size() - 1; k >= 0; k--)
+	if (index.checkpoints[k].state.line <= target)
+	    break;
+    if (k < 0)
+	return INTERP_ERROR;
+
+    // what to go back to if the seek fails
+    interp_checkpoint before;
+    std::vector<double> params(_setup.parameters,
+	    _setup.parameters + interp_param_global::RS274NGC_MAX_PARAMETERS);
+    parameter_map globals = _setup.sub_context[0].named_params;
+    save_checkpoint(before, &params[0]);
+
+    const interp_checkpoint &c = index.checkpoints[k];
+    status = restore_checkpoint(c, false);
+    if (status == INTERP_OK) {
+	restore_checkpoint_subs(index.subs, c.state.line);
+	status = seek_sequence(c.state.line, c.state.offset);
+    }
+    while (status == INTERP_OK
+	    && !(_setup.call_level == 0 && _setup.sequence_number == target)) {
+	status = read();
+	if (status == INTERP_OK)
+	    status = execute();
+	// a deleted block, or a line that waits for the machine
+	if (status == INTERP_EXECUTE_FINISH)
+	    status = INTERP_OK;
+    }
+    if (status != INTERP_OK) {
+	// back to the start, for task to step through the program
+	int lazy = _setup.use_lazy_close;
+	logDebug("seek_line(%d) failed at line %d", line,
+		 _setup.sequence_number);
+	_setup.use_lazy_close = 0;
+	close();
+	_setup.use_lazy_close = lazy;
+	std::copy(params.begin(), params.end(), _setup.parameters);
+	_setup.sub_context[0].named_params = globals;
+	if (open(filename) == INTERP_OK)
+	    restore_checkpoint(before, false);
+	return INTERP_ERROR;
+    }
+    return INTERP_OK;
+}
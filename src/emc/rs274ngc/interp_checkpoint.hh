@@ -0,0 +1,149 @@
+/********************************************************************
+* Description: interp_checkpoint.hh
+*   Checkpoints of the interpreter state, taken between the lines of a
+*   program while 'rs274 -x' scans it, and the index file next to the
+*   program that keeps them.  Running from a line restores the nearest
+*   checkpoint before it and interprets only the lines after that,
+*   instead of every line from the top of the file.
+*
+*   The index starts with an interp_checkpoint_header.  Then come the
+*   checkpoints, ordered by line, each an interp_checkpoint_state
+*   followed by the numbered parameters that differ from the start of
+*   the program, as pairs of an int32 number and a double, and the named
+*   parameters of the main program, as an u32 length, the name with its
+*   NUL, a double and an u32 attribute.  After the checkpoints come the
+*   top level o-word blocks, as pairs of int32 lines, and the
+*   subroutines defined in the program, as a name like a named parameter
+*   followed by an int64 offset and two int32, its line and o-word type.
+*
+*   Values are stored in host byte order; the index is only ever read
+*   on the machine that wrote it.  The header records the size and time
+*   of the program and a hash of everything the interpreter starts a
+*   program with, so an index that no longer fits is not used.
+*
+* License: GPL Version 2
+********************************************************************/
+#ifndef INTERP_CHECKPOINT_HH
+#define INTERP_CHECKPOINT_HH
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include "interp_base.hh"	/* ACTIVE_G_CODES */
+
+#define INTERP_CHECKPOINT_MAGIC "LCNCCKPT"
+#define INTERP_CHECKPOINT_VERSION 1
+
+struct interp_checkpoint_header {
+    char magic[8];		/* INTERP_CHECKPOINT_MAGIC */
+    uint32_t version;		/* INTERP_CHECKPOINT_VERSION */
+    uint32_t size;		/* sizeof(interp_checkpoint_state) */
+    int64_t program_size;	/* of the program when it was scanned */
+    int64_t program_mtime;
+    uint64_t start_hash;	/* Interp::checkpoint_start_hash() */
+    int32_t block_delete;	/* the block delete switch during the scan */
+    int32_t lines;		/* the program ended after this many lines */
+    uint32_t count;		/* checkpoints */
+    uint32_t nblocks;
+    uint32_t nsubs;
+    uint32_t pad;
+};
+
+/* The state between two lines at call level 0, all that decides how
+   the rest of the program is interpreted.  Everything after 'offset'
+   is compared with memcmp, so a state is cleared before it is filled
+   in. */
+struct interp_checkpoint_state {
+    int32_t line;		/* sequence number of the line last read */
+    int32_t pad;
+    int64_t offset;		/* of the next line in the file */
+    double position[9];		/* current_x .. w_current */
+    int32_t g_codes[ACTIVE_G_CODES];	/* write_g_codes() without a block */
+    int32_t m_codes[ACTIVE_M_CODES];
+    double feed_rate;
+    double speed;
+    double tolerance;		/* of G64, as canon has it */
+    double tool_offset[9];
+    double cycle[8];		/* cc, i, j, k, p, q, r, il */
+    double return_value;
+    int32_t motion_mode;
+    int32_t cycle_l;
+    int32_t cycle_il_flag;
+    int32_t tool;		/* in the spindle */
+    int32_t selected_tool;
+    int32_t selected_pocket;
+    int32_t arc_not_allowed;
+    int32_t value_returned;
+};
+
+struct interp_checkpoint_global {
+    std::string name;
+    double value;
+    unsigned attr;
+};
+
+struct interp_checkpoint {
+    interp_checkpoint_state state;
+    std::vector<std::pair<int, double> > params;	/* by number */
+    std::vector<interp_checkpoint_global> globals;	/* by name */
+};
+
+/* the same state, whatever line and offset it was taken at */
+bool operator==(const interp_checkpoint &a, const interp_checkpoint &b);
+inline bool operator!=(const interp_checkpoint &a, const interp_checkpoint &b)
+{
+    return !(a == b);
+}
+
+struct interp_checkpoint_sub {
+    std::string name;
+    int64_t offset;
+    int sequence_number;
+    int type;
+};
+
+struct interp_checkpoint_index {
+    interp_checkpoint_header header;
+    std::vector<interp_checkpoint> checkpoints;
+    /* lines first..last are inside an o-word block of the main
+       program, which no checkpoint or seek may stop in */
+    std::vector<std::pair<int, int> > blocks;
+    std::vector<interp_checkpoint_sub> subs;
+};
+
+/* What a scan of the text of a program finds out before it is
+   interpreted.  Lines are numbered like the interpreter numbers them,
+   counting the line with a leading % but not the blank lines before
+   it. */
+struct interp_program_structure {
+    int first;			/* sequence number after open() */
+    int lines;
+    /* offsets[n] is where the line after line n starts */
+    std::vector<int64_t> offsets;
+    std::vector<std::pair<int, int> > blocks;
+    std::vector<int> tool_changes;	/* lines with an M6 outside blocks */
+    bool subs;			/* o-word subroutines are defined */
+    std::string unsupported;	/* why there can be no index, or empty */
+};
+
+extern int interp_scan_program(const char *filename,
+	interp_program_structure &s);
+extern bool interp_in_block(const std::vector<std::pair<int, int> > &blocks,
+	int line);
+
+/* "<program>.ckpt" */
+extern std::string interp_checkpoint_file(const char *program);
+extern int interp_checkpoint_write_one(FILE *f, const interp_checkpoint &c);
+extern int interp_checkpoint_read_one(FILE *f, interp_checkpoint &c);
+extern int interp_checkpoint_write_sub(FILE *f, const interp_checkpoint_sub &s);
+extern int interp_checkpoint_read_sub(FILE *f, interp_checkpoint_sub &s);
+/* both return 0 on success; write goes through a temporary file that
+   is renamed over 'filename' */
+extern int interp_checkpoint_write(const char *filename,
+	const interp_checkpoint_index &index);
+extern int interp_checkpoint_read(const char *filename,
+	interp_checkpoint_index &index);
+
+#endif
@@ -401,6 +401,10 @@ struct remap_struct {
     const char *remap_py;    // Py function maybe  null, OR
     const char *remap_ngc;   // NGC file, maybe  null
     const char *epilog_func; // Py function or null
+    // PythonPlugin handles for the above, -1 if unset
+    int prolog_handle;
+    int remap_py_handle;
+    int epilog_handle;
 };
 
 
@@ -119,7 +119,8 @@ int Interp::pycall(setup_pointer settings,
 		   context_pointer frame,
 		   const char *module,
 		   const char *funcname,
-		   int calltype)
+		   int calltype,
+		   int handle)
 {
     bp::object retval, function;
     std::string msg;
@@ -179,7 +180,9 @@ int Interp::pycall(setup_pointer settings,
 	}
 	break;
     default:
-	python_plugin->call(module,funcname, frame->pystuff.impl->tupleargs,frame->pystuff.impl->kwargs,retval);
+	if (handle < 0)
+	    handle = python_plugin->resolve(module, funcname);
+	python_plugin->call(handle, frame->pystuff.impl->tupleargs,frame->pystuff.impl->kwargs,retval);
 	CHKS(python_plugin->plugin_status() == PLUGIN_EXCEPTION,
 	     "pycall(%s):\n%s", funcname,
 	     python_plugin->last_exception().c_str());
@@ -362,6 +362,7 @@ int Interp::parse_remap(const char *inistring, int lineno)
     memset((void *)&r, 0, sizeof(remap));
     r.modal_group = -1; // mark as unset, required param for m/g
     r.motion_code = INT_MIN;
+    r.prolog_handle = r.remap_py_handle = r.epilog_handle = -1;
     strcpy(iniline, inistring);
     // strip trailing comments
     if ((s = strchr(iniline, '#')) != NULL) {
@@ -498,6 +499,13 @@ int Interp::parse_remap(const char *inistring, int lineno)
 	goto fail;
     }
 
+    // bind the Python functions once here instead of on every call
+    if (PYUSABLE) {
+	r.prolog_handle = python_plugin->resolve(REMAP_MODULE, r.prolog_func);
+	r.remap_py_handle = python_plugin->resolve(REMAP_MODULE, r.remap_py);
+	r.epilog_handle = python_plugin->resolve(REMAP_MODULE, r.epilog_func);
+    }
+
 #define CHECK(bad, fmt, ...)			\
     do {					\
 	if (bad) {				\
@@ -19,6 +19,7 @@
 #include "rs274ngc.hh"
 #include "interp_internal.hh"
 #include "interp_return.hh"
+#include "interp_checkpoint.hh"
 
 class Interp : public InterpBase {
 
@@ -116,6 +117,7 @@ public:
 
  int line() { return sequence_number(); }
  int call_level();
+ int seek_line(int line);
 
  char *command(char *buf, size_t len) { line_text(buf, len); return buf; }
 
@@ -461,6 +463,16 @@ int read_dollar(char *line, int *counter, block_pointer block,
  int gen_settings(double *current, double *saved, std::string &cmd);
  int gen_g_codes(int *current, int *saved, std::string &cmd);
  int gen_m_codes(int *current, int *saved, std::string &cmd);
+ // checkpoints for running from a line, see interp_checkpoint.hh
+ bool checkpoint_safe();
+ uint64_t checkpoint_start_hash();
+ int save_checkpoint(interp_checkpoint &c, const double *start);
+ int restore_checkpoint(const interp_checkpoint &c, bool tool);
+ int checkpoint_execute(const char *line);
+ void save_checkpoint_subs(std::vector<interp_checkpoint_sub> &subs);
+ void restore_checkpoint_subs(const std::vector<interp_checkpoint_sub> &subs,
+                              int line);
+ int seek_sequence(int sequence_number, long offset);
  int read_name(char *line, int *counter, char *nameBuf);
  int read_named_parameter(char *line, int *counter, double *double_ptr,
                           double *parameters, bool check_exists);
@@ -657,7 +669,8 @@ int read_inputs(setup_pointer settings);
 	       context_pointer frame,
 	       const char *module,
 	       const char *funcname,
-	       int calltype);
+	       int calltype,
+	       int handle = -1);
     int py_execute(const char *cmd, bool as_file = false); // for (py, ....) comments
     int py_reload();
     FILE *find_ngc_file(setup_pointer settings,const char *basename, char *foundhere = NULL);
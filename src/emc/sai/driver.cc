@@ -22,6 +22,7 @@
 #include "rs274ngc_interp.hh"
 #include "rs274ngc_return.hh"
 #include "inifile.hh"		// INIFILE
+#include "emcIniFile.hh"	// EmcIniFile::FindLinearUnits
 #include "canon.hh"		// _parameter_file_name
 #include "config.h"		// LINELEN
 #include "tool_parse.h"
@@ -31,6 +32,13 @@
 #include <getopt.h>
 #include <stdarg.h>
 #include <string>
+#include <vector>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <algorithm>
 
 #include <readline/readline.h>
 #include <readline/history.h>
@@ -284,6 +292,8 @@ int interpret_from_file( /* ARGUMENTS                  */
             continue;
         }
       status = interp_execute();
+      if (status == INTERP_EXECUTE_FINISH)
+        canonbin_synch();
       if ((status != INTERP_OK) &&
           (status != INTERP_EXIT) &&
           (status != INTERP_EXECUTE_FINISH))
@@ -309,6 +319,729 @@ int interpret_from_file( /* ARGUMENTS                  */
 
 /************************************************************************/
 
+/* verify_from_file
+
+Returned Value: int (0 or 1)
+   Returns 1 if the program has an error, 0 otherwise.
+
+Side Effects:
+   An open NC-program file is interpreted without printing canon calls.
+   The error message and line are stored in err and err_line.
+
+Called By:
+   verify_one
+
+This is interpret_from_file with do_next == 2 (stop on error), except
+that errors are collected instead of printed.
+
+*/
+
+int verify_from_file(int block_delete, std::string &err, int &err_line)
+{
+  char buf[LINELEN];
+  int status;
+
+  SET_BLOCK_DELETE(block_delete);
+
+  for(; ;)
+    {
+      status = interp_read();
+      if ((status == INTERP_EXECUTE_FINISH) && (block_delete == ON))
+        continue;
+      else if (status == INTERP_ENDFILE)
+        return 0;
+      if ((status == INTERP_OK) || (status == INTERP_EXECUTE_FINISH))
+        {
+          status = interp_execute();
+          if (status == INTERP_EXIT)
+            return 0;
+          if ((status == INTERP_OK) || (status == INTERP_EXECUTE_FINISH))
+            continue;
+        }
+      error_text(status, buf, LINELEN);
+      err = buf[0] ? buf : "Unknown error, bad error code";
+      err_line = sequence_number();
+      return 1;
+    }
+}
+
+/* json_string
+
+Returned Value: std::string
+   The argument as a quoted JSON string.
+
+*/
+
+static std::string json_string(const std::string &in)
+{
+  std::string out = "\"";
+  for (size_t i = 0; i < in.size(); i++)
+    {
+      unsigned char c = in[i];
+      if (c == '"' || c == '\\')
+        {
+          out += '\\';
+          out += c;
+        }
+      else if (c < 0x20)
+        {
+          char esc[8];
+          snprintf(esc, sizeof(esc), "\\u%04x", c);
+          out += esc;
+        }
+      else
+        out += c;
+    }
+  return out + "\"";
+}
+
+/* verify_one
+
+Returned Value: none, does not return
+
+Side Effects:
+   Runs in a child process forked from verify_files.  The program
+   named by file_name is interpreted and a one line JSON summary is
+   written to fd.  The parameter file is not saved.
+
+*/
+
+static void verify_one(const char *fname, int index, int block_delete, int fd)
+{
+  SaiSummary &sum = _sai_summary;
+  std::string err, out;
+  int err_line = 0;
+  int status;
+  char buf[256];
+
+  reset_summary();
+  status = interp_open(fname);
+  if (status != INTERP_OK)
+    {
+      error_text(status, buf, sizeof(buf));
+      err = buf;
+      status = 1;
+    }
+  else
+    {
+      status = verify_from_file(block_delete, err, err_line);
+      interp_close();
+    }
+
+  snprintf(buf, sizeof(buf), "{\"index\": %d, \"file\": ", index);
+  out = buf;
+  out += json_string(fname);
+  out += status ? ", \"ok\": false, \"error\": " + json_string(err)
+                : ", \"ok\": true, \"error\": null";
+  snprintf(buf, sizeof(buf),
+           ", \"error_line\": %d, \"units\": \"%s\", \"moves\": %ld",
+           err_line,
+           _sai._length_unit_type == CANON_UNITS_INCHES ? "in" : "mm",
+           sum.moves);
+  out += buf;
+  if (sum.have_extents)
+    snprintf(buf, sizeof(buf),
+             ", \"min\": [%.6f, %.6f, %.6f], \"max\": [%.6f, %.6f, %.6f]",
+             sum.min[0], sum.min[1], sum.min[2],
+             sum.max[0], sum.max[1], sum.max[2]);
+  else
+    snprintf(buf, sizeof(buf), ", \"min\": null, \"max\": null");
+  out += buf;
+  out += ", \"tools\": [";
+  for (std::set<int>::iterator it = sum.tools.begin(); it != sum.tools.end(); ++it)
+    {
+      snprintf(buf, sizeof(buf), "%s%d", it == sum.tools.begin() ? "" : ", ", *it);
+      out += buf;
+    }
+  snprintf(buf, sizeof(buf),
+           "], \"feed_length\": %.6f, \"traverse_length\": %.6f"
+           ", \"path_length\": %.6f",
+           sum.feed_length, sum.traverse_length,
+           sum.feed_length + sum.traverse_length);
+  out += buf;
+  snprintf(buf, sizeof(buf),
+           ", \"feed_time\": %.3f, \"traverse_time\": %.3f"
+           ", \"dwell_time\": %.3f, \"estimated_time\": %.3f",
+           sum.feed_time, sum.traverse_time, sum.dwell_time,
+           sum.feed_time + sum.traverse_time + sum.dwell_time);
+  out += buf;
+  snprintf(buf, sizeof(buf),
+           ", \"limit_violations\": %d, \"first_violation_line\": %d}\n",
+           sum.limit_violations, sum.first_violation_line);
+  out += buf;
+
+  const char *p = out.c_str();
+  size_t left = out.size();
+  while (left > 0)
+    {
+      ssize_t r = write(fd, p, left);
+      if (r < 0 && errno == EINTR)
+        continue;
+      if (r <= 0)
+        break;
+      p += r;
+      left -= r;
+    }
+  close(fd);
+  _exit(status);
+}
+
+/* verify_files
+
+Returned Value: int
+   The number of programs that failed verification.
+
+Side Effects:
+   One JSON summary line per program is printed on stdout, in the
+   order the programs finish.
+
+Called By: main
+
+Each program is interpreted in its own process, at most 'jobs' at a
+time.  The processes are forked after interp_init(), so reading the ini
+file, the tool table and initializing the python plugin are done only
+once and shared copy-on-write by every program.
+
+*/
+
+static int verify_files(int jobs, int nfiles, char **files, int block_delete)
+{
+  struct job { pid_t pid; int fd; int index; };
+  std::vector<job> running;
+  int next = 0, failed = 0;
+
+  fflush(stdout);
+  fflush(stderr);
+  while (next < nfiles || !running.empty())
+    {
+      while (next < nfiles && (int) running.size() < jobs)
+        {
+          int fds[2];
+          if (pipe(fds) < 0)
+            {
+              perror("pipe");
+              return nfiles;
+            }
+          pid_t pid = fork();
+          if (pid < 0)
+            {
+              perror("fork");
+              return nfiles;
+            }
+          if (pid == 0)
+            {
+              close(fds[0]);
+              verify_one(files[next], next, block_delete, fds[1]);
+            }
+          close(fds[1]);
+          running.push_back(job{pid, fds[0], next});
+          next++;
+        }
+
+      int wstatus;
+      pid_t pid = waitpid(-1, &wstatus, 0);
+      if (pid < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          perror("waitpid");
+          return nfiles;
+        }
+      for (size_t i = 0; i < running.size(); i++)
+        {
+          if (running[i].pid != pid)
+            continue;
+          /* the summary is far smaller than a pipe buffer, so the
+             child has written all of it before exiting */
+          char buf[4096];
+          ssize_t r;
+          bool any = false;
+          while ((r = read(running[i].fd, buf, sizeof(buf))) > 0)
+            {
+              fwrite(buf, 1, r, stdout);
+              any = true;
+            }
+          if (!any)
+            printf("{\"index\": %d, \"ok\": false, \"error\": "
+                   "\"interpreter process died\"}\n", running[i].index);
+          fflush(stdout);
+          if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0)
+            failed++;
+          close(running[i].fd);
+          running.erase(running.begin() + i);
+          break;
+        }
+    }
+  return failed;
+}
+
+/* Checkpoints for running from a line, see interp_checkpoint.hh.  One
+   is taken every PRESCAN_INTERVAL lines and at the chunk boundaries,
+   wherever the interpreter is at a state it can be restored to. */
+#define PRESCAN_INTERVAL 1000
+
+/* how a chunk of the pre-scan ended */
+enum { PRESCAN_CHUNK_DONE, PRESCAN_PROGRAM_END, PRESCAN_ERROR };
+
+static bool prescan_checkpoint_line(int line, const std::vector<int> &bounds)
+{
+  return line % PRESCAN_INTERVAL == 0
+      || std::binary_search(bounds.begin(), bounds.end(), line);
+}
+
+/* prescan_step
+
+Returned Value: int
+   INTERP_OK after a line is read and executed, INTERP_ENDFILE or
+   INTERP_EXIT at the end of the program, otherwise the error.
+
+This is one pass of the loop of interpret_from_file.
+
+*/
+
+static int prescan_step(int block_delete)
+{
+  int status = interp_read();
+  if ((status == INTERP_EXECUTE_FINISH) && (block_delete == ON))
+    return INTERP_OK;
+  if ((status != INTERP_OK) && (status != INTERP_EXECUTE_FINISH))
+    return status;
+  status = interp_execute();
+  if (status == INTERP_EXECUTE_FINISH)
+    return INTERP_OK;
+  return status;
+}
+
+/* prescan_bounds
+
+Returned Value: std::vector<int>
+   The lines the chunks of the program start after, ending with its
+   last line.
+
+The program is cut into about as many even chunks as there are jobs,
+but none shorter than ten checkpoint intervals.  A cut goes before a
+tool change near the even point if there is one, since a new
+operation seldom depends on the modal state the last one left, and
+never inside an o-word block.  A program that defines subroutines is
+one chunk, as a chunk cannot know the subroutines defined before it.
+
+*/
+
+static std::vector<int> prescan_bounds(const interp_program_structure &s,
+                                       int jobs)
+{
+  std::vector<int> bounds;
+  int n = s.subs ? 1 : std::min(jobs, s.lines / (10 * PRESCAN_INTERVAL));
+  int length = s.lines - s.first;
+
+  if (n < 1)
+    n = 1;
+  bounds.push_back(s.first);
+  for (int k = 1; k < n; k++)
+    {
+      int even = s.first + (int) ((long) length * k / n);
+      int slack = length / (4 * n);
+      int best = -1;
+      for (size_t i = 0; i < s.tool_changes.size(); i++)
+        {
+          int b = s.tool_changes[i] - 1;
+          if (abs(b - even) <= slack && (best < 0 || abs(b - even) < abs(best - even)))
+            best = b;
+        }
+      if (best < 0)
+        best = even;
+      while (best > bounds.back() && interp_in_block(s.blocks, best))
+        best--;
+      if (best > bounds.back() && best < s.lines)
+        bounds.push_back(best);
+    }
+  bounds.push_back(s.lines);
+  return bounds;
+}
+
+/* prescan_chunk
+
+Returned Value: none, does not return
+
+Side Effects:
+   Runs in a child process forked from prescan.  Interprets chunk k of
+   the program from the state at its start and writes to out how the
+   chunk ended, the checkpoints taken and the subroutines defined.
+
+For every chunk but the first, the state at the start is not known:
+the chunk starts from the state after interp_open(), as if the lines
+before it were not there.  The first checkpoint written is that
+assumed state, for prescan to compare with the real one.
+
+*/
+
+static void prescan_chunk(const char *fname, const interp_program_structure &s,
+                          const std::vector<int> &bounds, int k,
+                          const double *start, int block_delete, FILE *out)
+{
+  Interp *interp = (Interp *) pinterp;
+  std::vector<interp_checkpoint> records;
+  std::vector<interp_checkpoint_sub> subs;
+  interp_checkpoint c;
+  int32_t result = PRESCAN_ERROR;
+  int status;
+
+  status = interp_open(fname);
+  if (status == INTERP_OK && k > 0)
+    status = interp->seek_sequence(bounds[k], s.offsets[bounds[k]]);
+  if (status == INTERP_OK)
+    {
+      interp->save_checkpoint(c, start);
+      records.push_back(c);
+      for (;;)
+        {
+          status = prescan_step(block_delete);
+          if ((status == INTERP_ENDFILE) || (status == INTERP_EXIT))
+            {
+              result = PRESCAN_PROGRAM_END;
+              break;
+            }
+          if (status != INTERP_OK)
+            break;
+          if (interp->call_level() != 0)
+            continue;
+          int line = sequence_number();
+          if (prescan_checkpoint_line(line, bounds)
+              && !interp_in_block(s.blocks, line) && interp->checkpoint_safe())
+            {
+              interp->save_checkpoint(c, start);
+              records.push_back(c);
+            }
+          if (line >= bounds[k + 1])
+            {
+              result = PRESCAN_CHUNK_DONE;
+              break;
+            }
+        }
+      interp->save_checkpoint_subs(subs);
+    }
+
+  uint32_t count = records.size(), nsubs = subs.size();
+  fwrite(&result, sizeof(result), 1, out);
+  fwrite(&count, sizeof(count), 1, out);
+  for (size_t i = 0; i < records.size(); i++)
+    interp_checkpoint_write_one(out, records[i]);
+  fwrite(&nsubs, sizeof(nsubs), 1, out);
+  for (size_t i = 0; i < subs.size(); i++)
+    interp_checkpoint_write_sub(out, subs[i]);
+  _exit(fflush(out) == 0 && !ferror(out) ? 0 : 1);
+}
+
+struct prescan_result {
+  int32_t result;
+  std::vector<interp_checkpoint> records;
+  std::vector<interp_checkpoint_sub> subs;
+};
+
+static int prescan_read(FILE *in, prescan_result &r)
+{
+  uint32_t count, nsubs;
+
+  rewind(in);
+  if (fread(&r.result, sizeof(r.result), 1, in) != 1
+      || fread(&count, sizeof(count), 1, in) != 1)
+    return -1;
+  r.records.resize(count);
+  for (uint32_t i = 0; i < count; i++)
+    if (interp_checkpoint_read_one(in, r.records[i]) != 0)
+      return -1;
+  if (fread(&nsubs, sizeof(nsubs), 1, in) != 1)
+    return -1;
+  r.subs.resize(nsubs);
+  for (uint32_t i = 0; i < nsubs; i++)
+    if (interp_checkpoint_read_sub(in, r.subs[i]) != 0)
+      return -1;
+  return 0;
+}
+
+/* the checkpoint a chunk took at line, or NULL */
+static const interp_checkpoint *prescan_find(const prescan_result &r, int line,
+                                             size_t *index)
+{
+  for (size_t i = 0; i < r.records.size(); i++)
+    if (r.records[i].state.line == line)
+      {
+        *index = i;
+        return &r.records[i];
+      }
+  return NULL;
+}
+
+/* prescan
+
+Returned Value: int
+   0 if the checkpoint index of the program was written, 1 otherwise.
+
+Side Effects:
+   Writes the checkpoint index next to the program and prints a line
+   about it on stdout.
+
+Called By: main
+
+The chunks of the program are interpreted at once, each in its own
+process forked after interp_init().  The checkpoints of the first
+chunk are exact.  A later chunk is only right if the state it assumed
+at its start is the state the chunk before it ended with; where it is
+not, the program is interpreted again from the last exact checkpoint
+until the state is the same as a chunk's at one of its checkpoints,
+and from there on that chunk's checkpoints are taken as they are.  As
+the state is all the interpreter goes on, that chunk interprets the
+rest of its lines exactly as running the program would.  Most
+programs set their modes again after every tool change, so the
+chunks soon agree and little is interpreted twice.
+
+*/
+
+static int prescan(const char *fname, int jobs, int block_delete)
+{
+  Interp *interp = dynamic_cast<Interp *>(pinterp);
+  interp_program_structure s;
+  interp_checkpoint_index index;
+  std::string ckpt = interp_checkpoint_file(fname);
+  struct stat st;
+  int status;
+
+  if (!interp)
+    {
+      fprintf(stderr, "rs274: -x needs the rs274ngc interpreter\n");
+      return 1;
+    }
+  if (interp_scan_program(fname, s) != 0 || stat(fname, &st) != 0)
+    {
+      fprintf(stderr, "rs274: cannot read %s\n", fname);
+      return 1;
+    }
+  if (!s.unsupported.empty())
+    {
+      fprintf(stderr, "rs274: no checkpoints for %s: %s\n", fname,
+              s.unsupported.c_str());
+      return 1;
+    }
+
+  SET_BLOCK_DELETE(block_delete);
+  status = interp_open(fname);
+  if (status != INTERP_OK)
+    {
+      report_error(status, OFF);
+      return 1;
+    }
+  std::vector<double> start(interp->_setup.parameters,
+      interp->_setup.parameters + interp_param_global::RS274NGC_MAX_PARAMETERS);
+  parameter_map globals = interp->_setup.sub_context[0].named_params;
+  memset(&index.header, 0, sizeof(index.header));
+  index.header.program_size = st.st_size;
+  index.header.program_mtime = st.st_mtime;
+  index.header.start_hash = interp->checkpoint_start_hash();
+  index.header.block_delete = block_delete == ON ? 1 : 0;
+  index.header.lines = s.lines;
+  interp_close();
+
+  std::vector<int> bounds = prescan_bounds(s, jobs);
+  int n = bounds.size() - 1;
+  std::vector<prescan_result> chunks(n);
+  std::vector<pid_t> pids(n);
+  std::vector<FILE *> outs(n);
+
+  fflush(stdout);
+  fflush(stderr);
+  for (int k = 0; k < n; k++)
+    {
+      outs[k] = tmpfile();
+      if (outs[k] == NULL)
+        {
+          perror("tmpfile");
+          return 1;
+        }
+      pids[k] = fork();
+      if (pids[k] < 0)
+        {
+          perror("fork");
+          return 1;
+        }
+      if (pids[k] == 0)
+        prescan_chunk(fname, s, bounds, k, &start[0], block_delete, outs[k]);
+    }
+  for (int k = 0; k < n; k++)
+    {
+      int wstatus;
+      while (waitpid(pids[k], &wstatus, 0) < 0)
+        {
+          if (errno != EINTR)
+            {
+              perror("waitpid");
+              return 1;
+            }
+        }
+      /* a chunk that died is redone below like one that was wrong */
+      if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0
+          || prescan_read(outs[k], chunks[k]) != 0)
+        {
+          chunks[k].result = PRESCAN_ERROR;
+          chunks[k].records.clear();
+        }
+      fclose(outs[k]);
+    }
+
+  std::vector<interp_checkpoint> &exact = index.checkpoints;
+  bool open = false;
+  long again = 0;       /* lines interpreted a second time */
+  int k = 0;
+  exact = chunks[0].records;
+  for (;;)
+    {
+      if (!exact.empty() && chunks[k].result == PRESCAN_CHUNK_DONE)
+        {
+          if (++k == n)
+            break;
+          const interp_checkpoint &last = exact.back();
+          if (last.state.line == bounds[k] && !chunks[k].records.empty()
+              && chunks[k].records[0] == last)
+            {
+              exact.insert(exact.end(), chunks[k].records.begin() + 1,
+                           chunks[k].records.end());
+              continue;
+            }
+        }
+      else if (!exact.empty() && chunks[k].result == PRESCAN_PROGRAM_END)
+        break;
+
+      /* from the last exact checkpoint on, until a chunk has the same
+         state; this also finds the error a chunk stopped at */
+      if (open)
+        interp_close();
+      std::copy(start.begin(), start.end(), interp->_setup.parameters);
+      interp->_setup.sub_context[0].named_params = globals;
+      status = interp_open(fname);
+      open = true;
+      if (status == INTERP_OK && !exact.empty())
+        {
+          const interp_checkpoint &last = exact.back();
+          status = interp->restore_checkpoint(last, true);
+          if (status == INTERP_OK)
+            status = interp->seek_sequence(last.state.line, last.state.offset);
+        }
+      if (status != INTERP_OK)
+        {
+          report_error(status, OFF);
+          interp_close();
+          return 1;
+        }
+      if (exact.empty())
+        {
+          interp_checkpoint c;
+          interp->save_checkpoint(c, &start[0]);
+          exact.push_back(c);
+        }
+      bool joined = false, ended = false;
+      while (!joined)
+        {
+          status = prescan_step(block_delete);
+          if ((status == INTERP_ENDFILE) || (status == INTERP_EXIT))
+            {
+              ended = true;
+              break;
+            }
+          if (status != INTERP_OK)
+            {
+              report_error(status, OFF);
+              fprintf(stderr, "rs274: %s was not written\n", ckpt.c_str());
+              interp_close();
+              return 1;
+            }
+          again++;
+          if (interp->call_level() != 0)
+            continue;
+          int line = sequence_number();
+          while (k < n - 1 && line > bounds[k + 1])
+            k++;
+          if (!prescan_checkpoint_line(line, bounds)
+              || interp_in_block(s.blocks, line) || !interp->checkpoint_safe())
+            continue;
+          interp_checkpoint c;
+          interp->save_checkpoint(c, &start[0]);
+          exact.push_back(c);
+          for (int j = k; j <= k + 1 && j < n && !joined; j++)
+            {
+              size_t i;
+              const interp_checkpoint *w = prescan_find(chunks[j], line, &i);
+              if (w && *w == c)
+                {
+                  exact.insert(exact.end(), chunks[j].records.begin() + i + 1,
+                               chunks[j].records.end());
+                  k = j;
+                  joined = true;
+                }
+            }
+        }
+      if (ended)
+        break;
+    }
+  if (open)
+    interp_close();
+
+  index.blocks = s.blocks;
+  if (n == 1)
+    index.subs = chunks[0].subs;
+  if (interp_checkpoint_write(ckpt.c_str(), index) != 0)
+    {
+      fprintf(stderr, "rs274: %s was not written\n", ckpt.c_str());
+      return 1;
+    }
+  printf("%s: %zu checkpoints, %d lines in %d chunks, %ld lines interpreted again\n",
+         ckpt.c_str(), exact.size(), s.lines, n, again);
+  return 0;
+}
+
+/* load_machine_limits
+
+Side Effects:
+   The velocity, acceleration and XYZ soft limits used for the program
+   summaries are read from the ini file and converted to mm.
+
+Called By: main
+
+*/
+
+static void load_machine_limits(const char *inifile)
+{
+  EmcIniFile ini;
+  EmcLinearUnits units = 1.0;   // units per mm
+  double d;
+  const char *axes = "XYZ";
+
+  if (!inifile || !ini.Open(inifile))
+    return;
+  ini.FindLinearUnits(&units, "LINEAR_UNITS", "TRAJ");
+  if (units <= 0)
+    units = 1.0;
+  if (ini.Find(&d, "MAX_LINEAR_VELOCITY", "TRAJ") == IniFile::ERR_NONE)
+    _sai_summary.max_velocity = d / units;
+  if (ini.Find(&d, "MAX_LINEAR_ACCELERATION", "TRAJ") == IniFile::ERR_NONE ||
+      ini.Find(&d, "DEFAULT_LINEAR_ACCELERATION", "TRAJ") == IniFile::ERR_NONE)
+    _sai_summary.max_acceleration = d / units;
+  for (int i = 0; i < 3; i++)
+    {
+      char section[16];
+      double lo, hi;
+      snprintf(section, sizeof(section), "AXIS_%c", axes[i]);
+      if (ini.Find(&lo, "MIN_LIMIT", section) == IniFile::ERR_NONE &&
+          ini.Find(&hi, "MAX_LIMIT", section) == IniFile::ERR_NONE)
+        {
+          _sai_summary.have_limits[i] = true;
+          _sai_summary.limit_min[i] = lo / units;
+          _sai_summary.limit_max[i] = hi / units;
+        }
+    }
+  ini.Close();
+}
+
+/************************************************************************/
+
 /* read_tool_file
 
 Returned Value: int
@@ -549,6 +1282,10 @@ int main (int argc, char ** argv)
   char *inifile = NULL;
   int log_level = -1;
   std::string interp;
+  int batch = 0;
+  int jobs = 0;
+  char *compile = NULL;
+  int prescan_jobs = -1;
 
   do_next = 2;  /* 2=stop */
   block_delete = OFF;
@@ -559,7 +1296,7 @@ int main (int argc, char ** argv)
   go_flag = 0;
 
   while(1) {
-      int c = getopt(argc, argv, "p:t:v:bsn:gi:l:T");
+      int c = getopt(argc, argv, "p:t:v:bsn:gi:l:Tj:c:x:");
       if(c == -1) break;
 
       switch(c) {
@@ -573,16 +1310,27 @@ int main (int argc, char ** argv)
           case 'g': go_flag = !go_flag; break;
           case 'i': inifile = optarg; break;
           case 'T': _task = 1; break;
+          case 'j': batch = 1; jobs = atoi(optarg); go_flag = 1; break;
+          case 'c': compile = optarg; go_flag = 1; break;
+          case 'x': prescan_jobs = atoi(optarg); go_flag = 1; break;
           case '?': default: goto usage;
       }
   }
 
-  if (argc - optind > 3)
+  if ((batch && argc == optind) || (!batch && argc - optind > 3)
+      || (compile && (batch || argc - optind != 1))
+      || (prescan_jobs >= 0 && (batch || compile || argc - optind != 1)))
     {
 usage:
       fprintf(stderr,
             "Usage: %s [-p interp.so] [-t tool.tbl] [-v var-file.var] [-n 0|1|2]\n"
             "          [-b] [-s] [-g] [input file [output file]]\n"
+            "       %s [-p interp.so] [-t tool.tbl] [-v var-file.var] [-b]\n"
+            "          [-i inifile] -j jobs input file ...\n"
+            "       %s [-p interp.so] [-t tool.tbl] [-v var-file.var] [-b]\n"
+            "          [-i inifile] -c output.ncb input file\n"
+            "       %s [-p interp.so] [-t tool.tbl] [-v var-file.var] [-b]\n"
+            "          [-i inifile] -x jobs input file\n"
             "\n"
             "    -p: Specify the pluggable interpreter to use\n"
             "    -t: Specify the .tbl (tool table) file to use\n"
@@ -597,7 +1345,16 @@ usage:
             "    -i: specify the .ini file (default: no ini file)\n"
             "    -T: call task_init()\n"
             "    -l: specify the log_level (default: -1)\n"
-            , argv[0]);
+            "    -j: verify all input files, running up to 'jobs' at once\n"
+            "        (0 = one per cpu), and print a JSON summary line\n"
+            "        for each instead of the canon calls\n"
+            "    -c: write the canon calls of the input file to a compiled\n"
+            "        canon stream that canterp can replay, instead of\n"
+            "        printing them\n"
+            "    -x: write the checkpoint index that lets task run the input\n"
+            "        file from a line quickly, scanning it with up to 'jobs'\n"
+            "        processes (0 = one per cpu)\n"
+            , argv[0], argv[0], argv[0], argv[0]);
       exit(1);
     }
 
@@ -649,7 +1406,7 @@ usage:
   argc = argc - optind + 1;
   argv = argv + optind - 1;
 
-  if (argc == 3)
+  if (argc == 3 && !batch)
     {
       _outfile = fopen(argv[2], "w");
       if (_outfile == NULL)
@@ -663,15 +1420,52 @@ usage:
   } else
       unsetenv("INI_FILE_NAME");
 
+  if (batch)
+    {
+      _sai_summary.quiet = true;
+      load_machine_limits(inifile);
+    }
+  if (prescan_jobs >= 0)
+    _sai_summary.quiet = true;
+
+  /* opened before interp_init() so the stream starts with the offsets
+     and units the interpreter sets up from the parameter file */
+  if (compile)
+    {
+      _sai_summary.quiet = true;
+      if (canonbin_open(compile) != 0)
+        exit(1);
+    }
+
   if ((status = interp_init()) != INTERP_OK)
     {
       report_error(status, print_stack);
+      canonbin_close(false);
       exit(1);
     }
 
   if (log_level != -1)
       interp_set_loglevel(log_level);
 
+  if (batch)
+    {
+      if (jobs <= 0)
+        jobs = sysconf(_SC_NPROCESSORS_ONLN);
+      if (jobs <= 0)
+        jobs = 1;
+      status = verify_files(jobs, argc - 1, argv + 1, block_delete);
+      exit(status ? 1 : 0);
+    }
+
+  if (prescan_jobs >= 0)
+    {
+      if (prescan_jobs == 0)
+        prescan_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+      if (prescan_jobs <= 0)
+        prescan_jobs = 1;
+      status = prescan(argv[1], prescan_jobs, block_delete);
+      exit(status);
+    }
 
   if (argc == 1)
     status = interpret_from_keyboard(block_delete, print_stack);
@@ -681,12 +1475,18 @@ usage:
       if (status != INTERP_OK) /* do not need to close since not open */
         {
           report_error(status, print_stack);
+          canonbin_close(false);
           exit(1);
         }
       status = interpret_from_file(do_next, block_delete, print_stack);
       file_name(buffer, 5);  /* called to exercise the function */
       file_name(buffer, 79); /* called to exercise the function */
       interp_close();
+      if (compile && canonbin_close(status == 0) != 0)
+        {
+          fprintf(stderr, "rs274: %s was not written\n", compile);
+          status = 1;
+        }
     }
   line_length();         /* called to exercise the function */
   sequence_number();     /* called to exercise the function */
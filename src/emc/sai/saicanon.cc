@@ -40,8 +40,13 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <unistd.h>
+#include <initializer_list>
+#include <vector>
+#include "emc/canterp/canonbin.hh"
 
 StandaloneInterpInternals _sai = StandaloneInterpInternals();
+SaiSummary _sai_summary;
 
 char               _parameter_file_name[PARAMETER_FILE_NAME_LENGTH];
 
@@ -103,16 +108,294 @@ void print_nc_line_number()
 
 #define PRINT(control, ...) do \
 { \
+    if (_sai_summary.quiet) break; \
     _outfile = _outfile ?: stdout; \
     fprintf(_outfile,  "%5d ", _sai._line_number++); \
     print_nc_line_number(); \
     fprintf(_outfile, control, ##__VA_ARGS__); \
 } while (false)
 
+/* Compiled canon stream (rs274 -c)
+
+Each call that canterp can replay is also appended to the stream, tagged
+with the line and call level the interpreter is at.  Calls whose outcome
+depends on the machine, like probing or reading inputs, cannot be
+replayed; they mark the stream as unusable and canonbin_close() fails.
+
+*/
+
+static FILE *_canonbin = nullptr;
+static std::string _canonbin_name;
+static uint64_t _canonbin_offset;
+static bool _canonbin_failed;
+static int _canonbin_line, _canonbin_level;
+static std::vector<canonbin_index> _canonbin_index;
+
+static void canonbin_write(const void *data, size_t size)
+{
+  if (fwrite(data, 1, size, _canonbin) != size)
+    _canonbin_failed = true;
+  _canonbin_offset += size;
+}
+
+static void canonbin_call(canonbin_op op,
+                          std::initializer_list<double> doubles = {},
+                          std::initializer_list<int> ints = {},
+                          const char *string = nullptr)
+{
+  if (!_canonbin)
+    return;
+  const canonbin_op_info &info = canonbin_ops[op];
+  if (info.string && !string)
+    string = "";
+  uint32_t length = string ? strlen(string) : 0;
+  uint64_t start = _canonbin_offset;
+  canonbin_record r;
+
+  r.op = op;
+  r.level = pinterp->call_level();
+  r.ndoubles = info.ndoubles;
+  while (r.ndoubles && doubles.begin()[r.ndoubles - 1] == 0
+         && !signbit(doubles.begin()[r.ndoubles - 1]))
+    r.ndoubles--;
+  r.nints = info.nints;
+  r.line = pinterp->line();
+  /* the index has the first record of every top level line */
+  if (r.level == 0 && (r.line != _canonbin_line || _canonbin_level != 0))
+    _canonbin_index.push_back({r.line, 0, start});
+  _canonbin_line = r.line;
+  _canonbin_level = r.level;
+
+  canonbin_write(&r, sizeof(r));
+  canonbin_write(doubles.begin(), r.ndoubles * sizeof(double));
+  for (int i : ints)
+    {
+      int32_t i32 = i;
+      canonbin_write(&i32, sizeof(i32));
+    }
+  if (info.string)
+    {
+      canonbin_write(&length, sizeof(length));
+      canonbin_write(string, length + 1);
+    }
+  static const char pad[8] = {0};
+  canonbin_write(pad, start + canonbin_record_size(r, length) - _canonbin_offset);
+}
+
+static void canonbin_unsupported(const char *call)
+{
+  if (!_canonbin || _canonbin_failed)
+    return;
+  fprintf(stderr, "rs274: the program uses %s at line %d, which cannot be compiled\n",
+          call, pinterp->line());
+  _canonbin_failed = true;
+}
+
+int canonbin_open(const char *filename)
+{
+  canonbin_header h;
+
+  _canonbin = fopen(filename, "wb");
+  if (!_canonbin)
+    {
+      fprintf(stderr, "rs274: could not open %s: %s\n", filename, strerror(errno));
+      return -1;
+    }
+  _canonbin_name = filename;
+  _canonbin_offset = 0;
+  _canonbin_failed = false;
+  _canonbin_line = -1;
+  _canonbin_level = -1;
+  _canonbin_index.clear();
+  memcpy(h.magic, CANONBIN_MAGIC, sizeof(h.magic));
+  h.version = CANONBIN_VERSION;
+  h.size = sizeof(h);
+  canonbin_write(&h, sizeof(h));
+  return 0;
+}
+
+void canonbin_synch()
+{
+  canonbin_call(CB_SYNCH);
+}
+
+int canonbin_close(bool ok)
+{
+  canonbin_footer f;
+
+  if (!_canonbin)
+    return 0;
+  canonbin_call(CB_END);
+  f.index_offset = _canonbin_offset;
+  f.index_count = _canonbin_index.size();
+  f.pad = 0;
+  memcpy(f.magic, CANONBIN_INDEX_MAGIC, sizeof(f.magic));
+  if (!_canonbin_index.empty())
+    canonbin_write(_canonbin_index.data(),
+                   _canonbin_index.size() * sizeof(canonbin_index));
+  canonbin_write(&f, sizeof(f));
+  if (fclose(_canonbin) != 0)
+    _canonbin_failed = true;
+  _canonbin = nullptr;
+  if (ok && !_canonbin_failed)
+    return 0;
+  unlink(_canonbin_name.c_str());
+  return -1;
+}
+
+/* Program summary
+
+Moves are accounted from the current program position to the end point
+given, before the world model is updated.  The time estimate assumes a
+trapezoidal velocity profile that comes to a stop at the end of every
+move, so it is an upper bound for programs that blend.
+
+*/
+
+static double move_time(double length, double vel, double acc)
+{
+  if (length <= 0 || vel <= 0)
+    return 0;
+  if (acc <= 0)
+    return length / vel;
+  if (length >= vel * vel / acc)
+    return length / vel + vel / acc;
+  return 2 * sqrt(length / acc);
+}
+
+static void account_point(double x, double y, double z)
+{
+  SaiSummary &s = _sai_summary;
+  double p[3] = {x, y, z};
+  double off[3] = {_sai._g5x_x + _sai._g92_x,
+                   _sai._g5x_y + _sai._g92_y,
+                   _sai._g5x_z + _sai._g92_z + _sai._tool_offset.tran.z};
+  bool violation = false;
+
+  for (int i = 0; i < 3; i++)
+    {
+      if (!s.have_extents || p[i] < s.min[i]) s.min[i] = p[i];
+      if (!s.have_extents || p[i] > s.max[i]) s.max[i] = p[i];
+      if (s.have_limits[i])
+        {
+          double m = (p[i] + off[i]) * _sai._length_unit_factor;
+          if (m < s.limit_min[i] || m > s.limit_max[i])
+            violation = true;
+        }
+    }
+  s.have_extents = true;
+  if (violation)
+    {
+      if (s.limit_violations++ == 0)
+        s.first_violation_line = pinterp->sequence_number();
+    }
+}
+
+static void account_move(bool feed, double length, double x, double y, double z)
+{
+  SaiSummary &s = _sai_summary;
+  /* machine limits are in mm, moves in program units */
+  double max_vel = s.max_velocity / _sai._length_unit_factor;
+  double max_acc = s.max_acceleration / _sai._length_unit_factor;
+
+  s.moves++;
+  if (feed)
+    {
+      double vel = _sai._feed_rate / 60.;
+      if (max_vel > 0 && (vel <= 0 || vel > max_vel))
+        vel = max_vel;
+      s.feed_length += length;
+      s.feed_time += move_time(length, vel, max_acc);
+    }
+  else
+    {
+      double vel = _sai._traverse_rate;
+      if (max_vel > 0 && (vel <= 0 || vel > max_vel))
+        vel = max_vel;
+      s.traverse_length += length;
+      s.traverse_time += move_time(length, vel, max_acc);
+    }
+  account_point(x, y, z);
+}
+
+static void account_line(bool feed, double x, double y, double z)
+{
+  if (!_sai_summary.quiet)
+    return;
+  if (_sai_summary.moves == 0 && !_sai_summary.have_extents)
+    account_point(_sai._program_position_x, _sai._program_position_y,
+                  _sai._program_position_z);
+  account_move(feed,
+               hypot(hypot(x - _sai._program_position_x,
+                           y - _sai._program_position_y),
+                     z - _sai._program_position_z),
+               x, y, z);
+}
+
+/* arcs are given in the coordinates of the active plane: p1/p2 in the
+   plane, p3 along its normal; intermediate points are accounted so the
+   extents include the bulge of the arc */
+static void plane_to_xyz(double p1, double p2, double p3,
+                         double *x, double *y, double *z)
+{
+  if (_sai._active_plane == CANON_PLANE_XY)
+    { *x = p1; *y = p2; *z = p3; }
+  else if (_sai._active_plane == CANON_PLANE_YZ)
+    { *y = p1; *z = p2; *x = p3; }
+  else /* CANON_PLANE_XZ */
+    { *z = p1; *x = p2; *y = p3; }
+}
+
+static void account_arc(double p1_end, double p2_end, double p3_end,
+                        double c1, double c2, int rotation)
+{
+  double p1, p2, p3, x, y, z;
+  double r, a0, a1, sweep;
+  int steps;
+
+  if (!_sai_summary.quiet)
+    return;
+  if (_sai._active_plane == CANON_PLANE_XY)
+    { p1 = _sai._program_position_x; p2 = _sai._program_position_y;
+      p3 = _sai._program_position_z; }
+  else if (_sai._active_plane == CANON_PLANE_YZ)
+    { p1 = _sai._program_position_y; p2 = _sai._program_position_z;
+      p3 = _sai._program_position_x; }
+  else
+    { p1 = _sai._program_position_z; p2 = _sai._program_position_x;
+      p3 = _sai._program_position_y; }
+  r = hypot(p1 - c1, p2 - c2);
+  a0 = atan2(p2 - c2, p1 - c1);
+  a1 = atan2(p2_end - c2, p1_end - c1);
+  if (rotation > 0)
+    {
+      if (a1 <= a0) a1 += 2 * M_PI;
+      sweep = (a1 - a0) + 2 * M_PI * (rotation - 1);
+    }
+  else
+    {
+      if (a1 >= a0) a1 -= 2 * M_PI;
+      sweep = (a1 - a0) - 2 * M_PI * (-rotation - 1);
+    }
+  /* one point every 5 degrees is plenty for extents */
+  steps = (int) ceil(fabs(sweep) / (M_PI / 36));
+  for (int i = 1; i < steps; i++)
+    {
+      double t = (double) i / steps;
+      double a = a0 + sweep * t;
+      plane_to_xyz(c1 + r * cos(a), c2 + r * sin(a),
+                   p3 + (p3_end - p3) * t, &x, &y, &z);
+      account_point(x, y, z);
+    }
+  plane_to_xyz(p1_end, p2_end, p3_end, &x, &y, &z);
+  account_move(true, hypot(r * sweep, p3_end - p3), x, y, z);
+}
+
 /* Representation */
 
 void SET_XY_ROTATION(double t) {
   ECHO_WITH_ARGS("%.4f", t);
+  canonbin_call(CB_SET_XY_ROTATION, {t});
 }
 
 void SET_G5X_OFFSET(int index,
@@ -122,6 +405,7 @@ void SET_G5X_OFFSET(int index,
 
   ECHO_WITH_ARGS("%d, %.4f, %.4f, %.4f, %.4f, %.4f, %.4f",
           index, x, y, z, a, b, c);
+  canonbin_call(CB_SET_G5X_OFFSET, {x, y, z, a, b, c, u, v, w}, {index});
   _sai._program_position_x = _sai._program_position_x + _sai._g5x_x - x;
   _sai._program_position_y = _sai._program_position_y + _sai._g5x_y - y;
   _sai._program_position_z = _sai._program_position_z + _sai._g5x_z - z;
@@ -142,6 +426,7 @@ void SET_G92_OFFSET(double x, double y, double z,
                     double u, double v, double w) {
   ECHO_WITH_ARGS("%.4f, %.4f, %.4f, %.4f, %.4f, %.4f",
                       x, y, z, a, b, c);
+  canonbin_call(CB_SET_G92_OFFSET, {x, y, z, a, b, c, u, v, w});
   _sai._program_position_x = _sai._program_position_x + _sai._g92_x - x;
   _sai._program_position_y = _sai._program_position_y + _sai._g92_y - y;
   _sai._program_position_z = _sai._program_position_z + _sai._g92_z - z;
@@ -159,6 +444,7 @@ void SET_G92_OFFSET(double x, double y, double z,
 
 void USE_LENGTH_UNITS(CANON_UNITS in_unit)
 {
+  canonbin_call(CB_USE_LENGTH_UNITS, {}, {in_unit});
   if (in_unit == CANON_UNITS_INCHES)
     {
       PRINT("USE_LENGTH_UNITS(CANON_UNITS_INCHES)\n");
@@ -209,6 +495,7 @@ void USE_LENGTH_UNITS(CANON_UNITS in_unit)
 void SET_TRAVERSE_RATE(double rate)
 {
   PRINT("SET_TRAVERSE_RATE(%.4f)\n", rate);
+  canonbin_call(CB_SET_TRAVERSE_RATE, {rate});
   _sai._traverse_rate = rate;
 }
 
@@ -229,6 +516,8 @@ void STRAIGHT_TRAVERSE( int line_number,
          , b /*BB*/
          , c /*CC*/
          );
+  canonbin_call(CB_STRAIGHT_TRAVERSE, {x, y, z, a, b, c, u, v, w}, {line_number});
+  account_line(false, x, y, z);
   _sai._program_position_x = x;
   _sai._program_position_y = y;
   _sai._program_position_z = z;
@@ -241,22 +530,26 @@ void STRAIGHT_TRAVERSE( int line_number,
 void SET_FEED_MODE(int spindle, int mode)
 {
   PRINT("SET_FEED_MODE(%d, %d)\n", spindle, mode);
+  canonbin_call(CB_SET_FEED_MODE, {}, {spindle, mode});
   _sai._feed_mode = mode;
 }
 void SET_FEED_RATE(double rate)
 {
   PRINT("SET_FEED_RATE(%.4f)\n", rate);
+  canonbin_call(CB_SET_FEED_RATE, {rate});
   _sai._feed_rate = rate;
 }
 
 void SET_FEED_REFERENCE(CANON_FEED_REFERENCE reference)
 {
+  canonbin_call(CB_SET_FEED_REFERENCE, {}, {reference});
   PRINT("SET_FEED_REFERENCE(%s)\n",
          (reference == CANON_WORKPIECE) ? "CANON_WORKPIECE" : "CANON_XYZ");
 }
 
 extern void SET_MOTION_CONTROL_MODE(CANON_MOTION_MODE mode, double tolerance)
 {
+  canonbin_call(CB_SET_MOTION_CONTROL_MODE, {tolerance}, {mode});
   _sai.motion_tolerance = 0;
   if (mode == CANON_EXACT_STOP)
     {
@@ -282,10 +575,18 @@ extern void SET_NAIVECAM_TOLERANCE(double tolerance)
 {
   _sai.naivecam_tolerance = tolerance;
   PRINT("SET_NAIVECAM_TOLERANCE(%.4f)\n", tolerance);
+  canonbin_call(CB_SET_NAIVECAM_TOLERANCE, {tolerance});
+}
+
+void SET_FEED_LIMIT(double limit)
+{
+  PRINT("SET_FEED_LIMIT(%.4f)\n", limit);
+  canonbin_call(CB_SET_FEED_LIMIT, {limit});
 }
 
 void SELECT_PLANE(CANON_PLANE in_plane)
 {
+  canonbin_call(CB_SELECT_PLANE, {}, {in_plane});
   PRINT("SELECT_PLANE(CANON_PLANE_%s)\n",
          ((in_plane == CANON_PLANE_XY) ? "XY" :
           (in_plane == CANON_PLANE_YZ) ? "YZ" :
@@ -309,7 +610,10 @@ void START_SPEED_FEED_SYNCH()
 {PRINT ("START_SPEED_FEED_SYNCH()\n");}
 
 void STOP_SPEED_FEED_SYNCH()
-{PRINT ("STOP_SPEED_FEED_SYNCH()\n");}
+{
+  PRINT ("STOP_SPEED_FEED_SYNCH()\n");
+  canonbin_call(CB_STOP_SPEED_FEED_SYNCH);
+}
 
 /* Machining Functions */
 
@@ -317,6 +621,7 @@ void NURBS_FEED(int lineno,
 std::vector<CONTROL_POINT> nurbs_control_points, unsigned int k)
 {
   ECHO_WITH_ARGS("%lu, ...", (unsigned long)nurbs_control_points.size());
+  canonbin_unsupported("NURBS_FEED");
 
   _sai._program_position_x = nurbs_control_points[nurbs_control_points.size()].X;
   _sai._program_position_y = nurbs_control_points[nurbs_control_points.size()].Y;
@@ -341,6 +646,11 @@ void ARC_FEED(int line_number,
          , b /*BB*/
          , c /*CC*/
          );
+  canonbin_call(CB_ARC_FEED, {first_end, second_end, first_axis, second_axis,
+                             axis_end_point, a, b, c, u, v, w},
+                {line_number, rotation});
+  account_arc(first_end, second_end, axis_end_point,
+              first_axis, second_axis, rotation);
   if (_sai._active_plane == CANON_PLANE_XY)
     {
       _sai._program_position_x = first_end;
@@ -381,6 +691,8 @@ void STRAIGHT_FEED(int line_number,
          , b /*BB*/
          , c /*CC*/
          );
+  canonbin_call(CB_STRAIGHT_FEED, {x, y, z, a, b, c, u, v, w}, {line_number});
+  account_line(true, x, y, z);
   _sai._program_position_x = x;
   _sai._program_position_y = y;
   _sai._program_position_z = z;
@@ -420,6 +732,8 @@ void STRAIGHT_PROBE(int line_number,
          , b /*BB*/
          , c /*CC*/
          );
+  canonbin_unsupported("STRAIGHT_PROBE");
+  account_line(true, x, y, z);
   _sai._probe_position_x = x;
   _sai._probe_position_y = y;
   _sai._probe_position_z = z;
@@ -442,12 +756,24 @@ void STRAIGHT_PROBE(int line_number,
 void RIGID_TAP(int line_number, double x, double y, double z, double scale)
 {
     ECHO_WITH_ARGS("%.4f, %.4f, %.4f", x, y, z);
+    canonbin_call(CB_RIGID_TAP, {x, y, z, scale}, {line_number});
+    /* in and back out again, the position does not change */
+    account_line(true, x, y, z);
+    if (_sai_summary.quiet)
+      account_move(true,
+                   hypot(hypot(x - _sai._program_position_x,
+                               y - _sai._program_position_y),
+                         z - _sai._program_position_z),
+                   _sai._program_position_x, _sai._program_position_y,
+                   _sai._program_position_z);
 }
 
 
 void DWELL(double seconds)
 {
   ECHO_WITH_ARGS("%.4f", seconds);
+  canonbin_call(CB_DWELL, {seconds});
+  _sai_summary.dwell_time += seconds;
 }
 
 /* Spindle Functions */
@@ -456,11 +782,13 @@ void SPINDLE_RETRACT_TRAVERSE()
 
 void SET_SPINDLE_MODE(int spindle, double arg) {
   PRINT("SET_SPINDLE_MODE(%d %.4f)\n", spindle, arg);
+  canonbin_call(CB_SET_SPINDLE_MODE, {arg}, {spindle});
 }
 
 void START_SPINDLE_CLOCKWISE(int spindle, int wait_for_atspeed)
 {
   PRINT("START_SPINDLE_CLOCKWISE(%i)\n", spindle);
+  canonbin_call(CB_START_SPINDLE_CLOCKWISE, {}, {spindle, wait_for_atspeed});
   _sai._spindle_turning[spindle] = ((_sai._spindle_speed[spindle] == 0) ? CANON_STOPPED :
                                                    CANON_CLOCKWISE);
 }
@@ -468,6 +796,7 @@ void START_SPINDLE_CLOCKWISE(int spindle, int wait_for_atspeed)
 void START_SPINDLE_COUNTERCLOCKWISE(int spindle, int wait_for_atspeed)
 {
   PRINT("START_SPINDLE_COUNTERCLOCKWISE(%i)\n", spindle);
+  canonbin_call(CB_START_SPINDLE_COUNTERCLOCKWISE, {}, {spindle, wait_for_atspeed});
   _sai._spindle_turning[spindle] = ((_sai._spindle_speed[spindle] == 0) ? CANON_STOPPED :
                                                    CANON_COUNTERCLOCKWISE);
 }
@@ -475,12 +804,14 @@ void START_SPINDLE_COUNTERCLOCKWISE(int spindle, int wait_for_atspeed)
 void SET_SPINDLE_SPEED(int spindle, double rpm)
 {
   PRINT("SET_SPINDLE_SPEED(%i, %.4f)\n", spindle, rpm);
+  canonbin_call(CB_SET_SPINDLE_SPEED, {rpm}, {spindle});
   _sai._spindle_speed[spindle] = rpm;
 }
 
 void STOP_SPINDLE_TURNING(int spindle)
 {
   PRINT("STOP_SPINDLE_TURNING(%i)\n", spindle);
+  canonbin_call(CB_STOP_SPINDLE_TURNING, {}, {spindle});
   _sai._spindle_turning[spindle] = CANON_STOPPED;
 }
 
@@ -488,12 +819,15 @@ void SPINDLE_RETRACT()
 {PRINT("SPINDLE_RETRACT()\n");}
 
 void ORIENT_SPINDLE(int spindle, double orientation, int mode)
-{PRINT("ORIENT_SPINDLE(%d, %.4f, %d)\n", spindle, orientation, mode);
+{
+  PRINT("ORIENT_SPINDLE(%d, %.4f, %d)\n", spindle, orientation, mode);
+  canonbin_call(CB_ORIENT_SPINDLE, {orientation}, {spindle, mode});
 }
 
 void WAIT_SPINDLE_ORIENT_COMPLETE(int spindle, double timeout)
 {
   PRINT("SPINDLE.%i.WAIT_ORIENT_COMPLETE(%.4f)\n", spindle, timeout);
+  canonbin_call(CB_WAIT_SPINDLE_ORIENT_COMPLETE, {timeout}, {spindle});
 }
 
 void USE_NO_SPINDLE_FORCE()
@@ -512,6 +846,10 @@ void SET_TOOL_TABLE_ENTRY(int pocket, int toolno, EmcPose offset, double diamete
             pocket, toolno,
             offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b, offset.c, offset.u, offset.v, offset.w,
             frontangle, backangle, orientation);
+    canonbin_call(CB_SET_TOOL_TABLE_ENTRY,
+                  {offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b,
+                   offset.c, offset.u, offset.v, offset.w, diameter, frontangle, backangle},
+                  {pocket, toolno, orientation});
 }
 
 void USE_TOOL_LENGTH_OFFSET(EmcPose offset)
@@ -519,22 +857,32 @@ void USE_TOOL_LENGTH_OFFSET(EmcPose offset)
     _sai._tool_offset = offset;
     ECHO_WITH_ARGS("%.4f %.4f %.4f, %.4f %.4f %.4f, %.4f %.4f %.4f",
          offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b, offset.c, offset.u, offset.v, offset.w);
+    canonbin_call(CB_USE_TOOL_LENGTH_OFFSET,
+                  {offset.tran.x, offset.tran.y, offset.tran.z, offset.a, offset.b,
+                   offset.c, offset.u, offset.v, offset.w});
 }
 
 void CHANGE_TOOL(int slot)
 {
   PRINT("CHANGE_TOOL(%d)\n", slot);
+  canonbin_call(CB_CHANGE_TOOL, {}, {slot});
   _sai._active_slot = slot;
+  _sai_summary.tools.insert(_sai._tools[slot].toolno);
   _sai._tools[0] = _sai._tools[slot];
 }
 
 void SELECT_POCKET(int slot, int tool)
-{PRINT("SELECT_POCKET(%d)\n", slot);}
+{
+  PRINT("SELECT_POCKET(%d)\n", slot);
+  canonbin_call(CB_SELECT_POCKET, {}, {slot, tool});
+}
 
 void CHANGE_TOOL_NUMBER(int slot)
 {
   PRINT("CHANGE_TOOL_NUMBER(%d)\n", slot);
+  canonbin_call(CB_CHANGE_TOOL_NUMBER, {}, {slot});
   _sai._active_slot = slot;
+  _sai_summary.tools.insert(_sai._tools[slot].toolno);
 }
 
 
@@ -550,80 +898,140 @@ void CLAMP_AXIS(CANON_AXIS axis)
         (axis == CANON_AXIS_C) ? "CANON_AXIS_C" : "UNKNOWN");}
 
 void COMMENT(const char *s)
-{PRINT("COMMENT(\"%s\")\n", s);}
+{
+  PRINT("COMMENT(\"%s\")\n", s);
+  canonbin_call(CB_COMMENT, {}, {}, s);
+}
 
 void DISABLE_ADAPTIVE_FEED()
-{PRINT("DISABLE_ADAPTIVE_FEED()\n");}
+{
+  PRINT("DISABLE_ADAPTIVE_FEED()\n");
+  canonbin_call(CB_DISABLE_ADAPTIVE_FEED);
+}
 
 void DISABLE_FEED_HOLD()
-{PRINT("DISABLE_FEED_HOLD()\n");}
+{
+  PRINT("DISABLE_FEED_HOLD()\n");
+  canonbin_call(CB_DISABLE_FEED_HOLD);
+}
 
 void DISABLE_FEED_OVERRIDE()
-{PRINT("DISABLE_FEED_OVERRIDE()\n"); fo_enable = false; }
+{
+  PRINT("DISABLE_FEED_OVERRIDE()\n");
+  canonbin_call(CB_DISABLE_FEED_OVERRIDE);
+  fo_enable = false;
+}
 
 void DISABLE_SPEED_OVERRIDE(int spindle)
-{PRINT("DISABLE_SPEED_OVERRIDE(%i)\n", spindle); so_enable = false; }
+{
+  PRINT("DISABLE_SPEED_OVERRIDE(%i)\n", spindle);
+  canonbin_call(CB_DISABLE_SPEED_OVERRIDE, {}, {spindle});
+  so_enable = false;
+}
 
 void ENABLE_ADAPTIVE_FEED()
-{PRINT("ENABLE_ADAPTIVE_FEED()\n");}
+{
+  PRINT("ENABLE_ADAPTIVE_FEED()\n");
+  canonbin_call(CB_ENABLE_ADAPTIVE_FEED);
+}
 
 void ENABLE_FEED_HOLD()
-{PRINT("ENABLE_FEED_HOLD()\n");}
+{
+  PRINT("ENABLE_FEED_HOLD()\n");
+  canonbin_call(CB_ENABLE_FEED_HOLD);
+}
 
 void ENABLE_FEED_OVERRIDE()
-{PRINT("ENABLE_FEED_OVERRIDE()\n"); fo_enable = true; }
+{
+  PRINT("ENABLE_FEED_OVERRIDE()\n");
+  canonbin_call(CB_ENABLE_FEED_OVERRIDE);
+  fo_enable = true;
+}
 
 void ENABLE_SPEED_OVERRIDE(int spindle)
-{PRINT("ENABLE_SPEED_OVERRIDE(%i)\n", spindle); so_enable = true; }
+{
+  PRINT("ENABLE_SPEED_OVERRIDE(%i)\n", spindle);
+  canonbin_call(CB_ENABLE_SPEED_OVERRIDE, {}, {spindle});
+  so_enable = true;
+}
 
 void FLOOD_OFF()
 {
   PRINT("FLOOD_OFF()\n");
+  canonbin_call(CB_FLOOD_OFF);
   _sai._flood = 0;
 }
 
 void FLOOD_ON()
 {
   PRINT("FLOOD_ON()\n");
+  canonbin_call(CB_FLOOD_ON);
   _sai._flood = 1;
 }
 
 void INIT_CANON()
 {
+  canonbin_call(CB_INIT_CANON);
 }
 
 void MESSAGE(char *s)
-{PRINT("MESSAGE(\"%s\")\n", s);}
+{
+  PRINT("MESSAGE(\"%s\")\n", s);
+  canonbin_call(CB_MESSAGE, {}, {}, s);
+}
 
 void LOG(char *s)
-{PRINT("LOG(\"%s\")\n", s);}
+{
+  PRINT("LOG(\"%s\")\n", s);
+  canonbin_unsupported("LOG");
+}
 void LOGOPEN(char *s)
-{PRINT("LOGOPEN(\"%s\")\n", s);}
+{
+  PRINT("LOGOPEN(\"%s\")\n", s);
+  canonbin_unsupported("LOGOPEN");
+}
 void LOGAPPEND(char *s)
-{PRINT("LOGAPPEND(\"%s\")\n", s);}
+{
+  PRINT("LOGAPPEND(\"%s\")\n", s);
+  canonbin_unsupported("LOGAPPEND");
+}
 void LOGCLOSE()
-{PRINT("LOGCLOSE()\n");}
+{
+  PRINT("LOGCLOSE()\n");
+  canonbin_unsupported("LOGCLOSE");
+}
 
 void MIST_OFF()
 {
   PRINT("MIST_OFF()\n");
+  canonbin_call(CB_MIST_OFF);
   _sai._mist = 0;
 }
 
 void MIST_ON()
 {
   PRINT("MIST_ON()\n");
+  canonbin_call(CB_MIST_ON);
   _sai._mist = 1;
 }
 
 void PALLET_SHUTTLE()
-{PRINT("PALLET_SHUTTLE()\n");}
+{
+  PRINT("PALLET_SHUTTLE()\n");
+  canonbin_call(CB_PALLET_SHUTTLE);
+}
 
 void TURN_PROBE_OFF()
-{PRINT("TURN_PROBE_OFF()\n");}
+{
+  PRINT("TURN_PROBE_OFF()\n");
+  canonbin_call(CB_TURN_PROBE_OFF);
+}
 
 void TURN_PROBE_ON()
-{PRINT("TURN_PROBE_ON()\n");}
+{
+  PRINT("TURN_PROBE_ON()\n");
+  canonbin_call(CB_TURN_PROBE_ON);
+}
 
 void UNCLAMP_AXIS(CANON_AXIS axis)
 {PRINT("UNCLAMP_AXIS(%s)\n",
@@ -637,7 +1045,10 @@ void UNCLAMP_AXIS(CANON_AXIS axis)
 /* Program Functions */
 
 void PROGRAM_STOP()
-{PRINT("PROGRAM_STOP()\n");}
+{
+  PRINT("PROGRAM_STOP()\n");
+  canonbin_call(CB_PROGRAM_STOP);
+}
 
 void SET_BLOCK_DELETE(bool state)
 {_sai.block_delete = state;} //state == ON, means we don't interpret lines starting with "/"
@@ -652,10 +1063,16 @@ bool GET_OPTIONAL_PROGRAM_STOP()
 {return _sai.optional_program_stop;} //state == ON, means we stop
 
 void OPTIONAL_PROGRAM_STOP()
-{PRINT("OPTIONAL_PROGRAM_STOP()\n");}
+{
+  PRINT("OPTIONAL_PROGRAM_STOP()\n");
+  canonbin_call(CB_OPTIONAL_PROGRAM_STOP);
+}
 
 void PROGRAM_END()
-{PRINT("PROGRAM_END()\n");}
+{
+  PRINT("PROGRAM_END()\n");
+  canonbin_call(CB_PROGRAM_END);
+}
 
 
 /*************************************************************************/
@@ -689,12 +1106,18 @@ double GET_EXTERNAL_ANGLE_UNITS() {return 1.0;}
 int GET_EXTERNAL_SELECTED_TOOL_SLOT() { return 0; }
 int GET_EXTERNAL_SPINDLE_OVERRIDE_ENABLE(int spindle) {return so_enable;}
 void START_SPEED_FEED_SYNCH(int spindle, double sync, bool vel)
-{PRINT("START_SPEED_FEED_SYNC(%f,%d)\n", sync, vel);}
+{
+  PRINT("START_SPEED_FEED_SYNC(%f,%d)\n", sync, vel);
+  canonbin_call(CB_START_SPEED_FEED_SYNCH, {sync}, {spindle, vel});
+}
 CANON_MOTION_MODE motion_mode;
 
-int GET_EXTERNAL_DIGITAL_INPUT(int index, int def) { return def; }
-double GET_EXTERNAL_ANALOG_INPUT(int index, double def) { return def; }
-int WAIT(int index, int input_type, int wait_type, double timeout) { return 0; }
+int GET_EXTERNAL_DIGITAL_INPUT(int index, int def)
+{ canonbin_unsupported("M66"); return def; }
+double GET_EXTERNAL_ANALOG_INPUT(int index, double def)
+{ canonbin_unsupported("M66"); return def; }
+int WAIT(int index, int input_type, int wait_type, double timeout)
+{ canonbin_unsupported("M66"); return 0; }
 int UNLOCK_ROTARY(int line_no, int joint_num) {return 0;}
 int LOCK_ROTARY(int line_no, int joint_num) {return 0;}
 
@@ -939,36 +1362,42 @@ int USER_DEFINED_FUNCTION_ADD(USER_DEFINED_FUNCTION_TYPE func, int num)
 void SET_MOTION_OUTPUT_BIT(int index)
 {
     PRINT("SET_MOTION_OUTPUT_BIT(%d)\n", index);
+    canonbin_call(CB_SET_MOTION_OUTPUT_BIT, {}, {index});
     return;
 }
 
 void CLEAR_MOTION_OUTPUT_BIT(int index)
 {
     PRINT("CLEAR_MOTION_OUTPUT_BIT(%d)\n", index);
+    canonbin_call(CB_CLEAR_MOTION_OUTPUT_BIT, {}, {index});
     return;
 }
 
 void SET_MOTION_OUTPUT_VALUE(int index, double value)
 {
     PRINT("SET_MOTION_OUTPUT_VALUE(%d,%f)\n", index, value);
+    canonbin_call(CB_SET_MOTION_OUTPUT_VALUE, {value}, {index});
     return;
 }
 
 void SET_AUX_OUTPUT_BIT(int index)
 {
     PRINT("SET_AUX_OUTPUT_BIT(%d)\n", index);
+    canonbin_call(CB_SET_AUX_OUTPUT_BIT, {}, {index});
     return;
 }
 
 void CLEAR_AUX_OUTPUT_BIT(int index)
 {
     PRINT("CLEAR_AUX_OUTPUT_BIT(%d)\n", index);
+    canonbin_call(CB_CLEAR_AUX_OUTPUT_BIT, {}, {index});
     return;
 }
 
 void SET_AUX_OUTPUT_VALUE(int index, double value)
 {
     PRINT("SET_AUX_OUTPUT_VALUE(%d,%f)\n", index, value);
+    canonbin_call(CB_SET_AUX_OUTPUT_VALUE, {value}, {index});
     return;
 }
 
@@ -1084,11 +1513,13 @@ void CANON_ERROR(const char *fmt, ...)
 void PLUGIN_CALL(int len, const char *call)
 {
     printf("PLUGIN_CALL(%d)\n",len);
+    canonbin_unsupported("PLUGIN_CALL");
 }
 
 void IO_PLUGIN_CALL(int len, const char *call)
 {
     printf("IO_PLUGIN_CALL(%d)\n",len);
+    canonbin_unsupported("IO_PLUGIN_CALL");
 }
 
 void reset_internals()
@@ -1149,3 +1580,40 @@ StandaloneInterpInternals::StandaloneInterpInternals() :
   _toolchanger_reason(0)
 {
 }
+
+void reset_summary()
+{
+  SaiSummary &s = _sai_summary;
+
+  s.have_extents = false;
+  for (int i = 0; i < 3; i++)
+    s.min[i] = s.max[i] = 0;
+  s.moves = 0;
+  s.feed_length = s.traverse_length = 0;
+  s.feed_time = s.traverse_time = s.dwell_time = 0;
+  s.limit_violations = 0;
+  s.first_violation_line = 0;
+  s.tools.clear();
+}
+
+SaiSummary::SaiSummary() :
+  quiet(false),
+  max_velocity(0.),
+  max_acceleration(0.),
+  have_limits{false, false, false},
+  limit_min{0., 0., 0.},
+  limit_max{0., 0., 0.},
+  have_extents(false),
+  min{0., 0., 0.},
+  max{0., 0., 0.},
+  moves(0),
+  feed_length(0.),
+  traverse_length(0.),
+  feed_time(0.),
+  traverse_time(0.),
+  dwell_time(0.),
+  limit_violations(0),
+  first_violation_line(0),
+  tools()
+{
+}
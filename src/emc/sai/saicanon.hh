@@ -5,11 +5,14 @@
 #include <interp_fwd.hh>
 #include <canon.hh>
 #include <string>
+#include <set>
 
 struct StandaloneInterpInternals;
+struct SaiSummary;
 class InterpBase;
 
 extern StandaloneInterpInternals _sai;
+extern SaiSummary _sai_summary;
 extern InterpBase *pinterp;
 extern FILE *_outfile;
 extern char _parameter_file_name[PARAMETER_FILE_NAME_LENGTH];
@@ -71,5 +74,38 @@ struct StandaloneInterpInternals
   int  _toolchanger_reason ;
 };
 
+/* Collected by the canon functions while verifying a program (rs274 -j).
+   Lengths are in program units, times in seconds. */
+struct SaiSummary
+{
+  SaiSummary();
+  bool quiet;                 /* suppress the canon call trace */
+  /* machine limits in mm, used for estimates and soft limit checks */
+  double max_velocity;        /* mm/s, 0 if unknown */
+  double max_acceleration;    /* mm/s^2, 0 if unknown */
+  bool have_limits[3];
+  double limit_min[3], limit_max[3];  /* XYZ soft limits */
+  /* results */
+  bool have_extents;
+  double min[3], max[3];      /* XYZ extents in program coordinates */
+  long moves;
+  double feed_length;
+  double traverse_length;
+  double feed_time;
+  double traverse_time;
+  double dwell_time;
+  int limit_violations;
+  int first_violation_line;
+  std::set<int> tools;
+};
+
 void reset_internals();
+void reset_summary();
+
+/* Compiled canon stream, see canterp/canonbin.hh.  canonbin_close()
+   removes the file and returns -1 if 'ok' is false or the program used
+   calls that cannot be compiled. */
+int canonbin_open(const char *filename);
+void canonbin_synch();
+int canonbin_close(bool ok);
 #endif // SAICANON_HH
@@ -1192,6 +1192,23 @@ void SET_NAIVECAM_TOLERANCE(double tolerance)
     canon.naivecamTolerance =  FROM_PROG_LEN(tolerance);
 }
 
+void SET_FEED_LIMIT(double limit)
+{
+    EMC_TRAJ_SET_FEED_LIMIT setFeedLimitMsg;
+
+    /* convert from /min to /sec, and to traj units */
+    double newFeedLimit = FROM_PROG_LEN(limit / 60.0);
+
+    if (newFeedLimit == canon.feedLimit)
+        return;
+
+    flush_segments();
+
+    canon.feedLimit = newFeedLimit;
+    setFeedLimitMsg.limit = TO_EXT_LEN(canon.feedLimit);
+    interp_list.append(setFeedLimitMsg);
+}
+
 void SELECT_PLANE(CANON_PLANE in_plane)
 {
     canon.activePlane = in_plane;
@@ -2451,6 +2468,9 @@ void PROGRAM_END()
 {
     flush_segments();
 
+    if (canon.feedLimit != 0)
+        SET_FEED_LIMIT(0);
+
     EMC_TASK_PLAN_END endMsg;
 
     interp_list.append(endMsg);
@@ -2515,6 +2535,7 @@ void INIT_CANON()
     canon.xy_rotation = 0.0;
     canon.rotary_unlock_for_traverse = -1;
     canon.feed_mode = 0;
+    canon.feedLimit = 0.0;
     canon.g5xOffset.x = 0.0;
     canon.g5xOffset.y = 0.0;
     canon.g5xOffset.z = 0.0;
@@ -649,6 +649,17 @@ int emcTaskPlanLevel()
     return retval;
 }
 
+int emcTaskPlanSeek(int line)
+{
+    int retval = interp.seek_line(line);
+
+    if (emc_debug & EMC_DEBUG_INTERP) {
+        rcs_print("emcTaskPlanSeek(%d) returned %d\n", line, retval);
+    }
+
+    return retval;
+}
+
 int emcTaskPlanCommand(char *cmd)
 {
     char buf[LINELEN];
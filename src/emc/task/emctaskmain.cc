@@ -82,6 +82,8 @@ fpu_control_t __fpu_control = _FPU_IEEE & ~(_FPU_MASK_IM | _FPU_MASK_ZM | _FPU_M
 #include "taskclass.hh"
 #include "motion.h"             // EMCMOT_ORIENT_*
 #include "inihal.hh"
+#include "emccfg.h"		// DEFAULT_EMC_STAT_MIRROR_KEY
+#include "emcstatmirror.hh"
 
 static emcmot_config_t emcmotConfig;
 
@@ -96,6 +98,9 @@ static RCS_CMD_CHANNEL *emcCommandBuffer = 0;
 static RCS_STAT_CHANNEL *emcStatusBuffer = 0;
 static NML *emcErrorBuffer = 0;
 
+// lock-free copy of emcStatus for local readers
+static EMC_STAT_MIRROR *emcStatusMirror = 0;
+
 // NML command channel data pointer
 static RCS_CMD_MSG *emcCommand = 0;
 
@@ -381,6 +386,7 @@ static EMC_TRAJ_LINEAR_MOVE *emcTrajLinearMoveMsg;
 static EMC_TRAJ_CIRCULAR_MOVE *emcTrajCircularMoveMsg;
 static EMC_TRAJ_DELAY *emcTrajDelayMsg;
 static EMC_TRAJ_SET_TERM_COND *emcTrajSetTermCondMsg;
+static EMC_TRAJ_SET_FEED_LIMIT *emcTrajSetFeedLimitMsg;
 static EMC_TRAJ_SET_SPINDLESYNC *emcTrajSetSpindlesyncMsg;
 
 // These classes are commented out because the compiler
@@ -1501,6 +1507,7 @@ static int emcTaskCheckPreconditions(NMLmsg * cmd)
     case EMC_TRAJ_SET_VELOCITY_TYPE:
     case EMC_TRAJ_SET_ACCELERATION_TYPE:
     case EMC_TRAJ_SET_TERM_COND_TYPE:
+    case EMC_TRAJ_SET_FEED_LIMIT_TYPE:
     case EMC_TRAJ_SET_SPINDLESYNC_TYPE:
     case EMC_TRAJ_SET_FO_ENABLE_TYPE:
     case EMC_TRAJ_SET_FH_ENABLE_TYPE:
@@ -1862,6 +1869,11 @@ static int emcTaskIssueCommand(NMLmsg * cmd)
 	retval = emcTrajSetTermCond(emcTrajSetTermCondMsg->cond, emcTrajSetTermCondMsg->tolerance);
 	break;
 
+    case EMC_TRAJ_SET_FEED_LIMIT_TYPE:
+	emcTrajSetFeedLimitMsg = (EMC_TRAJ_SET_FEED_LIMIT *) cmd;
+	retval = emcTrajSetFeedLimit(emcTrajSetFeedLimitMsg->limit);
+	break;
+
     case EMC_TRAJ_SET_SPINDLESYNC_TYPE:
         emcTrajSetSpindlesyncMsg = (EMC_TRAJ_SET_SPINDLESYNC *) cmd;
         retval = emcTrajSetSpindleSync(emcTrajSetSpindlesyncMsg->spindle, emcTrajSetSpindlesyncMsg->feed_per_revolution, emcTrajSetSpindlesyncMsg->velocity_mode);
@@ -2281,6 +2293,14 @@ static int emcTaskIssueCommand(NMLmsg * cmd)
 	}
 	run_msg = (EMC_TASK_PLAN_RUN *) cmd;
 	programStartLine = run_msg->line;
+	// an interpreter that can seek skips to just before the start
+	// line, leaving only that line to step over below.  What it
+	// queued on the way is dropped, also when it gave up part way
+	// and went back to the top of the program.
+	if (programStartLine > 0) {
+	    emcTaskPlanSeek(programStartLine);
+	    interp_list.clear();
+	}
 	emcStatus->task.interpState = EMC_TASK_INTERP_READING;
 	emcStatus->task.task_paused = 0;
 	retval = 0;
@@ -2420,6 +2440,7 @@ static int emcTaskCheckPostconditions(NMLmsg * cmd)
     case EMC_TRAJ_SET_VELOCITY_TYPE:
     case EMC_TRAJ_SET_ACCELERATION_TYPE:
     case EMC_TRAJ_SET_TERM_COND_TYPE:
+    case EMC_TRAJ_SET_FEED_LIMIT_TYPE:
     case EMC_TRAJ_SET_SPINDLESYNC_TYPE:
     case EMC_TRAJ_SET_OFFSET_TYPE:
     case EMC_TRAJ_SET_G5X_TYPE:
@@ -2928,6 +2949,9 @@ static int emctask_startup()
 	return -1;
     }
 
+    // not fatal, readers fall back to the NML channel
+    emcStatusMirror = EMC_STAT_MIRROR::create(DEFAULT_EMC_STAT_MIRROR_KEY);
+
     if (!(emc_debug & EMC_DEBUG_NML)) {
 	set_rcs_print_destination(RCS_PRINT_TO_NULL);	// inhibit diag
 	// messages
@@ -3098,6 +3122,11 @@ static int emctask_shutdown(void)
 	emcErrorBuffer = 0;
     }
 
+    if (0 != emcStatusMirror) {
+	delete emcStatusMirror;
+	emcStatusMirror = 0;
+    }
+
     if (0 != emcStatusBuffer) {
 	delete emcStatusBuffer;
 	emcStatusBuffer = 0;
@@ -3537,6 +3566,9 @@ int main(int argc, char *argv[])
 	// will be updated in the _update() functions above. There's
 	// no need to call the individual functions on all WM items.
 	emcStatusBuffer->write(emcStatus);
+	if (emcStatusMirror) {
+	    emcStatusMirror->publish(emcStatus);
+	}
 
 	// wait on timer cycle, if specified, or calculate actual
 	// interval if ini file says to run full out via
@@ -52,6 +52,7 @@ int emcTaskPlanReset();
 
 int emcTaskPlanLine();
 int emcTaskPlanLevel();
+int emcTaskPlanSeek(int line);
 int emcTaskPlanCommand(char *cmd);
 
 int emcTaskUpdate(EMC_TASK_STAT * stat);
@@ -418,8 +418,9 @@ int emcPluginCall(EMC_EXEC_PLUGIN_CALL *call_msg)
 	bp::object retval;
 	bp::object arg = bp::make_tuple(bp::object(call_msg->call));
 	bp::dict kwarg;
+	static int handle = python_plugin->resolve(TASK_MODULE, PLUGIN_CALL);
 
-	python_plugin->call(TASK_MODULE, PLUGIN_CALL, arg, kwarg, retval);
+	python_plugin->call(handle, arg, kwarg, retval);
 	return return_int(PLUGIN_CALL, retval.ptr());
 
     } else {
@@ -1379,6 +1379,14 @@ int emcTrajSetTermCond(int cond, double tolerance)
     return usrmotWriteEmcmotCommand(&emcmotCommand);
 }
 
+int emcTrajSetFeedLimit(double limit)
+{
+    emcmotCommand.command = EMCMOT_SET_FEED_LIMIT;
+    emcmotCommand.vel = limit;
+
+    return usrmotWriteEmcmotCommand(&emcmotCommand);
+}
+
 int emcTrajLinearMove(EmcPose end, int type, double vel, double ini_maxvel, double acc,
                       int indexer_jnum)
 {
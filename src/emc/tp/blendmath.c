@@ -11,7 +11,7 @@
 * Last change:
 ********************************************************************/
 
-#include "posemath.h"
+#include "posemath_inline.h"
 #include "tc_types.h"
 #include "tc.h"
 #include "tp_types.h"
@@ -1243,8 +1243,7 @@ int blendFindPoints3(BlendPoints3 * const points, BlendGeom3 const * const geom,
     double center_dist = param->R_plan / sin(param->theta);
     tp_debug_print("center_dist = %f\n", center_dist);
 
-    pmCartScalMult(&geom->normal, center_dist, &points->arc_center);
-    pmCartCartAddEq(&points->arc_center, &geom->P);
+    pmCartScalMultAdd(&geom->normal, center_dist, &geom->P, &points->arc_center);
     tp_debug_print("arc_center = %f %f %f\n",
             points->arc_center.x,
             points->arc_center.y,
@@ -1252,8 +1251,7 @@ int blendFindPoints3(BlendPoints3 * const points, BlendGeom3 const * const geom,
 
     // Start point is d_plan away from intersection P in the
     // negative direction of u1
-    pmCartScalMult(&geom->u1, -param->d_plan, &points->arc_start);
-    pmCartCartAddEq(&points->arc_start, &geom->P);
+    pmCartScalMultAdd(&geom->u1, -param->d_plan, &geom->P, &points->arc_start);
     tp_debug_print("arc_start = %f %f %f\n",
             points->arc_start.x,
             points->arc_start.y,
@@ -1261,8 +1259,7 @@ int blendFindPoints3(BlendPoints3 * const points, BlendGeom3 const * const geom,
 
     // End point is d_plan away from intersection P in the
     // positive direction of u1
-    pmCartScalMult(&geom->u2, param->d_plan, &points->arc_end);
-    pmCartCartAddEq(&points->arc_end, &geom->P);
+    pmCartScalMultAdd(&geom->u2, param->d_plan, &geom->P, &points->arc_end);
     tp_debug_print("arc_end = %f %f %f\n",
             points->arc_end.x,
             points->arc_end.y,
@@ -1473,8 +1470,14 @@ int blendArcArcPostProcess(BlendPoints3 * const points, BlendPoints3 const * con
     //Find "x" distance between C1 and C2
     PmCartesian r_C1C2;
     pmCartCartSub(&geom->center2, &geom->center1, &r_C1C2);
+
+    // Find the basis vector uc from center1 to center2, and the distance
+    PmCartesian uc;
     double c2x;
-    pmCartMag(&r_C1C2, &c2x);
+    int norm_err = pmCartUnitMag(&r_C1C2, &uc, &c2x);
+    if (norm_err) {
+        return TP_ERR_FAIL;
+    }
 
     // Compute the new center location
 
@@ -1483,14 +1486,6 @@ int blendArcArcPostProcess(BlendPoints3 * const points, BlendPoints3 const * con
 
     tp_debug_print("Cx = %f, Cy = %f\n",Cx,Cy);
 
-    // Find the basis vector uc from center1 to center2
-    PmCartesian uc;
-    //TODO catch failures here
-    int norm_err = pmCartUnit(&r_C1C2, &uc);
-    if (norm_err) {
-        return TP_ERR_FAIL;
-    }
-
     // Find the basis vector perpendicular to the binormal and uc
     PmCartesian nc;
     pmCartCartCross(&geom->binormal, &uc, &nc);
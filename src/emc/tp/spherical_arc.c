@@ -11,7 +11,7 @@
  *
  ********************************************************************/
 
-#include "posemath.h"
+#include "posemath_inline.h"
 #include "spherical_arc.h"
 #include "tp_types.h"
 #include "rtapi_math.h"
@@ -92,20 +92,17 @@ int arcPoint(SphericalArc const * const arc, double progress, PmCartesian * cons
     if (net_progress <= 0.0 && arc->line_length > 0) {
         tc_debug_print("net_progress = %f, line_length = %f\n", net_progress, arc->line_length);
         //Get position on line (not actually an angle in this case)
-        pmCartScalMult(&arc->uTan, net_progress, out);
-        pmCartCartAdd(out, &arc->start, out);
+        pmCartScalMultAdd(&arc->uTan, net_progress, &arc->start, out);
     } else {
         double angle_in = net_progress / arc->radius;
         tc_debug_print("angle_in = %f, angle_total = %f\n", angle_in, arc->angle);
         double scale0 = sin(arc->angle - angle_in) / arc->Sangle;
         double scale1 = sin(angle_in) / arc->Sangle;
 
-        PmCartesian interp0,interp1;
+        PmCartesian interp0;
         pmCartScalMult(&arc->rStart, scale0, &interp0);
-        pmCartScalMult(&arc->rEnd, scale1, &interp1);
-
-        pmCartCartAdd(&interp0, &interp1, out);
-        pmCartCartAdd(&arc->center, out, out);
+        pmCartScalMultAdd(&arc->rEnd, scale1, &interp0, out);
+        pmCartCartAddEq(out, &arc->center);
     }
     return TP_ERR_OK;
 }
@@ -141,13 +138,11 @@ int arcFromLines(SphericalArc * const arc, PmCartLine const * const line1,
 
     // Start point is blend_dist away from middle point in the
     // negative direction of line1
-    pmCartScalMult(&line1->uVec, -blend_dist, start);
-    pmCartCartAdd(start, middle, start);
+    pmCartScalMultAdd(&line1->uVec, -blend_dist, middle, start);
 
     // End point is blend_dist away from middle point in the positive
     // direction of line2
-    pmCartScalMult(&line2->uVec, blend_dist, end);
-    pmCartCartAddEq(end, middle);
+    pmCartScalMultAdd(&line2->uVec, blend_dist, middle, end);
 
     //Handle line portion of line-arc
     arc->uTan = line1->uVec;
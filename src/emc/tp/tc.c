@@ -16,7 +16,7 @@
 
 #include "rtapi.h"		/* rtapi_print_msg */
 #include "rtapi_math.h"
-#include "posemath.h"
+#include "posemath_inline.h"
 #include "blendmath.h"
 #include "emcpose.h"
 #include "tc.h"
@@ -240,7 +240,7 @@ int pmCircleTangentVector(PmCircle const * const circle,
 
     PmCartesian startpoint;
     PmCartesian radius;
-    PmCartesian uTan, dHelix, dRadial;
+    PmCartesian uTan, dRadial;
 
     // Get vector in radial direction
     pmCirclePoint(circle, angle_in, &startpoint);
@@ -255,16 +255,13 @@ int pmCircleTangentVector(PmCircle const * const circle,
     /* the binormal component of the tangent vector is (dz / dtheta) * dtheta.
      */
     double dz = 1.0 / circle->angle;
-    pmCartScalMult(&circle->rHelix, dz, &dHelix);
-
-    pmCartCartAddEq(&uTan, &dHelix);
+    pmCartScalMultAdd(&circle->rHelix, dz, &uTan, &uTan);
 
     /* The normal component is (dr / dtheta) * dtheta.
      */
     double dr = circle->spiral / circle->angle;
     pmCartUnit(&radius, &dRadial);
-    pmCartScalMultEq(&dRadial, dr);
-    pmCartCartAddEq(&uTan, &dRadial);
+    pmCartScalMultAdd(&dRadial, dr, &uTan, &uTan);
 
     //Normalize final output vector
     pmCartUnit(&uTan, out);
@@ -675,6 +672,7 @@ int tcSetupState(TC_STRUCT * const tc, TP_STRUCT const * const tp)
 {
     tcSetTermCond(tc, NULL, tp->termCond);
     tc->tolerance = tp->tolerance;
+    tc->feed_limit = tp->feedLimit;
     tc->synchronized = tp->synchronized;
     tc->uu_per_rev = tp->uu_per_rev;
     return TP_ERR_OK;
@@ -804,6 +802,26 @@ int tcClampVelocityByLength(TC_STRUCT * const tc)
     return TP_ERR_OK;
 }
 
+/**
+ * Apply the segment's external feed limit to its maximum velocity.
+ * The limit is a hard constraint like the machine limits, not a scale of the
+ * requested feed, so the optimizer plans the decelerations around it. Like
+ * the max velocity slider, it is a cartesian limit, so pure rotary moves are
+ * not limited, and position-synced moves have to follow the spindle.
+ */
+int tcClampVelocityByFeedLimit(TC_STRUCT * const tc)
+{
+    if (!tc) {
+        return TP_ERR_FAIL;
+    }
+
+    if (tc->feed_limit > 0.0 && !tcPureRotaryCheck(tc) &&
+            tc->synchronized != TC_SYNC_POSITION) {
+        tc->maxvel = fmin(tc->maxvel, tc->feed_limit);
+    }
+    return TP_ERR_OK;
+}
+
 /**
  * compute the total arc length of a circle segment
  */
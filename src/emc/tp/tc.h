@@ -109,6 +109,7 @@ int tcUpdateCircleAccRatio(TC_STRUCT * tc);
 int tcFinalizeLength(TC_STRUCT * const tc);
 
 int tcClampVelocityByLength(TC_STRUCT * const tc);
+int tcClampVelocityByFeedLimit(TC_STRUCT * const tc);
 
 int tcPureRotaryCheck(TC_STRUCT const * const tc);
 
@@ -11,7 +11,7 @@
 * Copyright (c) 2004 All rights reserved.
 ********************************************************************/
 #include "rtapi.h"              /* rtapi_print_msg */
-#include "posemath.h"           /* Geometry types & functions */
+#include "posemath_inline.h"    /* Geometry types & functions */
 #include "tc.h"
 #include "tp.h"
 #include "emcpose.h"
@@ -375,6 +375,7 @@ int tpClear(TP_STRUCT * const tp)
     tp->motionType = 0;
     tp->termCond = TC_TERM_COND_PARABOLIC;
     tp->tolerance = 0.0;
+    tp->feedLimit = 0.0;
     tp->done = 1;
     tp->depth = tp->activeDepth = 0;
     tp->aborting = 0;
@@ -556,6 +557,21 @@ int tpSetTermCond(TP_STRUCT * const tp, int cond, double tolerance)
     return TP_ERR_OK;
 }
 
+/**
+ * Sets an external feed limit for all subsequent queued moves, 0 for none.
+ * Unlike the feed override, the limit is part of each segment's maximum
+ * velocity, so the optimizer slows down ahead of a limited segment instead
+ * of reacting once it is reached.
+ */
+int tpSetFeedLimit(TP_STRUCT * const tp, double limit)
+{
+    if (!tp || limit < 0.0) {
+        return TP_ERR_FAIL;
+    }
+    tp->feedLimit = limit;
+    return TP_ERR_OK;
+}
+
 /**
  * Used to tell the tp the initial position.
  * It sets the current position AND the goal position to be the same.  Used
@@ -706,12 +722,18 @@ STATIC int tpInitBlendArcFromPrev(TP_STRUCT const * const tp,
 
     // Copy over state data from TP
     tcSetupState(blend_tc, tp);
+    // The blend replaces the end of prev_tc, so its feed limit applies too
+    if (prev_tc->feed_limit > 0.0 &&
+            (blend_tc->feed_limit <= 0.0 || prev_tc->feed_limit < blend_tc->feed_limit)) {
+        blend_tc->feed_limit = prev_tc->feed_limit;
+    }
     
     // Set kinematics parameters from blend calculations
     tcSetupMotion(blend_tc,
             vel,
             ini_maxvel,
             acc);
+    tcClampVelocityByFeedLimit(blend_tc);
 
     // Skip syncdio setup since this blend extends the previous line
     blend_tc->syncdio = prev_tc->syncdio; //enqueue the list of DIOs that need toggling
@@ -1956,6 +1978,7 @@ int tpAddLine(TP_STRUCT * const tp, EmcPose end, int canon_motion_type, double v
     }
     tc.nominal_length = tc.target;
     tcClampVelocityByLength(&tc);
+    tcClampVelocityByFeedLimit(&tc);
 
     // For linear move, set joint corresponding to a locking indexer axis
     tc.indexer_jnum = indexer_jnum;
@@ -2047,6 +2070,7 @@ int tpAddCircle(TP_STRUCT * const tp,
 
     //Reduce max velocity to match sample rate
     tcClampVelocityByLength(&tc);
+    tcClampVelocityByFeedLimit(&tc);
 
     TC_STRUCT *prev_tc;
     prev_tc = tcqLast(&tp->queue);
@@ -30,6 +30,7 @@ int tpSetAmax(TP_STRUCT * const tp, double aMax);
 int tpSetId(TP_STRUCT * const tp, int id);
 int tpGetExecId(TP_STRUCT * const tp);
 int tpSetTermCond(TP_STRUCT * const tp, int cond, double tolerance);
+int tpSetFeedLimit(TP_STRUCT * const tp, double limit);
 int tpSetPos(TP_STRUCT * const tp, EmcPose const * const pos);
 int tpAddCurrentPos(TP_STRUCT * const tp, EmcPose const * const disp);
 int tpSetCurrentPos(TP_STRUCT * const tp, EmcPose const * const pos);
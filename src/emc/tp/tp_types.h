@@ -126,6 +126,8 @@ typedef struct {
     double tolerance;           /* for subsequent motions, stay within this
                                    distance of the programmed path during
                                    blends */
+    double feedLimit;           /* external feed limit for subsequent
+                                   motions, 0 for none */
     int synchronized;       // spindle sync required for this move
     int velocity_mode; 	        /* TRUE if spindle sync is in velocity mode,
 				   FALSE if in position mode */
@@ -32,8 +32,16 @@
 #include "timer.hh"
 #include "nml_oi.hh"
 #include "rcs_print.hh"
+#include "emccfg.h"
+#include "emcstatmirror.hh"
+#include "emcmotcfg.h"
+#include "postrace.h"
+#include "toolpath.hh"
 
 #include <cmath>
+#include <deque>
+#include <algorithm>
+#include <sys/shm.h>
 
 #ifndef T_BOOL
 // The C++ standard probably doesn't specify the amount of storage for a 'bool',
@@ -83,6 +91,7 @@ struct pyIniFile {
 struct pyStatChannel {
     PyObject_HEAD
     RCS_STAT_CHANNEL *c;
+    EMC_STAT_MIRROR *mirror;    // lock-free status when task is local
     EMC_STAT status;
 };
 
@@ -267,10 +276,12 @@ static int Stat_init(pyStatChannel *self, PyObject *a, PyObject *k) {
     }
 
     self->c = c;
+    self->mirror = EMC_STAT_MIRROR::attach(DEFAULT_EMC_STAT_MIRROR_KEY);
     return 0;
 }
 
 static void Stat_dealloc(PyObject *self) {
+    delete ((pyStatChannel*)self)->mirror;
     delete ((pyStatChannel*)self)->c;
     PyObject_Del(self);
 }
@@ -285,6 +296,17 @@ static bool check_stat(RCS_STAT_CHANNEL *emcStatusBuffer) {
 
 static PyObject *poll(pyStatChannel *s, PyObject *o) {
     if(!check_stat(s->c)) return NULL;
+    if(!s->mirror)
+        s->mirror = EMC_STAT_MIRROR::attach(DEFAULT_EMC_STAT_MIRROR_KEY);
+    if(s->mirror) {
+        if(s->mirror->read(&s->status) >= 0) {
+            Py_INCREF(Py_None);
+            return Py_None;
+        }
+        // task went away, use NML until it is back
+        delete s->mirror;
+        s->mirror = 0;
+    }
     if(s->c->peek() == EMC_STAT_TYPE) {
         EMC_STAT *emcStatus = static_cast<EMC_STAT*>(s->c->get_address());
         memcpy(&s->status, emcStatus, sizeof(EMC_STAT));
@@ -1554,81 +1576,15 @@ static PyTypeObject Error_Type = {
 
 #include <GL/gl.h>
 
-static void rotate_z(double pt[3], double a) {
-    double theta = a * M_PI / 180;
-    double c = cos(theta), s = sin(theta);
-    double tx, ty;
-    tx = pt[0] * c - pt[1] * s;
-    ty = pt[0] * s + pt[1] * c;
-
-    pt[0] = tx; pt[1] = ty;
-}
-
-static void rotate_y(double pt[3], double a) {
-    double theta = a * M_PI / 180;
-    double c = cos(theta), s = sin(theta);
-    double tx, tz;
-    tx = pt[0] * c - pt[2] * s;
-    tz = pt[0] * s + pt[2] * c;
-
-    pt[0] = tx; pt[2] = tz;
-}
-
-static void rotate_x(double pt[3], double a) {
-    double theta = a * M_PI / 180;
-    double c = cos(theta), s = sin(theta);
-    double tx, tz;
-    tx = pt[1] * c - pt[2] * s;
-    tz = pt[1] * s + pt[2] * c;
-
-    pt[1] = tx; pt[2] = tz;
-}
-
-static void translate(double pt[3], double ox, double oy, double oz) {
-    pt[0] += ox;
-    pt[1] += oy;
-    pt[2] += oz;
-}
-
-static void vertex9(const double pt[9], double p[3], const char *geometry) {
-    double sign = 1;
-
-    p[0] = 0;
-    p[1] = 0;
-    p[2] = 0;
-
-    for(; *geometry; geometry++) {
-        switch(*geometry) {
-            case '-': sign = -1; break;
-            case 'X': translate(p, pt[0] * sign, 0, 0); sign=1; break;
-            case 'Y': translate(p, 0, pt[1] * sign, 0); sign=1; break;
-            case 'Z': translate(p, 0, 0, pt[2] * sign); sign=1; break;
-            case 'U': translate(p, pt[6] * sign, 0, 0); sign=1; break;
-            case 'V': translate(p, 0, pt[7] * sign, 0); sign=1; break;
-            case 'W': translate(p, 0, 0, pt[8] * sign); sign=1; break;
-            case 'A': rotate_x(p, pt[3] * sign); sign=1; break;
-            case 'B': rotate_y(p, pt[4] * sign); sign=1; break;
-            case 'C': rotate_z(p, pt[5] * sign); sign=1; break;
-        }
-    }
-}
-
 static void glvertex9(const double pt[9], const char *geometry) {
     double p[3];
     vertex9(pt, p, geometry);
     glVertex3dv(p);
 }
 
-#define max(a,b) ((a) < (b) ? (b) : (a))
-#define max3(a,b,c) (max((a),max((b),(c))))
-
 static void line9(const double p1[9], const double p2[9], const char *geometry) {
-    if(p1[3] != p2[3] || p1[4] != p2[4] || p1[5] != p2[5]) {
-        double dc = max3(
-            fabs(p2[3] - p1[3]),
-            fabs(p2[4] - p1[4]),
-            fabs(p2[5] - p1[5]));
-        int st = (int)ceil(max(10, dc/10));
+    int st = line9_steps(p1, p2);
+    if(st > 1) {
         int i;
 
         for(i=1; i<=st; i++) {
@@ -1644,13 +1600,9 @@ static void line9(const double p1[9], const double p2[9], const char *geometry)
 }
 
 static void line9b(const double p1[9], const double p2[9], const char *geometry) {
+    int st = line9_steps(p1, p2);
     glvertex9(p1, geometry);
-    if(p1[3] != p2[3] || p1[4] != p2[4] || p1[5] != p2[5]) {
-        double dc = max3(
-            fabs(p2[3] - p1[3]),
-            fabs(p2[4] - p1[4]),
-            fabs(p2[5] - p1[5]));
-        int st = (int)ceil(max(10, dc/10));
+    if(st > 1) {
         int i;
 
         for(i=1; i<=st; i++) {
@@ -1819,6 +1771,250 @@ static PyObject *pydraw_dwells(PyObject *s, PyObject *o) {
     return Py_None;
 }
 
+/* The moves and dwells of a loaded program as native vertex arrays, see
+   toolpath.hh.  glcanon builds them once from its lists and draws them
+   every frame. */
+typedef struct {
+    PyObject_HEAD
+    Toolpath *path;
+    int segments, levels;
+    long vertices;
+} pyToolpath;
+
+static int Toolpath_init(pyToolpath *self, PyObject *a, PyObject *k) {
+    PyListObject *li;
+    char *geometry;
+    double p1[9], p2[9];
+    int i, n;
+
+    if(!PyArg_ParseTuple(a, "sO!:toolpath", &geometry, &PyList_Type, &li))
+        return -1;
+
+    Toolpath *path = new Toolpath(geometry);
+    for(i=0; i<PyList_GET_SIZE(li); i++) {
+        PyObject *it = PyList_GET_ITEM(li, i);
+        PyObject *dummy1, *dummy2, *dummy3;
+        if(!PyArg_ParseTuple(it, "i(ddddddddd)(ddddddddd)|OOO", &n,
+                    p1+0, p1+1, p1+2,
+                    p1+3, p1+4, p1+5,
+                    p1+6, p1+7, p1+8,
+                    p2+0, p2+1, p2+2,
+                    p2+3, p2+4, p2+5,
+                    p2+6, p2+7, p2+8,
+                    &dummy1, &dummy2, &dummy3)) {
+            delete path;
+            return -1;
+        }
+        path->add(n, p1, p2);
+    }
+    path->finish();
+
+    delete self->path;
+    self->path = path;
+    self->segments = path->segments();
+    self->vertices = path->vertices();
+    self->levels = path->nlevels();
+    return 0;
+}
+
+static void Toolpath_dealloc(pyToolpath *s) {
+    delete s->path;
+    PyObject_Del(s);
+}
+
+static PyObject *Toolpath_draw(pyToolpath *s, PyObject *o) {
+    int for_selection = 0;
+    if(!PyArg_ParseTuple(o, "|i:toolpath.draw", &for_selection))
+        return NULL;
+    if(!s->path)
+        return PyInt_FromLong(0);
+    if(for_selection) {
+        s->path->draw_selection();
+        return PyInt_FromLong(0);
+    }
+    return PyInt_FromLong(s->path->draw());
+}
+
+static PyObject *Toolpath_highlight(pyToolpath *s, PyObject *o) {
+    int line;
+    double sum[3] = {0, 0, 0};
+    long n = 0;
+    if(!PyArg_ParseTuple(o, "i:toolpath.highlight", &line))
+        return NULL;
+    if(s->path)
+        n = s->path->highlight(line, sum);
+    return Py_BuildValue("lddd", n, sum[0], sum[1], sum[2]);
+}
+
+static PyMemberDef Toolpath_members[] = {
+    {(char*)"segments", T_INT, offsetof(pyToolpath, segments), READONLY},
+    {(char*)"vertices", T_LONG, offsetof(pyToolpath, vertices), READONLY},
+    {(char*)"levels", T_INT, offsetof(pyToolpath, levels), READONLY},
+    {0, 0, 0, 0},
+};
+
+static PyMethodDef Toolpath_methods[] = {
+    {"draw", (PyCFunction)Toolpath_draw, METH_VARARGS,
+        "Draw the moves, or load their line numbers as names if ARG is true; "
+        "returns the number of vertices drawn"},
+    {"highlight", (PyCFunction)Toolpath_highlight, METH_VARARGS,
+        "Draw the moves of line ARG and return the number of their vertices "
+        "and the sums of their x, y and z"},
+    {NULL, NULL, 0, NULL},
+};
+
+static PyTypeObject ToolpathType = {
+    PyObject_HEAD_INIT(NULL)
+    0,                      /*ob_size*/
+    "linuxcnc.toolpath",    /*tp_name*/
+    sizeof(pyToolpath),     /*tp_basicsize*/
+    0,                      /*tp_itemsize*/
+    /* methods */
+    (destructor)Toolpath_dealloc, /*tp_dealloc*/
+    0,                      /*tp_print*/
+    0,                      /*tp_getattr*/
+    0,                      /*tp_setattr*/
+    0,                      /*tp_compare*/
+    0,                      /*tp_repr*/
+    0,                      /*tp_as_number*/
+    0,                      /*tp_as_sequence*/
+    0,                      /*tp_as_mapping*/
+    0,                      /*tp_hash*/
+    0,                      /*tp_call*/
+    0,                      /*tp_str*/
+    0,                      /*tp_getattro*/
+    0,                      /*tp_setattro*/
+    0,                      /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,     /*tp_flags*/
+    0,                      /*tp_doc*/
+    0,                      /*tp_traverse*/
+    0,                      /*tp_clear*/
+    0,                      /*tp_richcompare*/
+    0,                      /*tp_weaklistoffset*/
+    0,                      /*tp_iter*/
+    0,                      /*tp_iternext*/
+    Toolpath_methods,       /*tp_methods*/
+    Toolpath_members,       /*tp_members*/
+    0,                      /*tp_getset*/
+    0,                      /*tp_base*/
+    0,                      /*tp_dict*/
+    0,                      /*tp_descr_get*/
+    0,                      /*tp_descr_set*/
+    0,                      /*tp_dictoffset*/
+    (initproc)Toolpath_init, /*tp_init*/
+    0,                      /*tp_alloc*/
+    PyType_GenericNew,      /*tp_new*/
+    0,                      /*tp_free*/
+    0,                      /*tp_is_gc*/
+};
+
+typedef struct {
+    PyObject_HEAD
+    Dwells *dwells;
+    int count;
+} pyDwells;
+
+static int Dwells_init(pyDwells *self, PyObject *a, PyObject *k) {
+    PyListObject *li;
+    double alpha;
+    int is_lathe = 0, i, n;
+
+    if(!PyArg_ParseTuple(a, "O!di:dwells", &PyList_Type, &li, &alpha, &is_lathe))
+        return -1;
+
+    Dwells *dwells = new Dwells;
+    for(i=0; i<PyList_GET_SIZE(li); i++) {
+        PyObject *it = PyList_GET_ITEM(li, i);
+        double red, green, blue, x, y, z;
+        int axis;
+        if(!PyArg_ParseTuple(it, "i(ddd)dddi", &n, &red, &green, &blue, &x, &y, &z, &axis)) {
+            delete dwells;
+            return -1;
+        }
+        float color[4] = { (float)red, (float)green, (float)blue, (float)alpha };
+        if (is_lathe == 1)
+            axis = 1;
+        dwells->add(n, color, x, y, z, axis);
+    }
+
+    delete self->dwells;
+    self->dwells = dwells;
+    self->count = dwells->size();
+    return 0;
+}
+
+static void Dwells_dealloc(pyDwells *s) {
+    delete s->dwells;
+    PyObject_Del(s);
+}
+
+static PyObject *Dwells_draw(pyDwells *s, PyObject *o) {
+    int for_selection = 0;
+    if(!PyArg_ParseTuple(o, "|i:dwells.draw", &for_selection))
+        return NULL;
+    if(s->dwells) {
+        if(for_selection) s->dwells->draw_selection();
+        else s->dwells->draw();
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMemberDef Dwells_members[] = {
+    {(char*)"count", T_INT, offsetof(pyDwells, count), READONLY},
+    {0, 0, 0, 0},
+};
+
+static PyMethodDef Dwells_methods[] = {
+    {"draw", (PyCFunction)Dwells_draw, METH_VARARGS,
+        "Draw the dwells, or load their line numbers as names if ARG is true"},
+    {NULL, NULL, 0, NULL},
+};
+
+static PyTypeObject DwellsType = {
+    PyObject_HEAD_INIT(NULL)
+    0,                      /*ob_size*/
+    "linuxcnc.dwells",      /*tp_name*/
+    sizeof(pyDwells),       /*tp_basicsize*/
+    0,                      /*tp_itemsize*/
+    /* methods */
+    (destructor)Dwells_dealloc, /*tp_dealloc*/
+    0,                      /*tp_print*/
+    0,                      /*tp_getattr*/
+    0,                      /*tp_setattr*/
+    0,                      /*tp_compare*/
+    0,                      /*tp_repr*/
+    0,                      /*tp_as_number*/
+    0,                      /*tp_as_sequence*/
+    0,                      /*tp_as_mapping*/
+    0,                      /*tp_hash*/
+    0,                      /*tp_call*/
+    0,                      /*tp_str*/
+    0,                      /*tp_getattro*/
+    0,                      /*tp_setattro*/
+    0,                      /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,     /*tp_flags*/
+    0,                      /*tp_doc*/
+    0,                      /*tp_traverse*/
+    0,                      /*tp_clear*/
+    0,                      /*tp_richcompare*/
+    0,                      /*tp_weaklistoffset*/
+    0,                      /*tp_iter*/
+    0,                      /*tp_iternext*/
+    Dwells_methods,         /*tp_methods*/
+    Dwells_members,         /*tp_members*/
+    0,                      /*tp_getset*/
+    0,                      /*tp_base*/
+    0,                      /*tp_dict*/
+    0,                      /*tp_descr_get*/
+    0,                      /*tp_descr_set*/
+    0,                      /*tp_dictoffset*/
+    (initproc)Dwells_init,  /*tp_init*/
+    0,                      /*tp_alloc*/
+    PyType_GenericNew,      /*tp_new*/
+    0,                      /*tp_free*/
+    0,                      /*tp_is_gc*/
+};
+
 struct color {
     unsigned char r, g, b, a;
     bool operator==(const color &o) const {
@@ -1836,18 +2032,35 @@ struct logger_point {
     struct color c2;
 };
 
+/* Points are kept in chunks that are never moved or resized once
+   allocated, so adding a point never copies the plot and the oldest
+   points are dropped a whole chunk at a time.  For a line strip each
+   chunk after the first starts with a copy of the point before it. */
+#define LOGGER_CHUNK (4096)
+struct logger_chunk {
+    int n;
+    struct logger_point p[LOGGER_CHUNK];
+};
+
 #define NUMCOLORS (6)
-#define MAX_POINTS (10000)
+#define MAX_POINTS (1000000)
+#define TRACE_BATCH (256)
 typedef struct {
     PyObject_HEAD
-    int npts, mpts, lpts;
-    struct logger_point *p;
+    int npts, lpts;
+    std::deque<logger_chunk *> *chunks;
+    logger_chunk *spare;
+    struct logger_point lp;	// the last point plotted
     struct color colors[NUMCOLORS];
-    bool exit, clear, changed;
+    bool exit, clear;
     char *geometry;
     int is_xyuv;
     double foam_z, foam_w;
     pyStatChannel *st;
+    // the position trace written by motion, or 0 when polling EMC_STAT
+    const emcmot_trace_t *trace;
+    unsigned int trace_next, trace_lost;
+    int trace_retry;
 } pyPositionLogger;
 
 static const double epsilon = 1e-4; // 1-cos(1 deg) ~= 1e-4
@@ -1873,14 +2086,17 @@ static void UNLOCK() { pthread_mutex_unlock(&mutex); }
 static int Logger_init(pyPositionLogger *self, PyObject *a, PyObject *k) {
     char *geometry;
     struct color *c = self->colors;
-    self->p = (logger_point*)malloc(0);
-    self->npts = self->mpts = 0;
+    self->chunks = new std::deque<logger_chunk *>;
+    self->spare = 0;
+    self->npts = self->lpts = 0;
     self->exit = self->clear = 0;
-    self->changed = 1;
     self->st = 0;
     self->is_xyuv = 0;
     self->foam_z = 0;
     self->foam_w = 1.5;  // temporarily hard-code
+    self->trace = 0;
+    self->trace_next = self->trace_lost = 0;
+    self->trace_retry = 0;
     if(!PyArg_ParseTuple(a, "O!(BBBB)(BBBB)(BBBB)(BBBB)(BBBB)(BBBB)s|i",
             &Stat_Type, &self->st,
             &c[0].r,&c[0].g, &c[0].b, &c[0].a,
@@ -1897,13 +2113,83 @@ static int Logger_init(pyPositionLogger *self, PyObject *a, PyObject *k) {
     return 0;
 }
 
+static void Logger_free_chunks(pyPositionLogger *s) {
+    for(size_t i = 0; i < s->chunks->size(); i++)
+        free((*s->chunks)[i]);
+    s->chunks->clear();
+}
+
 static void Logger_dealloc(pyPositionLogger *s) {
-    free(s->p);
+    if(s->chunks) {
+        Logger_free_chunks(s);
+        delete s->chunks;
+    }
+    free(s->spare);
+    if(s->trace) shmdt((void *)s->trace);
     Py_XDECREF(s->st);
     free(s->geometry);
     PyObject_Del(s);
 }
 
+/* The k-th point from the end, 1 being the last, or 0 if there are
+   fewer points than that. */
+static struct logger_point *Logger_point(pyPositionLogger *s, int k) {
+    std::deque<logger_chunk *> &chunks = *s->chunks;
+    int copy = s->is_xyuv ? 0 : 1;
+    for(size_t i = chunks.size(); i--; ) {
+        logger_chunk *c = chunks[i];
+        int first = i ? copy : 0;
+        if(k <= c->n - first) return &c->p[c->n - k];
+        k -= c->n - first;
+    }
+    return 0;
+}
+
+/* Room for one more point; it is counted by Logger_commit() once it
+   has been filled in, so the plot never draws a half written point. */
+static struct logger_point *Logger_next(pyPositionLogger *s) {
+    std::deque<logger_chunk *> &chunks = *s->chunks;
+    if(!chunks.empty() && chunks.back()->n < LOGGER_CHUNK)
+        return &chunks.back()->p[chunks.back()->n];
+
+    logger_chunk *c = s->spare;
+    s->spare = 0;
+    if(!c) c = (logger_chunk *)malloc(sizeof(logger_chunk));
+    c->n = 0;
+    if(!chunks.empty() && !s->is_xyuv)
+        c->p[c->n++] = chunks.back()->p[LOGGER_CHUNK-1];
+    LOCK();
+    chunks.push_back(c);
+    if(s->npts > MAX_POINTS) {
+        // the next chunk's copy of the point before it becomes a point
+        // of its own
+        logger_chunk *f = chunks.front();
+        chunks.pop_front();
+        s->npts -= f->n - (s->is_xyuv ? 0 : 1);
+        s->lpts = std::min(s->lpts, s->npts);
+        s->spare = f;
+    }
+    UNLOCK();
+    return &c->p[c->n];
+}
+
+static void Logger_commit(pyPositionLogger *s) {
+    s->chunks->back()->n++;
+    s->npts++;
+}
+
+static void Logger_clear_points(pyPositionLogger *s) {
+    LOCK();
+    if(!s->spare && !s->chunks->empty()) {
+        s->spare = s->chunks->back();
+        s->chunks->pop_back();
+    }
+    Logger_free_chunks(s);
+    s->npts = 0;
+    s->lpts = 0;
+    UNLOCK();
+}
+
 static PyObject *Logger_set_depth(pyPositionLogger *s, PyObject *o) {
     double z, w;
     if(!PyArg_ParseTuple(o, "dd:logger.set_depth", &z, &w)) return NULL;
@@ -1919,6 +2205,128 @@ static double dist2(double x1, double y1, double x2, double y2) {
     return dx*dx + dy*dy;
 }
 
+/* Add a position to the plot, or move the last point there when the
+   last three points are on a line. */
+static void Logger_add(pyPositionLogger *s, const EMC_STAT *status,
+        const EmcPose &pos, int colornum) {
+    if(colornum < 0 || colornum > NUMCOLORS) colornum = 0;
+    struct color c = s->colors[colornum];
+    struct logger_point *op = Logger_point(s, 1);
+    struct logger_point *oop = Logger_point(s, 2);
+    bool add_point = s->npts < 2 || c != op->c;
+    double x, y, z, rx, ry, rz;
+    if(s->is_xyuv) {
+        x = pos.tran.x - status->task.toolOffset.tran.x,
+        y = pos.tran.y - status->task.toolOffset.tran.y,
+        z = s->foam_z;
+        rx = pos.u - status->task.toolOffset.u,
+        ry = pos.v - status->task.toolOffset.v,
+        rz = s->foam_w;
+        /* TODO .01, the distance at which a preview line is dropped,
+         * should either be dependent on units or configurable, because
+         * 0.1 is inappropriate for mm systems
+         */
+        add_point = add_point || (dist2(x, y, oop->x, oop->y) > .01)
+            || (dist2(rx, ry, oop->rx, oop->ry) > .01);
+        add_point = add_point || !colinear( x, y, z,
+                        op->x, op->y, op->z,
+                        oop->x, oop->y, oop->z);
+        add_point = add_point || !colinear( rx, ry, rz,
+                        op->rx, op->ry, op->rz,
+                        oop->rx, oop->ry, oop->rz);
+    } else {
+        double pt[9] = {
+            pos.tran.x - status->task.toolOffset.tran.x,
+            pos.tran.y - status->task.toolOffset.tran.y,
+            pos.tran.z - status->task.toolOffset.tran.z,
+            pos.a - status->task.toolOffset.a,
+            pos.b - status->task.toolOffset.b,
+            pos.c - status->task.toolOffset.c,
+            pos.u - status->task.toolOffset.u,
+            pos.v - status->task.toolOffset.v,
+            pos.w - status->task.toolOffset.w};
+
+        double p[3];
+        vertex9(pt, p, s->geometry);
+        x = p[0]; y = p[1]; z = p[2];
+        rx = pt[3]; ry = -pt[4]; rz = pt[5];
+
+        add_point = add_point || !colinear( x, y, z,
+                        op->x, op->y, op->z,
+                        oop->x, oop->y, oop->z);
+    }
+    if(add_point) {
+        bool changed_color = s->npts && c != op->c;
+        if(changed_color) {
+            float ox = op->x, oy = op->y, oz = op->z;
+            {
+            struct logger_point &np = *Logger_next(s);
+            np.x = ox; np.y = oy; np.z = oz;
+            np.rx = rx; np.ry = ry; np.rz = rz;
+            np.c = np.c2 = c;
+            Logger_commit(s);
+            }
+            {
+            struct logger_point &np = *Logger_next(s);
+            np.x = x; np.y = y; np.z = z;
+            np.rx = rx; np.ry = ry; np.rz = rz;
+            np.c = np.c2 = c;
+            Logger_commit(s);
+            }
+        } else {
+            struct logger_point &np = *Logger_next(s);
+            np.x = x; np.y = y; np.z = z;
+            np.rx = rx; np.ry = ry; np.rz = rz;
+            np.c = np.c2 = c;
+            Logger_commit(s);
+        }
+    } else {
+        struct logger_point &np = *op;
+        np.x = x; np.y = y; np.z = z;
+        np.rx = rx; np.ry = ry; np.rz = rz;
+    }
+}
+
+/* Add the points motion traced since the last call, then its current
+   position.  Returns false, and the caller polls EMC_STAT instead, when
+   there is no trace to read: motion is not running on this machine or
+   its realtime shared memory is not SysV. */
+static bool Logger_trace(pyPositionLogger *s, const EMC_STAT *status) {
+    if(!s->trace) {
+        // look for motion again every 100 polls
+        if(s->trace_retry-- > 0) return false;
+        s->trace_retry = 100;
+        int id = shmget(DEFAULT_TRACE_SHMEM_KEY, 0, 0);
+        if(id < 0) return false;
+        void *addr = shmat(id, 0, SHM_RDONLY);
+        if(addr == (void *)-1) return false;
+        const emcmot_trace_t *trace = (const emcmot_trace_t *)addr;
+        if(trace->magic != EMCMOT_TRACE_MAGIC
+                || trace->size != EMCMOT_TRACE_SIZE) {
+            shmdt(addr);
+            return false;
+        }
+        s->trace = trace;
+        s->trace_next = trace->head + 1;
+    }
+
+    emcmot_trace_point_t pts[TRACE_BATCH], live;
+    int n;
+    do {
+        n = emcmotTraceRead(s->trace, &s->trace_next, pts, TRACE_BATCH,
+                &live, &s->trace_lost);
+        if(n < 0) {
+            shmdt((void *)s->trace);
+            s->trace = 0;
+            return false;
+        }
+        for(int i = 0; i < n; i++)
+            Logger_add(s, status, pts[i].pos, pts[i].motion_type);
+    } while(n == TRACE_BATCH);
+    Logger_add(s, status, live.pos, live.motion_type);
+    return true;
+}
+
 static PyObject *Logger_start(pyPositionLogger *s, PyObject *o) {
     double interval;
     struct timespec ts;
@@ -1931,117 +2339,28 @@ static PyObject *Logger_start(pyPositionLogger *s, PyObject *o) {
 
     s->exit = 0;
     s->clear = 0;
-    s->npts = 0;
+    Logger_clear_points(s);
+    s->trace_retry = 0;
 
     Py_BEGIN_ALLOW_THREADS
     while(!s->exit) {
         if(s->clear) {
-            s->npts = 0;
-            s->lpts = 0;
+            Logger_clear_points(s);
             s->clear = 0;
         }
         if(s->st->c->valid() && s->st->c->peek() == EMC_STAT_TYPE) {
             EMC_STAT *status = static_cast<EMC_STAT*>(s->st->c->get_address());
-            int colornum = 2;
-            colornum = status->motion.traj.motion_type;
-            if(colornum < 0 || colornum > NUMCOLORS) colornum = 0;
-            struct color c = s->colors[colornum];
-            struct logger_point *op = &s->p[s->npts-1];
-            struct logger_point *oop = &s->p[s->npts-2];
-            bool add_point = s->npts < 2 || c != op->c;
-            double x, y, z, rx, ry, rz;
-            if(s->is_xyuv) {
-                x = status->motion.traj.position.tran.x - status->task.toolOffset.tran.x,
-                y = status->motion.traj.position.tran.y - status->task.toolOffset.tran.y,
-                z = s->foam_z;
-                rx = status->motion.traj.position.u - status->task.toolOffset.u,
-                ry = status->motion.traj.position.v - status->task.toolOffset.v,
-                rz = s->foam_w;
-                /* TODO .01, the distance at which a preview line is dropped,
-                 * should either be dependent on units or configurable, because
-                 * 0.1 is inappropriate for mm systems
-                 */
-                add_point = add_point || (dist2(x, y, oop->x, oop->y) > .01)
-                    || (dist2(rx, ry, oop->rx, oop->ry) > .01);
-                add_point = add_point || !colinear( x, y, z,
-                                op->x, op->y, op->z,
-                                oop->x, oop->y, oop->z);
-                add_point = add_point || !colinear( rx, ry, rz,
-                                op->rx, op->ry, op->rz,
-                                oop->rx, oop->ry, oop->rz);
-            } else {
-                double pt[9] = {
-                    status->motion.traj.position.tran.x - status->task.toolOffset.tran.x,
-                    status->motion.traj.position.tran.y - status->task.toolOffset.tran.y,
-                    status->motion.traj.position.tran.z - status->task.toolOffset.tran.z,
-                    status->motion.traj.position.a - status->task.toolOffset.a,
-                    status->motion.traj.position.b - status->task.toolOffset.b,
-                    status->motion.traj.position.c - status->task.toolOffset.c,
-                    status->motion.traj.position.u - status->task.toolOffset.u,
-                    status->motion.traj.position.v - status->task.toolOffset.v,
-                    status->motion.traj.position.w - status->task.toolOffset.w};
-
-                double p[3];
-                vertex9(pt, p, s->geometry);
-                x = p[0]; y = p[1]; z = p[2];
-                rx = pt[3]; ry = -pt[4]; rz = pt[5];
-
-                add_point = add_point || !colinear( x, y, z,
-                                op->x, op->y, op->z,
-                                oop->x, oop->y, oop->z);
-            }
-            if(add_point) {
-                // 1 or 2 points may be added, make room whenever
-                // fewer than 2 are left
-                bool changed_color = s->npts && c != op->c;
-                if(s->npts+2 > s->mpts) {
-                    LOCK();
-                    if(s->mpts >= MAX_POINTS) {
-                        int adjust = MAX_POINTS / 10;
-                        if(adjust < 2) adjust = 2;
-                        s->npts -= adjust;
-                        memmove(s->p, s->p + adjust,
-                                sizeof(struct logger_point) * s->npts);
-                    } else {
-                        s->mpts = 2 * s->mpts + 2;
-                        s->changed = 1;
-                        s->p = (struct logger_point*) realloc(s->p,
-                                    sizeof(struct logger_point) * s->mpts);
-                    }
-                    UNLOCK();
-                    op = &s->p[s->npts-1];
-                    oop = &s->p[s->npts-2];
-                }
-                if(changed_color) {
-                    {
-                    struct logger_point &np = s->p[s->npts];
-                    np.x = op->x; np.y = op->y; np.z = op->z;
-                    np.rx = rx; np.ry = ry; np.rz = rz;
-                    np.c = np.c2 = c;
-                    }
-                    {
-                    struct logger_point &np = s->p[s->npts+1];
-                    np.x = x; np.y = y; np.z = z;
-                    np.rx = rx; np.ry = ry; np.rz = rz;
-                    np.c = np.c2 = c;
-                    }
-                    s->npts += 2;
-                } else {
-                    struct logger_point &np = s->p[s->npts];
-                    np.x = x; np.y = y; np.z = z;
-                    np.rx = rx; np.ry = ry; np.rz = rz;
-                    np.c = np.c2 = c;
-                    s->npts++;
-                }
-            } else {
-                struct logger_point &np = s->p[s->npts-1];
-                np.x = x; np.y = y; np.z = z;
-                np.rx = rx; np.ry = ry; np.rz = rz;
-            }
+            if(!Logger_trace(s, status))
+                Logger_add(s, status, status->motion.traj.position,
+                        status->motion.traj.motion_type);
         }
         nanosleep(&ts, NULL);
     }
     Py_END_ALLOW_THREADS
+    if(s->trace) {
+        shmdt((void *)s->trace);
+        s->trace = 0;
+    }
     Py_DECREF(s->st);
     Py_INCREF(Py_None);
     return Py_None;
@@ -2062,31 +2381,27 @@ static PyObject* Logger_stop(pyPositionLogger *s, PyObject *o) {
 static PyObject* Logger_call(pyPositionLogger *s, PyObject *o) {
     if(!s->clear) {
         LOCK();
-        if(s->is_xyuv) {
-            if(s->changed) {
+        std::deque<logger_chunk *> &chunks = *s->chunks;
+        glEnableClientState(GL_COLOR_ARRAY);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        for(size_t i = 0; i < chunks.size(); i++) {
+            logger_chunk *c = chunks[i];
+            if(s->is_xyuv) {
                 glVertexPointer(3, GL_FLOAT,
-                        sizeof(struct logger_point)/2, &s->p->x);
+                        sizeof(struct logger_point)/2, &c->p->x);
                 glColorPointer(4, GL_UNSIGNED_BYTE,
-                        sizeof(struct logger_point)/2, &s->p->c);
-                glEnableClientState(GL_COLOR_ARRAY);
-                glEnableClientState(GL_VERTEX_ARRAY);
-                s->changed = 0;
-            }
-            s->lpts = s->npts;
-            glDrawArrays(GL_LINES, 0, 2*s->npts);
-        } else {
-            if(s->changed) {
+                        sizeof(struct logger_point)/2, &c->p->c);
+                glDrawArrays(GL_LINES, 0, 2*c->n);
+            } else {
                 glVertexPointer(3, GL_FLOAT,
-                        sizeof(struct logger_point), &s->p->x);
+                        sizeof(struct logger_point), &c->p->x);
                 glColorPointer(4, GL_UNSIGNED_BYTE,
-                        sizeof(struct logger_point), &s->p->c);
-                glEnableClientState(GL_COLOR_ARRAY);
-                glEnableClientState(GL_VERTEX_ARRAY);
-                s->changed = 0;
+                        sizeof(struct logger_point), &c->p->c);
+                glDrawArrays(GL_LINE_STRIP, 0, c->n);
             }
-            s->lpts = s->npts;
-            glDrawArrays(GL_LINE_STRIP, 0, s->npts);
         }
+        s->lpts = s->npts;
+        if(s->npts) s->lp = *Logger_point(s, 1);
         UNLOCK();
     }
     Py_INCREF(Py_None);
@@ -2098,13 +2413,13 @@ static PyObject *Logger_last(pyPositionLogger *s, PyObject *o) {
     if(!PyArg_ParseTuple(o, "|i:emc.positionlogger.last", &flag)) return NULL;
     PyObject *result = NULL;
     LOCK();
-    int idx = flag ? s->lpts : s->npts;
-    if(!idx) {
+    struct logger_point *pp = flag ? (s->lpts ? &s->lp : 0) : Logger_point(s, 1);
+    if(!pp) {
         Py_INCREF(Py_None);
         result = Py_None;
     } else {
         result = PyTuple_New(6);
-        struct logger_point &p = s->p[idx-1];
+        struct logger_point &p = *pp;
         PyTuple_SET_ITEM(result, 0, PyFloat_FromDouble(p.x));
         PyTuple_SET_ITEM(result, 1, PyFloat_FromDouble(p.y));
         PyTuple_SET_ITEM(result, 2, PyFloat_FromDouble(p.z));
@@ -2118,6 +2433,7 @@ static PyObject *Logger_last(pyPositionLogger *s, PyObject *o) {
 
 static PyMemberDef Logger_members[] = {
     {(char*)"npts", T_INT, offsetof(pyPositionLogger, npts), READONLY},
+    {(char*)"lost", T_UINT, offsetof(pyPositionLogger, trace_lost), READONLY},
     {0, 0, 0, 0},
 };
 
@@ -2221,6 +2537,10 @@ initlinuxcnc(void) {
 
     PyType_Ready(&PositionLoggerType);
     PyModule_AddObject(m, "positionlogger", (PyObject*)&PositionLoggerType);
+    PyType_Ready(&ToolpathType);
+    PyModule_AddObject(m, "toolpath", (PyObject*)&ToolpathType);
+    PyType_Ready(&DwellsType);
+    PyModule_AddObject(m, "dwells", (PyObject*)&DwellsType);
     pthread_mutex_init(&mutex, NULL);
 
     PyModule_AddStringConstant(m, "PREFIX", EMC2_HOME);
@@ -0,0 +1,472 @@
+//    This is a component of AXIS, a front-end for LinuxCNC
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include "toolpath.hh"
+
+/* vertices in a block; smaller blocks cull closer to the view */
+#define BLOCK (256)
+/* error allowed in a level of detail, in pixels */
+#define LOD_PIXELS (0.5)
+/* the finest level of detail is this fraction of the size of the path */
+#define LOD_FINEST (1.0 / 65536)
+
+static void rotate_z(double pt[3], double a) {
+    double theta = a * M_PI / 180;
+    double c = cos(theta), s = sin(theta);
+    double tx, ty;
+    tx = pt[0] * c - pt[1] * s;
+    ty = pt[0] * s + pt[1] * c;
+
+    pt[0] = tx; pt[1] = ty;
+}
+
+static void rotate_y(double pt[3], double a) {
+    double theta = a * M_PI / 180;
+    double c = cos(theta), s = sin(theta);
+    double tx, tz;
+    tx = pt[0] * c - pt[2] * s;
+    tz = pt[0] * s + pt[2] * c;
+
+    pt[0] = tx; pt[2] = tz;
+}
+
+static void rotate_x(double pt[3], double a) {
+    double theta = a * M_PI / 180;
+    double c = cos(theta), s = sin(theta);
+    double tx, tz;
+    tx = pt[1] * c - pt[2] * s;
+    tz = pt[1] * s + pt[2] * c;
+
+    pt[1] = tx; pt[2] = tz;
+}
+
+static void translate(double pt[3], double ox, double oy, double oz) {
+    pt[0] += ox;
+    pt[1] += oy;
+    pt[2] += oz;
+}
+
+void vertex9(const double pt[9], double p[3], const char *geometry) {
+    double sign = 1;
+
+    p[0] = 0;
+    p[1] = 0;
+    p[2] = 0;
+
+    for(; *geometry; geometry++) {
+        switch(*geometry) {
+            case '-': sign = -1; break;
+            case 'X': translate(p, pt[0] * sign, 0, 0); sign=1; break;
+            case 'Y': translate(p, 0, pt[1] * sign, 0); sign=1; break;
+            case 'Z': translate(p, 0, 0, pt[2] * sign); sign=1; break;
+            case 'U': translate(p, pt[6] * sign, 0, 0); sign=1; break;
+            case 'V': translate(p, 0, pt[7] * sign, 0); sign=1; break;
+            case 'W': translate(p, 0, 0, pt[8] * sign); sign=1; break;
+            case 'A': rotate_x(p, pt[3] * sign); sign=1; break;
+            case 'B': rotate_y(p, pt[4] * sign); sign=1; break;
+            case 'C': rotate_z(p, pt[5] * sign); sign=1; break;
+        }
+    }
+}
+
+int line9_steps(const double p1[9], const double p2[9]) {
+    if(p1[3] == p2[3] && p1[4] == p2[4] && p1[5] == p2[5])
+        return 1;
+    double dc = std::max(fabs(p2[3] - p1[3]),
+            std::max(fabs(p2[4] - p1[4]), fabs(p2[5] - p1[5])));
+    return (int)ceil(std::max(10., dc/10));
+}
+
+Toolpath::Toolpath(const char *geometry) :
+        geometry(geometry), nsegments(0), levels(1), in_strip(false),
+        strip_first(0) {
+    levels[0].tolerance = 0;
+}
+
+void Toolpath::end_strip() {
+    level &l = levels[0];
+    if(!in_strip) return;
+    strip s = { strip_first, (unsigned)(l.v.size() / 3 - strip_first) };
+    l.strips.push_back(s);
+    in_strip = false;
+}
+
+void Toolpath::add(int line, const double p1[9], const double p2[9]) {
+    std::vector<float> &v = levels[0].v;
+    double p[3];
+
+    nsegments++;
+    if(!in_strip || memcmp(p1, last, sizeof(last))) {
+        end_strip();
+        strip_first = v.size() / 3;
+        in_strip = true;
+        vertex9(p1, p, geometry.c_str());
+        v.insert(v.end(), p, p + 3);
+        range r = { line, strip_first, 1 };
+        ranges.push_back(r);
+    } else if(ranges.back().line != line) {
+        range r = { line, (unsigned)(v.size() / 3 - 1), 1 };
+        ranges.push_back(r);
+    }
+
+    int st = line9_steps(p1, p2);
+    if(st == 1) {
+        vertex9(p2, p, geometry.c_str());
+        v.insert(v.end(), p, p + 3);
+    } else {
+        for(int i=1; i<=st; i++) {
+            double t = i * 1.0 / st;
+            double pt[9];
+            for(int j=0; j<9; j++) { pt[j] = t * p2[j] + (1.0 - t) * p1[j]; }
+            vertex9(pt, p, geometry.c_str());
+            v.insert(v.end(), p, p + 3);
+        }
+    }
+    ranges.back().count += st;
+    memcpy(last, p2, sizeof(last));
+}
+
+struct by_line_less {
+    const std::vector<int> &line;
+    bool operator()(unsigned a, unsigned b) const { return line[a] < line[b]; }
+};
+
+void Toolpath::finish() {
+    end_strip();
+    make_blocks(levels[0]);
+
+    std::vector<int> line(ranges.size());
+    by_line.resize(ranges.size());
+    for(size_t i = 0; i < ranges.size(); i++) {
+        line[i] = ranges[i].line;
+        by_line[i] = i;
+    }
+    by_line_less less = { line };
+    std::stable_sort(by_line.begin(), by_line.end(), less);
+
+    // each level is simplified from the one before, so its error is the
+    // tolerance of that level plus what is taken away now
+    const std::vector<block> &b = levels[0].blocks;
+    if(b.empty()) return;
+    double size = 0;
+    for(int k = 0; k < 3; k++) {
+        float lo = b[0].lo[k], hi = b[0].hi[k];
+        for(size_t i = 1; i < b.size(); i++) {
+            lo = std::min(lo, b[i].lo[k]);
+            hi = std::max(hi, b[i].hi[k]);
+        }
+        size += (double)(hi - lo) * (hi - lo);
+    }
+    size = sqrt(size);
+    for(double tolerance = size * LOD_FINEST; tolerance < size;
+            tolerance *= 2) {
+        const level &from = levels.back();
+        if(from.v.size() / 3 <= 2 * from.strips.size())
+            break;
+        level to;
+        simplify(from, to, tolerance - from.tolerance);
+        // keep only levels that are worth their memory
+        if(to.v.size() > from.v.size() * 3 / 4)
+            continue;
+        to.tolerance = tolerance;
+        make_blocks(to);
+        levels.push_back(level());
+        std::swap(levels.back(), to);
+    }
+}
+
+void Toolpath::make_blocks(level &l) {
+    l.blocks.clear();
+    for(size_t i = 0; i < l.strips.size(); i++) {
+        unsigned first = l.strips[i].first, end = first + l.strips[i].count;
+        for(unsigned s = first; ; s += BLOCK - 1) {
+            block b;
+            b.first = s;
+            b.count = std::min(end - s, (unsigned)BLOCK);
+            b.joined = s != first;
+            const float *p = &l.v[3 * s];
+            for(int k = 0; k < 3; k++) b.lo[k] = b.hi[k] = p[k];
+            for(unsigned j = 1; j < b.count; j++) {
+                p += 3;
+                for(int k = 0; k < 3; k++) {
+                    b.lo[k] = std::min(b.lo[k], p[k]);
+                    b.hi[k] = std::max(b.hi[k], p[k]);
+                }
+            }
+            l.blocks.push_back(b);
+            if(s + b.count == end) break;
+        }
+    }
+}
+
+static double distance2(const float *p, const float *a, const float *b) {
+    double ab[3], ap[3], ab2 = 0, t = 0, d2 = 0;
+    for(int k = 0; k < 3; k++) {
+        ab[k] = (double)b[k] - a[k];
+        ap[k] = (double)p[k] - a[k];
+        ab2 += ab[k] * ab[k];
+        t += ap[k] * ab[k];
+    }
+    if(ab2 > 0) t = std::min(1., std::max(0., t / ab2));
+    else t = 0;
+    for(int k = 0; k < 3; k++) {
+        double d = ap[k] - t * ab[k];
+        d2 += d * d;
+    }
+    return d2;
+}
+
+/* Douglas-Peucker on each strip: keep the point furthest from the chord
+   while it is further than 'tolerance' and look again on both sides */
+void Toolpath::simplify(const level &from, level &to, double tolerance) {
+    double tol2 = tolerance * tolerance;
+    std::vector<bool> keep;
+    std::vector<std::pair<unsigned, unsigned> > todo;
+
+    for(size_t i = 0; i < from.strips.size(); i++) {
+        unsigned first = from.strips[i].first, count = from.strips[i].count;
+        const float *v = &from.v[3 * first];
+        keep.assign(count, false);
+        keep[0] = keep[count - 1] = true;
+        todo.push_back(std::make_pair(0u, count - 1));
+        while(!todo.empty()) {
+            unsigned a = todo.back().first, b = todo.back().second;
+            todo.pop_back();
+            double dmax = tol2;
+            unsigned kmax = 0;
+            for(unsigned k = a + 1; k < b; k++) {
+                double d = distance2(v + 3 * k, v + 3 * a, v + 3 * b);
+                if(d > dmax) { dmax = d; kmax = k; }
+            }
+            if(!kmax) continue;
+            keep[kmax] = true;
+            todo.push_back(std::make_pair(a, kmax));
+            todo.push_back(std::make_pair(kmax, b));
+        }
+        strip s = { (unsigned)(to.v.size() / 3), 0 };
+        for(unsigned k = 0; k < count; k++) {
+            if(!keep[k]) continue;
+            to.v.insert(to.v.end(), v + 3 * k, v + 3 * k + 3);
+            s.count++;
+        }
+        to.strips.push_back(s);
+    }
+}
+
+/* Mark the blocks of 'l' that may be inside the view volume of 'm', the
+   projection times the modelview, and find the smallest clip w of their
+   corners.  Returns the number of blocks marked. */
+int Toolpath::cull(const level &l, const double m[16],
+        std::vector<bool> *visible, double *wmin) {
+    int n = 0;
+    visible->assign(l.blocks.size(), false);
+    if(wmin) *wmin = HUGE_VAL;
+    for(size_t i = 0; i < l.blocks.size(); i++) {
+        const block &b = l.blocks[i];
+        // bit 2k for below -w on axis k, 2k+1 for above w
+        int all = 63;
+        double w0 = HUGE_VAL;
+        for(int c = 0; c < 8; c++) {
+            double x = c & 1 ? b.hi[0] : b.lo[0];
+            double y = c & 2 ? b.hi[1] : b.lo[1];
+            double z = c & 4 ? b.hi[2] : b.lo[2];
+            double w = m[3] * x + m[7] * y + m[11] * z + m[15];
+            int out = 0;
+            for(int k = 0; k < 3; k++) {
+                double q = m[k] * x + m[4 + k] * y + m[8 + k] * z + m[12 + k];
+                if(q < -w) out |= 1 << (2 * k);
+                if(q > w) out |= 2 << (2 * k);
+            }
+            all &= out;
+            w0 = std::min(w0, w);
+        }
+        if(all) continue;
+        (*visible)[i] = true;
+        n++;
+        if(wmin) *wmin = std::min(*wmin, w0);
+    }
+    return n;
+}
+
+long Toolpath::draw() {
+    double mv[16], p[16], m[16];
+    GLint vp[4];
+    std::vector<bool> visible;
+    double wmin;
+
+    if(levels[0].blocks.empty()) return 0;
+    glGetDoublev(GL_MODELVIEW_MATRIX, mv);
+    glGetDoublev(GL_PROJECTION_MATRIX, p);
+    glGetIntegerv(GL_VIEWPORT, vp);
+    for(int c = 0; c < 4; c++)
+        for(int r = 0; r < 4; r++)
+            m[4*c + r] = p[r] * mv[4*c] + p[4 + r] * mv[4*c + 1]
+                + p[8 + r] * mv[4*c + 2] + p[12 + r] * mv[4*c + 3];
+
+    if(!cull(levels[0], m, &visible, &wmin)) return 0;
+
+    // pixels per unit where the visible path is nearest to the eye, or
+    // nowhere when it reaches behind the eye
+    size_t k = 0;
+    if(wmin > 0) {
+        double sx = vp[2] / 2. * sqrt(m[0]*m[0] + m[4]*m[4] + m[8]*m[8]);
+        double sy = vp[3] / 2. * sqrt(m[1]*m[1] + m[5]*m[5] + m[9]*m[9]);
+        double pixel = wmin / std::max(sx, sy);
+        while(k + 1 < levels.size()
+                && levels[k + 1].tolerance <= LOD_PIXELS * pixel)
+            k++;
+    }
+    const level &l = levels[k];
+    if(k) cull(l, m, &visible, 0);
+
+    long drawn = 0;
+    firsts.clear();
+    counts.clear();
+    for(size_t i = 0; i < l.blocks.size(); i++) {
+        const block &b = l.blocks[i];
+        if(!visible[i]) continue;
+        if(b.joined && visible[i - 1]) {
+            counts.back() += b.count - 1;
+            drawn += b.count - 1;
+        } else {
+            firsts.push_back(b.first);
+            counts.push_back(b.count);
+            drawn += b.count;
+        }
+    }
+    if(firsts.empty()) return 0;
+
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, &l.v[0]);
+    glMultiDrawArrays(GL_LINE_STRIP, &firsts[0], &counts[0], firsts.size());
+    glPopClientAttrib();
+    return drawn;
+}
+
+void Toolpath::draw_selection() {
+    double mv[16], p[16], m[16];
+    std::vector<bool> visible;
+    const level &l = levels[0];
+
+    if(l.blocks.empty()) return;
+    glGetDoublev(GL_MODELVIEW_MATRIX, mv);
+    glGetDoublev(GL_PROJECTION_MATRIX, p);
+    for(int c = 0; c < 4; c++)
+        for(int r = 0; r < 4; r++)
+            m[4*c + r] = p[r] * mv[4*c] + p[4 + r] * mv[4*c + 1]
+                + p[8 + r] * mv[4*c + 2] + p[12 + r] * mv[4*c + 3];
+    // with a pick matrix only the blocks around the cursor are left
+    if(!cull(l, m, &visible, 0)) return;
+
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, &l.v[0]);
+    size_t j = 0, nb = l.blocks.size();
+    for(size_t i = 0; i < ranges.size(); i++) {
+        const range &r = ranges[i];
+        while(j < nb && l.blocks[j].first + l.blocks[j].count <= r.first)
+            j++;
+        bool show = false;
+        for(size_t t = j; t < nb && l.blocks[t].first < r.first + r.count; t++)
+            if(visible[t]) { show = true; break; }
+        if(!show) continue;
+        glLoadName(r.line);
+        glDrawArrays(GL_LINE_STRIP, r.first, r.count);
+    }
+    glPopClientAttrib();
+}
+
+long Toolpath::highlight(int line, double sum[3]) {
+    const level &l = levels[0];
+    long n = 0;
+    size_t lo = 0, hi = by_line.size();
+
+    while(lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if(ranges[by_line[mid]].line < line) lo = mid + 1;
+        else hi = mid;
+    }
+    if(lo == by_line.size() || ranges[by_line[lo]].line != line)
+        return 0;
+
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, &l.v[0]);
+    for(; lo < by_line.size() && ranges[by_line[lo]].line == line; lo++) {
+        const range &r = ranges[by_line[lo]];
+        glDrawArrays(GL_LINE_STRIP, r.first, r.count);
+        for(unsigned i = r.first; i < r.first + r.count; i++)
+            for(int k = 0; k < 3; k++)
+                sum[k] += l.v[3*i + k];
+        n += r.count;
+    }
+    glPopClientAttrib();
+    return n;
+}
+
+void Dwells::add(int line, const float color[4], double x, double y,
+        double z, int axis) {
+    static const double delta = 0.015625;
+    // the two arms of the cross, each drawn in both directions as the
+    // immediate mode code always has
+    static const signed char arms[8][2] = {
+        {-1, -1}, {1, 1}, {-1, 1}, {1, -1},
+        {1, 1}, {-1, -1}, {1, -1}, {-1, 1},
+    };
+    for(int i = 0; i < 8; i++) {
+        vertex q;
+        double a = arms[i][0] * delta, b = arms[i][1] * delta;
+        memcpy(q.c, color, sizeof(q.c));
+        if(axis == 0) {
+            q.p[0] = x + a; q.p[1] = y + b; q.p[2] = z;
+        } else if(axis == 1) {
+            q.p[0] = x + a; q.p[1] = y; q.p[2] = z + b;
+        } else {
+            q.p[0] = x; q.p[1] = y + a; q.p[2] = z + b;
+        }
+        v.push_back(q);
+    }
+    lines.push_back(line);
+}
+
+void Dwells::draw() {
+    if(v.empty()) return;
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glColorPointer(4, GL_FLOAT, sizeof(vertex), &v[0].c);
+    glVertexPointer(3, GL_FLOAT, sizeof(vertex), &v[0].p);
+    glDrawArrays(GL_LINES, 0, v.size());
+    glPopClientAttrib();
+}
+
+void Dwells::draw_selection() {
+    if(v.empty()) return;
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(vertex), &v[0].p);
+    for(size_t i = 0; i < lines.size(); i++) {
+        glLoadName(lines[i]);
+        glDrawArrays(GL_LINES, 8 * i, 8);
+    }
+    glPopClientAttrib();
+}
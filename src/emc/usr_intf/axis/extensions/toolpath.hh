@@ -0,0 +1,127 @@
+//    This is a component of AXIS, a front-end for LinuxCNC
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#ifndef TOOLPATH_HH
+#define TOOLPATH_HH
+
+#include <vector>
+#include <string>
+
+/* The 3d location of a 9d point for an AXIS geometry string such as
+   "XYZ" or "-AXYZ". */
+void vertex9(const double pt[9], double p[3], const char *geometry);
+
+/* The number of pieces a move from p1 to p2 is drawn in, more than one
+   when it turns a rotary axis. */
+int line9_steps(const double p1[9], const double p2[9]);
+
+/* The moves of a loaded program, kept as vertex arrays that are built
+   once and drawn with a few calls per frame instead of one glVertex per
+   point.
+
+   Besides the full path there are coarser levels of detail, each
+   simplified so no point strays further from the path than its
+   tolerance.  draw() works out how large a pixel is where the path is
+   closest to the eye and uses the coarsest level whose tolerance is
+   under half a pixel, and it skips the blocks of vertices that are
+   outside the view.  So a program of a million moves costs about as
+   many vertices as there are pixels along its plot when zoomed out, and
+   only the moves on screen when zoomed in.
+
+   Selection and highlighting always use the full path, and find the
+   moves of a program line through an index sorted by line. */
+class Toolpath {
+public:
+    explicit Toolpath(const char *geometry);
+
+    /* Append a move of program line 'line'.  Call finish() after the
+       last one. */
+    void add(int line, const double p1[9], const double p2[9]);
+    void finish();
+
+    /* Draw with the current color and matrices.  Returns the number of
+       vertices drawn. */
+    long draw();
+    /* Draw for GL_SELECT, loading the line number of each move as its
+       name. */
+    void draw_selection();
+    /* Draw the moves of 'line' and return how many vertices there are,
+       adding their coordinates to sum. */
+    long highlight(int line, double sum[3]);
+
+    long segments() const { return nsegments; }
+    long vertices() const { return levels.empty() ? 0 : levels[0].v.size() / 3; }
+    int nlevels() const { return levels.size(); }
+
+private:
+    /* vertices [first, first+count) are one line strip */
+    struct strip { unsigned first, count; };
+    /* a piece of a strip, bounded for culling; 'joined' when it goes
+       on from the block before it, sharing that block's last vertex */
+    struct block {
+        unsigned first, count;
+        bool joined;
+        float lo[3], hi[3];
+    };
+    struct level {
+        double tolerance;
+        std::vector<float> v;
+        std::vector<strip> strips;
+        std::vector<block> blocks;
+    };
+    /* the moves of one program line in a row along a strip of level 0 */
+    struct range { int line; unsigned first, count; };
+
+    void make_blocks(level &l);
+    void simplify(const level &from, level &to, double tolerance);
+    int cull(const level &l, const double m[16], std::vector<bool> *visible,
+            double *wmin);
+    void end_strip();
+
+    std::string geometry;
+    long nsegments;
+    std::vector<level> levels;
+    std::vector<range> ranges;
+    std::vector<unsigned> by_line;	// indices into ranges, sorted by line
+    double last[9];
+    bool in_strip;
+    unsigned strip_first;
+    std::vector<int> firsts, counts;	// scratch for glMultiDrawArrays
+};
+
+/* The dwell marks of a program, each a small colored cross of eight
+   vertices, kept as one interleaved array. */
+class Dwells {
+public:
+    Dwells() {}
+
+    /* Append a mark at x, y, z across the plane given by 'axis', 0 for
+       XY, 1 for XZ and 2 for YZ. */
+    void add(int line, const float color[4], double x, double y, double z,
+            int axis);
+
+    void draw();
+    void draw_selection();
+
+    long size() const { return lines.size(); }
+
+private:
+    struct vertex { float c[4]; float p[3]; };
+    std::vector<vertex> v;
+    std::vector<int> lines;
+};
+
+#endif
@@ -34,6 +34,7 @@
 #include "rcs_print.hh"
 #include "nml_oi.hh"
 #include "timer.hh"
+#include "emcstatmirror.hh"	// EMC_STAT_MIRROR
 
 /* Using halui: see the man page */
 
@@ -250,6 +251,9 @@ static RCS_CMD_CHANNEL *emcCommandBuffer = 0;
 static RCS_STAT_CHANNEL *emcStatusBuffer = 0;
 EMC_STAT *emcStatus = 0;
 
+// lock-free copy of the status, when task runs on this machine
+static EMC_STAT_MIRROR *emcStatusMirror = 0;
+
 // the NML channel for errors
 static NML *emcErrorBuffer = 0;
 
@@ -294,6 +298,9 @@ static int emcTaskNmlGet()
 	    retval = -1;
 	} else {
 	    emcStatus = (EMC_STAT *) emcStatusBuffer->get_address();
+	    if (emcStatusMirror) {
+		emcStatusMirror->invalidate();
+	    }
 	}
     }
 
@@ -388,6 +395,18 @@ static int updateStatus()
 	return -1;
     }
 
+    if (0 == emcStatusMirror) {
+	emcStatusMirror = EMC_STAT_MIRROR::attach(DEFAULT_EMC_STAT_MIRROR_KEY);
+    }
+    if (0 != emcStatusMirror) {
+	if (emcStatusMirror->read(emcStatus) >= 0) {
+	    return 0;
+	}
+	// task went away, use NML until it is back
+	delete emcStatusMirror;
+	emcStatusMirror = 0;
+    }
+
     switch (type = emcStatusBuffer->peek()) {
     case -1:
 	// error on CMS channel
@@ -472,6 +491,7 @@ static void thisQuit()
     hal_exit(comp_id);
 
     if(emcCommandBuffer) { delete emcCommandBuffer;  emcCommandBuffer = 0; }
+    if(emcStatusMirror) { delete emcStatusMirror;  emcStatusMirror = 0; }
     if(emcStatusBuffer) { delete emcStatusBuffer;  emcStatusBuffer = 0; }
     if(emcErrorBuffer) { delete emcErrorBuffer;  emcErrorBuffer = 0; }
     exit(0);
@@ -38,6 +38,7 @@
 #include "rcs_print.hh"
 #include "timer.hh"             // esleep
 #include "shcom.hh"             // Common NML communications functions
+#include "emcstatmirror.hh"     // EMC_STAT_MIRROR
 
 LINEAR_UNIT_CONVERSION linearUnitConversion;
 ANGULAR_UNIT_CONVERSION angularUnitConversion;
@@ -51,6 +52,9 @@ RCS_CMD_CHANNEL *emcCommandBuffer;
 RCS_STAT_CHANNEL *emcStatusBuffer;
 EMC_STAT *emcStatus;
 
+// lock-free copy of the status, when task runs on this machine
+static EMC_STAT_MIRROR *emcStatusMirror;
+
 // the NML channel for errors
 NML *emcErrorBuffer;
 char error_string[NML_ERROR_LEN];
@@ -101,6 +105,9 @@ int emcTaskNmlGet()
 	    retval = -1;
 	} else {
 	    emcStatus = (EMC_STAT *) emcStatusBuffer->get_address();
+	    if (emcStatusMirror) {
+		emcStatusMirror->invalidate();
+	    }
 	}
     }
 
@@ -185,6 +192,18 @@ int updateStatus()
 	return -1;
     }
 
+    if (0 == emcStatusMirror) {
+	emcStatusMirror = EMC_STAT_MIRROR::attach(DEFAULT_EMC_STAT_MIRROR_KEY);
+    }
+    if (0 != emcStatusMirror) {
+	if (emcStatusMirror->read(emcStatus) >= 0) {
+	    return 0;
+	}
+	// task went away, use NML until it is back
+	delete emcStatusMirror;
+	emcStatusMirror = 0;
+    }
+
     switch (type = emcStatusBuffer->peek()) {
     case -1:
 	// error on CMS channel
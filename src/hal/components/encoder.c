@@ -63,6 +63,7 @@
 #include "rtapi_app.h"		/* RTAPI realtime module decls */
 #include "rtapi_string.h"
 #include "hal.h"		/* HAL public API decls */
+#include "encoder_batch.h"	/* decoder core for all channels */
 
 /* module information */
 MODULE_AUTHOR("John Kasunich");
@@ -74,7 +75,7 @@ static int default_num_chan=3;
 static int howmany;
 RTAPI_MP_INT(num_chan, "number of encoder channels");
 
-#define MAX_CHAN 8
+#define MAX_CHAN ENCODER_BATCH_MAX_CHAN
 char *names[MAX_CHAN] = {0,};
 RTAPI_MP_ARRAY_STRING(names, MAX_CHAN, "names of encoder");
 
@@ -98,12 +99,10 @@ typedef struct {
    u:rw means update() reads and writes the
    c:w  means capture() writes the field
    c:s u:rc means capture() sets (to 1), update() reads and clears
+   The decoder state itself is in the encoder_batch_t below.
 */
 
 typedef struct {
-    unsigned char state;	/* u:rw quad decode state machine state */
-    unsigned char oldZ;		/* u:rw previous value of phase Z */
-    unsigned char Zmask;	/* u:rc c:s mask for oldZ, from index-ena */
     hal_bit_t *x4_mode;		/* u:r enables x4 counting (default) */
     hal_bit_t *counter_mode;	/* u:r enables counter mode */
     atomic buf[2];		/* u:w c:r double buffer for atomic data */
@@ -130,7 +129,6 @@ typedef struct {
     hal_float_t *vel;		/* c:w scaled velocity (floating point) */
     hal_float_t *vel_rpm;   /* rps * 60 for convenience */
     hal_float_t *pos_scale;	/* c:r pin: scaling factor for pos */
-    hal_bit_t old_latch;        /* value of latch on previous cycle */
     double old_scale;		/* c:rw stored scale value */
     double scale;		/* c:rw reciprocal value used for scaling */
     int counts_since_timeout;	/* c:rw used for velocity calcs */
@@ -141,39 +139,9 @@ static rtapi_u32 timebase;		/* master timestamp for all counters */
 /* pointer to array of counter_t structs in shmem, 1 per counter */
 static counter_t *counter_array;
 
-/* bitmasks for quadrature decode state machine */
-#define SM_PHASE_A_MASK 0x01
-#define SM_PHASE_B_MASK 0x02
-#define SM_LOOKUP_MASK  0x0F
-#define SM_CNT_UP_MASK  0x40
-#define SM_CNT_DN_MASK  0x80
-
-/* Lookup table for quadrature decode state machine.  This machine
-   will reject glitches on either input (will count up 1 on glitch,
-   down 1 after glitch), and on both inputs simultaneously (no count
-   at all)  In theory, it can count once per cycle, in practice the
-   maximum count rate should be at _least_ 10% below the sample rate,
-   and preferrable around half the sample rate.  It counts every
-   edge of the quadrature waveform, 4 counts per complete cycle.
-*/
-static const unsigned char lut_x4[16] = {
-    0x00, 0x44, 0x88, 0x0C, 0x80, 0x04, 0x08, 0x4C,
-    0x40, 0x04, 0x08, 0x8C, 0x00, 0x84, 0x48, 0x0C
-};
-
-/* same thing, but counts only once per complete cycle */
-
-static const unsigned char lut_x1[16] = {
-    0x00, 0x44, 0x08, 0x0C, 0x80, 0x04, 0x08, 0x0C,
-    0x00, 0x04, 0x08, 0x0C, 0x00, 0x04, 0x08, 0x0C
-};
-
-/* look-up table for a one-wire counter */
-
-static const unsigned char lut_ctr[16] = {
-   0x00, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-   0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-};
+/* decoder state for all counters, in shmem: state, oldZ and old_latch
+   are u:rw, Zmask is u:rc c:s */
+static encoder_batch_t *batch;
 
 /* other globals */
 static int comp_id;		/* component ID */
@@ -234,6 +202,13 @@ int rtapi_app_main(void)
 	hal_exit(comp_id);
 	return -1;
     }
+    batch = hal_malloc(sizeof(encoder_batch_t));
+    if (batch == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "ENCODER: ERROR: hal_malloc() failed\n");
+	hal_exit(comp_id);
+	return -1;
+    }
     /* init master timestamp counter */
     timebase = 0;
     /* export all the variables for each counter */
@@ -256,9 +231,10 @@ int rtapi_app_main(void)
 	    return -1;
 	}
 	/* init counter */
-	cntr->state = 0;
-	cntr->oldZ = 0;
-	cntr->Zmask = 0;
+	batch->state[n] = 0;
+	batch->oldZ[n] = 0;
+	batch->Zmask[n] = 0;
+	batch->old_latch[n] = 0;
 	*(cntr->x4_mode) = 1;
 	*(cntr->counter_mode) = 0;
 	*(cntr->latch_rising) = 1;
@@ -321,69 +297,46 @@ static void update(void *arg, long period)
     counter_t *cntr;
     atomic *buf;
     int n;
-    unsigned char state;
-    int latch, old_latch, rising, falling;
+    unsigned char ev;
 
+    /* gather the input pins of every channel */
     cntr = arg;
     for (n = 0; n < howmany; n++) {
-	buf = (atomic *) cntr->bp;
-	/* get state machine current state */
-	state = cntr->state;
-	/* add input bits to state code */
-	if (*(cntr->phaseA)) {
-	    state |= SM_PHASE_A_MASK;
-	}
-	if (*(cntr->phaseB)) {
-	    state |= SM_PHASE_B_MASK;
-	}
-	/* look up new state */
-	if ( *(cntr->counter_mode) ) {
-	    state = lut_ctr[state & (SM_LOOKUP_MASK & ~SM_PHASE_B_MASK)];
-	} else if ( *(cntr->x4_mode) ) {
-	    state = lut_x4[state & SM_LOOKUP_MASK];
-	} else {
-	    state = lut_x1[state & SM_LOOKUP_MASK];
-	}
-	/* should we count? */
-	if (state & SM_CNT_UP_MASK) {
-	    (*cntr->raw_counts)++;
-	    buf->raw_count = *(cntr->raw_counts);
-	    buf->timestamp = timebase;
-	    buf->count_detected = 1;
-	} else if (state & SM_CNT_DN_MASK) {
-	    (*cntr->raw_counts)--;
-	    buf->raw_count = *(cntr->raw_counts);
-	    buf->timestamp = timebase;
-	    buf->count_detected = 1;
-	}
-	/* save state machine state */
-	cntr->state = state;
-	/* get old phase Z state, make room for new bit value */
-	state = cntr->oldZ << 1;
-	/* add new value of phase Z */
-	if (*(cntr->phaseZ)) {
-	    state |= 1;
-	}
-	cntr->oldZ = state & 3;
-	/* test for index enabled and rising edge on phase Z */
-	if ((state & cntr->Zmask) == 1) {
-	    /* capture counts, reset Zmask */
-	    buf->index_count = *(cntr->raw_counts);
-	    buf->index_detected = 1;
-	    cntr->Zmask = 0;
+	batch->in[n] = (*(cntr->phaseA) ? ENC_IN_A : 0)
+	    | (*(cntr->phaseB) ? ENC_IN_B : 0)
+	    | (*(cntr->phaseZ) ? ENC_IN_Z : 0)
+	    | (*(cntr->latch_in) ? ENC_IN_LATCH : 0)
+	    | (*(cntr->x4_mode) ? ENC_IN_X4 : 0)
+	    | (*(cntr->counter_mode) ? ENC_IN_CTR : 0)
+	    | (*(cntr->latch_rising) ? ENC_IN_RISING : 0)
+	    | (*(cntr->latch_falling) ? ENC_IN_FALLING : 0);
+	batch->raw_counts[n] = *(cntr->raw_counts);
+	cntr++;
+    }
+    /* run the state machines */
+    encoder_batch_update(batch, howmany);
+    /* write back counts and pass events to capture() */
+    cntr = arg;
+    for (n = 0; n < howmany; n++) {
+	*(cntr->raw_counts) = batch->raw_counts[n];
+	ev = batch->events[n];
+	if (ev) {
+	    buf = (atomic *) cntr->bp;
+	    if (ev & ENC_EV_COUNT) {
+		buf->raw_count = batch->raw_counts[n];
+		buf->timestamp = timebase;
+		buf->count_detected = 1;
+	    }
+	    if (ev & ENC_EV_INDEX) {
+		/* capture counts */
+		buf->index_count = batch->raw_counts[n];
+		buf->index_detected = 1;
+	    }
+	    if (ev & ENC_EV_LATCH) {
+		buf->latch_detected = 1;
+		buf->latch_count = batch->raw_counts[n];
+	    }
 	}
-        /* test for latch enabled and desired edge on latch-in */
-        latch = *(cntr->latch_in), old_latch = cntr->old_latch;
-        rising = latch && !old_latch;
-        falling = !latch && old_latch;
-
-        if((rising && *(cntr->latch_rising))
-                || (falling && *(cntr->latch_falling))) {
-            buf->latch_detected = 1;
-            buf->latch_count = *(cntr->raw_counts);
-        }
-        cntr->old_latch = latch;
-
 	/* move on to next channel */
 	cntr++;
     }
@@ -426,9 +379,9 @@ static void capture(void *arg, long period)
 
 	/* update Zmask based on index_ena */
 	if (*(cntr->index_ena)) {
-	    cntr->Zmask = 3;
+	    batch->Zmask[n] = 3;
 	} else {
-	    cntr->Zmask = 0;
+	    batch->Zmask[n] = 0;
 	}
 	/* done interacting with update() */
 	/* check for change in scale value */
@@ -0,0 +1,132 @@
+/********************************************************************
+* Description:  encoder_batch.h
+*               Quadrature decoder core for the "encoder" HAL
+*               component, run for all channels at once.
+*
+*               update() gathers each channel's input pins into one
+*               byte, runs the decoder below over every channel, and
+*               then hands the few channels that saw a count, index or
+*               latch event to capture().  The decoder keeps its state
+*               as one array per field and has no data dependent
+*               branches apart from clearing Zmask on an index pulse:
+*               the three lookup tables are one table indexed by mode,
+*               and counting up or down is a subtraction of two state
+*               bits.
+*
+*               Included by encoder.c, and by the unit test that checks
+*               it against the original per-channel code.
+*
+* License: GPL Version 2
+*
+********************************************************************/
+
+#ifndef ENCODER_BATCH_H
+#define ENCODER_BATCH_H
+
+#include "rtapi_stdint.h"	/* rtapi_s32 */
+
+#define ENCODER_BATCH_MAX_CHAN	8
+
+/* bits of the gathered input byte */
+#define ENC_IN_A	0x01	/* phase A */
+#define ENC_IN_B	0x02	/* phase B */
+#define ENC_IN_Z	0x04	/* phase Z */
+#define ENC_IN_LATCH	0x08	/* latch-input */
+#define ENC_IN_X4	0x10	/* x4-mode */
+#define ENC_IN_CTR	0x20	/* counter-mode */
+#define ENC_IN_RISING	0x40	/* latch-rising */
+#define ENC_IN_FALLING	0x80	/* latch-falling */
+
+/* bits of the event byte */
+#define ENC_EV_COUNT	0x01	/* raw count changed */
+#define ENC_EV_INDEX	0x02	/* index pulse seen while enabled */
+#define ENC_EV_LATCH	0x04	/* selected edge on latch-input */
+
+/* bitmasks for quadrature decode state machine */
+#define SM_PHASE_A_MASK 0x01
+#define SM_PHASE_B_MASK 0x02
+#define SM_LOOKUP_MASK  0x0F
+#define SM_CNT_UP_MASK  0x40
+#define SM_CNT_DN_MASK  0x80
+
+typedef struct {
+    unsigned char in[ENCODER_BATCH_MAX_CHAN];	/* gathered input pins */
+    unsigned char state[ENCODER_BATCH_MAX_CHAN];	/* decode state */
+    unsigned char oldZ[ENCODER_BATCH_MAX_CHAN];	/* previous phase Z */
+    unsigned char Zmask[ENCODER_BATCH_MAX_CHAN];	/* set by capture() */
+    unsigned char old_latch[ENCODER_BATCH_MAX_CHAN];	/* previous latch-input */
+    unsigned char events[ENCODER_BATCH_MAX_CHAN];	/* ENC_EV_* this period */
+    rtapi_s32 raw_counts[ENCODER_BATCH_MAX_CHAN];	/* copy of the pin */
+} encoder_batch_t;
+
+/* Lookup tables for the quadrature decode state machine, indexed by
+   [mode][state], mode 0 counting x4, 1 counting x1 and 2 counting
+   one-wire.
+
+   x4: This machine will reject glitches on either input (will count up
+   1 on glitch, down 1 after glitch), and on both inputs simultaneously
+   (no count at all)  In theory, it can count once per cycle, in
+   practice the maximum count rate should be at _least_ 10% below the
+   sample rate, and preferrable around half the sample rate.  It counts
+   every edge of the quadrature waveform, 4 counts per complete cycle.
+
+   x1: same thing, but counts only once per complete cycle.
+
+   one-wire: phase B is ignored, see encoder_batch_update(). */
+static const unsigned char encoder_lut[3][16] = {
+    {
+	0x00, 0x44, 0x88, 0x0C, 0x80, 0x04, 0x08, 0x4C,
+	0x40, 0x04, 0x08, 0x8C, 0x00, 0x84, 0x48, 0x0C
+    }, {
+	0x00, 0x44, 0x08, 0x0C, 0x80, 0x04, 0x08, 0x0C,
+	0x00, 0x04, 0x08, 0x0C, 0x00, 0x04, 0x08, 0x0C
+    }, {
+	0x00, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    }
+};
+
+/** Run one period of every channel.  Updates state, raw_counts and the
+    edge history exactly as the original per-channel code in update()
+    did, and leaves in events[] what that code would have written to the
+    capture buffer. */
+static inline void encoder_batch_update(encoder_batch_t *b, int num_chan)
+{
+    int n;
+
+    for (n = 0; n < num_chan; n++) {
+	unsigned in = b->in[n], state, z, latch, old_latch, ctr, mode, ev;
+	int delta;
+
+	/* add input bits to state code and look up new state; counter
+	   mode ignores phase B */
+	ctr = (in & ENC_IN_CTR) != 0;
+	mode = ctr ? 2 : !(in & ENC_IN_X4);
+	state = b->state[n] | (in & (SM_PHASE_A_MASK | SM_PHASE_B_MASK));
+	state &= ctr ? SM_LOOKUP_MASK & ~SM_PHASE_B_MASK : SM_LOOKUP_MASK;
+	state = encoder_lut[mode][state];
+	/* should we count? */
+	delta = ((state & SM_CNT_UP_MASK) != 0) - ((state & SM_CNT_DN_MASK) != 0);
+	b->raw_counts[n] += delta;
+	ev = delta ? ENC_EV_COUNT : 0;
+	b->state[n] = state;
+	/* rising edge on phase Z while index is enabled */
+	z = (b->oldZ[n] << 1) | ((in & ENC_IN_Z) != 0);
+	b->oldZ[n] = z & 3;
+	ev |= (z & b->Zmask[n]) == 1 ? ENC_EV_INDEX : 0;
+	if (ev & ENC_EV_INDEX) {
+	    /* only store when clearing, capture() may be setting it */
+	    b->Zmask[n] = 0;
+	}
+	/* desired edge on latch-in */
+	latch = (in & ENC_IN_LATCH) != 0;
+	old_latch = b->old_latch[n];
+	ev |= ((latch & (old_latch ^ 1) & ((in & ENC_IN_RISING) != 0))
+	    | ((latch ^ 1) & old_latch & ((in & ENC_IN_FALLING) != 0)))
+	    ? ENC_EV_LATCH : 0;
+	b->old_latch[n] = latch;
+	b->events[n] = ev;
+    }
+}
+
+#endif /* ENCODER_BATCH_H */
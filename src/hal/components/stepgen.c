@@ -300,11 +300,12 @@
 #include "rtapi.h"		/* RTAPI realtime OS API */
 #include "rtapi_app.h"		/* RTAPI realtime module decls */
 #include "hal.h"		/* HAL public API decls */
+#include "stepgen_batch.h"	/* step generator core for all channels */
 
 #include <float.h>
 #include "rtapi_math.h"
 
-#define MAX_CHAN 16
+#define MAX_CHAN STEPGEN_BATCH_MAX_CHAN
 #define MAX_CYCLE 18
 #define USER_STEP_TYPE 13
 
@@ -324,35 +325,22 @@ RTAPI_MP_ARRAY_INT(user_step_type, MAX_CYCLE,
 *                STRUCTURES AND GLOBAL VARIABLES                       *
 ************************************************************************/
 
-/** This structure contains the runtime data for a single generator. */
-
-/* structure members are ordered to optimize caching for makepulses,
-   which runs in the fastest thread */
+/** This structure contains the pins, parameters and servo thread data
+    for a single generator.  The state of the step generator core that
+    makepulses runs in the fastest thread is in the stepgen_batch_t
+    below, one array per field, indexed by channel number. */
 
 typedef struct {
-    /* stuff that is both read and written by makepulses */
-    unsigned int timer1;	/* times out when step pulse should end */
-    unsigned int timer2;	/* times out when safe to change dir */
-    unsigned int timer3;	/* times out when safe to step in new dir */
-    int hold_dds;		/* prevents accumulator from updating */
-    long addval;		/* actual frequency generator add value */
-    volatile long long accum;	/* frequency generator accumulator */
-    hal_s32_t rawcount;		/* param: position feedback in counts */
-    int curr_dir;		/* current direction */
-    int state;			/* current position in state table */
-    /* stuff that is read but not written by makepulses */
+    /* stuff that is accessed by makepulses */
     hal_bit_t *enable;		/* pin for enable stepgen */
-    long target_addval;		/* desired freq generator add value */
-    long deltalim;		/* max allowed change per period */
+    hal_s32_t rawcount;		/* param: position feedback in counts */
+    int num_phases;		/* number of output pins */
+    hal_bit_t *phase[5];	/* pins for output signals */
+    /* stuff that is not accessed by makepulses */
     hal_u32_t step_len;		/* parameter: step pulse length */
     hal_u32_t dir_hold_dly;	/* param: direction hold time or delay */
     hal_u32_t dir_setup;	/* param: direction setup time */
     int step_type;		/* stepping type - see list above */
-    int cycle_max;		/* cycle length for step types 2 and up */
-    int num_phases;		/* number of phases for types 2 and up */
-    hal_bit_t *phase[5];	/* pins for output signals */
-    const unsigned char *lut;	/* pointer to state lookup table */
-    /* stuff that is not accessed by makepulses */
     int pos_mode;		/* 1 = position mode, 0 = velocity mode */
     hal_u32_t step_space;	/* parameter: min step pulse spacing */
     double old_pos_cmd;		/* previous position command (counts) */
@@ -376,6 +364,12 @@ typedef struct {
 /* ptr to array of stepgen_t structs in shared memory, 1 per channel */
 static stepgen_t *stepgen_array;
 
+/* ptr to step generator core state in shared memory, for all channels */
+static stepgen_batch_t *batch;
+#ifdef STEPGEN_BATCH_HAVE_AVX2
+static int use_avx2;		/* run four channels at a time */
+#endif
+
 /* lookup tables for stepping types 2 and higher - phase A is the LSB */
 
 static unsigned char master_lut[][MAX_CYCLE] = {
@@ -408,7 +402,7 @@ static unsigned char num_phases_lut[] =
 #define UP_PIN		0	/* output phase used for UP signal */
 #define DOWN_PIN	1	/* output phase used for DOWN signal */
 
-#define PICKOFF		28	/* bit location in DDS accum */
+#define PICKOFF		STEPGEN_PICKOFF	/* bit location in DDS accum */
 
 
 
@@ -492,12 +486,16 @@ int rtapi_app_main(void)
     }
     /* allocate shared memory for counter data */
     stepgen_array = hal_malloc(num_chan * sizeof(stepgen_t));
-    if (stepgen_array == 0) {
+    batch = hal_malloc(sizeof(stepgen_batch_t));
+    if (stepgen_array == 0 || batch == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
 			"STEPGEN: ERROR: hal_malloc() failed\n");
 	hal_exit(comp_id);
 	return -1;
     }
+#ifdef STEPGEN_BATCH_HAVE_AVX2
+    use_avx2 = stepgen_batch_have_avx2();
+#endif
     /* export all the variables for each pulse generator */
     for (n = 0; n < num_chan; n++) {
 	/* export all vars */
@@ -558,7 +556,6 @@ void rtapi_app_exit(void)
 static void make_pulses(void *arg, long period)
 {
     stepgen_t *stepgen;
-    long old_addval, target_addval, new_addval, step_now;
     int n, p;
     unsigned char outbits;
 
@@ -567,144 +564,27 @@ static void make_pulses(void *arg, long period)
     /* point to stepgen data structures */
     stepgen = arg;
 
+    /* gather the enable pins */
     for (n = 0; n < num_chan; n++) {
-	/* decrement "timing constraint" timers */
-	if ( stepgen->timer1 > 0 ) {
-	    if ( stepgen->timer1 > periodns ) {
-		stepgen->timer1 -= periodns;
-	    } else {
-		stepgen->timer1 = 0;
-	    }
-	}
-	if ( stepgen->timer2 > 0 ) {
-	    if ( stepgen->timer2 > periodns ) {
-		stepgen->timer2 -= periodns;
-	    } else {
-		stepgen->timer2 = 0;
-	    }
-	}
-	if ( stepgen->timer3 > 0 ) {
-	    if ( stepgen->timer3 > periodns ) {
-		stepgen->timer3 -= periodns;
-	    } else {
-		stepgen->timer3 = 0;
-		/* last timer timed out, cancel hold */
-		stepgen->hold_dds = 0;
-	    }
-	}
-	if ( !stepgen->hold_dds && *(stepgen->enable) ) {
-	    /* update addval (ramping) */
-	    old_addval = stepgen->addval;
-	    target_addval = stepgen->target_addval;
-	    if (stepgen->deltalim != 0) {
-		/* implement accel/decel limit */
-		if (target_addval > (old_addval + stepgen->deltalim)) {
-		    /* new value is too high, increase addval as far as possible */
-		    new_addval = old_addval + stepgen->deltalim;
-		} else if (target_addval < (old_addval - stepgen->deltalim)) {
-		    /* new value is too low, decrease addval as far as possible */
-		    new_addval = old_addval - stepgen->deltalim;
-		} else {
-		    /* new value can be reached in one step - do it */
-		    new_addval = target_addval;
-		}
-	    } else {
-		/* go to new freq without any ramping */
-		new_addval = target_addval;
-	    }
-	    /* save result */
-	    stepgen->addval = new_addval;
-	    /* check for direction reversal */
-	    if (((new_addval >= 0) && (old_addval < 0)) ||
-		((new_addval < 0) && (old_addval >= 0))) {
-		/* reversal required, can we do so now? */
-		if ( stepgen->timer3 != 0 ) {
-		    /* no - hold everything until delays time out */
-		    stepgen->hold_dds = 1;
-		}
-	    }
-	}
-	/* update DDS */
-	if ( !stepgen->hold_dds && *(stepgen->enable) ) {
-	    /* save current value of low half of accum */
-	    step_now = stepgen->accum;
-	    /* update the accumulator */
-	    stepgen->accum += stepgen->addval;
-	    /* test for changes in low half of accum */
-	    step_now ^= stepgen->accum;
-	    /* we only care about the pickoff bit */
-	    step_now &= (1L << PICKOFF);
-	    /* update rawcounts parameter */
-	    stepgen->rawcount = stepgen->accum >> PICKOFF;
-	} else {
-	    /* DDS is in hold, no steps */
-	    step_now = 0;
-	}
-	if ( stepgen->timer2 == 0 ) {
-	    /* update direction - do not change if addval = 0 */
-	    if ( stepgen->addval > 0 ) {
-		stepgen->curr_dir = 1;
-	    } else if ( stepgen->addval < 0 ) {
-		stepgen->curr_dir = -1;
-	    }
-	}
-	if ( step_now ) {
-	    /* (re)start various timers */
-	    /* timer 1 = time till end of step pulse */
-	    stepgen->timer1 = stepgen->step_len;
-	    /* timer 2 = time till allowed to change dir pin */
-	    stepgen->timer2 = stepgen->timer1 + stepgen->dir_hold_dly;
-	    /* timer 3 = time till allowed to step the other way */
-	    stepgen->timer3 = stepgen->timer2 + stepgen->dir_setup;
-	    if ( stepgen->step_type >= 2 ) {
-		/* update state */
-		stepgen->state += stepgen->curr_dir;
-		if ( stepgen->state < 0 ) {
-		    stepgen->state = stepgen->cycle_max;
-		} else if ( stepgen->state > stepgen->cycle_max ) {
-		    stepgen->state = 0;
-		}
-	    }
-	}
-	/* generate output, based on stepping type */
-	if (stepgen->step_type == 0) {
-	    /* step/dir output */
-	    if ( stepgen->timer1 != 0 ) {
-		 *(stepgen->phase[STEP_PIN]) = 1;
-	    } else {
-		 *(stepgen->phase[STEP_PIN]) = 0;
-	    }
-	    if ( stepgen->curr_dir < 0 ) {
-		 *(stepgen->phase[DIR_PIN]) = 1;
-	    } else {
-		 *(stepgen->phase[DIR_PIN]) = 0;
-	    }
-	} else if (stepgen->step_type == 1) {
-	    /* up/down */
-	    if ( stepgen->timer1 != 0 ) {
-		if ( stepgen->curr_dir < 0 ) {
-		    *(stepgen->phase[UP_PIN]) = 0;
-		    *(stepgen->phase[DOWN_PIN]) = 1;
-		} else {
-		    *(stepgen->phase[UP_PIN]) = 1;
-		    *(stepgen->phase[DOWN_PIN]) = 0;
-		}
-	    } else {
-		*(stepgen->phase[UP_PIN]) = 0;
-		*(stepgen->phase[DOWN_PIN]) = 0;
-	    }
-	} else {
-	    /* step type 2 or greater */
-	    /* look up correct output pattern */
-	    outbits = (stepgen->lut)[stepgen->state];
-	    /* now output the phase bits */
-	    for (p = 0; p < stepgen->num_phases; p++) {
-		/* output one phase */
-		*(stepgen->phase[p]) = outbits & 1;
-		/* move to the next phase */
-		outbits >>= 1;
-	    }
+	batch->enable[n] = *(stepgen[n].enable);
+    }
+    /* run timers, ramping, DDS and state machine of every channel */
+#ifdef STEPGEN_BATCH_HAVE_AVX2
+    if (use_avx2) {
+	stepgen_batch_make_pulses_avx2(batch, num_chan, periodns);
+    } else
+#endif
+    stepgen_batch_make_pulses_scalar(batch, num_chan, periodns);
+    /* output the phase bits and update rawcounts parameter */
+    for (n = 0; n < num_chan; n++) {
+	outbits = batch->outbits[n];
+	for (p = 0; p < stepgen->num_phases; p++) {
+	    /* output one phase */
+	    *(stepgen->phase[p]) = outbits & 1;
+	    /* move to the next phase */
+	    outbits >>= 1;
 	}
+	stepgen->rawcount = batch->accum[n] >> PICKOFF;
 	/* move on to next step generator */
 	stepgen++;
     }
@@ -724,8 +604,8 @@ static void update_pos(void *arg, long period)
 	   make_pulses could change it half-way through a read.
 	   So we have a crude atomic read routine */
 	do {
-	    accum_a = stepgen->accum;
-	    accum_b = stepgen->accum;
+	    accum_a = *(volatile rtapi_s64 *)&batch->accum[n];
+	    accum_b = *(volatile rtapi_s64 *)&batch->accum[n];
 	} while ( accum_a != accum_b );
 	/* compute integer counts */
 	*(stepgen->count) = accum_a >> PICKOFF;
@@ -859,6 +739,10 @@ static void update_freq(void *arg, long period)
 	    stepgen->old_dir_hold_dly = ulceil(stepgen->dir_hold_dly, periodns);
 	    stepgen->dir_hold_dly = stepgen->old_dir_hold_dly;
 	}
+	/* hand the validated values to make_pulses */
+	batch->step_len[n] = stepgen->step_len;
+	batch->dir_hold_dly[n] = stepgen->dir_hold_dly;
+	batch->dir_setup[n] = stepgen->dir_setup;
 	/* test for disabled stepgen */
 	if (*stepgen->enable == 0) {
 	    /* disabled: keep updating old_pos_cmd (if in pos ctrl mode) */
@@ -867,8 +751,8 @@ static void update_freq(void *arg, long period)
 	    }
 	    /* set velocity to zero */
 	    stepgen->freq = 0;
-	    stepgen->addval = 0;
-	    stepgen->target_addval = 0;
+	    batch->addval[n] = 0;
+	    batch->target_addval[n] = 0;
 	    /* and skip to next one */
 	    stepgen++;
 	    continue;
@@ -930,8 +814,8 @@ static void update_freq(void *arg, long period)
 	       make_pulses could change it half-way through a read.
 	       So we have a crude atomic read routine */
 	    do {
-		accum_a = stepgen->accum;
-		accum_b = stepgen->accum;
+		accum_a = *(volatile rtapi_s64 *)&batch->accum[n];
+		accum_b = *(volatile rtapi_s64 *)&batch->accum[n];
 	    } while ( accum_a != accum_b );
 	    /* convert from fixed point to double, after subtracting
 	       the one-half step offset */
@@ -1016,9 +900,9 @@ static void update_freq(void *arg, long period)
 	}
 	stepgen->freq = new_vel;
 	/* calculate new addval */
-	stepgen->target_addval = stepgen->freq * freqscale;
+	batch->target_addval[n] = stepgen->freq * freqscale;
 	/* calculate new deltalim */
-	stepgen->deltalim = max_ac * accelscale;
+	batch->deltalim[n] = max_ac * accelscale;
 	/* move on to next channel */
 	stepgen++;
     }
@@ -1164,26 +1048,43 @@ static int export_stepgen(int num, stepgen_t * addr, int step_type, int pos_mode
     addr->old_step_space = ~0;
     addr->old_dir_hold_dly = ~0;
     addr->old_dir_setup = ~0;
-    if ( step_type >= 2 ) {
-	/* init output stuff */
-	addr->cycle_max = cycle_len_lut[step_type - 2] - 1;
-	addr->lut = &(master_lut[step_type - 2][0]);
+    /* init output stuff */
+    if ( step_type == 0 ) {
+	addr->num_phases = 2;
+	batch->use_state[num] = 0;
+	batch->cycle_max[num] = 0;
+	batch->lut[num] = stepgen_lut_step_dir;
+    } else if ( step_type == 1 ) {
+	addr->num_phases = 2;
+	batch->use_state[num] = 0;
+	batch->cycle_max[num] = 0;
+	batch->lut[num] = stepgen_lut_up_down;
+    } else {
+	batch->use_state[num] = 1;
+	batch->cycle_max[num] = cycle_len_lut[step_type - 2] - 1;
+	batch->lut[num] = &(master_lut[step_type - 2][0]);
     }
+    /* make_pulses uses these until update_freq validates them */
+    batch->step_len[num] = addr->step_len;
+    batch->dir_hold_dly[num] = addr->dir_hold_dly;
+    batch->dir_setup[num] = addr->dir_setup;
     /* init the step generator core to zero output */
-    addr->timer1 = 0;
-    addr->timer2 = 0;
-    addr->timer3 = 0;
-    addr->hold_dds = 0;
-    addr->addval = 0;
+    batch->timer1[num] = 0;
+    batch->timer2[num] = 0;
+    batch->timer3[num] = 0;
+    batch->hold_dds[num] = 0;
+    batch->addval[num] = 0;
     /* accumulator gets a half step offset, so it will step half
        way between integer positions, not at the integer positions */
-    addr->accum = 1 << (PICKOFF-1);
+    batch->accum[num] = 1 << (PICKOFF-1);
     addr->rawcount = 0;
-    addr->curr_dir = 0;
-    addr->state = 0;
+    batch->curr_dir[num] = 0;
+    batch->state[num] = 0;
     *(addr->enable) = 0;
-    addr->target_addval = 0;
-    addr->deltalim = 0;
+    batch->enable[num] = 0;
+    batch->target_addval[num] = 0;
+    batch->deltalim[num] = 0;
+    batch->outbits[num] = 0;
     /* other init */
     addr->printed_error = 0;
     addr->old_pos_cmd = 0.0;
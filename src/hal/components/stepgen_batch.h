@@ -0,0 +1,277 @@
+/********************************************************************
+* Description:  stepgen_batch.h
+*               Step pulse generator core for the "stepgen" HAL
+*               component, run for all channels at once.
+*
+*               The state that make_pulses() reads and writes every
+*               base period is kept as one array per field rather than
+*               one struct per channel, so four channels sit next to
+*               each other in one 256 bit register.  On x86-64 CPUs
+*               with AVX2 (in uspace builds only, kernel modules must
+*               not touch the vector registers) make_pulses() runs the
+*               branch-free four-channel version below, elsewhere the
+*               original one-channel-at-a-time code.
+*
+*               Included by stepgen.c, and by the unit test that checks
+*               it against the original per-channel code.
+*
+* License: GPL Version 2
+*
+********************************************************************/
+
+#ifndef STEPGEN_BATCH_H
+#define STEPGEN_BATCH_H
+
+#include "rtapi_stdint.h"	/* rtapi_s64 */
+
+#define STEPGEN_BATCH_MAX_CHAN	16
+#define STEPGEN_PICKOFF		28	/* bit location in DDS accum */
+
+/* Every field is 64 bits wide so all the lanes of a vector operation
+   line up; the timers only ever hold values that fit a hal_u32_t.  The
+   arrays are full length whatever the number of channels, so the vector
+   version can always run a whole vector. */
+
+typedef struct {
+    /* read and written by make_pulses */
+    rtapi_s64 timer1[STEPGEN_BATCH_MAX_CHAN];	/* step pulse ends */
+    rtapi_s64 timer2[STEPGEN_BATCH_MAX_CHAN];	/* safe to change dir */
+    rtapi_s64 timer3[STEPGEN_BATCH_MAX_CHAN];	/* safe to step new dir */
+    rtapi_s64 hold_dds[STEPGEN_BATCH_MAX_CHAN];	/* accumulator on hold */
+    rtapi_s64 addval[STEPGEN_BATCH_MAX_CHAN];	/* actual add value */
+    rtapi_s64 accum[STEPGEN_BATCH_MAX_CHAN];	/* DDS accumulator */
+    rtapi_s64 curr_dir[STEPGEN_BATCH_MAX_CHAN];	/* current direction */
+    rtapi_s64 state[STEPGEN_BATCH_MAX_CHAN];	/* position in state table */
+    /* read but not written by make_pulses */
+    rtapi_s64 enable[STEPGEN_BATCH_MAX_CHAN];	/* copy of the enable pin */
+    rtapi_s64 target_addval[STEPGEN_BATCH_MAX_CHAN]; /* desired add value */
+    rtapi_s64 deltalim[STEPGEN_BATCH_MAX_CHAN];	/* max change per period */
+    rtapi_s64 step_len[STEPGEN_BATCH_MAX_CHAN];	/* validated timing params */
+    rtapi_s64 dir_hold_dly[STEPGEN_BATCH_MAX_CHAN];
+    rtapi_s64 dir_setup[STEPGEN_BATCH_MAX_CHAN];
+    rtapi_s64 use_state[STEPGEN_BATCH_MAX_CHAN];	/* 1 for step types 2 and up */
+    rtapi_s64 cycle_max[STEPGEN_BATCH_MAX_CHAN];	/* last entry in state table */
+    const unsigned char *lut[STEPGEN_BATCH_MAX_CHAN];	/* output patterns */
+    /* written by make_pulses */
+    rtapi_s64 index[STEPGEN_BATCH_MAX_CHAN];	/* lut entry, vector version */
+    unsigned char outbits[STEPGEN_BATCH_MAX_CHAN];	/* phase A is the LSB */
+} stepgen_batch_t;
+
+/* Output tables for step/dir and up/down.  For these types the table is
+   indexed by (pulse active) | (direction negative) << 1 instead of by the
+   state, so every step type produces its outputs with one lookup. */
+
+static const unsigned char stepgen_lut_step_dir[4] = { 0, 1, 2, 3 };
+static const unsigned char stepgen_lut_up_down[4] = { 0, 1, 0, 2 };
+
+/** Run one base period of every channel, one channel at a time.  This
+    is the original make_pulses() algorithm, reading and writing the
+    arrays above. */
+static inline void stepgen_batch_make_pulses_scalar(stepgen_batch_t *b,
+    int num_chan, long periodns)
+{
+    rtapi_s64 old_addval, target_addval, new_addval, step_now;
+    int n;
+
+    for (n = 0; n < num_chan; n++) {
+	/* decrement "timing constraint" timers */
+	if ( b->timer1[n] > 0 ) {
+	    if ( b->timer1[n] > periodns ) {
+		b->timer1[n] -= periodns;
+	    } else {
+		b->timer1[n] = 0;
+	    }
+	}
+	if ( b->timer2[n] > 0 ) {
+	    if ( b->timer2[n] > periodns ) {
+		b->timer2[n] -= periodns;
+	    } else {
+		b->timer2[n] = 0;
+	    }
+	}
+	if ( b->timer3[n] > 0 ) {
+	    if ( b->timer3[n] > periodns ) {
+		b->timer3[n] -= periodns;
+	    } else {
+		b->timer3[n] = 0;
+		/* last timer timed out, cancel hold */
+		b->hold_dds[n] = 0;
+	    }
+	}
+	if ( !b->hold_dds[n] && b->enable[n] ) {
+	    /* update addval (ramping) */
+	    old_addval = b->addval[n];
+	    target_addval = b->target_addval[n];
+	    if (b->deltalim[n] != 0) {
+		/* implement accel/decel limit */
+		if (target_addval > (old_addval + b->deltalim[n])) {
+		    /* new value is too high, increase addval as far as possible */
+		    new_addval = old_addval + b->deltalim[n];
+		} else if (target_addval < (old_addval - b->deltalim[n])) {
+		    /* new value is too low, decrease addval as far as possible */
+		    new_addval = old_addval - b->deltalim[n];
+		} else {
+		    /* new value can be reached in one step - do it */
+		    new_addval = target_addval;
+		}
+	    } else {
+		/* go to new freq without any ramping */
+		new_addval = target_addval;
+	    }
+	    /* save result */
+	    b->addval[n] = new_addval;
+	    /* check for direction reversal */
+	    if (((new_addval >= 0) && (old_addval < 0)) ||
+		((new_addval < 0) && (old_addval >= 0))) {
+		/* reversal required, can we do so now? */
+		if ( b->timer3[n] != 0 ) {
+		    /* no - hold everything until delays time out */
+		    b->hold_dds[n] = 1;
+		}
+	    }
+	}
+	/* update DDS */
+	if ( !b->hold_dds[n] && b->enable[n] ) {
+	    /* save current value of low half of accum */
+	    step_now = b->accum[n];
+	    /* update the accumulator */
+	    b->accum[n] += b->addval[n];
+	    /* test for changes in low half of accum */
+	    step_now ^= b->accum[n];
+	    /* we only care about the pickoff bit */
+	    step_now &= (1LL << STEPGEN_PICKOFF);
+	} else {
+	    /* DDS is in hold, no steps */
+	    step_now = 0;
+	}
+	if ( b->timer2[n] == 0 ) {
+	    /* update direction - do not change if addval = 0 */
+	    if ( b->addval[n] > 0 ) {
+		b->curr_dir[n] = 1;
+	    } else if ( b->addval[n] < 0 ) {
+		b->curr_dir[n] = -1;
+	    }
+	}
+	if ( step_now ) {
+	    /* (re)start various timers */
+	    /* timer 1 = time till end of step pulse */
+	    b->timer1[n] = b->step_len[n];
+	    /* timer 2 = time till allowed to change dir pin */
+	    b->timer2[n] = b->timer1[n] + b->dir_hold_dly[n];
+	    /* timer 3 = time till allowed to step the other way */
+	    b->timer3[n] = b->timer2[n] + b->dir_setup[n];
+	    if ( b->use_state[n] ) {
+		/* update state */
+		b->state[n] += b->curr_dir[n];
+		if ( b->state[n] < 0 ) {
+		    b->state[n] = b->cycle_max[n];
+		} else if ( b->state[n] > b->cycle_max[n] ) {
+		    b->state[n] = 0;
+		}
+	    }
+	}
+	/* look up correct output pattern */
+	if ( b->use_state[n] ) {
+	    b->outbits[n] = b->lut[n][b->state[n]];
+	} else {
+	    b->outbits[n] = b->lut[n][(b->timer1[n] != 0)
+		| (b->curr_dir[n] < 0) << 1];
+	}
+    }
+}
+
+#if defined(__x86_64__) && !defined(__KERNEL__)
+#define STEPGEN_BATCH_HAVE_AVX2 1
+
+/* four channels, loaded and stored at the 8 byte alignment hal_malloc
+   gives us */
+typedef rtapi_s64 stepgen_v4_t __attribute__((vector_size(32), aligned(8)));
+
+#define STEPGEN_V4(field)	(*(stepgen_v4_t *)&b->field[n])
+/* a where mask m is set, c where it is clear */
+#define STEPGEN_SEL(m, a, c)	((c) ^ (((a) ^ (c)) & (m)))
+
+/** Run one base period of every channel, four channels at a time with
+    AVX2.  Produces exactly the same results as the scalar version.
+
+    Each comparison of two vectors gives an all-ones/all-zeros mask per
+    channel, so every if of the scalar version becomes a select between
+    the old and new value.  Channels past num_chan, up to the next
+    multiple of four, are computed too; their enable is 0, and
+    make_pulses() ignores them. */
+__attribute__((target("avx2")))
+static void stepgen_batch_make_pulses_avx2(stepgen_batch_t *b,
+    int num_chan, long periodns)
+{
+    int n;
+    stepgen_v4_t p = (stepgen_v4_t){0} + periodns;
+    stepgen_v4_t one = (stepgen_v4_t){0} + 1;
+
+    for (n = 0; n < num_chan; n += 4) {
+	stepgen_v4_t t1 = STEPGEN_V4(timer1), t2 = STEPGEN_V4(timer2);
+	stepgen_v4_t t3 = STEPGEN_V4(timer3), hold = -STEPGEN_V4(hold_dds);
+	stepgen_v4_t old_addval = STEPGEN_V4(addval);
+	stepgen_v4_t target = STEPGEN_V4(target_addval);
+	stepgen_v4_t dl = STEPGEN_V4(deltalim), dir = STEPGEN_V4(curr_dir);
+	stepgen_v4_t state = STEPGEN_V4(state), accum = STEPGEN_V4(accum);
+	stepgen_v4_t cycle_max = STEPGEN_V4(cycle_max);
+	stepgen_v4_t use_state = -STEPGEN_V4(use_state);
+	stepgen_v4_t ramped, new_addval, new_accum, run, step, dir_ok, idx;
+
+	/* decrement "timing constraint" timers, the last one timing out
+	   cancels a hold */
+	hold &= ~((t3 > 0) & (t3 <= p));
+	t1 = (t1 - p) & (t1 > p);
+	t2 = (t2 - p) & (t2 > p);
+	t3 = (t3 - p) & (t3 > p);
+	run = ~hold & (STEPGEN_V4(enable) != 0);
+	/* update addval (ramping), limited to deltalim if that is set */
+	ramped = STEPGEN_SEL(target > old_addval + dl, old_addval + dl, target);
+	ramped = STEPGEN_SEL(ramped < old_addval - dl, old_addval - dl, ramped);
+	ramped = STEPGEN_SEL(dl != 0, ramped, target);
+	new_addval = STEPGEN_SEL(run, ramped, old_addval);
+	/* a direction reversal holds everything until the delays time out */
+	hold |= run & ((new_addval ^ old_addval) < 0) & (t3 != 0);
+	run &= ~hold;
+	/* update DDS, a step is a change of the pickoff bit */
+	new_accum = accum + (new_addval & run);
+	step = ((accum ^ new_accum) & (1LL << STEPGEN_PICKOFF)) != 0;
+	/* update direction - do not change if addval = 0 */
+	dir_ok = t2 == 0;
+	dir = STEPGEN_SEL(dir_ok & (new_addval > 0), one, dir);
+	dir = STEPGEN_SEL(dir_ok & (new_addval < 0), -one, dir);
+	/* a step (re)starts the timers and moves through the state table */
+	t1 = STEPGEN_SEL(step, STEPGEN_V4(step_len), t1);
+	t2 = STEPGEN_SEL(step, t1 + STEPGEN_V4(dir_hold_dly), t2);
+	t3 = STEPGEN_SEL(step, t2 + STEPGEN_V4(dir_setup), t3);
+	state += dir & step & use_state;
+	state = STEPGEN_SEL(state < 0, cycle_max, state);
+	state &= ~(state > cycle_max);
+	/* step/dir and up/down look up the pulse and direction instead */
+	idx = ((t1 != 0) & 1) | ((dir < 0) & 2);
+
+	STEPGEN_V4(timer1) = t1;
+	STEPGEN_V4(timer2) = t2;
+	STEPGEN_V4(timer3) = t3;
+	STEPGEN_V4(hold_dds) = hold & 1;
+	STEPGEN_V4(addval) = new_addval;
+	STEPGEN_V4(accum) = new_accum;
+	STEPGEN_V4(curr_dir) = dir;
+	STEPGEN_V4(state) = state;
+	STEPGEN_V4(index) = STEPGEN_SEL(use_state, state, idx);
+    }
+    /* the table lookups are a gather, done one channel at a time */
+    for (n = 0; n < num_chan; n++) {
+	b->outbits[n] = b->lut[n][b->index[n]];
+    }
+}
+
+/** True if this CPU can run stepgen_batch_make_pulses_avx2(). */
+static inline int stepgen_batch_have_avx2(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#endif /* STEPGEN_BATCH_H */
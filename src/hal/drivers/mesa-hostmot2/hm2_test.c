@@ -69,6 +69,212 @@ static void set32(hm2_test_t *me, uint16_t addr, uint32_t val) {
     me->test_pattern.tp32[addr/4] = val;
 }
 
+static uint32_t get32(hm2_test_t *me, uint16_t addr) {
+    return me->test_pattern.tp32[addr/4];
+}
+
+static void set_config_name(hm2_test_t *me) {
+    set8(me, HM2_ADDR_CONFIGNAME+0, 'H');
+    set8(me, HM2_ADDR_CONFIGNAME+1, 'O');
+    set8(me, HM2_ADDR_CONFIGNAME+2, 'S');
+    set8(me, HM2_ADDR_CONFIGNAME+3, 'T');
+    set8(me, HM2_ADDR_CONFIGNAME+4, 'M');
+    set8(me, HM2_ADDR_CONFIGNAME+5, 'O');
+    set8(me, HM2_ADDR_CONFIGNAME+6, 'T');
+    set8(me, HM2_ADDR_CONFIGNAME+7, '2');
+}
+
+
+
+
+//
+// The simulated board.
+//
+// This is a register-level model of a small HostMot2 firmware, enough for
+// the driver to load and run its normal read and write functions:
+//
+//     1x watchdog (never bites)
+//     2x ioport (48 pins, outputs read back, inputs read high)
+//     4x encoder (encoder N counts the steps of stepgen N)
+//     4x stepgen (the accumulator integrates the rate register)
+//     2x pwmgen (registers are only stored)
+//
+// Everything the driver writes is stored in the register file.  Reads of
+// the ioport data, encoder and stepgen accumulator registers are computed
+// from the simulated time, which follows rtapi_get_time().
+//
+
+#define SIM_CLOCK_LOW  (50 * 1000 * 1000)
+#define SIM_CLOCK_HIGH (100 * 1000 * 1000)
+
+#define SIM_WATCHDOG_ADDR (0x0C00)
+#define SIM_IOPORT_ADDR   (0x1000)
+#define SIM_STEPGEN_ADDR  (0x2000)
+#define SIM_ENCODER_ADDR  (0x3000)
+#define SIM_PWMGEN_ADDR   (0x4000)
+
+// all modules use a register stride of 0x100 and an instance stride of 4
+#define SIM_REG(base, reg, instance) ((base) + ((reg) * 0x100) + ((instance) * 4))
+
+static void sim_md(hm2_test_t *me, int md_index, int gtag, int version, int clock_tag, int instances, int base_address, int num_registers, rtapi_u32 multiple_registers) {
+    uint16_t addr = 0x440 + (md_index * 12);
+
+    // register stride and instance stride both select "0" from the IDROM
+    set32(me, addr + 0, gtag | (version << 8) | (clock_tag << 16) | (instances << 24));
+    set32(me, addr + 4, base_address | (num_registers << 16));
+    set32(me, addr + 8, multiple_registers);
+}
+
+static void sim_pd(hm2_test_t *me, int pin, int sec_pin, int sec_tag, int sec_unit) {
+    set32(me, 0x600 + (pin * 4), sec_pin | (sec_tag << 8) | (sec_unit << 16) | (HM2_GTAG_IOPORT << 24));
+}
+
+static void hm2_test_sim_init(hm2_test_t *me) {
+    int num_pins = HM2_TEST_SIM_NUM_IOPORTS * 24;
+    int pin = 0;
+    int i;
+
+    set32(me, HM2_ADDR_IOCOOKIE, HM2_IOCOOKIE);
+    set_config_name(me);
+    set32(me, HM2_ADDR_IDROM_OFFSET, 0x400);
+
+    set32(me, 0x400, 2);              // IDROM type
+    set32(me, 0x404, 0x40);           // offset to Module Descriptors
+    set32(me, 0x408, 0x200);          // offset to Pin Descriptors
+    set8(me, 0x40c + 0, 'S');         // board name
+    set8(me, 0x40c + 1, 'I');
+    set8(me, 0x40c + 2, 'M');
+    set32(me, 0x41c, HM2_TEST_SIM_NUM_IOPORTS);
+    set32(me, 0x420, num_pins);       // IOWidth
+    set32(me, 0x424, 24);             // PortWidth
+    set32(me, 0x428, SIM_CLOCK_LOW);
+    set32(me, 0x42c, SIM_CLOCK_HIGH);
+    set32(me, 0x430, 4);              // InstanceStride0
+    set32(me, 0x434, 0x40);           // InstanceStride1
+    set32(me, 0x438, 0x100);          // RegisterStride0
+    set32(me, 0x43c, 4);              // RegisterStride1
+
+    sim_md(me, 0, HM2_GTAG_WATCHDOG, 0, 1, 1, SIM_WATCHDOG_ADDR, 3, 0);
+    sim_md(me, 1, HM2_GTAG_IOPORT, 0, 1, HM2_TEST_SIM_NUM_IOPORTS, SIM_IOPORT_ADDR, 5, 0x1F);
+    sim_md(me, 2, HM2_GTAG_ENCODER, 2, 1, HM2_TEST_SIM_NUM_ENCODERS, SIM_ENCODER_ADDR, 5, 0x03);
+    sim_md(me, 3, HM2_GTAG_STEPGEN, 2, 2, HM2_TEST_SIM_NUM_STEPGENS, SIM_STEPGEN_ADDR, 10, 0x1FF);
+    sim_md(me, 4, HM2_GTAG_PWMGEN, 0, 2, HM2_TEST_SIM_NUM_PWMGENS, SIM_PWMGEN_ADDR, 5, 0x03);
+
+    // step & dir, then A, B & index, then pwm, dir & enable, then GPIOs
+    for (i = 0; i < HM2_TEST_SIM_NUM_STEPGENS; i ++) {
+        sim_pd(me, pin++, 0x81, HM2_GTAG_STEPGEN, i);
+        sim_pd(me, pin++, 0x82, HM2_GTAG_STEPGEN, i);
+    }
+    for (i = 0; i < HM2_TEST_SIM_NUM_ENCODERS; i ++) {
+        sim_pd(me, pin++, 1, HM2_GTAG_ENCODER, i);
+        sim_pd(me, pin++, 2, HM2_GTAG_ENCODER, i);
+        sim_pd(me, pin++, 3, HM2_GTAG_ENCODER, i);
+    }
+    for (i = 0; i < HM2_TEST_SIM_NUM_PWMGENS; i ++) {
+        sim_pd(me, pin++, 0x81, HM2_GTAG_PWMGEN, i);
+        sim_pd(me, pin++, 0x82, HM2_GTAG_PWMGEN, i);
+        sim_pd(me, pin++, 0x83, HM2_GTAG_PWMGEN, i);
+    }
+    while (pin < num_pins) {
+        sim_pd(me, pin++, 0, 0, 0);
+    }
+
+    me->llio.num_ioport_connectors = HM2_TEST_SIM_NUM_IOPORTS;
+    me->llio.ioport_connector_name[0] = "P2";
+    me->llio.ioport_connector_name[1] = "P3";
+
+    me->sim.enabled = 1;
+    me->sim.last_ns = rtapi_get_time();
+}
+
+
+// advance the simulation to the current time
+static void hm2_test_sim_update(hm2_test_t *me) {
+    hm2_test_sim_t *sim = &me->sim;
+    long long now = rtapi_get_time();
+    double dt = (now - sim->last_ns) * 1e-9;
+    rtapi_u32 timestamp_div;
+    rtapi_u16 timestamp;
+    int i;
+
+    sim->last_ns = now;
+    sim->time += dt;
+
+    for (i = 0; i < HM2_TEST_SIM_NUM_STEPGENS; i ++) {
+        // the rate register is steps per clock in 0.32 fixed point
+        rtapi_s32 rate = get32(me, SIM_REG(SIM_STEPGEN_ADDR, 0, i));
+        sim->stepgen_position[i] += (rtapi_s64)((double)rate * dt * SIM_CLOCK_HIGH);
+    }
+
+    // the timestamp counter runs at ClockLow / (TSDiv + 2)
+    timestamp_div = get32(me, SIM_REG(SIM_ENCODER_ADDR, 2, 0)) & 0xFFFF;
+    timestamp = (rtapi_u16)(rtapi_u64)(sim->time * SIM_CLOCK_LOW / (timestamp_div + 2));
+
+    for (i = 0; i < HM2_TEST_SIM_NUM_ENCODERS; i ++) {
+        rtapi_u16 count = 0;
+        if (i < HM2_TEST_SIM_NUM_STEPGENS) {
+            count = (rtapi_u16)(sim->stepgen_position[i] >> 32);
+        }
+        if (count != sim->encoder_count[i]) {
+            sim->encoder_count[i] = count;
+            sim->encoder_timestamp[i] = timestamp;
+        }
+    }
+}
+
+
+// the value the driver sees when reading a register of the simulated board
+static rtapi_u32 hm2_test_sim_read_reg(hm2_test_t *me, rtapi_u32 addr) {
+    hm2_test_sim_t *sim = &me->sim;
+    rtapi_u32 val = get32(me, addr);
+    int i;
+
+    if ((addr >= SIM_REG(SIM_IOPORT_ADDR, 0, 0)) && (addr < SIM_REG(SIM_IOPORT_ADDR, 0, HM2_TEST_SIM_NUM_IOPORTS))) {
+        // outputs read back what was written, inputs are pulled up
+        i = (addr - SIM_IOPORT_ADDR) / 4;
+        val &= get32(me, SIM_REG(SIM_IOPORT_ADDR, 1, i));
+        return (val | ~get32(me, SIM_REG(SIM_IOPORT_ADDR, 1, i))) & 0x00FFFFFF;
+    }
+
+    if ((addr >= SIM_REG(SIM_STEPGEN_ADDR, 1, 0)) && (addr < SIM_REG(SIM_STEPGEN_ADDR, 1, HM2_TEST_SIM_NUM_STEPGENS))) {
+        // accumulator, 16.16 fixed point steps
+        i = (addr - SIM_REG(SIM_STEPGEN_ADDR, 1, 0)) / 4;
+        return (rtapi_u32)(sim->stepgen_position[i] >> 16);
+    }
+
+    if ((addr >= SIM_REG(SIM_ENCODER_ADDR, 0, 0)) && (addr < SIM_REG(SIM_ENCODER_ADDR, 0, HM2_TEST_SIM_NUM_ENCODERS))) {
+        // count in the low half, timestamp of the last count in the high half
+        i = (addr - SIM_ENCODER_ADDR) / 4;
+        return sim->encoder_count[i] | (sim->encoder_timestamp[i] << 16);
+    }
+
+    if ((addr >= SIM_REG(SIM_ENCODER_ADDR, 1, 0)) && (addr < SIM_REG(SIM_ENCODER_ADDR, 1, HM2_TEST_SIM_NUM_ENCODERS))) {
+        // latch/control: the written control bits plus the A and B inputs
+        static const rtapi_u32 quadrature[4] = {
+            0,
+            HM2_ENCODER_INPUT_A,
+            HM2_ENCODER_INPUT_A | HM2_ENCODER_INPUT_B,
+            HM2_ENCODER_INPUT_B
+        };
+        i = (addr - SIM_REG(SIM_ENCODER_ADDR, 1, 0)) / 4;
+        val &= HM2_ENCODER_CONTROL_MASK & ~(HM2_ENCODER_QUADRATURE_ERROR | HM2_ENCODER_INPUT_INDEX | HM2_ENCODER_INPUT_B | HM2_ENCODER_INPUT_A);
+        return val | quadrature[sim->encoder_count[i] & 3];
+    }
+
+    if (addr == SIM_REG(SIM_ENCODER_ADDR, 3, 0)) {
+        // timestamp count
+        rtapi_u32 timestamp_div = get32(me, SIM_REG(SIM_ENCODER_ADDR, 2, 0)) & 0xFFFF;
+        return (rtapi_u16)(rtapi_u64)(sim->time * SIM_CLOCK_LOW / (timestamp_div + 2));
+    }
+
+    if (addr == SIM_REG(SIM_WATCHDOG_ADDR, 1, 0)) {
+        // status: has not bitten
+        return 0;
+    }
+
+    return val;
+}
+
 
 // 
 // these are the "low-level I/O" functions exported up
@@ -78,11 +284,28 @@ static void set32(hm2_test_t *me, uint16_t addr, uint32_t val) {
 static int hm2_test_read(hm2_lowlevel_io_t *this, rtapi_u32 addr, void *buffer, int size) {
     hm2_test_t *me = this->private;
     memcpy(buffer, &me->test_pattern.tp8[addr], size);
+
+    if (me->sim.enabled && ((addr % 4) == 0)) {
+        rtapi_u32 *buffer32 = buffer;
+        int i;
+
+        hm2_test_sim_update(me);
+        for (i = 0; i < size / 4; i ++) {
+            buffer32[i] = hm2_test_sim_read_reg(me, addr + (i * 4));
+        }
+    }
+
     return 1;  // success
 }
 
 
 static int hm2_test_write(hm2_lowlevel_io_t *this, rtapi_u32 addr, const void *buffer, int size) {
+    hm2_test_t *me = this->private;
+
+    if (me->sim.enabled) {
+        memcpy(&me->test_pattern.tp8[addr], buffer, size);
+    }
+
     return 1;  // success
 }
 
@@ -550,6 +773,17 @@ int rtapi_app_main(void) {
             break;
         }
 
+
+        //
+        // a working board, with a simulation of the modules behind the
+        // registers, see hm2_test_sim_init()
+        //
+
+        case 15: {
+            hm2_test_sim_init(me);
+            break;
+        }
+
         default: {
             LL_ERR("unknown test pattern %d", test_pattern); 
             return -ENODEV;
@@ -22,12 +22,39 @@
 
 #define HM2_TEST_MAX_BOARDS (2)
 
+
+//
+// The simulated board (test pattern 15) has these modules, see
+// hm2_test_sim_init() for the register layout.
+//
+
+#define HM2_TEST_SIM_NUM_IOPORTS  (2)
+#define HM2_TEST_SIM_NUM_ENCODERS (4)
+#define HM2_TEST_SIM_NUM_STEPGENS (4)
+#define HM2_TEST_SIM_NUM_PWMGENS  (2)
+
+typedef struct {
+    int enabled;
+    long long last_ns;           // rtapi_get_time() of the last update
+    double time;                 // seconds of simulated time
+
+    // stepgen position in steps, 32.32 fixed point
+    rtapi_s64 stepgen_position[HM2_TEST_SIM_NUM_STEPGENS];
+
+    // encoder N counts the steps of stepgen N
+    rtapi_u16 encoder_count[HM2_TEST_SIM_NUM_ENCODERS];
+    rtapi_u16 encoder_timestamp[HM2_TEST_SIM_NUM_ENCODERS];
+} hm2_test_sim_t;
+
+
 typedef struct {
     union {
         rtapi_u8 tp8[64 * 1024];
         rtapi_u32 tp32[16 * 1024];
     } test_pattern;
 
+    hm2_test_sim_t sim;
+
     hm2_lowlevel_io_t llio;
 } hm2_test_t;
 
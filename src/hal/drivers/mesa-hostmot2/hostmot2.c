@@ -382,6 +382,7 @@ static int hm2_parse_config_string(hostmot2_t *hm2, char *config_string) {
     hm2->config.num_leds = -1;
     hm2->config.num_ssrs = -1;
     hm2->config.enable_raw = 0;
+    hm2->config.tram_delta = 0;
     hm2->config.firmware = NULL;
 
     if (config_string == NULL) return 0;
@@ -500,6 +501,10 @@ static int hm2_parse_config_string(hostmot2_t *hm2, char *config_string) {
         } else if (strncmp(token, "enable_raw", 10) == 0) {
             hm2->config.enable_raw = 1;
 
+        } else if (strncmp(token, "tram_delta=", 11) == 0) {
+            token += 11;
+            hm2->config.tram_delta = simple_strtol(token, NULL, 0);
+
         } else if (strncmp(token, "firmware=", 9) == 0) {
             // FIXME: we leak this in hm2_register
             hm2->config.firmware = rtapi_kstrdup(token + 9, RTAPI_GFP_KERNEL);
@@ -535,6 +540,7 @@ static int hm2_parse_config_string(hostmot2_t *hm2, char *config_string) {
     HM2_DBG("    num_uarts=%d\n", hm2->config.num_uarts);
     HM2_DBG("    num_pktuarts=%d\n", hm2->config.num_pktuarts);
     HM2_DBG("    enable_raw=%d\n",   hm2->config.enable_raw);
+    HM2_DBG("    tram_delta=%d\n",   hm2->config.tram_delta);
     HM2_DBG("    firmware=%s\n",   hm2->config.firmware ? hm2->config.firmware : "(NULL)");
 
     rtapi_argv_free(argv);
@@ -1488,6 +1494,11 @@ int hm2_register(hm2_lowlevel_io_t *llio, char *config_string) {
         goto fail1;
     }
 
+    r = hm2_tram_export_hal(hm2);
+    if (r != 0) {
+        goto fail1;
+    }
+
 
     //
     // At this point, all register buffers have been allocated.
@@ -1753,6 +1764,9 @@ void rtapi_app_exit(void) {
 
 // this pushes our idea of what things are like into the FPGA's poor little mind
 void hm2_force_write(hostmot2_t *hm2) {
+    // the next TRAM write sends every output region in full
+    hm2->tram_write_shadow_valid = 0;
+
     hm2_watchdog_force_write(hm2);
     hm2_ioport_force_write(hm2);
     hm2_encoder_force_write(hm2);
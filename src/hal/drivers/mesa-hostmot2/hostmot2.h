@@ -1318,10 +1318,21 @@ typedef struct {
     rtapi_u16 addr;
     rtapi_u16 size;
     rtapi_u32 **buffer;
+    int output;  // write region holds plain output values, may be skipped when unchanged
     struct rtapi_list_head list;
 } hm2_tram_entry_t;
 
 
+//
+// per-board TRAM write statistics, exported to HAL
+//
+
+typedef struct {
+    hal_u32_t *write_bytes;     // LBP16 bytes (headers + data) queued by the last TRAM write
+    hal_u32_t *write_commands;  // number of writes queued by the last TRAM write
+} hm2_tram_stats_t;
+
+
 
 
 // 
@@ -1352,6 +1363,7 @@ typedef struct {
         int num_ssrs;
         char sserial_modes[4][8];
         int enable_raw;
+        int tram_delta;
         char *firmware;
     } config;
 
@@ -1378,6 +1390,13 @@ typedef struct {
     rtapi_u32 *tram_write_buffer;
     rtapi_u16 tram_write_size;
 
+    // with config.tram_delta, what the FPGA was last sent
+    rtapi_u32 *tram_write_shadow;
+    int tram_write_shadow_valid;
+    int tram_write_refresh;
+
+    hm2_tram_stats_t *tram_stats;
+
     // the hostmot2 "Functions"
     hm2_encoder_t encoder;
     hm2_absenc_t absenc;
@@ -1448,7 +1467,9 @@ int hm2_get_pktuart(hostmot2_t **hm2, char *name);
 
 int hm2_register_tram_read_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer);
 int hm2_register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer);
+int hm2_register_tram_output_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer);
 int hm2_allocate_tram_regions(hostmot2_t *hm2);
+int hm2_tram_export_hal(hostmot2_t *hm2);
 int hm2_tram_read(hostmot2_t *hm2);
 int hm2_finish_read(hostmot2_t *hm2);
 int hm2_queue_read(hostmot2_t *hm2);
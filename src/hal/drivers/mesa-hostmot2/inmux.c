@@ -142,7 +142,7 @@ int hm2_inmux_parse_md(hostmot2_t *hm2, int md_index) {
         goto fail0;
     }
 
-    r = hm2_register_tram_write_region(hm2, hm2->inmux.filter_addr, (hm2->inmux.num_instances * sizeof(rtapi_u32)), &hm2->inmux.filter_reg);
+    r = hm2_register_tram_output_region(hm2, hm2->inmux.filter_addr, (hm2->inmux.num_instances * sizeof(rtapi_u32)), &hm2->inmux.filter_reg);
     if (r < 0) {
         HM2_ERR("error registering tram write region for InMux Filter register (%d)\n", r);
         goto fail1;
@@ -115,7 +115,7 @@ int hm2_ssr_parse_md(hostmot2_t *hm2, int md_index) {
         goto fail0;
     }
 
-    r = hm2_register_tram_write_region(hm2, hm2->ssr.data_addr, (hm2->ssr.num_instances * sizeof(rtapi_u32)), &hm2->ssr.data_reg);
+    r = hm2_register_tram_output_region(hm2, hm2->ssr.data_addr, (hm2->ssr.num_instances * sizeof(rtapi_u32)), &hm2->ssr.data_reg);
     if (r < 0) {
         HM2_ERR("error registering tram write region for SSR Data register (%d)\n", r);
         goto fail1;
@@ -672,7 +672,7 @@ int hm2_stepgen_parse_md(hostmot2_t *hm2, int md_index) {
     hm2->stepgen.master_dds_addr = md->base_address + (9 * md->register_stride);
     hm2->stepgen.dpll_timer_num_addr = md->base_address + (10 * md->register_stride);
 
-    r = hm2_register_tram_write_region(hm2, hm2->stepgen.step_rate_addr, (hm2->stepgen.num_instances * sizeof(rtapi_u32)), &hm2->stepgen.step_rate_reg);
+    r = hm2_register_tram_output_region(hm2, hm2->stepgen.step_rate_addr, (hm2->stepgen.num_instances * sizeof(rtapi_u32)), &hm2->stepgen.step_rate_reg);
     if (r < 0) {
         HM2_ERR("error registering tram write region for StepGen Step Rate register (%d)\n", r);
         goto fail0;
@@ -287,7 +287,7 @@ int hm2_tp_pwmgen_parse_md(hostmot2_t *hm2, int md_index) {
     }
 
     // Register the PWM values with the TRAM
-    r = hm2_register_tram_write_region(hm2, hm2->tp_pwmgen.pwm_value_addr, (hm2->tp_pwmgen.num_instances * sizeof(rtapi_u32)), &hm2->tp_pwmgen.pwm_value_reg);
+    r = hm2_register_tram_output_region(hm2, hm2->tp_pwmgen.pwm_value_addr, (hm2->tp_pwmgen.num_instances * sizeof(rtapi_u32)), &hm2->tp_pwmgen.pwm_value_reg);
     if (r < 0) {
         HM2_ERR("error registering tram write region for 3PWM Value register (%d)\n", r);
         goto fail2;
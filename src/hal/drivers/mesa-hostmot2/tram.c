@@ -27,6 +27,7 @@
 #include "hal.h"
 
 #include "hal/drivers/mesa-hostmot2/hostmot2.h"
+#include "hal/drivers/mesa-hostmot2/lbp16.h"
 
 
 
@@ -55,6 +56,7 @@ int hm2_register_tram_read_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 siz
     tram_entry->addr = addr;
     tram_entry->size = size;
     tram_entry->buffer = buffer;
+    tram_entry->output = 0;
 
     rtapi_list_add_tail(&tram_entry->list, &hm2->tram_read_entries);
 
@@ -62,7 +64,7 @@ int hm2_register_tram_read_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 siz
 }
 
 
-int hm2_register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer) {
+static int hm2_register_tram_write_entry(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer, int output) {
     hm2_tram_entry_t *tram_entry;
 
     tram_entry = rtapi_kmalloc(sizeof(hm2_tram_entry_t), RTAPI_GFP_KERNEL);
@@ -74,12 +76,31 @@ int hm2_register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 si
     tram_entry->addr = addr;
     tram_entry->size = size;
     tram_entry->buffer = buffer;
+    tram_entry->output = output;
 
     rtapi_list_add_tail(&tram_entry->list, &hm2->tram_write_entries);
 
     return 0;
 }
 
+int hm2_register_tram_write_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer) {
+    return hm2_register_tram_write_entry(hm2, addr, size, buffer, 0);
+}
+
+
+//
+// Like hm2_register_tram_write_region(), but for registers that just hold
+// output values: writing the same value again has no effect on the FPGA.
+// With the "tram_delta" config option only the words that changed since
+// the last write get sent.  Registers where the write itself does
+// something (watchdog reset, FIFOs, command registers) must use
+// hm2_register_tram_write_region() instead.
+//
+
+int hm2_register_tram_output_region(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u16 size, rtapi_u32 **buffer) {
+    return hm2_register_tram_write_entry(hm2, addr, size, buffer, 1);
+}
+
 
 int hm2_allocate_tram_regions(hostmot2_t *hm2) {
     struct rtapi_list_head *ptr;
@@ -122,6 +143,16 @@ int hm2_allocate_tram_regions(hostmot2_t *hm2) {
     if(hm2->tram_write_size>old_tram_write_size)
         memset((char*)hm2->tram_write_buffer+old_tram_write_size, 0, hm2->tram_write_size-old_tram_write_size);
 
+    if (hm2->config.tram_delta > 0) {
+        hm2->tram_write_shadow = (rtapi_u32 *)rtapi_krealloc(hm2->tram_write_shadow, hm2->tram_write_size, RTAPI_GFP_KERNEL);
+        if (hm2->tram_write_shadow == NULL) {
+            HM2_ERR("Error while (re)allocating Translation RAM shadow buffer (%d bytes)\n", hm2->tram_write_size);
+            return -ENOMEM;
+        }
+    }
+    // the layout may have changed, send everything next time
+    hm2->tram_write_shadow_valid = 0;
+
     HM2_DBG("buffer address %p\n", &hm2->tram_write_buffer);
     HM2_DBG("Translation RAM read buffer:\n");
     offset = 0;
@@ -185,20 +216,126 @@ int hm2_finish_read(hostmot2_t *hm2) {
 }
 
 
+int hm2_tram_export_hal(hostmot2_t *hm2) {
+    int r;
+
+    hm2->tram_stats = (hm2_tram_stats_t *)hal_malloc(sizeof(hm2_tram_stats_t));
+    if (hm2->tram_stats == NULL) {
+        HM2_ERR("out of memory!\n");
+        return -ENOMEM;
+    }
+
+    r = hal_pin_u32_newf(HAL_OUT, &(hm2->tram_stats->write_bytes),
+            hm2->llio->comp_id, "%s.tram.write-bytes", hm2->llio->name);
+    if (r < 0) {
+        HM2_ERR("error adding pin '%s.tram.write-bytes', aborting\n", hm2->llio->name);
+        return r;
+    }
+
+    r = hal_pin_u32_newf(HAL_OUT, &(hm2->tram_stats->write_commands),
+            hm2->llio->comp_id, "%s.tram.write-commands", hm2->llio->name);
+    if (r < 0) {
+        HM2_ERR("error adding pin '%s.tram.write-commands', aborting\n", hm2->llio->name);
+        return r;
+    }
+
+    return 0;
+}
+
+
+// Separate LBP16 writes each cost a 4 byte command header, the same as one
+// register, so changed runs at most this many unchanged registers apart
+// are sent as one write.
+#define HM2_TRAM_MAX_GAP 1
+
 static rtapi_u32 tram_write_iteration = 0;
+
+static int hm2_tram_queue_write(hostmot2_t *hm2, rtapi_u16 addr, rtapi_u32 *buffer, rtapi_u16 size, rtapi_u32 *bytes, rtapi_u32 *commands) {
+    if (!hm2->llio->queue_write(hm2->llio, addr, buffer, size)) {
+        HM2_ERR("TRAM write error! (addr=0x%04x, size=%d, iter=%u)\n", addr, size, tram_write_iteration);
+        return -EIO;
+    }
+    *bytes += sizeof(lbp16_cmd_addr) + size;
+    (*commands) ++;
+    return 0;
+}
+
+// queue only the registers of an output region that differ from the shadow
+static int hm2_tram_write_changed(hostmot2_t *hm2, hm2_tram_entry_t *tram_entry, rtapi_u32 *bytes, rtapi_u32 *commands) {
+    rtapi_u32 *buffer = *tram_entry->buffer;
+    rtapi_u32 *shadow = hm2->tram_write_shadow + (buffer - hm2->tram_write_buffer);
+    int num_regs = tram_entry->size / sizeof(rtapi_u32);
+    int i = 0;
+
+    while (i < num_regs) {
+        int start, end, r;
+
+        while ((i < num_regs) && (buffer[i] == shadow[i])) i ++;
+        if (i == num_regs) break;
+
+        start = i;
+        end = i + 1;
+        for (i = end; (i < num_regs) && (i - end <= HM2_TRAM_MAX_GAP); i ++) {
+            if (buffer[i] != shadow[i]) end = i + 1;
+        }
+
+        r = hm2_tram_queue_write(
+            hm2,
+            tram_entry->addr + (start * sizeof(rtapi_u32)),
+            &buffer[start],
+            (end - start) * sizeof(rtapi_u32),
+            bytes,
+            commands
+        );
+        if (r != 0) return r;
+        i = end;
+    }
+
+    return 0;
+}
+
 int hm2_tram_write(hostmot2_t *hm2) {
     struct rtapi_list_head *ptr;
+    rtapi_u32 bytes = 0, commands = 0;
+    int delta = 0;
+    int r;
+
+    // Output regions are sent in full every tram_delta writes, so that a
+    // lost packet or an FPGA that was reset behind our back only leaves
+    // stale outputs for a bounded time.
+    if (hm2->config.tram_delta > 0) {
+        if (hm2->tram_write_shadow_valid && (++hm2->tram_write_refresh < hm2->config.tram_delta)) {
+            delta = 1;
+        } else {
+            hm2->tram_write_refresh = 0;
+        }
+    }
 
     rtapi_list_for_each(ptr, &hm2->tram_write_entries) {
         hm2_tram_entry_t *tram_entry = rtapi_list_entry(ptr, hm2_tram_entry_t, list);
 
-        if (!hm2->llio->queue_write(hm2->llio, tram_entry->addr, *tram_entry->buffer, tram_entry->size)) {
-            HM2_ERR("TRAM write error! (addr=0x%04x, size=%d, iter=%u)\n", tram_entry->addr, tram_entry->size, tram_write_iteration);
-            return -EIO;
+        if (delta && tram_entry->output) {
+            r = hm2_tram_write_changed(hm2, tram_entry, &bytes, &commands);
+        } else {
+            r = hm2_tram_queue_write(hm2, tram_entry->addr, *tram_entry->buffer, tram_entry->size, &bytes, &commands);
+        }
+        if (r != 0) {
+            hm2->tram_write_shadow_valid = 0;
+            return r;
         }
     }
     tram_write_iteration ++;
 
+    if (hm2->config.tram_delta > 0) {
+        memcpy(hm2->tram_write_shadow, hm2->tram_write_buffer, hm2->tram_write_size);
+        hm2->tram_write_shadow_valid = 1;
+    }
+
+    if (hm2->tram_stats != NULL) {
+        *hm2->tram_stats->write_bytes = bytes;
+        *hm2->tram_stats->write_commands = commands;
+    }
+
     return 0;
 }
 
@@ -231,5 +368,6 @@ void hm2_tram_cleanup(hostmot2_t *hm2) {
     // free the tram buffers
     if (hm2->tram_read_buffer != NULL) rtapi_kfree(hm2->tram_read_buffer);
     if (hm2->tram_write_buffer != NULL) rtapi_kfree(hm2->tram_write_buffer);
+    if (hm2->tram_write_shadow != NULL) rtapi_kfree(hm2->tram_write_shadow);
 }
 
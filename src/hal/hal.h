@@ -812,13 +812,15 @@ extern void hal_port_clear(hal_port_t port);
 
 
 #ifdef ULAPI
-/** hal_port_wait_readable spin waits on a port until it has at least 
-    count bytes available for reading, or *stop > 0
+/** hal_port_wait_readable sleeps until a port has at least count
+    bytes available for reading, or *stop > 0.  The writer wakes it
+    as soon as data is committed; *stop is checked at least every 10ms.
  */
 extern void hal_port_wait_readable(hal_port_t** port, unsigned count, sig_atomic_t* stop);
 
-/** hal_port_wait_writable spin waits on a port until it has at least
-    count bytes available for writing or *stop > 0
+/** hal_port_wait_writable sleeps until a port has at least count
+    bytes available for writing or *stop > 0.  The reader wakes it as
+    soon as data is consumed; *stop is checked at least every 10ms.
  */
 extern void hal_port_wait_writable(hal_port_t** port, unsigned count, sig_atomic_t* stop);
 #endif
@@ -879,6 +881,43 @@ extern bool hal_stream_writable(hal_stream_t *stream);
 extern void hal_stream_wait_writable(hal_stream_t *stream, sig_atomic_t *stop);
 #endif
 
+typedef struct {
+    struct hal_snapshot_shm *snap;
+} hal_snapshot_t;
+
+/**
+ * HAL snapshots let user space read a set of signals as they were at
+ * the end of one period of a realtime thread.  The thread copies them
+ * after its last function, and a reader gets all of them with one
+ * memcpy, none torn and all from the same period, without locking.
+ *
+ * Any number of readers may attach to a snapshot.  The handle stays
+ * valid after the snapshot is deleted, it then just stops changing.
+ */
+
+/** create a snapshot called 'name' of 'count' signals, taken by
+    'thread_name' at the end of every period.  Port signals can not be
+    part of a snapshot. */
+extern int hal_snapshot_new(const char *name, const char *thread_name,
+    int count, const char **signals);
+/** stop taking a snapshot and forget its name */
+extern int hal_snapshot_delete(const char *name);
+
+/** attach to an existing snapshot */
+extern int hal_snapshot_attach(hal_snapshot_t *snapshot, const char *name);
+
+/** snapshot introspection */
+extern int hal_snapshot_element_count(hal_snapshot_t *snapshot);
+extern hal_type_t hal_snapshot_element_type(hal_snapshot_t *snapshot, int idx);
+
+/** copy the newest snapshot into buf, one element for each signal.  The
+    rtapi_get_time() at which it was taken goes to *time and the number of
+    snapshots taken so far, 0 before the first, to *serial; either may be
+    NULL.  Returns 0, or -EAGAIN if the thread kept overwriting the
+    snapshot while it was copied. */
+extern int hal_snapshot_read(hal_snapshot_t *snapshot,
+    union hal_stream_data *buf, long long *time, unsigned *serial);
+
 RTAPI_END_DECLS
 
 #endif /* HAL_H */
@@ -74,6 +74,14 @@ MODULE_LICENSE("GPL");
 #include <time.h>
 #endif
 
+#if !defined(__KERNEL__)
+#include <limits.h>		/* INT_MAX */
+#include <unistd.h>		/* syscall() */
+#include <sys/syscall.h>	/* SYS_futex */
+#include <linux/futex.h>	/* FUTEX_WAIT, FUTEX_WAKE */
+#define HAL_WAKE_FUTEX
+#endif
+
 char *hal_shmem_base = 0;
 hal_data_t *hal_data = 0;
 static int lib_module_id = -1;	/* RTAPI module ID for library module */
@@ -151,14 +159,46 @@ static void free_funct_entry_struct(hal_funct_entry_t * funct_entry);
 static void free_thread_struct(hal_thread_t * thread);
 #endif /* RTAPI */
 
+/** 'update_exec_list()' rebuilds the array of functions that the
+    realtime side of 'thread' runs from its funct_list, and swaps it in.
+    It must be called with the mutex held after every change to the
+    funct_list.  On return the realtime thread no longer runs the
+    previous array.  Returns 0, or -ENOMEM if the array could not be
+    grown, in which case the thread keeps running the previous one.
+*/
+static int update_exec_list(hal_thread_t * thread);
+
+/** 'place_thread_signals()' moves signal values used by realtime
+    functions into one cache-line aligned block per thread, so that a
+    thread's functions find their pins' data together instead of spread
+    over the whole shared memory area.  Threads are handled fastest
+    first, and a signal goes to the first thread that runs a function of
+    a component with a pin linked to it.  Signals with pins of userspace
+    components are left alone, since those may be written at any time.
+    It must be called with the mutex held and the threads stopped.
+*/
+static void place_thread_signals(void);
+
 #ifdef RTAPI
 /** 'thread_task()' is a function that is invoked as a realtime task.
     It implements a thread, by running down the thread's function list
     and calling each function in turn.
 */
 static void thread_task(void *arg);
+
+/** 'take_snapshot()' copies the signals of a snapshot into the buffer
+    readers are not directed to, and then directs them to it.  It is
+    called by thread_task() after the last function of each period.
+*/
+static void take_snapshot(struct hal_snapshot_shm *snap);
 #endif /* RTAPI */
 
+/** 'forget_snapshot()' unlinks a snapshot from the snapshot list and
+    from its thread.  It must be called with the mutex held.  'prev'
+    is the link that points to it.
+*/
+static void forget_snapshot(rtapi_intptr_t *prev);
+
 /***********************************************************************
 *                  PUBLIC (API) FUNCTION CODE                          *
 ************************************************************************/
@@ -1000,7 +1040,9 @@ with the C standard.
 int hal_signal_delete(const char *name)
 {
     hal_sig_t *sig;
-    rtapi_intptr_t *prev, next;
+    struct hal_snapshot_shm *snap;
+    rtapi_intptr_t *prev, next, snap_next;
+    int n, used;
 
     if (hal_data == 0) {
 	rtapi_print_msg(RTAPI_MSG_ERR,
@@ -1025,6 +1067,22 @@ int hal_signal_delete(const char *name)
 	if (strcmp(sig->name, name) == 0) {
 	    /* this is the right signal, unlink from list */
 	    *prev = sig->next_ptr;
+	    /* drop it from snapshots, and make sure their threads are
+	       done with it before the struct is reused */
+	    for (snap_next = hal_data->snapshot_list_ptr; snap_next != 0;
+		snap_next = snap->next_ptr) {
+		snap = SHMPTR(snap_next);
+		used = 0;
+		for (n = 0; n < snap->count; n++) {
+		    if (snap->entry[n].sig_ptr == next) {
+			snap->entry[n].sig_ptr = 0;
+			used = 1;
+		    }
+		}
+		if (used) {
+		    update_exec_list(SHMPTR(snap->thread_ptr));
+		}
+	    }
 	    /* and delete it */
 	    free_sig_struct(sig);
 	    /* done */
@@ -2153,6 +2211,15 @@ int hal_add_funct_to_thread(const char *funct_name, const char *thread_name, int
     funct_entry->funct = funct->funct;
     /* add the entry to the list */
     list_add_after((hal_list_t *) funct_entry, list_entry);
+    /* and hand the new list to the realtime thread */
+    if (update_exec_list(thread) != 0) {
+	list_remove_entry((hal_list_t *) funct_entry);
+	free_funct_entry_struct(funct_entry);
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: insufficient memory for thread->function link\n");
+	return -ENOMEM;
+    }
     /* update the function usage count */
     funct->users++;
     rtapi_mutex_give(&(hal_data->mutex));
@@ -2238,6 +2305,8 @@ int hal_del_funct_from_thread(const char *funct_name, const char *thread_name)
 	if (SHMPTR(funct_entry->funct_ptr) == funct) {
 	    /* this funct entry points to our funct, unlink */
 	    list_remove_entry(list_entry);
+	    /* the realtime thread must be done with it before it is freed */
+	    update_exec_list(thread);
 	    /* and delete it */
 	    free_funct_entry_struct(funct_entry);
 	    /* done */
@@ -2266,6 +2335,11 @@ int hal_start_threads(void)
 
 
     rtapi_print_msg(RTAPI_MSG_DBG, "HAL: starting threads\n");
+    if (hal_data->threads_running == 0) {
+	rtapi_mutex_get(&(hal_data->mutex));
+	place_thread_signals();
+	rtapi_mutex_give(&(hal_data->mutex));
+    }
     hal_data->threads_running = 1;
     return 0;
 }
@@ -2774,28 +2848,42 @@ static void thread_task(void *arg)
 {
     hal_thread_t *thread;
     hal_funct_t *funct;
-    hal_funct_entry_t *funct_root, *funct_entry;
+    hal_exec_list_t *exec;
+    hal_exec_entry_t *exec_entry, *exec_end, *snap_end;
     long long int start_time, end_time;
     long long int thread_start_time;
+    int active;
 
     thread = arg;
     while (1) {
 	if (hal_data->threads_running > 0) {
-	    /* point at first function on function list */
-	    funct_root = (hal_funct_entry_t *) & (thread->funct_list);
-	    funct_entry = SHMPTR(funct_root->links.next);
+	    /* claim the current exec list, see update_exec_list() */
+	    do {
+		active = atomic_load_explicit(&thread->exec_active,
+		    memory_order_seq_cst);
+		atomic_store_explicit(&thread->exec_reader, active + 1,
+		    memory_order_seq_cst);
+	    } while (atomic_load_explicit(&thread->exec_active,
+		    memory_order_seq_cst) != active);
+	    exec_entry = exec_end = snap_end = 0;
+	    if (thread->exec_list[active] != 0) {
+		exec = SHMPTR(thread->exec_list[active]);
+		exec_entry = exec->entry;
+		exec_end = exec->entry + exec->count;
+		snap_end = exec_end + exec->snapshots;
+	    }
 	    /* execution time logging */
 	    start_time = rtapi_get_clocks();
 	    end_time = start_time;
 	    thread_start_time = start_time;
 	    /* run thru function list */
-	    while (funct_entry != funct_root) {
+	    for (; exec_entry != exec_end; exec_entry++) {
 		/* call the function */
-		funct_entry->funct(funct_entry->arg, thread->period);
+		exec_entry->funct(exec_entry->arg, thread->period);
 		/* capture execution time */
 		end_time = rtapi_get_clocks();
 		/* point to function structure */
-		funct = SHMPTR(funct_entry->funct_ptr);
+		funct = SHMPTR(exec_entry->funct_ptr);
 		/* update execution time data */
 		*(funct->runtime) = (hal_s32_t)(end_time - start_time);
 		if ( *(funct->runtime) > funct->maxtime) {
@@ -2804,11 +2892,18 @@ static void thread_task(void *arg)
 		} else {
 		    funct->maxtime_increased = 0;
 		}
-		/* point to next next entry in list */
-		funct_entry = SHMPTR(funct_entry->links.next);
 		/* prepare to measure time for next funct */
 		start_time = end_time;
 	    }
+	    /* the snapshots follow the functions, and count as thread time */
+	    if (exec_entry != snap_end) {
+		for (; exec_entry != snap_end; exec_entry++) {
+		    take_snapshot(SHMPTR(exec_entry->funct_ptr));
+		}
+		end_time = rtapi_get_clocks();
+	    }
+	    atomic_store_explicit(&thread->exec_reader, 0,
+		memory_order_release);
 	    /* update thread execution time */
 	    *(thread->runtime) = (hal_s32_t)(end_time - thread_start_time);
 	    if ( *(thread->runtime) > thread->maxtime) {
@@ -2819,6 +2914,29 @@ static void thread_task(void *arg)
 	rtapi_wait();
     }
 }
+
+static void take_snapshot(struct hal_snapshot_shm *snap)
+{
+    hal_snapshot_buf_t *buf;
+    hal_sig_t *sig;
+    unsigned latest, seq;
+    int n;
+
+    latest = snap->latest;
+    buf = SHMPTR(snap->buf[(latest + 1) & 1]);
+    seq = buf->seq;
+    atomic_store_explicit(&buf->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (n = 0; n < snap->count; n++) {
+	if (snap->entry[n].sig_ptr != 0) {
+	    sig = SHMPTR(snap->entry[n].sig_ptr);
+	    buf->value[n] = *(hal_data_u *) SHMPTR(sig->data_ptr);
+	}
+    }
+    buf->time = rtapi_get_time();
+    atomic_store_explicit(&buf->seq, seq + 2, memory_order_release);
+    atomic_store_explicit(&snap->latest, latest + 1, memory_order_release);
+}
 #endif /* RTAPI */
 
 /* see the declarations of these functions (near top of file) for
@@ -2849,6 +2967,7 @@ static int init_hal_data(void)
     hal_data->param_list_ptr = 0;
     hal_data->funct_list_ptr = 0;
     hal_data->thread_list_ptr = 0;
+    hal_data->snapshot_list_ptr = 0;
     hal_data->base_period = 0;
     hal_data->threads_running = 0;
     hal_data->oldname_free_ptr = 0;
@@ -3009,6 +3128,7 @@ static hal_sig_t *alloc_sig_struct(void)
 	p->readers = 0;
 	p->writers = 0;
 	p->bidirs = 0;
+	p->placed = 0;
 	p->name[0] = '\0';
     }
     return p;
@@ -3121,6 +3241,222 @@ static hal_funct_entry_t *alloc_funct_entry_struct(void)
     return p;
 }
 
+static int update_exec_list(hal_thread_t * thread)
+{
+    hal_list_t *list_root, *list_entry;
+    hal_funct_entry_t *funct_entry;
+    hal_exec_list_t *exec;
+    struct hal_snapshot_shm *snap;
+    rtapi_intptr_t snap_next;
+    int next, old, n, nsnap, size;
+
+    /* count the functions and snapshots */
+    list_root = &(thread->funct_list);
+    n = 0;
+    for (list_entry = list_next(list_root); list_entry != list_root;
+	list_entry = list_next(list_entry)) {
+	n++;
+    }
+    nsnap = 0;
+    for (snap_next = hal_data->snapshot_list_ptr; snap_next != 0;
+	snap_next = snap->next_ptr) {
+	snap = SHMPTR(snap_next);
+	if (snap->thread_ptr == SHMOFF(thread)) {
+	    nsnap++;
+	}
+    }
+    n += nsnap;
+    /* the array not in use may be refilled; grow it if needed.  There
+       is no way to return the outgrown array to shared memory, so grow
+       by doubling to keep that waste small. */
+    old = thread->exec_active;
+    next = !old;
+    exec = thread->exec_list[next] ? SHMPTR(thread->exec_list[next]) : 0;
+    if (exec == 0 || exec->size < n) {
+	size = exec ? exec->size * 2 : 8;
+	if (size < n) {
+	    size = n;
+	}
+	exec = shmalloc_up(sizeof(hal_exec_list_t) +
+	    size * sizeof(hal_exec_entry_t));
+	if (exec == 0) {
+	    return -ENOMEM;
+	}
+	exec->size = size;
+	thread->exec_list[next] = SHMOFF(exec);
+    }
+    /* fill it in */
+    n = 0;
+    for (list_entry = list_next(list_root); list_entry != list_root;
+	list_entry = list_next(list_entry)) {
+	funct_entry = (hal_funct_entry_t *) list_entry;
+	exec->entry[n].arg = funct_entry->arg;
+	exec->entry[n].funct = funct_entry->funct;
+	exec->entry[n].funct_ptr = funct_entry->funct_ptr;
+	n++;
+    }
+    exec->count = n;
+    for (snap_next = hal_data->snapshot_list_ptr; snap_next != 0;
+	snap_next = snap->next_ptr) {
+	snap = SHMPTR(snap_next);
+	if (snap->thread_ptr == SHMOFF(thread)) {
+	    exec->entry[n].arg = 0;
+	    exec->entry[n].funct = 0;
+	    exec->entry[n].funct_ptr = snap_next;
+	    n++;
+	}
+    }
+    exec->snapshots = nsnap;
+    /* swap it in, then wait until the realtime thread has finished any
+       pass over the old array.  thread_task() reads 'exec_active' again
+       after announcing itself in 'exec_reader', so it cannot start on the
+       old array once this store is visible. */
+    atomic_store_explicit(&thread->exec_active, next, memory_order_seq_cst);
+    while (atomic_load_explicit(&thread->exec_reader, memory_order_seq_cst)
+	== old + 1) {
+	rtapi_delay(10000);
+    }
+    return 0;
+}
+
+#define HAL_CACHELINE 64
+
+/* Calls 'visit' for each signal that is a candidate for the block of
+   'thread' and is in state 'placed'. */
+static void for_each_thread_signal(hal_thread_t * thread, int placed,
+    void (*visit) (hal_sig_t * sig, void *arg), void *arg)
+{
+    hal_exec_list_t *exec;
+    hal_funct_t *funct;
+    hal_comp_t *comp, *other;
+    hal_pin_t *pin, *linked;
+    hal_sig_t *sig;
+    int n;
+
+    if (thread->exec_list[thread->exec_active] == 0) {
+	return;
+    }
+    exec = SHMPTR(thread->exec_list[thread->exec_active]);
+    for (n = 0; n < exec->count; n++) {
+	funct = SHMPTR(exec->entry[n].funct_ptr);
+	comp = SHMPTR(funct->owner_ptr);
+	for (pin = halpr_find_pin_by_owner(comp, 0); pin != 0;
+	    pin = halpr_find_pin_by_owner(comp, pin)) {
+	    if (pin->signal == 0) {
+		continue;
+	    }
+	    sig = SHMPTR(pin->signal);
+	    if (sig->placed != placed) {
+		continue;
+	    }
+	    /* only signals that just realtime components touch */
+	    for (linked = halpr_find_pin_by_sig(sig, 0); linked != 0;
+		linked = halpr_find_pin_by_sig(sig, linked)) {
+		other = SHMPTR(linked->owner_ptr);
+		if (other->type != 1) {
+		    break;
+		}
+	    }
+	    if (linked == 0) {
+		visit(sig, arg);
+	    }
+	}
+    }
+}
+
+static void count_signal(hal_sig_t * sig, void *arg)
+{
+    sig->placed = 1;
+    (*(int *) arg)++;
+}
+
+static void unmark_signal(hal_sig_t * sig, void *arg)
+{
+    (void) arg;
+    sig->placed = 0;
+}
+
+static void move_signal(hal_sig_t * sig, void *arg)
+{
+    hal_data_u **slot = arg;
+    hal_pin_t *pin;
+    hal_comp_t *comp;
+    void **data_ptr_addr;
+
+    **slot = *(hal_data_u *) SHMPTR(sig->data_ptr);
+    sig->data_ptr = SHMOFF(*slot);
+    sig->placed = 2;
+    (*slot)++;
+    /* point the linked pins at the new location, as hal_link() does */
+    for (pin = halpr_find_pin_by_sig(sig, 0); pin != 0;
+	pin = halpr_find_pin_by_sig(sig, pin)) {
+	data_ptr_addr = SHMPTR(pin->data_ptr_addr);
+	comp = SHMPTR(pin->owner_ptr);
+	*data_ptr_addr = comp->shmem_base + sig->data_ptr;
+    }
+}
+
+static void place_thread_signals(void)
+{
+    hal_thread_t *thread, *best;
+    long last_period;
+    rtapi_intptr_t last, next;
+    hal_data_u *slot;
+    char *block;
+    int n;
+
+    /* a pass that began before the threads were stopped may still be
+       running */
+    for (next = hal_data->thread_list_ptr; next != 0; next = thread->next_ptr) {
+	thread = SHMPTR(next);
+	while (atomic_load_explicit(&thread->exec_reader,
+		memory_order_seq_cst) != 0) {
+	    rtapi_delay(10000);
+	}
+    }
+    last_period = 0;
+    last = 0;
+    while (1) {
+	/* find the next thread in order of period */
+	best = 0;
+	for (next = hal_data->thread_list_ptr; next != 0;
+	    next = thread->next_ptr) {
+	    thread = SHMPTR(next);
+	    if (thread->period < last_period
+		|| (thread->period == last_period && next <= last)) {
+		continue;
+	    }
+	    if (best == 0 || thread->period < best->period
+		|| (thread->period == best->period && thread < best)) {
+		best = thread;
+	    }
+	}
+	if (best == 0) {
+	    break;
+	}
+	last_period = best->period;
+	last = SHMOFF(best);
+
+	n = 0;
+	for_each_thread_signal(best, 0, count_signal, &n);
+	if (n == 0) {
+	    continue;
+	}
+	/* the old locations are abandoned, so each signal moves only once */
+	block = shmalloc_up(n * sizeof(hal_data_u) + 2 * HAL_CACHELINE - 1);
+	if (block == 0) {
+	    for_each_thread_signal(best, 1, unmark_signal, 0);
+	    rtapi_print_msg(RTAPI_MSG_DBG,
+		"HAL: no memory to place signals of thread '%s'\n", best->name);
+	    continue;
+	}
+	slot = SHMPTR((SHMOFF(block) + HAL_CACHELINE - 1) & ~(HAL_CACHELINE - 1));
+	for_each_thread_signal(best, 1, move_signal, &slot);
+	rtapi_print_msg(RTAPI_MSG_DBG,
+	    "HAL: placed %d signals of thread '%s'\n", n, best->name);
+    }
+}
+
 #ifdef RTAPI
 static hal_thread_t *alloc_thread_struct(void)
 {
@@ -3136,6 +3472,11 @@ static hal_thread_t *alloc_thread_struct(void)
     } else {
 	/* nothing on free list, allocate a brand new one */
 	p = shmalloc_dn(sizeof(hal_thread_t));
+	if (p) {
+	    /* a recycled struct keeps its exec list arrays */
+	    p->exec_list[0] = 0;
+	    p->exec_list[1] = 0;
+	}
     }
     if (p) {
 	/* make sure it's empty */
@@ -3145,6 +3486,8 @@ static hal_thread_t *alloc_thread_struct(void)
 	p->priority = 0;
 	p->task_id = 0;
 	list_init_entry(&(p->funct_list));
+	p->exec_active = 0;
+	p->exec_reader = 0;
 	p->name[0] = '\0';
     }
     return p;
@@ -3301,6 +3644,16 @@ static void free_pin_struct(hal_pin_t * pin)
     hal_data->pin_free_ptr = SHMOFF(pin);
 }
 
+static void forget_snapshot(rtapi_intptr_t *prev)
+{
+    struct hal_snapshot_shm *snap;
+
+    snap = SHMPTR(*prev);
+    *prev = snap->next_ptr;
+    snap->next_ptr = 0;
+    snap->thread_ptr = 0;
+}
+
 static void free_sig_struct(hal_sig_t * sig)
 {
     hal_pin_t *pin;
@@ -3385,6 +3738,8 @@ static void free_funct_struct(hal_funct_t * funct)
 		    list_entry = list_next(list_entry);
 		}
 	    }
+	    /* stop the realtime thread calling the function */
+	    update_exec_list(thread);
 	    /* move on to the next thread */
 	    next_thread = thread->next_ptr;
 	}
@@ -3426,6 +3781,8 @@ static void free_thread_struct(hal_thread_t * thread)
 {
     hal_funct_entry_t *funct_entry;
     hal_list_t *list_root, *list_entry;
+    struct hal_snapshot_shm *snap;
+    rtapi_intptr_t *prev;
 /*! \todo Another #if 0 */
 #if 0
     rtapi_intptr_t *prev, next;
@@ -3454,6 +3811,19 @@ static void free_thread_struct(hal_thread_t * thread)
 	/* free the removed entry */
 	free_funct_entry_struct(funct_entry);
     }
+    /* and its snapshots */
+    prev = &(hal_data->snapshot_list_ptr);
+    while (*prev != 0) {
+	snap = SHMPTR(*prev);
+	if (snap->thread_ptr == SHMOFF(thread)) {
+	    forget_snapshot(prev);
+	} else {
+	    prev = &(snap->next_ptr);
+	}
+    }
+    /* the task is gone, so nobody is running the exec lists */
+    thread->exec_reader = 0;
+    update_exec_list(thread);
 /*! \todo Another #if 0 */
 #if 0
 /* Currently these don't get created, so we don't have to worry
@@ -3505,6 +3875,67 @@ static char *halpr_type_string(int type, char *buf, size_t nbuf) {
 
 
 
+/******************************************************************************
+Port and stream wakeups
+******************************************************************************/
+
+/* Userspace waiters on a port or stream sleep on the 'seq' word of a
+   hal_wake_t in shared memory.  Whoever moves a read or write position
+   bumps 'seq' and, only if somebody has announced itself in 'waiters',
+   issues a FUTEX_WAKE.  FUTEX_WAKE never blocks, and when nobody waits
+   the cost to the realtime side is one atomic add and one load.
+
+   The futex is not private since the word is in shared memory.  Kernel
+   realtime builds cannot make the syscall; there the waiters still wake
+   from the timeout, which also bounds how long a stop flag goes unseen.
+*/
+
+#define HAL_WAKE_TIMEOUT_NS 10000000
+
+static void hal_wake_notify(hal_wake_t *wake)
+{
+    atomic_fetch_add_explicit(&wake->seq, 1, memory_order_seq_cst);
+#ifdef HAL_WAKE_FUTEX
+    if(atomic_load_explicit(&wake->waiters, memory_order_seq_cst)) {
+        syscall(SYS_futex, &wake->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    }
+#endif
+}
+
+
+#ifdef ULAPI
+/* Announce a waiter and return the current sequence number.  The caller
+   must re-check its condition after this and then call hal_wake_wait()
+   or hal_wake_cancel(); a change made in between is never missed because
+   it alters 'seq' and the futex wait returns at once. */
+static unsigned hal_wake_prepare(hal_wake_t *wake)
+{
+    atomic_fetch_add_explicit(&wake->waiters, 1, memory_order_seq_cst);
+    return atomic_load_explicit(&wake->seq, memory_order_seq_cst);
+}
+
+
+static void hal_wake_cancel(hal_wake_t *wake)
+{
+    atomic_fetch_sub_explicit(&wake->waiters, 1, memory_order_seq_cst);
+}
+
+
+static void hal_wake_wait(hal_wake_t *wake, unsigned seq)
+{
+#ifdef HAL_WAKE_FUTEX
+    struct timespec timeout = { 0, HAL_WAKE_TIMEOUT_NS };
+    syscall(SYS_futex, &wake->seq, FUTEX_WAIT, seq, &timeout, NULL, 0);
+#else
+    (void)seq;
+    rtapi_delay(HAL_WAKE_TIMEOUT_NS);
+#endif
+    hal_wake_cancel(wake);
+}
+#endif
+
+
+
 /******************************************************************************
 HAL PORT functions
 ******************************************************************************/
@@ -3519,12 +3950,14 @@ static void hal_port_atomic_load(hal_port_shm_t* port_shm, unsigned* read, unsig
 static void hal_port_atomic_store_read(hal_port_shm_t* port_shm, unsigned read)
 {
     atomic_store_explicit(&port_shm->read, read, memory_order_release);
+    hal_wake_notify(&port_shm->wake);
 }
 
 
 static void hal_port_atomic_store_write(hal_port_shm_t* port_shm, unsigned write)
 {
     atomic_store_explicit(&port_shm->write, write, memory_order_release);
+    hal_wake_notify(&port_shm->wake);
 }
 
 
@@ -3794,14 +4227,45 @@ void hal_port_clear(hal_port_t port) {
 #ifdef ULAPI
 void hal_port_wait_readable(hal_port_t** port, unsigned count, sig_atomic_t* stop) {
     while((hal_port_readable(**port) < count) && (!stop || !*stop)) {
-        rtapi_delay(10000000);
+        hal_port_t p = **port;
+        hal_port_shm_t* port_shm;
+        unsigned seq;
+
+        if(!p) {
+            //not connected yet, nothing to sleep on
+            rtapi_delay(HAL_WAKE_TIMEOUT_NS);
+            continue;
+        }
+
+        port_shm = SHMPTR(p);
+        seq = hal_wake_prepare(&port_shm->wake);
+        if(hal_port_readable(p) < count) {
+            hal_wake_wait(&port_shm->wake, seq);
+        } else {
+            hal_wake_cancel(&port_shm->wake);
+        }
     }
 }
 
 
 void hal_port_wait_writable(hal_port_t** port, unsigned count, sig_atomic_t* stop) {
     while((hal_port_writable(**port) < count) && (!stop || !*stop)) {
-        rtapi_delay(10000000);
+        hal_port_t p = **port;
+        hal_port_shm_t* port_shm;
+        unsigned seq;
+
+        if(!p) {
+            rtapi_delay(HAL_WAKE_TIMEOUT_NS);
+            continue;
+        }
+
+        port_shm = SHMPTR(p);
+        seq = hal_wake_prepare(&port_shm->wake);
+        if(hal_port_writable(p) < count) {
+            hal_wake_wait(&port_shm->wake, seq);
+        } else {
+            hal_wake_cancel(&port_shm->wake);
+        }
     }
 }
 #endif
@@ -3922,15 +4386,23 @@ int hal_stream_maxdepth(hal_stream_t *stream) {
 #ifdef ULAPI
 void hal_stream_wait_writable(hal_stream_t *stream, sig_atomic_t *stop) {
     while(!hal_stream_writable(stream) && (!stop || !*stop)) {
-        /* fifo full, sleep for 10ms */
-        rtapi_delay(10000000);
+        /* fifo full, sleep until the reader moves 'out' */
+        unsigned seq = hal_wake_prepare(&stream->fifo->wake);
+        if(!hal_stream_writable(stream))
+            hal_wake_wait(&stream->fifo->wake, seq);
+        else
+            hal_wake_cancel(&stream->fifo->wake);
     }
 }
 
 void hal_stream_wait_readable(hal_stream_t *stream, sig_atomic_t *stop) {
     while(!hal_stream_readable(stream) && (!stop || !*stop)) {
-        /* fifo full, sleep for 10ms */
-        rtapi_delay(10000000);
+        /* fifo empty, sleep until the writer moves 'in' */
+        unsigned seq = hal_wake_prepare(&stream->fifo->wake);
+        if(!hal_stream_readable(stream))
+            hal_wake_wait(&stream->fifo->wake, seq);
+        else
+            hal_wake_cancel(&stream->fifo->wake);
     }
 }
 #endif
@@ -3949,11 +4421,13 @@ static int hal_stream_atomic_load_out(hal_stream_t *stream)
 static void hal_stream_atomic_store_in(hal_stream_t *stream, int newin)
 {
     atomic_store_explicit(&stream->fifo->in, newin, memory_order_release);
+    hal_wake_notify(&stream->fifo->wake);
 }
 
 static void hal_stream_atomic_store_out(hal_stream_t *stream, int newout)
 {
     atomic_store_explicit(&stream->fifo->out, newout, memory_order_release);
+    hal_wake_notify(&stream->fifo->wake);
 }
 
 int hal_stream_write(hal_stream_t *stream, union hal_stream_data *buf) {
@@ -4075,6 +4549,215 @@ int hal_stream_num_underruns(hal_stream_t *stream) {
     return stream->fifo->num_underruns;
 }
 
+/* the link that points to the snapshot called 'name', or 0 */
+static rtapi_intptr_t *find_snapshot_link(const char *name)
+{
+    rtapi_intptr_t *prev;
+    struct hal_snapshot_shm *snap;
+
+    for (prev = &(hal_data->snapshot_list_ptr); *prev != 0;
+	prev = &(snap->next_ptr)) {
+	snap = SHMPTR(*prev);
+	if (strcmp(snap->name, name) == 0) {
+	    return prev;
+	}
+    }
+    return 0;
+}
+
+int hal_snapshot_new(const char *name, const char *thread_name,
+    int count, const char **signals)
+{
+    hal_thread_t *thread;
+    hal_sig_t *sig;
+    struct hal_snapshot_shm *snap;
+    hal_snapshot_buf_t *buf[2];
+    long int buf_size;
+    int n, retval;
+
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: snapshot_new called before init\n");
+	return -EINVAL;
+    }
+    if (hal_data->lock & HAL_LOCK_CONFIG)  {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: snapshot_new called while HAL locked\n");
+	return -EPERM;
+    }
+    if (strlen(name) > HAL_NAME_LEN) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: snapshot name '%s' is too long\n", name);
+	return -EINVAL;
+    }
+    if (count < 1) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: snapshot '%s' has no signals\n", name);
+	return -EINVAL;
+    }
+    rtapi_print_msg(RTAPI_MSG_DBG, "HAL: creating snapshot '%s'\n", name);
+    /* get mutex before accessing shared data */
+    rtapi_mutex_get(&(hal_data->mutex));
+    if (find_snapshot_link(name) != 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: duplicate snapshot '%s'\n", name);
+	return -EINVAL;
+    }
+    thread = halpr_find_thread_by_name(thread_name);
+    if (thread == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: thread '%s' not found\n", thread_name);
+	return -EINVAL;
+    }
+    for (n = 0; n < count; n++) {
+	sig = halpr_find_sig_by_name(signals[n]);
+	if (sig == 0) {
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: signal '%s' not found\n", signals[n]);
+	    return -EINVAL;
+	}
+	if (sig->type == HAL_PORT) {
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    rtapi_print_msg(RTAPI_MSG_ERR,
+		"HAL: ERROR: port signal '%s' can not be in a snapshot\n",
+		signals[n]);
+	    return -EINVAL;
+	}
+    }
+    /* allocate the snapshot and its buffers */
+    buf_size = sizeof(hal_snapshot_buf_t) + count * sizeof(hal_data_u);
+    snap = shmalloc_up(sizeof(struct hal_snapshot_shm)
+	+ count * sizeof(hal_snapshot_entry_t));
+    buf[0] = snap ? shmalloc_up(buf_size) : 0;
+    buf[1] = buf[0] ? shmalloc_up(buf_size) : 0;
+    if (buf[1] == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: insufficient memory for snapshot '%s'\n", name);
+	return -ENOMEM;
+    }
+    /* initialize the structure */
+    memset(buf[0], 0, buf_size);
+    memset(buf[1], 0, buf_size);
+    snap->buf[0] = SHMOFF(buf[0]);
+    snap->buf[1] = SHMOFF(buf[1]);
+    snap->latest = 0;
+    snap->count = count;
+    for (n = 0; n < count; n++) {
+	sig = halpr_find_sig_by_name(signals[n]);
+	snap->entry[n].sig_ptr = SHMOFF(sig);
+	snap->entry[n].type = sig->type;
+    }
+    rtapi_snprintf(snap->name, sizeof(snap->name), "%s", name);
+    snap->thread_ptr = SHMOFF(thread);
+    /* put it on the list, and hand it to the thread */
+    snap->next_ptr = hal_data->snapshot_list_ptr;
+    hal_data->snapshot_list_ptr = SHMOFF(snap);
+    retval = update_exec_list(thread);
+    if (retval != 0) {
+	forget_snapshot(&(hal_data->snapshot_list_ptr));
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: insufficient memory for snapshot '%s'\n", name);
+	return retval;
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
+}
+
+int hal_snapshot_delete(const char *name)
+{
+    rtapi_intptr_t *prev;
+    struct hal_snapshot_shm *snap;
+    hal_thread_t *thread;
+
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: snapshot_delete called before init\n");
+	return -EINVAL;
+    }
+    if (hal_data->lock & HAL_LOCK_CONFIG)  {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: snapshot_delete called while HAL locked\n");
+	return -EPERM;
+    }
+    rtapi_print_msg(RTAPI_MSG_DBG, "HAL: deleting snapshot '%s'\n", name);
+    rtapi_mutex_get(&(hal_data->mutex));
+    prev = find_snapshot_link(name);
+    if (prev == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: snapshot '%s' not found\n", name);
+	return -EINVAL;
+    }
+    snap = SHMPTR(*prev);
+    thread = SHMPTR(snap->thread_ptr);
+    forget_snapshot(prev);
+    update_exec_list(thread);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
+}
+
+int hal_snapshot_attach(hal_snapshot_t *snapshot, const char *name)
+{
+    rtapi_intptr_t *prev;
+
+    snapshot->snap = NULL;
+    if (hal_data == 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "HAL: ERROR: snapshot_attach called before init\n");
+	return -EINVAL;
+    }
+    rtapi_mutex_get(&(hal_data->mutex));
+    prev = find_snapshot_link(name);
+    if (prev != 0) {
+	snapshot->snap = SHMPTR(*prev);
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    return prev ? 0 : -EINVAL;
+}
+
+int hal_snapshot_element_count(hal_snapshot_t *snapshot) {
+    return snapshot->snap->count;
+}
+
+hal_type_t hal_snapshot_element_type(hal_snapshot_t *snapshot, int idx) {
+    return snapshot->snap->entry[idx].type;
+}
+
+int hal_snapshot_read(hal_snapshot_t *snapshot, union hal_stream_data *buf,
+    long long *time, unsigned *serial)
+{
+    struct hal_snapshot_shm *snap = snapshot->snap;
+    hal_snapshot_buf_t *b;
+    long long t;
+    unsigned latest, seq;
+    int tries;
+
+    /* hal_data_u and union hal_stream_data both hold every type at
+       offset 0 in 8 bytes, so the values need no conversion */
+    for (tries = 0; tries < 1000; tries++) {
+	latest = atomic_load_explicit(&snap->latest, memory_order_acquire);
+	b = SHMPTR(snap->buf[latest & 1]);
+	seq = atomic_load_explicit(&b->seq, memory_order_acquire);
+	if (seq & 1) {
+	    continue;
+	}
+	memcpy(buf, b->value, snap->count * sizeof(hal_data_u));
+	t = b->time;
+	atomic_thread_fence(memory_order_acquire);
+	if (atomic_load_explicit(&b->seq, memory_order_relaxed) == seq) {
+	    if (time) *time = t;
+	    if (serial) *serial = latest;
+	    return 0;
+	}
+    }
+    return -EAGAIN;
+}
+
 #ifdef RTAPI
 /* only export symbols when we're building a kernel module */
 
@@ -4174,4 +4857,11 @@ EXPORT_SYMBOL_GPL(hal_stream_element_count);
 EXPORT_SYMBOL_GPL(hal_stream_element_type);
 EXPORT_SYMBOL_GPL(hal_stream_num_overruns);
 EXPORT_SYMBOL_GPL(hal_stream_num_underruns);
+
+EXPORT_SYMBOL(hal_snapshot_new);
+EXPORT_SYMBOL(hal_snapshot_delete);
+EXPORT_SYMBOL(hal_snapshot_attach);
+EXPORT_SYMBOL(hal_snapshot_element_count);
+EXPORT_SYMBOL(hal_snapshot_element_type);
+EXPORT_SYMBOL(hal_snapshot_read);
 #endif /* rtapi */
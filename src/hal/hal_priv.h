@@ -130,10 +130,20 @@ typedef union {
     hal_port_t p;
 } hal_data_u;
 
+/** Event word used to wake userspace waiters on a port or stream.
+    Every change of a read or write position increments 'seq'; the
+    futex wake is only issued when 'waiters' is non-zero.
+*/
+typedef struct {
+    volatile unsigned int seq;
+    volatile unsigned int waiters;
+} hal_wake_t;
+
 typedef struct {
     volatile unsigned int read;  //offset into buff that outgoing data gets read from
     volatile unsigned int write; //offset into buff that incoming data gets written to
     unsigned int size;           //size of allocated buffer
+    hal_wake_t wake;             //signalled when read or write moves
     char buff[];                 
 } hal_port_shm_t;
 
@@ -201,6 +211,7 @@ typedef struct {
     int exact_base_period;      /* if set, pretend that rtapi satisfied our
 				   period request exactly */
     unsigned char lock;         /* hal locking, can be one of the HAL_LOCK_* types */
+    rtapi_intptr_t snapshot_list_ptr;	/* root of linked list of snapshots */
 } hal_data_t;
 
 /** HAL 'component' data structure.
@@ -246,6 +257,7 @@ typedef struct {
     int readers;		/* number of input pins linked */
     int writers;		/* number of output pins linked */
     int bidirs;			/* number of I/O pins linked */
+    int placed;			/* value moved to a thread's block */
     char name[HAL_NAME_LEN + 1];	/* signal name */
 } hal_sig_t;
 
@@ -299,6 +311,27 @@ typedef struct {
     int funct_ptr;		/* pointer to function */
 } hal_funct_entry_t;
 
+/* The realtime thread does not walk the funct_list.  It runs a compact
+   array built from it, of which each thread has two.  A change to the
+   funct_list fills in the array that is not in use and swaps 'exec_active'
+   over to it; the writer then waits until the realtime thread is no
+   longer running the old array, announced in 'exec_reader'.  The
+   snapshots the thread takes after its last function follow the
+   function entries, as entries with no funct whose funct_ptr points to
+   the snapshot. */
+typedef struct {
+    void *arg;			/* argument for function */
+    void (*funct) (void *, long);	/* ptr to function code */
+    rtapi_intptr_t funct_ptr;	/* pointer to function */
+} hal_exec_entry_t;
+
+typedef struct {
+    int count;			/* number of function entries in use */
+    int snapshots;		/* number of snapshot entries after them */
+    int size;			/* number of entries allocated */
+    hal_exec_entry_t entry[];
+} hal_exec_list_t;
+
 #define HAL_STACKSIZE 16384	/* realtime task stacksize */
 
 typedef struct {
@@ -310,10 +343,44 @@ typedef struct {
     hal_s32_t* runtime;	/* (pin) duration of last run, in CPU cycles */
     hal_s32_t maxtime;	/* (param) duration of longest run, in CPU cycles */
     hal_list_t funct_list;	/* list of functions to run */
+    rtapi_intptr_t exec_list[2];	/* arrays built from funct_list */
+    volatile int exec_active;	/* index of the array to run next */
+    volatile int exec_reader;	/* 1 + index of the array being run, or 0 */
     char name[HAL_NAME_LEN + 1];	/* thread name */
     int comp_id;
 } hal_thread_t;
 
+/* A snapshot is a copy of a set of signals that a realtime thread
+   takes at the end of every period, so user space can read values that
+   belong to the same period and none of which is torn.  The thread
+   writes one of two buffers and then announces it in 'latest', while
+   readers copy the other.  Each buffer has a sequence number that is odd
+   while the thread writes it; a reader only has to retry when the thread
+   came round to its buffer again during the copy, a period after it was
+   announced.  Snapshots are never freed, so a reader's pointer stays
+   valid: one that is deleted, or whose thread is, is just no longer
+   taken. */
+typedef struct {
+    volatile unsigned seq;	/* odd while the buffer is being written */
+    long long int time;		/* rtapi_get_time() when it was taken */
+    hal_data_u value[];		/* one for each signal */
+} hal_snapshot_buf_t;
+
+typedef struct {
+    rtapi_intptr_t sig_ptr;	/* the signal, 0 once it is deleted */
+    hal_type_t type;		/* its type */
+} hal_snapshot_entry_t;
+
+struct hal_snapshot_shm {
+    rtapi_intptr_t next_ptr;	/* next snapshot in linked list */
+    rtapi_intptr_t thread_ptr;	/* thread that takes it, 0 once deleted */
+    int count;			/* number of signals */
+    volatile unsigned latest;	/* snapshots taken, the newest in buf[latest & 1] */
+    rtapi_intptr_t buf[2];	/* the two hal_snapshot_buf_t */
+    char name[HAL_NAME_LEN + 1];	/* snapshot name */
+    hal_snapshot_entry_t entry[];	/* one for each signal */
+};
+
 /* IMPORTANT:  If any of the structures in this file are changed, the
    version code (HAL_VER) must be incremented, to ensure that 
    incompatible utilities, etc, aren't used to manipulate data in
@@ -337,7 +404,7 @@ typedef struct {
 */
 
 #define HAL_KEY   0x48414C32	/* key used to open HAL shared memory */
-#define HAL_VER   0x0000000F	/* version code */
+#define HAL_VER   0x00000012	/* version code */
 #define HAL_SIZE  (85*4096)
 #define HAL_PSEUDO_COMP_PREFIX "__" /* prefix to identify a pseudo component */
 
@@ -453,6 +520,7 @@ struct hal_stream_shm {
     int depth;
     int num_pins;
     unsigned long num_overruns, num_underruns;
+    hal_wake_t wake;
     hal_type_t type[HAL_STREAM_MAX_PINS];
     union hal_stream_data data[];
 };
@@ -1195,6 +1195,51 @@ PyTypeObject shm_type = {
     0,                         /*tp_is_gc*/
 };
 
+/*######################################*/
+/* Get the newest snapshot of a set of signals */
+PyObject *get_snapshot(PyObject *self, PyObject *args) {
+    char *name;
+    hal_snapshot_t snapshot;
+    long long time;
+    unsigned serial;
+
+    if(!PyArg_ParseTuple(args, "s", &name)) return NULL;
+    if(!SHMPTR(0)) {
+	PyErr_Format(PyExc_RuntimeError,
+		"Cannot call before creating component");
+	return NULL;
+    }
+    if(hal_snapshot_attach(&snapshot, name) < 0) {
+        PyErr_Format(PyExc_RuntimeError, "snapshot %s not found", name);
+        return NULL;
+    }
+
+    int n = hal_snapshot_element_count(&snapshot);
+    hal_stream_data buf[n];
+    int r = hal_snapshot_read(&snapshot, buf, &time, &serial);
+    if(r < 0) { errno = -r; PyErr_SetFromErrno(PyExc_IOError); return NULL; }
+
+    PyObject *values = PyTuple_New(n);
+    if(!values) return 0;
+
+    for(int i=0; i<n; i++) {
+        PyObject *o;
+        switch(hal_snapshot_element_type(&snapshot, i)) {
+        case HAL_BIT: o = to_python(buf[i].b); break;
+        case HAL_FLOAT: o = to_python(buf[i].f); break;
+        case HAL_S32: o = to_python(buf[i].s); break;
+        case HAL_U32: o = to_python(buf[i].u); break;
+        default: Py_INCREF(Py_None); o = Py_None; break;
+        }
+        if(!o) {
+            Py_DECREF(values);
+            return 0;
+        }
+        PyTuple_SET_ITEM(values, i, o);
+    }
+    return Py_BuildValue("ILN", serial, time, values);
+}
+
 struct streamobj {
     PyObject_HEAD
     hal_stream_t stream;
@@ -1451,6 +1496,8 @@ PyMethodDef module_methods[] = {
 	"set pin value"},
     {"get_value", get_value, METH_VARARGS,
 	".get_value('name'}: Gets the pin, param or signal value"},
+    {"get_snapshot", get_snapshot, METH_VARARGS,
+	".get_snapshot('name'): Gets the newest snapshot of a set of signals as (serial, time, (values...))"},
     {NULL},
 };
 
@@ -115,17 +115,25 @@ QUIT_CLEANUP:
  * One thread loop for each link
  * The LOGIC is here
  * thrd_link_num is the corresponding link of this thread (int *)
+ *
+ * Each link schedules only its own transactions (this_mb_link->tx_list),
+ * earliest next_time (deadline) first, and sleeps until that deadline
+ * instead of polling. Due reads of the same slave and function whose
+ * elements are adjacent or overlap go out as one request, and several
+ * due read requests are pipelined on Modbus/TCP links with TCP_PIPELINE > 1.
  */
 
 void *link_loop_and_logic(void *thrd_link_num)
 {
     char *fnct_name = "link_loop_and_logic";
-    int ret, ret_available, ret_connected;
-    int tx_counter;
+    int ret, ret_connected;
+    int read_counter, tx_counter, tot_reads;
+    double now;
     mb_tx_t   *this_mb_tx = NULL;
     int        this_mb_tx_num;
     mb_link_t *this_mb_link = NULL;
     int        this_mb_link_num;
+    mb_read_t  reads[MB2HAL_MAX_TCP_PIPELINE];
 
     if (thrd_link_num == NULL) {
         ERR(gbl.init_dbg, "NULL pointer");
@@ -137,54 +145,72 @@ void *link_loop_and_logic(void *thrd_link_num)
         return NULL;
     }
     this_mb_link = &gbl.mb_links[this_mb_link_num];
+    if (this_mb_link->tot_tx <= 0) {
+        ERR(gbl.init_dbg, "no transactions for this_mb_link_num[%d]", this_mb_link_num);
+        return NULL;
+    }
 
-    while (1) {
+    while (gbl.quit_flag == 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
 
-        for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
+        this_mb_tx_num = next_tx_of_link(this_mb_link);
+        this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
 
-            if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
-                return NULL;
+        //not now, sleep until the deadline
+        now = get_time();
+        if (now < this_mb_tx->next_time) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT available for [%0.6f] s",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+                this_mb_tx->next_time - now);
+            if (this_mb_tx->next_time - now > MB2HAL_MAX_SLEEP) {
+                sleep_until(now + MB2HAL_MAX_SLEEP);
             }
+            else {
+                sleep_until(this_mb_tx->next_time);
+            }
+            continue;
+        }
 
-            this_mb_tx_num = tx_counter;
-            this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
+        DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST connection",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
 
-            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST availability",
+        //first time connection or reconnection, run time parameters setting
+        if (get_tx_connection(this_mb_tx_num, &ret_connected) != retOK) {
+            ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] get_tx_connection ERR",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            return NULL;
+        }
+        if (ret_connected == 0) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT connected",
                 this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            usleep(1000);
+            continue;
+        }
 
-            //corresponding link and time (update_rate)
-            if (is_this_tx_ready(this_mb_link_num, this_mb_tx_num, &ret_available) != retOK) {
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] is_this_tx_ready ERR",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                return NULL;
+        DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] lk_dbg[%d] going to EXECUTE transaction",
+            this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+            this_mb_tx->protocol_debug);
+
+        if (is_mergeable_read(this_mb_tx) && (gbl.merge_reads != 0 || this_mb_link->lp_tcp_pipeline > 1)) {
+            tot_reads = collect_reads(this_mb_link, reads, now);
+            if (tot_reads > 1) {
+                read_tcp_pipelined(reads, tot_reads, this_mb_link);
             }
-            if (ret_available == 0) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT available",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                usleep(1000);
-                continue;
+            else {
+                reads[0].ret = read_merged(&reads[0], this_mb_link);
             }
 
-            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] going to TEST connection",
-                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-
-            //first time connection or reconnection, run time parameters setting
-            if (get_tx_connection(this_mb_tx_num, &ret_connected) != retOK) {
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] get_tx_connection ERR",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
+            if (gbl.quit_flag != 0) { //tell the threads to quit (SIGTERM o SGIQUIT) (unloadusr mb2hal).
                 return NULL;
             }
-            if (ret_connected == 0) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] NOT connected",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                usleep(1000);
-                continue;
-            }
-
-            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] lk_dbg[%d] going to EXECUTE transaction",
-                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                this_mb_tx->protocol_debug);
 
+            for (read_counter = 0; read_counter < tot_reads; read_counter++) {
+                for (tx_counter = 0; tx_counter < reads[read_counter].tot_tx; tx_counter++) {
+                    set_tx_result(&gbl.mb_tx[reads[read_counter].tx[tx_counter]], this_mb_link,
+                                  reads[read_counter].ret, now);
+                }
+            }
+        }
+        else {
             switch (this_mb_tx->mb_tx_fnct) {
             case mbtx_02_READ_DISCRETE_INPUTS:
                 ret = fnct_02_read_discrete_inputs(this_mb_tx, this_mb_link);
@@ -205,7 +231,7 @@ void *link_loop_and_logic(void *thrd_link_num)
                 ret = fnct_16_write_multiple_registers(this_mb_tx, this_mb_link);
                 break;
             default:
-                ret = -1;
+                ret = retERR;
                 ERR(this_mb_tx->cfg_debug, "case error with mb_tx_fnct %d [%s] in mb_tx_num[%d]",
                     this_mb_tx->mb_tx_fnct, this_mb_tx->mb_tx_fnct_name, this_mb_tx_num);
                 break;
@@ -215,45 +241,23 @@ void *link_loop_and_logic(void *thrd_link_num)
                 return NULL;
             }
 
-            if (ret != retOK && modbus_get_socket(this_mb_link->modbus) < 0) { //link failure
-                (*this_mb_tx->num_errors)++;
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] link failure, going to close link",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus));
-                modbus_close(this_mb_link->modbus);
-            }
-            else if (ret != retOK) {  //transaction failure but link OK
-                (**this_mb_tx->num_errors)++;
-                ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction failure, num_errors[%d]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), **this_mb_tx->num_errors);
-                // Clear any unread data. Otherwise the link might get out of sync
-                modbus_flush(this_mb_link->modbus);
-            }
-            else { //transaction and link OK
-                OK(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] transaction OK, update_HZ[%0.03f]",
-                   this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                   1.0/(get_time()-this_mb_tx->last_time_ok));
-                this_mb_tx->last_time_ok = get_time();
-                (**this_mb_tx->num_errors) = 0;
-            }
-
-            //set the next (waiting) time for update rate
-            this_mb_tx->next_time = get_time() + this_mb_tx->time_increment;
+            set_tx_result(this_mb_tx, this_mb_link, ret, now);
+        }
 
-            //wait time for serial lines
-            if (this_mb_tx->cfg_link_type == linkRTU) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] SERIAL_DELAY_MS activated [%d]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
-                    this_mb_tx->cfg_serial_delay_ms);
-                usleep(this_mb_tx->cfg_serial_delay_ms * 1000);
-            }
+        //wait time for serial lines
+        if (this_mb_tx->cfg_link_type == linkRTU) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] SERIAL_DELAY_MS activated [%d]",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus),
+                this_mb_tx->cfg_serial_delay_ms);
+            usleep(this_mb_tx->cfg_serial_delay_ms * 1000);
+        }
 
-            //wait time to gbl.slowdown activity (debugging)
-            if (gbl.slowdown > 0) {
-                DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] gbl.slowdown activated [%0.3f]",
-                    this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), gbl.slowdown);
-                usleep(gbl.slowdown * 1000 * 1000);
-            }
-        }  //end for
+        //wait time to gbl.slowdown activity (debugging)
+        if (gbl.slowdown > 0) {
+            DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] thread[%d] fd[%d] gbl.slowdown activated [%0.3f]",
+                this_mb_tx_num, this_mb_tx->mb_link_num, this_mb_link_num, modbus_get_socket(this_mb_link->modbus), gbl.slowdown);
+            usleep(gbl.slowdown * 1000 * 1000);
+        }
 
     } //end while
 
@@ -261,46 +265,193 @@ void *link_loop_and_logic(void *thrd_link_num)
 }
 
 /*
- * Check if the transaction is available for this link
+ * The transaction of this link with the earliest deadline.
+ * Ties go to the first one in the INI file.
  */
 
-retCode is_this_tx_ready(const int this_mb_link_num, const int this_mb_tx_num, int *ret_available)
+int next_tx_of_link(mb_link_t *this_mb_link)
 {
-    char *fnct_name = "is_this_tx_available";
-    mb_tx_t *this_mb_tx;
-    int this_mb_tx_link_num;
+    int counter, this_mb_tx_num;
+    int next_mb_tx_num = this_mb_link->tx_list[0];
 
-    if (this_mb_tx_num < 0 || this_mb_tx_num > gbl.tot_mb_tx) {
-        ERR(gbl.init_dbg, "parameter out of range this_mb_tx_num[%d]", this_mb_tx_num);
-        return retERR;
+    for (counter = 1; counter < this_mb_link->tot_tx; counter++) {
+        this_mb_tx_num = this_mb_link->tx_list[counter];
+        if (gbl.mb_tx[this_mb_tx_num].next_time < gbl.mb_tx[next_mb_tx_num].next_time) {
+            next_mb_tx_num = this_mb_tx_num;
+        }
     }
-    this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
 
-    if (ret_available == NULL) {
-        ERR(this_mb_tx->cfg_debug, "NULL pointer");
-        return retERR;
-    }
+    return next_mb_tx_num;
+}
 
-    this_mb_tx_link_num = this_mb_tx->mb_link_num;
-    if (this_mb_tx_link_num < 0 || this_mb_tx_link_num >= gbl.tot_mb_links) {
-        ERR(this_mb_tx->cfg_debug, "parameter out of range this_mb_tx_link_num[%d]", this_mb_tx_link_num);
-        return retERR;
+/*
+ * Reads that may be merged with others or pipelined
+ */
+
+int is_mergeable_read(const mb_tx_t *this_mb_tx)
+{
+    switch (this_mb_tx->mb_tx_fnct) {
+    case mbtx_02_READ_DISCRETE_INPUTS:
+        return this_mb_tx->mb_tx_nelem <= MB2HAL_MAX_FNCT02_ELEMENTS;
+    case mbtx_03_READ_HOLDING_REGISTERS:
+        return this_mb_tx->mb_tx_nelem <= MB2HAL_MAX_FNCT03_ELEMENTS;
+    case mbtx_04_READ_INPUT_REGISTERS:
+        return this_mb_tx->mb_tx_nelem <= MB2HAL_MAX_FNCT04_ELEMENTS;
+    default:
+        return 0;
     }
+}
+
+/*
+ * Add to this_mb_read the reads of the same slave and function that are
+ * due now, or within a quarter of their own period, and whose elements
+ * are adjacent to or overlap the request, while it fits in one PDU
+ */
+
+static void merge_due_reads(mb_link_t *this_mb_link, mb_read_t *this_mb_read, const double now)
+{
+    int counter, grown, first_addr, last_addr, max_nelem;
+    mb_tx_t *this_mb_tx;
+
+    max_nelem = (this_mb_read->fnct == mbtx_02_READ_DISCRETE_INPUTS)? MB2HAL_MAX_READ_BITS : MB2HAL_MAX_READ_REGISTERS;
+
+    do {
+        grown = 0;
+        for (counter = 0; counter < this_mb_link->tot_tx && this_mb_read->tot_tx < MB2HAL_MAX_MERGED_TX; counter++) {
+            this_mb_tx = &gbl.mb_tx[this_mb_link->tx_list[counter]];
+            if (this_mb_tx->sched_mark == this_mb_link->sched_pass
+                    || this_mb_tx->mb_tx_fnct != this_mb_read->fnct
+                    || this_mb_tx->mb_tx_slave_id != this_mb_read->slave_id
+                    || !is_mergeable_read(this_mb_tx)
+                    || this_mb_tx->next_time - now > this_mb_tx->time_increment / 4) {
+                continue;
+            }
+            if (this_mb_tx->mb_tx_1st_addr > this_mb_read->first_addr + this_mb_read->nelem
+                    || this_mb_tx->mb_tx_1st_addr + this_mb_tx->mb_tx_nelem < this_mb_read->first_addr) {
+                continue; //there is a gap
+            }
+            first_addr = this_mb_read->first_addr;
+            if (this_mb_tx->mb_tx_1st_addr < first_addr) {
+                first_addr = this_mb_tx->mb_tx_1st_addr;
+            }
+            last_addr = this_mb_read->first_addr + this_mb_read->nelem;
+            if (this_mb_tx->mb_tx_1st_addr + this_mb_tx->mb_tx_nelem > last_addr) {
+                last_addr = this_mb_tx->mb_tx_1st_addr + this_mb_tx->mb_tx_nelem;
+            }
+            if (last_addr - first_addr > max_nelem) {
+                continue;
+            }
+            this_mb_read->first_addr = first_addr;
+            this_mb_read->nelem = last_addr - first_addr;
+            this_mb_read->tx[this_mb_read->tot_tx++] = this_mb_tx->mb_tx_num;
+            this_mb_tx->sched_mark = this_mb_link->sched_pass;
+            grown = 1;
+        }
+    } while (grown);
+}
+
+/*
+ * Build the read requests to send now, the 1st one for the due
+ * transaction with the earliest deadline.  Returns the number of
+ * requests: more than one only on a pipelined Modbus/TCP link.
+ */
 
-    *ret_available = 0; //defaults to not available
+int collect_reads(mb_link_t *this_mb_link, mb_read_t *reads, const double now)
+{
+    char *fnct_name = "collect_reads";
+    int tot_reads = 0, max_reads = 1;
+    int counter, this_mb_tx_num;
+    mb_tx_t *this_mb_tx;
+    mb_read_t *this_mb_read;
 
-    //the tx is not of this link
-    if (this_mb_link_num != this_mb_tx_link_num) {
-        return retOK;
+    if (this_mb_link->lp_link_type == linkTCP) {
+        max_reads = this_mb_link->lp_tcp_pipeline;
     }
+    this_mb_link->sched_pass++;
+
+    this_mb_tx_num = next_tx_of_link(this_mb_link);
+    do {
+        this_mb_tx = &gbl.mb_tx[this_mb_tx_num];
+        this_mb_read = &reads[tot_reads++];
+        this_mb_read->fnct = this_mb_tx->mb_tx_fnct;
+        this_mb_read->slave_id = this_mb_tx->mb_tx_slave_id;
+        this_mb_read->first_addr = this_mb_tx->mb_tx_1st_addr;
+        this_mb_read->nelem = this_mb_tx->mb_tx_nelem;
+        this_mb_read->tx[0] = this_mb_tx_num;
+        this_mb_read->tot_tx = 1;
+        this_mb_read->ret = retERR;
+        this_mb_tx->sched_mark = this_mb_link->sched_pass;
+
+        if (gbl.merge_reads != 0) {
+            merge_due_reads(this_mb_link, this_mb_read, now);
+        }
+        DBG(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] read[%d] slave[%d] 1st_addr[%d] nelem[%d] merged_tx[%d]",
+            this_mb_tx_num, this_mb_tx->mb_link_num, tot_reads - 1, this_mb_read->slave_id,
+            this_mb_read->first_addr, this_mb_read->nelem, this_mb_read->tot_tx);
+
+        //next due read for the pipeline
+        this_mb_tx_num = -1;
+        for (counter = 0; counter < this_mb_link->tot_tx && tot_reads < max_reads; counter++) {
+            this_mb_tx = &gbl.mb_tx[this_mb_link->tx_list[counter]];
+            if (this_mb_tx->sched_mark != this_mb_link->sched_pass
+                    && this_mb_tx->next_time <= now && is_mergeable_read(this_mb_tx)) {
+                this_mb_tx_num = this_mb_tx->mb_tx_num;
+                break;
+            }
+        }
+    } while (this_mb_tx_num >= 0);
+
+    return tot_reads;
+}
+
+/*
+ * Count errors or update the achieved rate of a finished transaction,
+ * then set its next deadline
+ */
 
-    //not now
-    if (get_time() < this_mb_tx->next_time) {
-        return retOK;
+void set_tx_result(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link, const retCode ret, const double start_time)
+{
+    char *fnct_name = "set_tx_result";
+    double now, period;
+
+    if (ret != retOK && modbus_get_socket(this_mb_link->modbus) < 0) { //link failure
+        (**this_mb_tx->num_errors)++;
+        ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] fd[%d] link failure, going to close link",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, modbus_get_socket(this_mb_link->modbus));
+        modbus_close(this_mb_link->modbus);
+    }
+    else if (ret != retOK) {  //transaction failure but link OK
+        (**this_mb_tx->num_errors)++;
+        ERR(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] fd[%d] transaction failure, num_errors[%d]",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, modbus_get_socket(this_mb_link->modbus), **this_mb_tx->num_errors);
+        // Clear any unread data. Otherwise the link might get out of sync
+        modbus_flush(this_mb_link->modbus);
+    }
+    else { //transaction and link OK
+        now = get_time();
+        if (this_mb_tx->last_time_ok > 0) {
+            period = now - this_mb_tx->last_time_ok;
+            if (this_mb_tx->avg_period > 0) {
+                this_mb_tx->avg_period += (period - this_mb_tx->avg_period) / 8;
+            }
+            else {
+                this_mb_tx->avg_period = period;
+            }
+            **this_mb_tx->update_rate = 1.0 / this_mb_tx->avg_period;
+            OK(this_mb_tx->cfg_debug, "mb_tx_num[%d] mb_links[%d] fd[%d] transaction OK, update_HZ[%0.03f] MAX_UPDATE_RATE[%0.03f]",
+               this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, modbus_get_socket(this_mb_link->modbus),
+               1.0 / period, this_mb_tx->cfg_update_rate);
+        }
+        this_mb_tx->last_time_ok = now;
+        (**this_mb_tx->num_errors) = 0;
     }
 
-    *ret_available = 1; //is available
-    return retOK;
+    //set the next deadline for update rate, keeping the phase unless
+    //the tx started more than one period late
+    this_mb_tx->next_time += this_mb_tx->time_increment;
+    if (this_mb_tx->next_time <= start_time) {
+        this_mb_tx->next_time = start_time + this_mb_tx->time_increment;
+    }
 }
 
 /*
@@ -396,6 +547,7 @@ void set_init_gbl_params()
     gbl.hal_mod_id   = -1;
     gbl.init_dbg     = debugERR; //until readed in config file
     gbl.slowdown     = 0;        //until readed in config file
+    gbl.merge_reads  = 1;        //until readed in config file
     gbl.mb_tx_fncts[mbtxERR]                         = "";
     gbl.mb_tx_fncts[mbtx_02_READ_DISCRETE_INPUTS]    = "fnct_02_read_discrete_inputs";
     gbl.mb_tx_fncts[mbtx_03_READ_HOLDING_REGISTERS]  = "fnct_03_read_holding_registers";
@@ -407,11 +559,27 @@ void set_init_gbl_params()
     return;
 }
 
+/*
+ * Monotonic time in seconds, for deadlines and update rates
+ */
+
 double get_time()
 {
-    struct timeval time;
-    gettimeofday(&time, NULL);
-    return (time.tv_sec + ((double) time.tv_usec / 1000000.0f));
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (time.tv_sec + ((double) time.tv_nsec / 1000000000.0));
+}
+
+void sleep_until(double wake_time)
+{
+    struct timespec time;
+
+    time.tv_sec  = (time_t) wake_time;
+    time.tv_nsec = (long) ((wake_time - time.tv_sec) * 1000000000.0);
+    if (time.tv_nsec > 999999999) {
+        time.tv_nsec = 999999999;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, NULL) == EINTR && gbl.quit_flag == 0);
 }
 
 /*
@@ -440,6 +608,8 @@ void quit_cleanup(void)
             modbus_free(gbl.mb_links[counter].modbus);
             gbl.mb_links[counter].modbus = NULL;
         }
+        free(gbl.mb_links[counter].tx_list);
+        gbl.mb_links[counter].tx_list = NULL;
     }
     gbl.tot_mb_links = 0;
 
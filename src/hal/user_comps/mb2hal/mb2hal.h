@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <sys/time.h>
+#include <time.h>
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
@@ -29,6 +30,14 @@
 #define MB2HAL_MAX_FNCT06_ELEMENTS 1
 #define MB2HAL_MAX_FNCT15_ELEMENTS 100
 #define MB2HAL_MAX_FNCT16_ELEMENTS 100
+#define MB2HAL_DEFAULT_TCP_PIPELINE 1
+#define MB2HAL_MAX_TCP_PIPELINE    16
+//Modbus PDU limits for a merged read request
+#define MB2HAL_MAX_READ_BITS      2000
+#define MB2HAL_MAX_READ_REGISTERS  125
+#define MB2HAL_MAX_MERGED_TX        32
+//longest sleep of a link thread, so it sees gbl.quit_flag
+#define MB2HAL_MAX_SLEEP           0.1
 
 #ifdef MODULE_VERBOSE
 MODULE_VERBOSE(emc2, "component:mb2hal:Userspace HAL component to communicate with one or more Modbus devices");
@@ -74,6 +83,7 @@ typedef struct {
     int  cfg_serial_delay_ms;  //delay between tx in serial lines
     char cfg_tcp_ip[17];       //tcp address
     int  cfg_tcp_port;         //tcp port number
+    int  cfg_tcp_pipeline;     //max outstanding tcp read requests
     //mb_* are Modbus transaction protocol related params
     int        mb_tx_slave_id; //MB device id
     mb_tx_fnct mb_tx_fnct;     //MB function code id
@@ -93,8 +103,10 @@ typedef struct {
     int mb_link_num;       //each tx know it's own link
     //internal processing values
     double time_increment; //wait time between tx
-    double next_time;      //next time for this tx
+    double next_time;      //next time for this tx (deadline)
     double last_time_ok;   //last OK tx time
+    double avg_period;     //filtered time between OK tx
+    int    sched_mark;     //last scheduler pass that took this tx
     //HAL related params
     char hal_tx_name[HAL_NAME_LEN + 1];
     hal_float_t **float_value;
@@ -103,6 +115,7 @@ typedef struct {
     //hal_float_t *offset; //not yet implemented
     hal_bit_t **bit;
     hal_u32_t **num_errors;     //num of acummulated errors (0=last tx OK)
+    hal_float_t **update_rate;  //achieved update rate in HZ
 } mb_tx_t;
 
 //Modbus link structure (mb_link_t)
@@ -121,12 +134,35 @@ typedef struct {
     int  lp_serial_delay_ms;  //delay between tx in serial lines
     char lp_tcp_ip[17];       //tcp address
     int  lp_tcp_port;         //tcp port number
+    int  lp_tcp_pipeline;     //max outstanding tcp read requests (1 = no pipelining)
     //run time processing values
     int mb_link_num;       //corresponding number of this link/thread
     modbus_t *modbus;
     pthread_t thrd;
+    int *tx_list;          //transactions of this link, the link scheduler queue
+    int  tot_tx;
+    int  sched_pass;       //scheduler pass counter (mb_tx_t sched_mark)
+    uint16_t tcp_tid;      //last Modbus/TCP transaction id sent by the pipeline
 } mb_link_t;
 
+//Modbus read request structure (mb_read_t)
+//One read request on the wire, made of one or more read transactions of
+//the same link, slave and function whose elements are adjacent or overlap
+typedef struct {
+    mb_tx_fnct fnct;       //MB function code id
+    int slave_id;          //MB device id
+    int first_addr;        //MB first element of the request
+    int nelem;             //MB n elements of the request
+    int tx[MB2HAL_MAX_MERGED_TX]; //merged transactions, tx[0] was the due one
+    int tot_tx;
+    uint16_t tid;          //Modbus/TCP transaction id when pipelined
+    retCode ret;           //result of the request
+    union {
+        uint8_t  bits[MB2HAL_MAX_READ_BITS];
+        uint16_t regs[MB2HAL_MAX_READ_REGISTERS];
+    } data;
+} mb_read_t;
+
 //Structure of global data (gbl_t)
 //Reduce functions parameters using this common global structure.
 typedef struct {
@@ -136,6 +172,7 @@ typedef struct {
     //INI config, common section
     int    init_dbg;
     double slowdown;
+    int    merge_reads;
     //HAL related
     int   hal_mod_id;
     char *hal_mod_name;
@@ -154,10 +191,14 @@ extern gbl_t gbl;
 
 //mb2hal.c
 void *link_loop_and_logic(void *thrd_link_num);
-retCode is_this_tx_ready(const int this_mb_link_num, const int this_mb_tx_num, int *ret_available);
+int next_tx_of_link(mb_link_t *this_mb_link);
+int is_mergeable_read(const mb_tx_t *this_mb_tx);
+int collect_reads(mb_link_t *this_mb_link, mb_read_t *reads, const double now);
+void set_tx_result(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link, const retCode ret, const double start_time);
 retCode get_tx_connection(const int mb_tx_num, int *ret_connected);
 void set_init_gbl_params();
 double get_time();
+void sleep_until(double wake_time);
 void quit_signal(int signal);
 void quit_cleanup(void);
 
@@ -184,3 +225,6 @@ retCode fnct_04_read_input_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_lin
 retCode fnct_03_read_holding_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
 retCode fnct_06_write_single_register(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
 retCode fnct_16_write_multiple_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link);
+retCode read_merged(mb_read_t *this_mb_read, mb_link_t *this_mb_link);
+retCode read_tcp_pipelined(mb_read_t *reads, const int tot_reads, mb_link_t *this_mb_link);
+void read_to_hal(const mb_read_t *this_mb_read);
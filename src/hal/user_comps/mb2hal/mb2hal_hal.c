@@ -43,6 +43,22 @@ retCode create_each_mb_tx_hal_pins(mb_tx_t *mb_tx)
     **(mb_tx->num_errors) = 0;
     DBG(gbl.init_dbg, "mb_tx_num [%d] pin_name [%s]", mb_tx->mb_tx_num, hal_pin_name);
 
+    //update_rate hal pin
+    mb_tx->update_rate = hal_malloc(sizeof(hal_float_t *));
+    if (mb_tx->update_rate == NULL) {
+        ERR(gbl.init_dbg, "[%d] [%s] NULL hal_malloc update_rate",
+            mb_tx->mb_tx_fnct, mb_tx->mb_tx_fnct_name);
+        return retERR;
+    }
+    memset(mb_tx->update_rate, 0, sizeof(hal_float_t *));
+    snprintf(hal_pin_name, HAL_NAME_LEN, "%s.%s.update_rate", gbl.hal_mod_name, mb_tx->hal_tx_name);
+    if (0 != hal_pin_float_newf(HAL_OUT, mb_tx->update_rate, gbl.hal_mod_id, "%s", hal_pin_name)) {
+        ERR(gbl.init_dbg, "[%d] [%s] [%s] hal_pin_float_newf failed", mb_tx->mb_tx_fnct, mb_tx->mb_tx_fnct_name, hal_pin_name);
+        return retERR;
+    }
+    **(mb_tx->update_rate) = 0;
+    DBG(gbl.init_dbg, "mb_tx_num [%d] pin_name [%s]", mb_tx->mb_tx_num, hal_pin_name);
+
     switch (mb_tx->mb_tx_fnct) {
 
     case mbtx_02_READ_DISCRETE_INPUTS:
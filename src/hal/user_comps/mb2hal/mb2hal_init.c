@@ -101,6 +101,10 @@ retCode parse_common_section()
     iniFindDouble(gbl.ini_file_ptr, tag, section, &gbl.slowdown);
     DBG(gbl.init_dbg, "[%s] [%s] [%0.3f]", section, tag, gbl.slowdown);
 
+    tag     = "MERGE_READS"; //optional
+    iniFindInt(gbl.ini_file_ptr, tag, section, &gbl.merge_reads);
+    DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, gbl.merge_reads);
+
     tag     = "TOTAL_TRANSACTIONS"; //required
     if (iniFindInt(gbl.ini_file_ptr, tag, section, &gbl.tot_mb_tx) != 0) {
         ERR(gbl.init_dbg, "required [%s] [%s] not found", section, tag);
@@ -447,6 +451,21 @@ retCode parse_tcp_subsection(const char *section, const int mb_tx_num)
     }
     DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, this_mb_tx->cfg_tcp_port);
 
+    tag = "TCP_PIPELINE"; //optional
+    this_mb_tx->cfg_tcp_pipeline = MB2HAL_DEFAULT_TCP_PIPELINE; //default
+    if (iniFindInt(gbl.ini_file_ptr, tag, section, &this_mb_tx->cfg_tcp_pipeline) != 0) { //not found
+        if (mb_tx_num > 0) { //previous value?
+            if (strcasecmp(this_mb_tx->cfg_link_type_str, gbl.mb_tx[mb_tx_num-1].cfg_link_type_str) == 0) {
+                this_mb_tx->cfg_tcp_pipeline = gbl.mb_tx[mb_tx_num-1].cfg_tcp_pipeline;
+            }
+        }
+    }
+    if (this_mb_tx->cfg_tcp_pipeline < 1 || this_mb_tx->cfg_tcp_pipeline > MB2HAL_MAX_TCP_PIPELINE) {
+        ERR(gbl.init_dbg, "[%s] [%s] [%d] out of range", section, tag, this_mb_tx->cfg_tcp_pipeline);
+        return retERR;
+    }
+    DBG(gbl.init_dbg, "[%s] [%s] [%d]", section, tag, this_mb_tx->cfg_tcp_pipeline);
+
     return retOK;
 }
 
@@ -715,6 +734,7 @@ retCode init_mb_links()
             else { //tcp
                 strncpy(this_mb_link->lp_tcp_ip, this_mb_tx->cfg_tcp_ip, sizeof(this_mb_tx->cfg_tcp_ip)-1);
                 this_mb_link->lp_tcp_port=this_mb_tx->cfg_tcp_port;
+                this_mb_link->lp_tcp_pipeline=this_mb_tx->cfg_tcp_pipeline;
 
                 this_mb_link->modbus = modbus_new_tcp(this_mb_link->lp_tcp_ip, this_mb_link->lp_tcp_port);
                 if (this_mb_link->modbus == NULL) {
@@ -742,9 +762,9 @@ retCode init_mb_links()
                 this_mb_link->lp_serial_stop_bit, modbus_get_socket(this_mb_link->modbus));
         }
         else { //tcp
-            DBG(gbl.init_dbg, "LINK %d (TCP) link_type[%d] IP[%s] port[%d] fd[%d]",
+            DBG(gbl.init_dbg, "LINK %d (TCP) link_type[%d] IP[%s] port[%d] pipeline[%d] fd[%d]",
                 lk_counter, this_mb_link->lp_link_type, this_mb_link->lp_tcp_ip,
-                this_mb_link->lp_tcp_port, modbus_get_socket(this_mb_link->modbus));
+                this_mb_link->lp_tcp_port, this_mb_link->lp_tcp_pipeline, modbus_get_socket(this_mb_link->modbus));
         }
     }
 
@@ -759,12 +779,24 @@ retCode init_mb_links()
 
 /*
  * init more parameters of global modbus transactions (gbl.mb_tx)
+ * and the list of transactions each link thread schedules
  */
 retCode init_mb_tx()
 {
     char *fnct_name="init_mb_tx";
-    int tx_counter;
+    int tx_counter, lk_counter;
     mb_tx_t   *this_mb_tx;
+    mb_link_t *this_mb_link;
+
+    for (lk_counter = 0; lk_counter < gbl.tot_mb_links; lk_counter++) {
+        this_mb_link = &gbl.mb_links[lk_counter];
+        this_mb_link->tx_list = malloc(sizeof(int) * gbl.tot_mb_tx);
+        if (this_mb_link->tx_list == NULL) {
+            ERR(gbl.init_dbg, "malloc tx_list of link %d failed [%s]", lk_counter, strerror(errno));
+            return retERR;
+        }
+        this_mb_link->tot_tx = 0;
+    }
 
     for (tx_counter = 0; tx_counter < gbl.tot_mb_tx; tx_counter++) {
         this_mb_tx = &gbl.mb_tx[tx_counter];
@@ -776,6 +808,10 @@ retCode init_mb_tx()
             this_mb_tx->time_increment = 1.0 / this_mb_tx->cfg_update_rate; //wait time between tx
         }
         this_mb_tx->next_time = 0; //next time for this tx
+        this_mb_tx->sched_mark = -1;
+
+        this_mb_link = &gbl.mb_links[this_mb_tx->mb_link_num];
+        this_mb_link->tx_list[this_mb_link->tot_tx++] = tx_counter;
 
         DBG(gbl.init_dbg, "MB_TX %d lk_n[%d] tx_n[%d] cfg_dbg[%d] lk_dbg[%d] t_inc[%0.3f] nxt_t[%0.3f]",
             tx_counter, this_mb_tx->mb_link_num, this_mb_tx->mb_tx_num, this_mb_tx->cfg_debug,
@@ -1,4 +1,6 @@
 #include <sys/time.h>
+#include <sys/socket.h>
+#include <poll.h>
 #include "mb2hal.h"
 
 retCode fnct_02_read_discrete_inputs(mb_tx_t *this_mb_tx, mb_link_t *this_mb_link)
@@ -219,3 +221,310 @@ retCode fnct_16_write_multiple_registers(mb_tx_t *this_mb_tx, mb_link_t *this_mb
 
     return retOK;
 }
+
+/*
+ * Copy the elements of a (merged) read to the HAL pins of each of its
+ * transactions
+ */
+
+void read_to_hal(const mb_read_t *this_mb_read)
+{
+    int tx_counter, counter, offset;
+    mb_tx_t *this_mb_tx;
+
+    for (tx_counter = 0; tx_counter < this_mb_read->tot_tx; tx_counter++) {
+        this_mb_tx = &gbl.mb_tx[this_mb_read->tx[tx_counter]];
+        offset = this_mb_tx->mb_tx_1st_addr - this_mb_read->first_addr;
+
+        for (counter = 0; counter < this_mb_tx->mb_tx_nelem; counter++) {
+            if (this_mb_read->fnct == mbtx_02_READ_DISCRETE_INPUTS) {
+                *(this_mb_tx->bit[counter]) = this_mb_read->data.bits[offset + counter];
+            }
+            else {
+                float val = this_mb_read->data.regs[offset + counter];
+                *(this_mb_tx->float_value[counter]) = val;
+                *(this_mb_tx->int_value[counter]) = (hal_s32_t) val;
+            }
+        }
+    }
+}
+
+/*
+ * One request for one or more merged read transactions
+ */
+
+retCode read_merged(mb_read_t *this_mb_read, mb_link_t *this_mb_link)
+{
+    char *fnct_name = "read_merged";
+    int ret;
+    mb_tx_t *this_mb_tx;
+
+    if (this_mb_read == NULL || this_mb_link == NULL) {
+        return retERR;
+    }
+    this_mb_tx = &gbl.mb_tx[this_mb_read->tx[0]];
+
+    DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] 1st_addr[%d] nelem[%d] merged_tx[%d]",
+        this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_read->slave_id,
+        modbus_get_socket(this_mb_link->modbus), this_mb_read->first_addr, this_mb_read->nelem,
+        this_mb_read->tot_tx);
+
+    switch (this_mb_read->fnct) {
+    case mbtx_02_READ_DISCRETE_INPUTS:
+        ret = modbus_read_input_bits(this_mb_link->modbus, this_mb_read->first_addr, this_mb_read->nelem,
+                                     this_mb_read->data.bits);
+        break;
+    case mbtx_03_READ_HOLDING_REGISTERS:
+        ret = modbus_read_registers(this_mb_link->modbus, this_mb_read->first_addr, this_mb_read->nelem,
+                                    this_mb_read->data.regs);
+        break;
+    case mbtx_04_READ_INPUT_REGISTERS:
+        ret = modbus_read_input_registers(this_mb_link->modbus, this_mb_read->first_addr, this_mb_read->nelem,
+                                          this_mb_read->data.regs);
+        break;
+    default:
+        ERR(this_mb_tx->cfg_debug, "mb_tx[%d] [%d] is not a read", this_mb_tx->mb_tx_num, this_mb_read->fnct);
+        return retERR;
+    }
+    if (ret < 0) {
+        if (modbus_get_socket(this_mb_link->modbus) < 0) {
+            modbus_close(this_mb_link->modbus);
+        }
+        ERR(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] = ret[%d] fd[%d]",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_read->slave_id, ret,
+            modbus_get_socket(this_mb_link->modbus));
+        return retERR;
+    }
+
+    read_to_hal(this_mb_read);
+
+    return retOK;
+}
+
+/*
+ * Modbus/TCP socket helpers for the pipeline, timeouts in ms
+ */
+
+static retCode tcp_send_all(int fd, const uint8_t *buf, int len)
+{
+    int ret;
+
+    while (len > 0) {
+        ret = send(fd, buf, len, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return retERR;
+        }
+        buf += ret;
+        len -= ret;
+    }
+
+    return retOK;
+}
+
+static retCode tcp_recv_all(int fd, uint8_t *buf, int len, int timeout_ms)
+{
+    struct pollfd pfd;
+    int ret;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    while (len > 0) {
+        ret = poll(&pfd, 1, timeout_ms);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return retERR; //error or time out
+        }
+        ret = recv(fd, buf, len, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return retERR; //error or closed by the slave
+        }
+        buf += ret;
+        len -= ret;
+    }
+
+    return retOK;
+}
+
+static void tcp_debug_frame(const char *dir, const uint8_t *buf, int len)
+{
+    int counter;
+
+    fprintf(stdout, "%s %s", gbl.hal_mod_name, dir);
+    for (counter = 0; counter < len; counter++) {
+        fprintf(stdout, "[%.2X]", buf[counter]);
+    }
+    fprintf(stdout, "\n");
+}
+
+/*
+ * Check a read response PDU (function code onwards) and unpack its
+ * elements
+ */
+
+static retCode tcp_unpack_read(mb_read_t *this_mb_read, const uint8_t *pdu, int pdu_len)
+{
+    char *fnct_name = "read_tcp_pipelined";
+    int counter, nbytes;
+    int fnct_code = (this_mb_read->fnct == mbtx_02_READ_DISCRETE_INPUTS)? 0x02 :
+                    (this_mb_read->fnct == mbtx_03_READ_HOLDING_REGISTERS)? 0x03 : 0x04;
+    mb_tx_t *this_mb_tx = &gbl.mb_tx[this_mb_read->tx[0]];
+
+    if (pdu[0] == (fnct_code | 0x80)) {
+        ERR(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] = exception[%d]",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_read->slave_id, pdu_len > 1 ? pdu[1] : -1);
+        return retERR;
+    }
+
+    if (this_mb_read->fnct == mbtx_02_READ_DISCRETE_INPUTS) {
+        nbytes = (this_mb_read->nelem + 7) / 8;
+    }
+    else {
+        nbytes = this_mb_read->nelem * 2;
+    }
+    if (pdu[0] != fnct_code || pdu_len != nbytes + 2 || pdu[1] != nbytes) {
+        ERR(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] bad response fnct[%d] length[%d]",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_read->slave_id, pdu[0], pdu_len);
+        return retERR;
+    }
+
+    for (counter = 0; counter < this_mb_read->nelem; counter++) {
+        if (this_mb_read->fnct == mbtx_02_READ_DISCRETE_INPUTS) {
+            this_mb_read->data.bits[counter] = (pdu[2 + counter / 8] >> (counter % 8)) & 1;
+        }
+        else {
+            this_mb_read->data.regs[counter] = (pdu[2 + counter * 2] << 8) | pdu[3 + counter * 2];
+        }
+    }
+
+    return retOK;
+}
+
+/*
+ * Send several read requests on a Modbus/TCP link before waiting for
+ * the first response, and match the responses by transaction id.
+ * libmodbus waits for each response before sending the next request,
+ * so the frames are built and parsed here, on the libmodbus socket.
+ * A time out or a broken frame closes the link: the ids restart on the
+ * new connection and no late response can be taken for a new request.
+ */
+
+retCode read_tcp_pipelined(mb_read_t *reads, const int tot_reads, mb_link_t *this_mb_link)
+{
+    char *fnct_name = "read_tcp_pipelined";
+    uint8_t req[MB2HAL_MAX_TCP_PIPELINE * 12];
+    uint8_t rsp[7 + 253];
+    uint8_t answered[MB2HAL_MAX_TCP_PIPELINE];
+    int fd, counter, pending, rsp_len, debug = debugSILENT, protocol_debug = 0;
+    int response_timeout_ms = 0, byte_timeout_ms = 0;
+    uint16_t tid;
+    mb_tx_t *this_mb_tx;
+    mb_read_t *this_mb_read;
+
+    if (reads == NULL || this_mb_link == NULL || tot_reads < 1 || tot_reads > MB2HAL_MAX_TCP_PIPELINE) {
+        return retERR;
+    }
+    fd = modbus_get_socket(this_mb_link->modbus);
+
+    for (counter = 0; counter < tot_reads; counter++) {
+        this_mb_read = &reads[counter];
+        this_mb_tx = &gbl.mb_tx[this_mb_read->tx[0]];
+        if (this_mb_tx->cfg_debug > debug) {
+            debug = this_mb_tx->cfg_debug;
+        }
+        protocol_debug |= this_mb_tx->protocol_debug;
+        if (this_mb_tx->mb_response_timeout_ms > response_timeout_ms) {
+            response_timeout_ms = this_mb_tx->mb_response_timeout_ms;
+        }
+        if (this_mb_tx->mb_byte_timeout_ms > byte_timeout_ms) {
+            byte_timeout_ms = this_mb_tx->mb_byte_timeout_ms;
+        }
+
+        this_mb_read->tid = ++this_mb_link->tcp_tid;
+        this_mb_read->ret = retERR;
+        answered[counter] = 0;
+        req[counter * 12 + 0]  = this_mb_read->tid >> 8;
+        req[counter * 12 + 1]  = this_mb_read->tid & 0xFF;
+        req[counter * 12 + 2]  = 0; //protocol id
+        req[counter * 12 + 3]  = 0;
+        req[counter * 12 + 4]  = 0; //length
+        req[counter * 12 + 5]  = 6;
+        req[counter * 12 + 6]  = this_mb_read->slave_id;
+        req[counter * 12 + 7]  = (this_mb_read->fnct == mbtx_02_READ_DISCRETE_INPUTS)? 0x02 :
+                                 (this_mb_read->fnct == mbtx_03_READ_HOLDING_REGISTERS)? 0x03 : 0x04;
+        req[counter * 12 + 8]  = this_mb_read->first_addr >> 8;
+        req[counter * 12 + 9]  = this_mb_read->first_addr & 0xFF;
+        req[counter * 12 + 10] = this_mb_read->nelem >> 8;
+        req[counter * 12 + 11] = this_mb_read->nelem & 0xFF;
+
+        DBG(this_mb_tx->cfg_debug, "mb_tx[%d] mb_links[%d] slave[%d] fd[%d] tid[%d] 1st_addr[%d] nelem[%d] merged_tx[%d]",
+            this_mb_tx->mb_tx_num, this_mb_tx->mb_link_num, this_mb_read->slave_id, fd, this_mb_read->tid,
+            this_mb_read->first_addr, this_mb_read->nelem, this_mb_read->tot_tx);
+        if (protocol_debug) {
+            tcp_debug_frame("pipeline send ", &req[counter * 12], 12);
+        }
+    }
+
+    if (tcp_send_all(fd, req, tot_reads * 12) != retOK) {
+        ERR(debug, "mb_links[%d] fd[%d] send failed [%s]", this_mb_link->mb_link_num, fd, strerror(errno));
+        goto LINK_FAILURE;
+    }
+
+    for (pending = tot_reads; pending > 0; ) {
+        //MBAP header, then the unit id and PDU
+        if (tcp_recv_all(fd, rsp, 7, response_timeout_ms) != retOK) {
+            ERR(debug, "mb_links[%d] fd[%d] no response, %d pending", this_mb_link->mb_link_num, fd, pending);
+            goto LINK_FAILURE;
+        }
+        rsp_len = (rsp[4] << 8) | rsp[5];
+        if (rsp[2] != 0 || rsp[3] != 0 || rsp_len < 3 || rsp_len > 254) {
+            ERR(debug, "mb_links[%d] fd[%d] bad MBAP header", this_mb_link->mb_link_num, fd);
+            goto LINK_FAILURE;
+        }
+        if (tcp_recv_all(fd, rsp + 7, rsp_len - 1, byte_timeout_ms) != retOK) {
+            ERR(debug, "mb_links[%d] fd[%d] short response", this_mb_link->mb_link_num, fd);
+            goto LINK_FAILURE;
+        }
+        if (protocol_debug) {
+            tcp_debug_frame("pipeline recv ", rsp, 6 + rsp_len);
+        }
+
+        tid = (rsp[0] << 8) | rsp[1];
+        for (counter = 0; counter < tot_reads; counter++) {
+            if (answered[counter] == 0 && reads[counter].tid == tid) {
+                break;
+            }
+        }
+        if (counter == tot_reads) {
+            DBG(debug, "mb_links[%d] fd[%d] unexpected tid[%d] ignored", this_mb_link->mb_link_num, fd, tid);
+            continue;
+        }
+        answered[counter] = 1;
+        pending--;
+
+        this_mb_read = &reads[counter];
+        this_mb_read->ret = tcp_unpack_read(this_mb_read, rsp + 7, rsp_len - 1);
+        if (this_mb_read->ret == retOK) {
+            read_to_hal(this_mb_read);
+        }
+    }
+
+    for (counter = 0; counter < tot_reads; counter++) {
+        if (reads[counter].ret != retOK) {
+            return retERR;
+        }
+    }
+    return retOK;
+
+LINK_FAILURE:
+    modbus_close(this_mb_link->modbus);
+    modbus_set_socket(this_mb_link->modbus, -1);
+    return retERR;
+}
@@ -86,6 +86,8 @@ int hal_flag = 0;	/* used to indicate that halcmd might have the
 int halcmd_done = 0;		/* used to break out of processing loop */
 int scriptmode = 0;	/* used to make output "script friendly" (suppress headers) */
 int echo_mode = 0;
+int halcmd_batch_loadrt = 0;	/* queue loadrt commands (-b) */
+int halcmd_timing = 0;		/* accumulate time per command (-t) */
 char comp_name[HAL_NAME_LEN+1];	/* name for this instance of halcmd */
 
 static void quit(int);
@@ -138,6 +140,7 @@ struct halcmd_command halcmd_commands[] = {
     {"alias",   FUNCT(do_alias_cmd),   A_THREE },
     {"delf",    FUNCT(do_delf_cmd),    A_TWO | A_OPTIONAL },
     {"delsig",  FUNCT(do_delsig_cmd),  A_ONE },
+    {"delsnap", FUNCT(do_delsnap_cmd), A_ONE },
     {"echo",    FUNCT(do_echo_cmd),    A_ZERO },
     {"getp",    FUNCT(do_getp_cmd),    A_ONE },
     {"gets",    FUNCT(do_gets_cmd),    A_ONE },
@@ -153,6 +156,7 @@ struct halcmd_command halcmd_commands[] = {
     {"lock",    FUNCT(do_lock_cmd),    A_ONE | A_OPTIONAL },
     {"net",     FUNCT(do_net_cmd),     A_ONE | A_PLUS | A_REMOVE_ARROWS },
     {"newsig",  FUNCT(do_newsig_cmd),  A_TWO },
+    {"newsnap", FUNCT(do_newsnap_cmd), A_TWO | A_PLUS },
     {"save",    FUNCT(do_save_cmd),    A_TWO | A_OPTIONAL | A_TILDE },
     {"setexact_for_test_suite_only", FUNCT(do_setexact_cmd), A_ZERO },
     {"setp",    FUNCT(do_setp_cmd),    A_TWO },
@@ -441,9 +445,21 @@ static int parse_cmd1(char **argv) {
     }
 }
 
-int halcmd_parse_cmd(char *tokens[])
-{
-    int retval;
+/* time spent in each command, indexed like the sorted halcmd_commands[] */
+static struct {
+    int count;
+    double seconds;
+} command_times[sizeof(halcmd_commands) / sizeof(halcmd_commands[0])];
+static double other_seconds;
+static int other_count;
+
+static double elapsed_since(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static void sort_commands(void) {
     static int first_time = 1;
 
     if(first_time) {
@@ -452,10 +468,85 @@ int halcmd_parse_cmd(char *tokens[])
                 sizeof(struct halcmd_command), sort_command);
         first_time = 0;
     }
+}
+
+static void account_time(const char *name, int calls, double seconds) {
+    struct halcmd_command *command = bsearch(name,
+                halcmd_commands, halcmd_ncommands,
+		sizeof(struct halcmd_command), compare_command);
+    if(command) {
+	command_times[command - halcmd_commands].count += calls;
+	command_times[command - halcmd_commands].seconds += seconds;
+    } else {
+	other_count += calls;
+	other_seconds += seconds;
+    }
+}
+
+int halcmd_flush(void)
+{
+    struct timespec start;
+    int retval;
+
+    if(!halcmd_batch_loadrt) return 0;
+    sort_commands();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    hal_flag = 1;
+    retval = halcmd_flush_loadrt();
+    hal_flag = 0;
+    /* the queued loadrt commands were counted when they were parsed */
+    if(halcmd_timing) account_time("loadrt", 0, elapsed_since(&start));
+    return retval;
+}
+
+void halcmd_report_timing(void)
+{
+    double total = other_seconds;
+    int i;
+
+    if(!halcmd_timing) return;
+    halcmd_output("Time spent per command%s:\n",
+	halcmd_batch_loadrt ? " (loadrt batched)" : "");
+    for(i=0; i<halcmd_ncommands; i++) {
+	if(!command_times[i].count) continue;
+	halcmd_output("    %-10s %6d %10.3f s\n", halcmd_commands[i].name,
+	    command_times[i].count, command_times[i].seconds);
+	/* commands run by 'source' are already counted on their own */
+	if(strcmp(halcmd_commands[i].name, "source"))
+	    total += command_times[i].seconds;
+    }
+    if(other_count) {
+	halcmd_output("    %-10s %6d %10.3f s\n", "(other)",
+	    other_count, other_seconds);
+    }
+    halcmd_output("    %-10s %6s %10.3f s\n", "total", "", total);
+}
 
+int halcmd_parse_cmd(char *tokens[])
+{
+    int retval;
+    struct timespec start;
+    char name[HAL_NAME_LEN+1];
+
+    sort_commands();
+
+    if(tokens[0] && tokens[0][0] && strcmp(tokens[0], "loadrt")) {
+	/* any other command may depend on modules queued by loadrt */
+	retval = halcmd_flush();
+	if(retval != 0) return retval;
+    }
+
+    if(halcmd_timing) {
+	/* parse_cmd1() may free the tokens of tilde-expanded commands */
+	snprintf(name, sizeof(name), "%s", tokens[0] ? tokens[0] : "");
+	clock_gettime(CLOCK_MONOTONIC, &start);
+    }
     hal_flag = 1;
     retval = parse_cmd1(tokens);
     hal_flag = 0;
+    if(halcmd_timing && name[0]) {
+	account_time(name, 1, elapsed_since(&start));
+    }
     return retval;
 }
 
@@ -48,6 +48,9 @@ extern int halcmd_parse_line(char * line);
 extern void halcmd_shutdown(void);
 extern int prompt_mode, echo_mode, errorcount, halcmd_done;
 extern int halcmd_preprocess_line ( char *line, char **tokens);
+extern int halcmd_batch_loadrt, halcmd_timing;
+extern int halcmd_flush(void);
+extern void halcmd_report_timing(void);
 
 void halcmd_info(const char *format,...) __attribute__((format(printf,1,2)));
 void halcmd_output(const char *format,...) __attribute__((format(printf,1,2)));
@@ -67,6 +67,7 @@ static void print_script_sig_info(int type, char **patterns);
 static void print_param_info(int type, char **patterns);
 static void print_funct_info(char **patterns);
 static void print_thread_info(char **patterns);
+static void print_snapshot_info(char **patterns);
 static void print_comp_names(char **patterns);
 static void print_pin_names(char **patterns);
 static void print_sig_names(char **patterns);
@@ -92,6 +93,7 @@ static void save_nets(FILE *dst, int arrows);
 static void save_params(FILE *dst);
 static void save_unconnected_input_pin_values(FILE *dst);
 static void save_threads(FILE *dst);
+static void save_snapshots(FILE *dst);
 static void print_help_commands(void);
 
 static int tmatch(int req_type, int type) {
@@ -633,6 +635,35 @@ int do_newsig_cmd(char *name, char *type)
     return retval;
 }
 
+int do_newsnap_cmd(char *name, char *thread, char *signals[])
+{
+    int retval, count;
+
+    for (count = 0; signals[count] && *signals[count]; count++) {
+    }
+    retval = hal_snapshot_new(name, thread, count, (const char **) signals);
+    if (retval == 0) {
+	halcmd_info("Snapshot '%s' of %d signals added to thread '%s'\n",
+	    name, count, thread);
+    } else {
+	halcmd_error("newsnap failed\n");
+    }
+    return retval;
+}
+
+int do_delsnap_cmd(char *name)
+{
+    int retval;
+
+    retval = hal_snapshot_delete(name);
+    if (retval == 0) {
+	halcmd_info("Snapshot '%s' deleted\n", name);
+    } else {
+	halcmd_error("delsnap failed\n");
+    }
+    return retval;
+}
+
 static int set_common(hal_type_t type, void *d_ptr, char *value) {
     // This function assumes that the mutex is held
     int retval = 0;
@@ -1006,6 +1037,10 @@ int do_show_cmd(char *type, char **patterns)
 	print_funct_info(patterns);
     } else if (strcmp(type, "thread") == 0) {
 	print_thread_info(patterns);
+    } else if (strcmp(type, "snap") == 0) {
+	print_snapshot_info(patterns);
+    } else if (strcmp(type, "snapshot") == 0) {
+	print_snapshot_info(patterns);
     } else if (strcmp(type, "alias") == 0) {
 	print_pin_aliases(patterns);
 	print_param_aliases(patterns);
@@ -1074,14 +1109,243 @@ int do_status_cmd(char *type)
     return 0;
 }
 
-int do_loadrt_cmd(char *mod_name, char *args[])
+/* wait until the component 'comp_name' started by process 'pid' is
+   ready, polling every 10mS.  Returns -1 if the process exits first. */
+static int wait_for_comp_ready(pid_t pid, const char *prog_name,
+    const char *comp_name)
+{
+    int ready = 0, count=0, exited=0, status, retval = 0;
+    hal_comp_t *comp = NULL;
+
+    while(!ready && !exited) {
+	/* sleep for 10mS */
+	struct timespec ts = {0, 10 * 1000 * 1000};
+	nanosleep(&ts, NULL);
+	/* check for program ending */
+	retval = waitpid( pid, &status, WNOHANG );
+	if ( retval != 0 ) {
+	    exited = 1;
+	    if (WIFEXITED(status) && WEXITSTATUS(status)) {
+		halcmd_error("waitpid failed %s %s\n",prog_name,comp_name);
+		ready = 0;
+		break;
+	    }
+	}
+	/* check for program becoming ready */
+	rtapi_mutex_get(&(hal_data->mutex));
+	comp = halpr_find_comp_by_name(comp_name);
+	if(comp && comp->ready) {
+	    ready = 1;
+	}
+	rtapi_mutex_give(&(hal_data->mutex));
+	/* pacify the user */
+	count++;
+	if(count == 200) {
+	    fprintf(stderr, "Waiting for component '%s' to become ready.",
+		    comp_name);
+	    fflush(stderr);
+	} else if(count > 200 && count % 10 == 0) {
+	    fprintf(stderr, ".");
+	    fflush(stderr);
+	}
+    }
+    if (count >= 100) {
+	/* terminate pacifier */
+	fprintf(stderr, "\n");
+    }
+    /* did it work? */
+    if (ready) {
+	halcmd_info("Component '%s' ready\n", comp_name);
+	return 0;
+    }
+    if ( retval < 0 ) {
+	halcmd_error("\nwaitpid(%d) failed\n", pid);
+    } else {
+	halcmd_error("%s exited without becoming ready\n", prog_name);
+    }
+    return -1;
+}
+
+/* record the args that were passed to a newly loaded module in its
+   comp struct, so that 'show comp' and 'save' can report them */
+static int set_insmod_args(char *mod_name, char *args[])
 {
     char arg_string[MAX_CMD_LEN+1];
-    int m=0, n=0, retval;
+    int n;
     hal_comp_t *comp;
-    char *argv[MAX_TOK+3];
     char *cp1;
+
+    /* make the args that were passed to the module into a single string */
+    n = 0;
+    arg_string[0] = '\0';
+    while ( args[n] && args[n][0] != '\0' ) {
+	strncat(arg_string, args[n++], MAX_CMD_LEN);
+	strncat(arg_string, " ", MAX_CMD_LEN);
+    }
+    /* allocate HAL shmem for the string */
+    cp1 = hal_malloc(strlen(arg_string)+1);
+    if ( cp1 == NULL ) {
+	halcmd_error("failed to allocate memory for module args\n");
+	return -1;
+    }
+    /* copy string to shmem */
+    strcpy (cp1, arg_string);
+    /* get mutex before accessing shared data */
+    rtapi_mutex_get(&(hal_data->mutex));
+    /* search component list for the newly loaded component */
+    comp = halpr_find_comp_by_name(mod_name);
+    if (comp == 0) {
+	rtapi_mutex_give(&(hal_data->mutex));
+	halcmd_error("module '%s' not loaded\n", mod_name);
+	return -EINVAL;
+    }
+    /* link args to comp struct */
+    comp->insmod_args = SHMOFF(cp1);
+    rtapi_mutex_give(&(hal_data->mutex));
+    return 0;
+}
+
+#if defined(RTAPI_USPACE)
+/* In batch mode (halcmd -b) consecutive loadrt commands are queued here
+   and handed to rtapi_app as a single load-batch request by
+   halcmd_flush_loadrt(), instead of starting one rtapi_app client and
+   waiting for each module in turn. */
+struct loadrt_batch_entry {
+    char *mod_name;
+    char *args[MAX_TOK+1];
+    int linenumber;
+};
+
+static struct loadrt_batch_entry *loadrt_batch;
+static int loadrt_batch_count, loadrt_batch_size;
+
+static int queue_loadrt(char *mod_name, char *args[])
+{
+    struct loadrt_batch_entry *entry;
+    int n;
+
+    if (hal_get_lock()&HAL_LOCK_LOAD) {
+	halcmd_error("HAL is locked, loading of modules is not permitted\n");
+	return -EPERM;
+    }
+    if (loadrt_batch_count == loadrt_batch_size) {
+	int new_size = loadrt_batch_size ? 2 * loadrt_batch_size : 16;
+	entry = realloc(loadrt_batch, new_size * sizeof(*entry));
+	if (entry == NULL) {
+	    halcmd_error("failed to allocate memory for loadrt batch\n");
+	    return -ENOMEM;
+	}
+	loadrt_batch = entry;
+	loadrt_batch_size = new_size;
+    }
+    entry = &loadrt_batch[loadrt_batch_count++];
+    entry->mod_name = strdup(mod_name);
+    for (n = 0; n < MAX_TOK && args[n] && args[n][0] != '\0'; n++) {
+	entry->args[n] = strdup(args[n]);
+    }
+    entry->args[n] = NULL;
+    entry->linenumber = halcmd_get_linenumber();
+    return 0;
+}
+
+static void free_loadrt_batch(void)
+{
+    int i, n;
+
+    for (i = 0; i < loadrt_batch_count; i++) {
+	free(loadrt_batch[i].mod_name);
+	for (n = 0; loadrt_batch[i].args[n]; n++) {
+	    free(loadrt_batch[i].args[n]);
+	}
+    }
+    loadrt_batch_count = 0;
+}
+#endif
+
+int halcmd_flush_loadrt(void)
+{
+#if defined(RTAPI_USPACE)
+    char **argv;
+    int i, n, m = 0, retval, saved_linenumber;
+    pid_t pid;
+
+    if (loadrt_batch_count == 0) {
+	return 0;
+    }
+    /* rtapi_app load-batch mod1 args... -- mod2 args... NULL */
+    m = 3;
+    for (i = 0; i < loadrt_batch_count; i++) {
+	m += 2;
+	for (n = 0; loadrt_batch[i].args[n]; n++) m++;
+    }
+    argv = malloc(m * sizeof(char *));
+    if (argv == NULL) {
+	halcmd_error("failed to allocate memory for loadrt batch\n");
+	free_loadrt_batch();
+	return -ENOMEM;
+    }
+    m = 0;
+    argv[m++] = EMC2_BIN_DIR "/rtapi_app";
+    argv[m++] = "load-batch";
+    for (i = 0; i < loadrt_batch_count; i++) {
+	if (i) argv[m++] = "--";
+	argv[m++] = loadrt_batch[i].mod_name;
+	for (n = 0; loadrt_batch[i].args[n]; n++) {
+	    argv[m++] = loadrt_batch[i].args[n];
+	}
+    }
+    argv[m] = NULL;
+
+    pid = hal_systemv_nowait(argv);
+    free(argv);
+    if (comp_id < 0) {
+	fprintf(stderr, "halcmd: hal_init() failed after fork: %d\n",
+	    comp_id );
+	exit(-1);
+    }
+    hal_ready(comp_id);
+    /* modules are loaded in order, so once the last one is ready all of
+       them are; if this rtapi_app became the master it never exits */
+    retval = wait_for_comp_ready(pid, "rtapi_app",
+	loadrt_batch[loadrt_batch_count-1].mod_name);
+
+    /* report errors against the line of the module that failed */
+    saved_linenumber = halcmd_get_linenumber();
+    for (i = 0; i < loadrt_batch_count; i++) {
+	struct loadrt_batch_entry *entry = &loadrt_batch[i];
+	halcmd_set_linenumber(entry->linenumber);
+	if (retval != 0) {
+	    hal_comp_t *comp;
+	    rtapi_mutex_get(&(hal_data->mutex));
+	    comp = halpr_find_comp_by_name(entry->mod_name);
+	    rtapi_mutex_give(&(hal_data->mutex));
+	    if (comp == 0) {
+		halcmd_error("insmod for %s failed\n", entry->mod_name);
+		break;
+	    }
+	}
+	if (set_insmod_args(entry->mod_name, entry->args) != 0) {
+	    retval = -1;
+	    break;
+	}
+	halcmd_info("Realtime module '%s' loaded\n", entry->mod_name);
+    }
+    halcmd_set_linenumber(saved_linenumber);
+    free_loadrt_batch();
+    return retval == 0 ? 0 : -1;
+#else
+    return 0;
+#endif
+}
+
+int do_loadrt_cmd(char *mod_name, char *args[])
+{
+    int m=0, n=0, retval;
+    char *argv[MAX_TOK+3];
 #if defined(RTAPI_USPACE)
+    if (halcmd_batch_loadrt) {
+	return queue_loadrt(mod_name, args);
+    }
     argv[m++] = "-Wn";
     argv[m++] = mod_name;
     argv[m++] = EMC2_BIN_DIR "/rtapi_app";
@@ -1151,33 +1415,10 @@ int do_loadrt_cmd(char *mod_name, char *args[])
         , mod_name, retval );
 	return -1;
     }
-    /* make the args that were passed to the module into a single string */
-    n = 0;
-    arg_string[0] = '\0';
-    while ( args[n] && args[n][0] != '\0' ) {
-	strncat(arg_string, args[n++], MAX_CMD_LEN);
-	strncat(arg_string, " ", MAX_CMD_LEN);
-    }
-    /* allocate HAL shmem for the string */
-    cp1 = hal_malloc(strlen(arg_string)+1);
-    if ( cp1 == NULL ) {
-	halcmd_error("failed to allocate memory for module args\n");
-	return -1;
-    }
-    /* copy string to shmem */
-    strcpy (cp1, arg_string);
-    /* get mutex before accessing shared data */
-    rtapi_mutex_get(&(hal_data->mutex));
-    /* search component list for the newly loaded component */
-    comp = halpr_find_comp_by_name(mod_name);
-    if (comp == 0) {
-	rtapi_mutex_give(&(hal_data->mutex));
-	halcmd_error("module '%s' not loaded\n", mod_name);
-	return -EINVAL;
+    retval = set_insmod_args(mod_name, args);
+    if ( retval != 0 ) {
+	return retval;
     }
-    /* link args to comp struct */
-    comp->insmod_args = SHMOFF(cp1);
-    rtapi_mutex_give(&(hal_data->mutex));
     /* print success message */
     halcmd_info("Realtime module '%s' loaded\n", mod_name);
     return 0;
@@ -1494,54 +1735,7 @@ int do_loadusr_cmd(char *args[])
     }
     hal_ready(comp_id);
     if ( wait_comp_flag ) {
-        int ready = 0, count=0, exited=0;
-        hal_comp_t *comp = NULL;
-	retval = 0;
-        while(!ready && !exited) {
-	    /* sleep for 10mS */
-            struct timespec ts = {0, 10 * 1000 * 1000};
-            nanosleep(&ts, NULL);
-	    /* check for program ending */
-	    retval = waitpid( pid, &status, WNOHANG );
-	    if ( retval != 0 ) {
-		    exited = 1;
-	        if (WIFEXITED(status) && WEXITSTATUS(status)) {
-	            halcmd_error("waitpid failed %s %s\n",prog_name,new_comp_name);
-	            ready = 0;
-	            break;
-	        }
-	    }
-	    /* check for program becoming ready */
-            rtapi_mutex_get(&(hal_data->mutex));
-            comp = halpr_find_comp_by_name(new_comp_name);
-            if(comp && comp->ready) {
-                ready = 1;
-            }
-            rtapi_mutex_give(&(hal_data->mutex));
-	    /* pacify the user */
-            count++;
-            if(count == 200) {
-                fprintf(stderr, "Waiting for component '%s' to become ready.",
-                        new_comp_name);
-                fflush(stderr);
-            } else if(count > 200 && count % 10 == 0) {
-                fprintf(stderr, ".");
-                fflush(stderr);
-            }
-        }
-        if (count >= 100) {
-	    /* terminate pacifier */
-	    fprintf(stderr, "\n");
-	}
-	/* did it work? */
-	if (ready) {
-	    halcmd_info("Component '%s' ready\n", new_comp_name);
-	} else {
-	    if ( retval < 0 ) {
-		halcmd_error("\nwaitpid(%d) failed\n", pid);
-	    } else {
-		halcmd_error("%s exited without becoming ready\n", prog_name);
-	    }
+	if (wait_for_comp_ready(pid, prog_name, new_comp_name) != 0) {
 	    return -1;
 	}
     }
@@ -1983,6 +2177,64 @@ static void print_thread_info(char **patterns)
     halcmd_output("\n");
 }
 
+static void print_snapshot_info(char **patterns)
+{
+    int next, n, retval;
+    struct hal_snapshot_shm *snap;
+    hal_snapshot_t snapshot;
+    union hal_stream_data *values;
+    hal_thread_t *tptr;
+    hal_sig_t *sig;
+    long long time;
+    unsigned serial;
+
+    if (scriptmode == 0) {
+	halcmd_output("Snapshots:\n");
+	halcmd_output("Name                 Thread                 Taken   Time (nsec)\n");
+    }
+    rtapi_mutex_get(&(hal_data->mutex));
+    next = hal_data->snapshot_list_ptr;
+    while (next != 0) {
+	snap = SHMPTR(next);
+	next = snap->next_ptr;
+	if (!match(patterns, snap->name)) {
+	    continue;
+	}
+	/* all values come from the same period */
+	snapshot.snap = snap;
+	values = malloc(snap->count * sizeof(union hal_stream_data));
+	if (values == 0) {
+	    continue;
+	}
+	retval = hal_snapshot_read(&snapshot, values, &time, &serial);
+	tptr = SHMPTR(snap->thread_ptr);
+	halcmd_output(((scriptmode == 0) ? "%-20s %-20s %8u %13lld\n"
+					 : "%s %s %u %lld"),
+	    snap->name, tptr->name, serial, time);
+	for (n = 0; n < snap->count; n++) {
+	    sig = snap->entry[n].sig_ptr ? SHMPTR(snap->entry[n].sig_ptr) : 0;
+	    if (scriptmode == 0) {
+		halcmd_output("     %s  %s  %s\n",
+		    data_type((int) snap->entry[n].type),
+		    retval == 0 ? data_value((int) snap->entry[n].type,
+			&values[n]) : "    (busy)",
+		    sig ? sig->name : "(deleted)");
+	    } else {
+		halcmd_output(" %s %s",
+		    retval == 0 ? data_value2((int) snap->entry[n].type,
+			&values[n]) : "busy",
+		    sig ? sig->name : "(deleted)");
+	    }
+	}
+	if (scriptmode != 0) {
+	    halcmd_output("\n");
+	}
+	free(values);
+    }
+    rtapi_mutex_give(&(hal_data->mutex));
+    halcmd_output("\n");
+}
+
 static void print_comp_names(char **patterns)
 {
     int next;
@@ -2723,9 +2975,33 @@ static void save_threads(FILE *dst)
 	}
 	next_thread = tptr->next_ptr;
     }
+    save_snapshots(dst);
     rtapi_mutex_give(&(hal_data->mutex));
 }
 
+static void save_snapshots(FILE *dst)
+{
+    int next, n;
+    struct hal_snapshot_shm *snap;
+    hal_thread_t *tptr;
+    hal_sig_t *sig;
+
+    next = hal_data->snapshot_list_ptr;
+    while (next != 0) {
+	snap = SHMPTR(next);
+	tptr = SHMPTR(snap->thread_ptr);
+	fprintf(dst, "newsnap %s %s", snap->name, tptr->name);
+	for (n = 0; n < snap->count; n++) {
+	    if (snap->entry[n].sig_ptr != 0) {
+		sig = SHMPTR(snap->entry[n].sig_ptr);
+		fprintf(dst, " %s", sig->name);
+	    }
+	}
+	fprintf(dst, "\n");
+	next = snap->next_ptr;
+    }
+}
+
 static void save_unconnected_input_pin_values(FILE *dst)
 {
     hal_pin_t *pin;
@@ -2840,6 +3116,16 @@ int do_help_cmd(char *command)
 	printf("delsig signame\n");
 	printf("  Deletes signal 'signame'.  If 'signame is 'all',\n");
 	printf("  deletes all signals\n");
+    } else if (strcmp(command, "newsnap") == 0) {
+	printf("newsnap snapname threadname signame [signame ...]\n");
+	printf("  Creates snapshot 'snapname' of the listed signals.\n");
+	printf("  Thread 'threadname' copies their values after its\n");
+	printf("  last function of every period, so 'show snap' and\n");
+	printf("  other readers see values that all belong to the same\n");
+	printf("  period.  Port signals can not be in a snapshot.\n");
+    } else if (strcmp(command, "delsnap") == 0) {
+	printf("delsnap snapname\n");
+	printf("  Deletes snapshot 'snapname'.\n");
     } else if (strcmp(command, "setp") == 0) {
 	printf("setp paramname value\n");
 	printf("setp pinname value\n");
@@ -2891,7 +3177,7 @@ int do_help_cmd(char *command)
 	printf("show [type] [pattern]\n");
 	printf("  Prints info about HAL items of the specified type.\n");
 	printf("  'type' is 'comp', 'pin', 'sig', 'param', 'funct',\n");
-	printf("  'thread', or 'all'.  If 'type' is omitted, it assumes\n");
+	printf("  'thread', 'snap', or 'all'.  If 'type' is omitted, it assumes\n");
 	printf("  'all' with no pattern.  If 'pattern' is specified\n");
 	printf("  it prints only those items whose names match the\n");
 	printf("  pattern, which may be a 'shell glob'.\n");
@@ -2983,6 +3269,7 @@ static void print_help_commands(void)
     printf("  net                 Link a number of pins to a signal\n");
     printf("  unlinkp             Unlink pin\n");
     printf("  newsig, delsig      Create/delete a signal\n");
+    printf("  newsnap, delsnap    Create/delete a snapshot of signals\n");
     printf("  getp, gets          Get the value of a pin, parameter or signal\n");
     printf("  ptype, stype        Get the type of a pin, parameter or signal\n");
     printf("  setp, sets          Set the value of a pin, parameter or signal\n");
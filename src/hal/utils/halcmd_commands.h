@@ -60,6 +60,8 @@ extern int do_lock_cmd(char *command);
 extern int do_unlock_cmd(char *command);
 extern int do_linkpp_cmd(char *first_pin_name, char *second_pin_name);
 extern int do_newsig_cmd(char *name, char *type);
+extern int do_newsnap_cmd(char *name, char *thread, char *signals[]);
+extern int do_delsnap_cmd(char *name);
 #if 0  /* newinst deferred to version 2.2 */
 extern int do_newinst_cmd(char *comp_name, char *inst_name);
 #endif
@@ -84,6 +86,7 @@ extern int do_loadusr_cmd(char *args[]);
 extern int do_waitusr_cmd(char *comp_name);
 extern int do_save_cmd(char *type, char *filename);
 extern int do_setexact_cmd(void);
+extern int halcmd_flush_loadrt(void);
 
 pid_t hal_systemv_nowait(char *const argv[]);
 int hal_systemv(char *const argv[]);
@@ -49,7 +49,7 @@ static int argno;
 static const char *command_table[] = {
     "loadrt", "loadusr", "unload", "lock", "unlock",
     "linkps", "linksp", "linkpp", "unlinkp",
-    "net", "newsig", "delsig", "getp", "gets", "setp", "sets", "ptype", "stype",
+    "net", "newsig", "delsig", "newsnap", "delsnap", "getp", "gets", "setp", "sets", "ptype", "stype",
     "addf", "delf", "show", "list", "status", "save", "source",
     "start", "stop", "quit", "exit", "help", "alias", "unalias", 
     NULL,
@@ -66,7 +66,7 @@ static const char *alias_table[] = {
 };
 
 static const char *show_table[] = {
-    "all", "alias", "comp", "pin", "sig", "param", "funct", "thread",
+    "all", "alias", "comp", "pin", "sig", "param", "funct", "thread", "snap",
     NULL,
 };
 
@@ -702,6 +702,10 @@ char **halcmd_completer(const char *text, int start, int end, hal_completer_func
         result = func(text, funct_generator);
     } else if(startswith(buffer, "addf ") && argno == 2) {
         result = func(text, thread_generator);
+    } else if(startswith(buffer, "newsnap ") && argno == 2) {
+        result = func(text, thread_generator);
+    } else if(startswith(buffer, "newsnap ") && argno > 2) {
+        result = func(text, signal_generator);
     } else if(startswith(buffer, "delf ") && argno == 1) {
         result = func(text, attached_funct_generator);
     } else if(startswith(buffer, "delf ") && argno == 2) {
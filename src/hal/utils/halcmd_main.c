@@ -97,7 +97,7 @@ int main(int argc, char **argv)
     keep_going = 0;
     /* start parsing the command line, options first */
     while(1) {
-        c = getopt(argc, argv, "+RCfi:kqQsvVhe");
+        c = getopt(argc, argv, "+RCbfi:kqQstvVhe");
         if(c == -1) break;
         switch(c) {
             case 'R':
@@ -147,6 +147,14 @@ int main(int argc, char **argv)
 	    case 'f':
                 filemode = 1;
 		break;
+	    case 'b':
+		/* -b = send consecutive loadrt commands to rtapi_app together */
+		halcmd_batch_loadrt = 1;
+		break;
+	    case 't':
+		/* -t = report the time spent in each command */
+		halcmd_timing = 1;
+		break;
 	    case 'C':
                 cl = getenv("COMP_LINE");
                 cw = getenv("COMP_POINT");
@@ -326,6 +334,11 @@ int main(int argc, char **argv)
 	} //while get_input()
         extend_ct=0;
     }
+    /* load anything still queued by loadrt */
+    if ( !halcmd_done && halcmd_flush() != 0 ) {
+	errorcount++;
+    }
+    halcmd_report_timing();
     /* all done */
     halcmd_shutdown();
     if ( errorcount > 0 ) {
@@ -405,6 +418,8 @@ static void print_help_general(int showR)
     printf("\nUsage:   halcmd [options] [cmd [args]]\n\n");
     printf("\n         halcmd [options] -f [filename]\n\n");
     printf("options:\n\n");
+    printf("  -b             Batch - load consecutive loadrt modules with one\n");
+    printf("                 request to rtapi_app (uspace only).\n");
     printf("  -e             echo the commands from stdin to stderr\n");
     printf("  -f [filename]  Read commands from 'filename', not command\n");
     printf("                 line.  If no filename, read from stdin.\n");
@@ -420,12 +435,14 @@ static void print_help_general(int showR)
     printf("  -R             Release mutex (for crash recovery only).\n");
     }
     printf("  -s             Script friendly - don't print headers on output.\n");
+    printf("  -t             Timing - report the time spent in each command.\n");
     printf("  -v             Verbose - print result of every command.\n");
     printf("  -V             Very verbose - print lots of junk.\n");
     printf("  -h             Help - print this help screen and exit.\n\n");
     printf("commands:\n\n");
     printf("  loadrt, loadusr, waitusr, unload, lock, unlock, net, linkps, linksp,\n");
-    printf("  unlinkp, newsig, delsig, setp, getp, ptype, sets, gets, stype,\n");
+    printf("  unlinkp, newsig, delsig, newsnap, delsnap, setp, getp, ptype, sets,\n");
+    printf("  gets, stype,\n");
     printf("  addf, delf, show, list, save, status, start, stop, source, echo, unecho, quit, exit\n");
     printf("  help           Lists all commands with short descriptions\n");
     printf("  help command   Prints detailed help for 'command'\n\n");
@@ -364,6 +364,8 @@ static int comp_id;
         if name in names:
             Error("Duplicate item name: %s" % name)
         print("static void %s(struct __comp_state *__comp_inst, long period);" % to_c(name), file=f)
+        if options.get("batch"):
+            print("static void __comp_batch_%s(void *__comp_unused, long period);" % to_c(name), file=f)
         names[name] = 1
 
     print("static int __comp_get_data_size(void);", file=f)
@@ -383,6 +385,29 @@ static int comp_id;
         print("#define false (0)", file=f)
 
     print("", file=f)
+    if options.get("batch"):
+        # instances are carved out of one block so the batch functions
+        # walk them in order through contiguous memory
+        print("static char *__comp_pool;", file=f)
+        print("static int __comp_pool_count, __comp_pool_used;", file=f)
+        print("static int __comp_inst_size(void) {", file=f)
+        print("    return (sizeof(struct __comp_state) + __comp_get_data_size() + 7) & ~7;", file=f)
+        print("}", file=f)
+        print("static void __comp_alloc_pool(int n) {", file=f)
+        print("    if(n <= 0) return;", file=f)
+        print("    __comp_pool = hal_malloc(n * __comp_inst_size());", file=f)
+        print("    if(__comp_pool) __comp_pool_count = n;", file=f)
+        print("}", file=f)
+        print("static int export_batch(void) {", file=f)
+        print("    int r = 0;", file=f)
+        for name, fp in functions:
+            print("    r = hal_export_funct(\"%s\", %s, 0, %s, 0, comp_id);" % (
+                to_hal(removeprefix(comp_name, "hal_") + ".all." + name),
+                "__comp_batch_" + to_c(name), int(fp)), file=f)
+            print("    if(r != 0) return r;", file=f)
+        print("    return r;", file=f)
+        print("}", file=f)
+        print("", file=f)
     if has_personality:
         print("static int export(char *prefix, long extra_arg, long personality) {", file=f)
     else:
@@ -392,8 +417,16 @@ static int comp_id;
     print("    int r = 0;", file=f)
     if has_array:
         print("    int j = 0;", file=f)
-    print("    int sz = sizeof(struct __comp_state) + __comp_get_data_size();", file=f)
-    print("    struct __comp_state *inst = hal_malloc(sz);", file=f)
+    if options.get("batch"):
+        print("    int sz = __comp_inst_size();", file=f)
+        print("    struct __comp_state *inst;", file=f)
+        print("    if(__comp_pool_used < __comp_pool_count)", file=f)
+        print("        inst = (struct __comp_state *)(__comp_pool + __comp_pool_used++ * sz);", file=f)
+        print("    else", file=f)
+        print("        inst = hal_malloc(sz);", file=f)
+    else:
+        print("    int sz = sizeof(struct __comp_state) + __comp_get_data_size();", file=f)
+        print("    struct __comp_state *inst = hal_malloc(sz);", file=f)
     print("    memset(inst, 0, sz);", file=f)
     if has_data:
         print("    inst->_data = (char*)inst + sizeof(struct __comp_state);", file=f)
@@ -543,6 +576,8 @@ static int comp_id;
         print("    if(comp_id < 0) return comp_id;", file=f)
 
         if options.get("singleton"):
+            if options.get("batch"):
+                print("    __comp_alloc_pool(1);", file=f)
             if has_personality:
                 print("    r = export(\"%s\", 0, personality[0]);" % \
                         to_hal(removeprefix(comp_name, "hal_")), file=f)
@@ -550,6 +585,8 @@ static int comp_id;
                 print("    r = export(\"%s\", 0);" % \
                         to_hal(removeprefix(comp_name, "hal_")), file=f)
         elif options.get("count_function"):
+            if options.get("batch"):
+                print("    __comp_alloc_pool(count);", file=f)
             print("    for(i=0; i<count; i++) {", file=f)
             print("        char buf[HAL_NAME_LEN + 1];", file=f)
             print("        rtapi_snprintf(buf, sizeof(buf), " \
@@ -567,6 +604,14 @@ static int comp_id;
             print("        return -EINVAL;", file=f)
             print("    }", file=f)
             print("    if(!count && !names[0]) count = default_count;", file=f)
+            if options.get("batch"):
+                print("    if(count) {", file=f)
+                print("        __comp_alloc_pool(count);", file=f)
+                print("    } else {", file=f)
+                print("        int n = 1;", file=f)
+                print("        for(i=0; names[i]; i++) if(names[i] == ',') n++;", file=f)
+                print("        __comp_alloc_pool(n);", file=f)
+                print("    }", file=f)
             print("    if(count) {", file=f)
             print("        for(i=0; i<count; i++) {", file=f)
             print("            char buf[HAL_NAME_LEN + 1];", file=f)
@@ -619,6 +664,8 @@ static int comp_id;
                 print("        }", file=f)
                 print("    }", file=f)
 
+        if options.get("batch"):
+            print("    if(r == 0) r = export_batch();", file=f)
         if options.get("constructable") and not options.get("singleton"):
             print("    hal_set_constructor(comp_id, export_1);", file=f)
         print("    if(r) {", file=f)
@@ -763,6 +810,14 @@ int __comp_parse_names(int *argc, char **argv) {
 def epilogue(f):
     data = options.get('data')
     print("", file=f)
+    if options.get("batch"):
+        for name, fp in functions:
+            print("static void __comp_batch_%s(void *__comp_unused, long period) {" % to_c(name), file=f)
+            print("    struct __comp_state *__comp_inst;", file=f)
+            print("    for(__comp_inst = __comp_first_inst; __comp_inst; __comp_inst = __comp_inst->_next)", file=f)
+            print("        %s(__comp_inst, period);" % to_c(name), file=f)
+            print("}", file=f)
+        print("", file=f)
     if data:
         print("static int __comp_get_data_size(void) { return sizeof(%s); }" % data, file=f)
     else:
@@ -951,6 +1006,11 @@ def document(filename, outfilename):
             else:
                 print("", file=f)
             print(doc, file=f)
+        if options.get("batch"):
+            for _, name, fp, doc in finddocs('funct'):
+                print(".TP", file=f)
+                print("\\fB%s\\fR" % to_hal_man_unnumbered("all." + name), file=f)
+                print("Runs \\fB%s\\fR of every instance in turn, in one call.  Add either this or the functions of the instances to a thread, not both." % to_hal_man(name), file=f)
 
     lead = ".TP"
     print(".SH PINS", file=f)
@@ -1044,6 +1104,8 @@ def process(filename, mode, outfilename):
         if options.get("userspace"):
             if functions:
                 raise SystemExit("Userspace components may not have functions")
+            if options.get("batch"):
+                raise SystemExit("Userspace components may not use 'option batch'")
         if not pins:
             raise SystemExit("Component must have at least one pin")
         prologue(f)
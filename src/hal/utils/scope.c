@@ -253,6 +253,9 @@ static int heartbeat(gpointer data)
         if(!gtk_window_is_active(GTK_WINDOW(ctrl_usr->main_win)))
             gtk_window_set_urgency_hint(GTK_WINDOW(ctrl_usr->main_win), TRUE);
 	capture_complete();
+    } else if (stream_active()) {
+	/* streaming, show the growing record */
+	refresh_display();
     } else if (ctrl_usr->run_mode == ROLL) capture_cont();
     return 1;
 }
@@ -336,6 +339,8 @@ void capture_copy_data(void) {
     scope_data_t *src, *dst, *src_end;
     int samp_len, samp_size;
 
+    /* a fresh record replaces any streamed one on the display */
+    stream_close();
     offs = 0;
     for (n = 0; n < 16; n++) {
 	if (ctrl_shm->data_len[n] > 0) {
@@ -521,11 +526,51 @@ static void save_configuration(int junk) {
 }
 
 
+static void do_stream_to_file(GtkWidget *w, GtkFileSelection *fs) {
+    if (stream_start((char *)gtk_file_selection_get_filename(
+	    GTK_FILE_SELECTION(fs))) != 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    _("Cannot start streaming, stop the scope first\n"));
+    }
+}
+
+static void stream_to_file(int junk) {
+    GtkWidget *filew;
+    filew = gtk_file_selection_new(_("Stream Data To File:"));
+    gtk_signal_connect (GTK_OBJECT (filew), "destroy",
+        (GtkSignalFunc) gtk_widget_destroy, &filew);
+    gtk_signal_connect (GTK_OBJECT (GTK_FILE_SELECTION (filew)->ok_button),
+                        "clicked", (GtkSignalFunc) do_stream_to_file, filew );
+    //link ok to destroy, otherwise the window stays open
+    gtk_signal_connect_object (GTK_OBJECT (GTK_FILE_SELECTION
+                                            (filew)->ok_button),
+                               "clicked", (GtkSignalFunc) gtk_widget_destroy,
+                               GTK_OBJECT (filew));
+    gtk_signal_connect_object (GTK_OBJECT (GTK_FILE_SELECTION
+                                            (filew)->cancel_button),
+                               "clicked", (GtkSignalFunc) gtk_widget_destroy,
+                               GTK_OBJECT (filew));
+    gtk_file_selection_set_select_multiple(GTK_FILE_SELECTION(filew), FALSE);
+    gtk_file_selection_hide_fileop_buttons (GTK_FILE_SELECTION(filew) );
+    gtk_dialog_run(GTK_DIALOG(filew));
+}
+
+static void stop_streaming(int junk) {
+    stream_stop();
+    if (stream_overruns()) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    _("halscope: %u samples dropped while streaming\n"),
+	    stream_overruns());
+    }
+    refresh_display();
+}
+
 static void define_menubar(GtkWidget *vboxtop) {
     GtkWidget *file_rootmenu, *help_rootmenu;
     GtkWidget *menubar, *filemenu, 
               *fileopenconfiguration, *filesaveconfiguration, 
               *fileopendatafile, *filesavedatafile,
+              *filestreamstart, *filestreamstop,
               *filequit, *sep1, *sep2;
     GtkWidget *helpmenu, *helpabout;
     GtkWidget *vbox;
@@ -562,6 +607,18 @@ static void define_menubar(GtkWidget *vboxtop) {
     gtk_signal_connect_object(GTK_OBJECT(filesavedatafile), "activate", 
             GTK_SIGNAL_FUNC(log_popup), 0);
     gtk_widget_show(filesavedatafile);
+
+    filestreamstart = gtk_menu_item_new_with_mnemonic(_("S_tream To File..."));
+    gtk_menu_append(GTK_MENU(filemenu), filestreamstart);
+    gtk_signal_connect_object(GTK_OBJECT(filestreamstart), "activate",
+            GTK_SIGNAL_FUNC(stream_to_file), 0);
+    gtk_widget_show(filestreamstart);
+
+    filestreamstop = gtk_menu_item_new_with_mnemonic(_("Stop St_reaming"));
+    gtk_menu_append(GTK_MENU(filemenu), filestreamstop);
+    gtk_signal_connect_object(GTK_OBJECT(filestreamstop), "activate",
+            GTK_SIGNAL_FUNC(stop_streaming), 0);
+    gtk_widget_show(filestreamstop);
     
     gtk_menu_append(GTK_MENU(filemenu), sep2);
     gtk_widget_show(sep2);
@@ -757,6 +814,7 @@ static void init_run_mode_window(void)
 
 static void exit_from_hal(void)
 {
+    stream_close();
     rtapi_shmem_delete(shm_id, comp_id);
     hal_exit(comp_id);
 }
@@ -843,6 +901,9 @@ static void rm_stop_button_clicked(GtkWidget * widget, gpointer * gdata)
 	/* not pressed, ignore it */
 	return;
     }
+    if (stream_active()) {
+	stop_streaming(0);
+    }
     if (ctrl_shm->state != IDLE) {
 	/* RT code is sampling, tell it to stop */
 	ctrl_shm->state = RESET;
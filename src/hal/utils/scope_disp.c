@@ -63,6 +63,7 @@ static void update_readout(void);
 static void draw_grid(void);
 static void draw_baseline(int chan_num, int highlight);
 static void draw_waveform(int chan_num, int highlight);
+static void draw_stream_waveform(int chan_num, int highlight);
 static void draw_triggerline(int chan_num, int highlight);
 static void handle_window_expose(GtkWidget * widget, gpointer data);
 static int handle_click(GtkWidget *widget, GdkEventButton *event, gpointer data);
@@ -127,6 +128,14 @@ void request_display_refresh(int delay)
 
 static int motion_x = -1, motion_y = -1;
 
+/* number of samples the horizontal controls span, a streamed record
+   is usually much longer than the shared memory buffer */
+static long record_len(void)
+{
+    long len = stream_view_len();
+    return len > 0 ? len : ctrl_shm->rec_len;
+}
+
 static void calculate_offset(int chan_num) {
     int n;
     scope_chan_t *chan = &(ctrl_usr->chan[chan_num]);
@@ -137,6 +146,8 @@ static void calculate_offset(int chan_num) {
     double sum=0, value;
 
     if(!chan->ac_offset) return;
+    /* streamed data is not in disp_buf, keep the last offset */
+    if(stream_view_len() > 0) return;
 
     for(n=0; n < ctrl_usr->samples; n++) {
 	switch (type) {
@@ -204,7 +215,7 @@ void refresh_display(void)
     pixels_per_div = disp->width * 0.1;
     pixels_per_sec = pixels_per_div / horiz->disp_scale;
     disp->pixels_per_sample = pixels_per_sec * horiz->sample_period;
-    overall_record_length = horiz->sample_period * ctrl_shm->rec_len;
+    overall_record_length = horiz->sample_period * record_len();
     screen_center_time = overall_record_length * horiz->pos_setting;
     screen_start_time = screen_center_time - (5.0 * horiz->disp_scale);
     disp->horiz_offset = screen_start_time * pixels_per_sec;
@@ -214,8 +225,8 @@ void refresh_display(void)
     }
     screen_end_time = screen_center_time + (5.0 * horiz->disp_scale);
     disp->end_sample = (screen_end_time / horiz->sample_period) + 1;
-    if (disp->end_sample > ctrl_shm->rec_len - 1) {
-	disp->end_sample = ctrl_shm->rec_len - 1;
+    if (disp->end_sample > record_len() - 1) {
+	disp->end_sample = record_len() - 1;
     }
 
     {
@@ -510,9 +521,9 @@ static void change_zoom(int dir, int x) {
 
     // how many samples away from the center of the window is this
     // pixel?
-    old_fraction = (x - disp->width / 2) / old_pixels_per_sample / ctrl_shm->rec_len;
+    old_fraction = (x - disp->width / 2) / old_pixels_per_sample / record_len();
     // and new?
-    new_fraction = (x - disp->width / 2) / new_pixels_per_sample / ctrl_shm->rec_len;
+    new_fraction = (x - disp->width / 2) / new_pixels_per_sample / record_len();
     // displace by the difference
     set_horiz_pos( horiz->pos_setting - new_fraction + old_fraction );
 }
@@ -561,7 +572,7 @@ static int handle_scroll(GtkWidget *widget, GdkEventScroll *event, gpointer data
 static void middle_drag(int dx) {
     scope_disp_t *disp = &(ctrl_usr->disp);
     scope_horiz_t *horiz = &(ctrl_usr->horiz);
-    double dt = (dx / disp->pixels_per_sample) / ctrl_shm->rec_len;
+    double dt = (dx / disp->pixels_per_sample) / record_len();
     set_horiz_pos(horiz->pos_setting + 5 * dt);
     refresh_display();
 }
@@ -782,6 +793,10 @@ void draw_waveform(int chan_num, int highlight)
     int first=1;
     scope_horiz_t *horiz = &(ctrl_usr->horiz);
 
+    if (stream_view_len() > 0) {
+	draw_stream_waveform(chan_num, highlight);
+	return;
+    }
     cursor_valid = 0;
     disp = &(ctrl_usr->disp);
     chan = &(ctrl_usr->chan[chan_num - 1]);
@@ -925,6 +940,60 @@ void draw_waveform(int chan_num, int highlight)
     }
 }
 
+/* Draws a streamed record from its min/max summary, one vertical
+   span per pixel column, so the cost depends only on the window width.
+*/
+static void draw_stream_waveform(int chan_num, int highlight)
+{
+    scope_disp_t *disp = &(ctrl_usr->disp);
+    scope_chan_t *chan = &(ctrl_usr->chan[chan_num - 1]);
+    double yscale, yfoffset, ypoffset, spp, first;
+    int x, ncols, pn, y1, y2, miny, maxy;
+
+    cursor_valid = 0;
+    if (disp->width <= 0 || disp->pixels_per_sample <= 0) {
+	return;
+    }
+    double mn[disp->width], mx[disp->width];
+    GdkPoint points[2 * disp->width];
+
+    spp = 1.0 / disp->pixels_per_sample;
+    first = disp->horiz_offset * spp;
+    ncols = stream_minmax(ctrl_usr->vert.data_offset[chan_num - 1],
+	first, spp, disp->width, mn, mx);
+    if (ncols <= 0) {
+	return;
+    }
+    miny = -disp->height;
+    maxy = 2 * disp->height;
+    yscale = disp->height / (-10.0 * chan->scale);
+    yfoffset = chan->vert_offset;
+    ypoffset = chan->position * disp->height;
+    if (highlight) {
+	gdk_gc_set_foreground(disp->context, &(disp->color_selected[chan_num-1]));
+    } else {
+	gdk_gc_set_foreground(disp->context, &(disp->color_normal[chan_num-1]));
+    }
+    pn = 0;
+    for (x = 0; x < ncols; x++) {
+	y1 = ((mn[x] - yfoffset) * yscale) + ypoffset;
+	y2 = ((mx[x] - yfoffset) * yscale) + ypoffset;
+	if (y1 < miny) y1 = miny; else if (y1 > maxy) y1 = maxy;
+	if (y2 < miny) y2 = miny; else if (y2 > maxy) y2 = maxy;
+	/* alternate the order so consecutive spans join up */
+	if (x & 1) {
+	    int t = y1; y1 = y2; y2 = t;
+	}
+	points[pn].x = x; points[pn].y = y1; pn++;
+	if (y2 != y1) {
+	    points[pn].x = x; points[pn].y = y2; pn++;
+	}
+    }
+    if (pn > 1) {
+	lines(chan_num, points, pn);
+    }
+}
+
 static int ch=0;
 // X limits all windows to 16-bit heights, so this static array will be OK
 static char conflict_map[32768];
@@ -38,6 +38,7 @@
 #include "../hal_priv.h"	/* HAL private API decls */
 #include "scope_rt.h"		/* scope related declarations */
 #include "rtapi_string.h"
+#include "rtapi_atomic.h"
 
 /* module information */
 MODULE_AUTHOR("John Kasunich");
@@ -72,6 +73,7 @@ static void init_shm_control_struct(void);
 
 static void sample(void *arg, long period);
 static void capture_sample(void);
+static void stream_sample(void);
 static int check_trigger(void);
 
 /***********************************************************************
@@ -182,8 +184,15 @@ static void sample(void *arg, long period)
 	    ctrl_rt->data_type[n] = ctrl_shm->data_type[n];
 	    ctrl_rt->data_len[n] = ctrl_shm->data_len[n];
 	}
+	ctrl_shm->stream_head = 0;
+	ctrl_shm->stream_overruns = 0;
 	/* set next state */
-	ctrl_shm->state = PRE_TRIG;
+	if (ctrl_shm->stream) {
+	    /* streaming ignores the trigger, user drains the ring */
+	    ctrl_shm->state = STREAM;
+	} else {
+	    ctrl_shm->state = PRE_TRIG;
+	}
 	break;
     case PRE_TRIG:
 	/* acquire a sample */
@@ -232,6 +241,9 @@ static void sample(void *arg, long period)
     case DONE:
 	/* do nothing while GUI displays waveform */
 	break;
+    case STREAM:
+	stream_sample();
+	break;
     default:
 	/* shouldn't get here - if we do, set a legal state */
 	ctrl_shm->state = IDLE;
@@ -282,6 +294,30 @@ static void capture_sample(void)
     }
 }
 
+/* In streaming mode the buffer is a ring of 'rec_len' samples.  The
+   user side advances 'stream_tail' as it drains samples to disk; we
+   never block, if the ring is full the sample is dropped and counted.
+*/
+static void stream_sample(void)
+{
+    unsigned int head, tail;
+
+    if (ctrl_shm->stream == 0) {
+	/* user asked us to stop, leave the ring for the drain thread */
+	ctrl_shm->state = IDLE;
+	return;
+    }
+    head = ctrl_shm->stream_head;
+    tail = atomic_load_explicit(&ctrl_shm->stream_tail, memory_order_acquire);
+    if ((head - tail) >= (unsigned int) ctrl_shm->rec_len) {
+	ctrl_shm->stream_overruns++;
+	return;
+    }
+    capture_sample();
+    atomic_store_explicit(&ctrl_shm->stream_head, head + 1,
+	memory_order_release);
+}
+
 // TODO: type-independent way to get high bit
 // #define SIGN_BIT (~(((ireal_t)~(ireal_t)0)>>1))
 static int check_trigger(void)
@@ -51,7 +51,8 @@ typedef enum {
     TRIG_WAIT,			/* waiting for trigger */
     POST_TRIG,			/* acquiring post-trigger data */
     DONE,			/* data acquisition complete */
-    RESET			/* data acquisition interrupted */
+    RESET,			/* data acquisition interrupted */
+    STREAM			/* continuous acquisition into ring buffer */
 } scope_state_t;
 
 /* this struct holds a single value - one sample of one channel */
@@ -91,6 +92,10 @@ typedef struct {
     int data_offset[16];	/* U data addr in shmem for each channel */
     hal_type_t data_type[16];	/* U data type for each channel */
     char data_len[16];		/* U data size, 0 if not to be acquired */
+    int stream;			/* U non-zero selects streaming capture */
+    unsigned int stream_head;	/* R samples written into ring since INIT */
+    unsigned int stream_tail;	/* U samples drained from ring by user */
+    unsigned int stream_overruns;	/* R samples dropped, ring was full */
 } scope_shm_control_t;
 
 #endif /* HALSC_SHM_H */
@@ -0,0 +1,513 @@
+/** This file, 'scope_stream.c', implements the streaming capture mode
+    of the HAL oscilloscope.  In streaming mode the realtime part of the
+    scope writes continuously into its shared buffer, used as a ring.
+    A drain thread copies each sample into a compact binary file and
+    folds it into a min/max pyramid, a multi-resolution summary that
+    lets the display draw millions of samples at a cost proportional to
+    the width of the window rather than the length of the record.
+*/
+
+/** This program is free software; you can redistribute it and/or
+    modify it under the terms of version 2 of the GNU General
+    Public License as published by the Free Software Foundation.
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+    THE AUTHORS OF THIS LIBRARY ACCEPT ABSOLUTELY NO LIABILITY FOR
+    ANY HARM OR LOSS RESULTING FROM ITS USE.  IT IS _EXTREMELY_ UNWISE
+    TO RELY ON SOFTWARE ALONE FOR SAFETY.  Any machinery capable of
+    harming persons must have provisions for completely removing power
+    from all motors, etc, before persons enter any danger area.  All
+    machinery must be designed to comply with local and national safety
+    codes, and the authors of this software can not, and do not, take
+    any responsibility for such compliance.
+
+    This code was written as part of the EMC HAL project.  For more
+    information, go to www.linuxcnc.org.
+*/
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "rtapi.h"		/* RTAPI realtime OS API */
+#include "rtapi_atomic.h"
+#include "hal.h"		/* HAL public API decls */
+#include "../hal_priv.h"	/* private HAL decls */
+
+#include <gtk/gtk.h>
+#include "scope_usr.h"		/* scope related declarations */
+
+/***********************************************************************
+*                         TYPEDEFS AND DEFINES                         *
+************************************************************************/
+
+/* samples summarized by one bucket at the bottom of the pyramid, each
+   level above halves the number of buckets */
+#define PYR_BASE	16
+#define PYR_LEVELS	32
+/* size of the file write buffer */
+#define WRITE_BUF_LEN	65536
+
+typedef struct {
+    float *min, *max;		/* one entry per bucket */
+    long count;			/* number of completed buckets */
+    long alloc;			/* allocated entries */
+} pyr_level_t;
+
+typedef struct {
+    int gui_chan;		/* 0-15, channel number in the GUI */
+    hal_type_t type;		/* data type */
+    int len;			/* bytes per sample in the file */
+    int offset;			/* byte offset within a file record */
+    double acc_min, acc_max;	/* partial bucket at level 0 */
+    int acc_count;
+    pyr_level_t level[PYR_LEVELS];
+} stream_chan_t;
+
+/* fixed part of the file header, followed by one scope_stream_chan_hdr_t
+   per channel, then by packed records of 'rec_size' bytes */
+typedef struct {
+    char magic[8];		/* "HALSCSTR" */
+    rtapi_u32 version;
+    rtapi_u32 num_chans;
+    rtapi_u32 rec_size;		/* bytes per sample record */
+    rtapi_u32 reserved;
+    double sample_period;	/* seconds */
+} scope_stream_hdr_t;
+
+typedef struct {
+    rtapi_u32 type;		/* hal_type_t */
+    rtapi_u32 len;		/* 1, 4 or 8 bytes */
+    char name[HAL_NAME_LEN + 1];
+} scope_stream_chan_hdr_t;
+
+/***********************************************************************
+*                         LOCAL VARIABLES                              *
+************************************************************************/
+
+static pthread_t drain_thread;
+static pthread_mutex_t pyr_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int drain_running;	/* thread is draining the ring */
+static int have_data;			/* a stream is open for viewing */
+static int fd = -1;
+static long data_start;			/* file offset of first record */
+static int rec_size;
+static int num_chans;
+static stream_chan_t chans[16];
+static volatile long samples_total;	/* samples folded into pyramid */
+static volatile long samples_flushed;	/* samples on disk */
+static char *wbuf;
+static int wbuf_used;
+
+/***********************************************************************
+*                   LOCAL FUNCTION DEFINITIONS                         *
+************************************************************************/
+
+static double decode_sample(hal_type_t type, const scope_data_t *d)
+{
+    switch (type) {
+    case HAL_BIT:
+	return d->d_u8 ? 1.0 : 0.0;
+    case HAL_FLOAT:
+	return d->d_real;
+    case HAL_S32:
+	return d->d_s32;
+    case HAL_U32:
+	return d->d_u32;
+    default:
+	return 0.0;
+    }
+}
+
+static double decode_packed(hal_type_t type, const char *p)
+{
+    scope_data_t d;
+
+    memset(&d, 0, sizeof(d));
+    switch (type) {
+    case HAL_BIT:
+	memcpy(&d.d_u8, p, 1);
+	break;
+    case HAL_FLOAT:
+	memcpy(&d.d_real, p, sizeof(d.d_real));
+	break;
+    default:
+	memcpy(&d.d_u32, p, 4);
+	break;
+    }
+    return decode_sample(type, &d);
+}
+
+static void pyr_push(stream_chan_t *ch, int lvl, double mn, double mx)
+{
+    pyr_level_t *l;
+
+    if (lvl >= PYR_LEVELS) {
+	return;
+    }
+    l = &(ch->level[lvl]);
+    if (l->count == l->alloc) {
+	l->alloc = l->alloc ? 2 * l->alloc : 1024;
+	l->min = g_realloc(l->min, l->alloc * sizeof(float));
+	l->max = g_realloc(l->max, l->alloc * sizeof(float));
+    }
+    l->min[l->count] = mn;
+    l->max[l->count] = mx;
+    l->count++;
+    /* every second bucket completes one bucket on the next level */
+    if ((l->count & 1) == 0) {
+	float a = l->min[l->count - 2], b = l->min[l->count - 1];
+	float c = l->max[l->count - 2], d = l->max[l->count - 1];
+	pyr_push(ch, lvl + 1, a < b ? a : b, c > d ? c : d);
+    }
+}
+
+static void pyr_add(stream_chan_t *ch, double v)
+{
+    if (ch->acc_count == 0 || v < ch->acc_min) {
+	ch->acc_min = v;
+    }
+    if (ch->acc_count == 0 || v > ch->acc_max) {
+	ch->acc_max = v;
+    }
+    if (++ch->acc_count == PYR_BASE) {
+	pyr_push(ch, 0, ch->acc_min, ch->acc_max);
+	ch->acc_count = 0;
+    }
+}
+
+static void pyr_free(void)
+{
+    int n, l;
+
+    for (n = 0; n < 16; n++) {
+	for (l = 0; l < PYR_LEVELS; l++) {
+	    g_free(chans[n].level[l].min);
+	    g_free(chans[n].level[l].max);
+	}
+    }
+    memset(chans, 0, sizeof(chans));
+}
+
+static int flush_wbuf(void)
+{
+    char *p = wbuf;
+    int left = wbuf_used;
+
+    while (left > 0) {
+	ssize_t r = write(fd, p, left);
+	if (r < 0) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    return -1;
+	}
+	p += r;
+	left -= r;
+    }
+    wbuf_used = 0;
+    samples_flushed = samples_total;
+    return 0;
+}
+
+static void *drain_main(void *arg)
+{
+    scope_data_t *buf = ctrl_usr->buffer;
+    unsigned int head, tail;
+    int n, slot, err = 0;
+
+    tail = ctrl_shm->stream_tail;
+    while (1) {
+	int running = (ctrl_shm->state == STREAM || ctrl_shm->state == INIT);
+	head = atomic_load_explicit(&ctrl_shm->stream_head,
+	    memory_order_acquire);
+	if (tail == head) {
+	    if (!running) {
+		break;
+	    }
+	    if (wbuf_used && !err) {
+		/* idle, make what we have visible to the display */
+		err = flush_wbuf();
+	    }
+	    usleep(1000);
+	    continue;
+	}
+	pthread_mutex_lock(&pyr_mutex);
+	while (tail != head) {
+	    scope_data_t *src;
+
+	    slot = (tail % ctrl_shm->rec_len) * ctrl_shm->sample_len;
+	    src = buf + slot;
+	    if (wbuf_used + rec_size > WRITE_BUF_LEN) {
+		if (!err) {
+		    err = flush_wbuf();
+		}
+		/* after a write error keep draining, but discard */
+		wbuf_used = 0;
+	    }
+	    for (n = 0; n < num_chans; n++) {
+		stream_chan_t *ch = &(chans[n]);
+		memcpy(wbuf + wbuf_used + ch->offset, &(src[n]), ch->len);
+		pyr_add(ch, decode_sample(ch->type, &(src[n])));
+	    }
+	    wbuf_used += rec_size;
+	    samples_total++;
+	    tail++;
+	    atomic_store_explicit(&ctrl_shm->stream_tail, tail,
+		memory_order_release);
+	}
+	pthread_mutex_unlock(&pyr_mutex);
+    }
+    if (!err) {
+	err = flush_wbuf();
+    }
+    if (err) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "SCOPE: stream write failed: %s\n", strerror(errno));
+    }
+    drain_running = 0;
+    return NULL;
+}
+
+/***********************************************************************
+*                       PUBLIC FUNCTIONS                               *
+************************************************************************/
+
+int stream_start(char *filename)
+{
+    scope_stream_hdr_t hdr;
+    scope_stream_chan_hdr_t chdr;
+    int n, offset;
+
+    if (drain_running || ctrl_shm->state != IDLE) {
+	return -1;
+    }
+    stream_close();
+    fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+	rtapi_print_msg(RTAPI_MSG_ERR,
+	    "SCOPE: cannot open stream file '%s': %s\n", filename,
+	    strerror(errno));
+	return -1;
+    }
+    /* set up the RT side, this fills in the channel info */
+    ctrl_shm->stream = 1;
+    ctrl_shm->stream_tail = 0;
+    ctrl_shm->stream_head = 0;
+    start_capture();
+    /* channels are packed in order, same as capture_sample() */
+    num_chans = 0;
+    offset = 0;
+    for (n = 0; n < 16; n++) {
+	if (ctrl_shm->data_len[n] > 0) {
+	    stream_chan_t *ch = &(chans[num_chans]);
+	    ch->gui_chan = n;
+	    ch->type = ctrl_shm->data_type[n];
+	    ch->len = ctrl_shm->data_len[n];
+	    ch->offset = offset;
+	    offset += ch->len;
+	    ctrl_usr->vert.data_offset[n] = num_chans;
+	    num_chans++;
+	} else {
+	    ctrl_usr->vert.data_offset[n] = -1;
+	}
+    }
+    rec_size = offset;
+    /* write the header */
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, "HALSCSTR", 8);
+    hdr.version = 1;
+    hdr.num_chans = num_chans;
+    hdr.rec_size = rec_size;
+    hdr.sample_period = ctrl_usr->horiz.sample_period;
+    wbuf = g_malloc(WRITE_BUF_LEN + sizeof(hdr) + 16 * sizeof(chdr));
+    memcpy(wbuf, &hdr, sizeof(hdr));
+    wbuf_used = sizeof(hdr);
+    for (n = 0; n < num_chans; n++) {
+	memset(&chdr, 0, sizeof(chdr));
+	chdr.type = chans[n].type;
+	chdr.len = chans[n].len;
+	snprintf(chdr.name, sizeof(chdr.name), "%s",
+	    ctrl_usr->chan[chans[n].gui_chan].name);
+	memcpy(wbuf + wbuf_used, &chdr, sizeof(chdr));
+	wbuf_used += sizeof(chdr);
+    }
+    data_start = wbuf_used;
+    samples_total = 0;
+    samples_flushed = 0;
+    have_data = 1;
+    drain_running = 1;
+    if (pthread_create(&drain_thread, NULL, drain_main, NULL) != 0) {
+	drain_running = 0;
+	ctrl_shm->stream = 0;
+	stream_close();
+	return -1;
+    }
+    return 0;
+}
+
+void stream_stop(void)
+{
+    if (!drain_running) {
+	return;
+    }
+    /* RT side goes IDLE on its next sample, the thread then drains
+       what is left in the ring and exits */
+    ctrl_shm->stream = 0;
+    pthread_join(drain_thread, NULL);
+    if (ctrl_shm->state == STREAM) {
+	/* RT thread not running, force it */
+	ctrl_shm->state = IDLE;
+    }
+}
+
+void stream_close(void)
+{
+    stream_stop();
+    if (fd >= 0) {
+	close(fd);
+	fd = -1;
+    }
+    g_free(wbuf);
+    wbuf = NULL;
+    pyr_free();
+    have_data = 0;
+    num_chans = 0;
+    samples_total = 0;
+    samples_flushed = 0;
+}
+
+int stream_active(void)
+{
+    return drain_running;
+}
+
+long stream_view_len(void)
+{
+    return have_data ? samples_total : 0;
+}
+
+unsigned int stream_overruns(void)
+{
+    return ctrl_shm->stream_overruns;
+}
+
+/* Fill 'mn' and 'mx' with the extremes of channel 'idx' (as stored in
+   vert.data_offset[]) for 'npix' columns of 'spp' samples each, the
+   first column starting at sample 'first'.  Returns the number of
+   columns filled, which is smaller than 'npix' at the end of data.
+   Coarse zoom levels are served from the pyramid, fine ones from the
+   file itself, so the cost is bounded by 'npix' either way.
+*/
+int stream_minmax(int idx, double first, double spp, int npix,
+    double *mn, double *mx)
+{
+    stream_chan_t *ch;
+    int c, lvl;
+    long bsize;
+
+    if (!have_data || idx < 0 || idx >= num_chans || spp <= 0) {
+	return 0;
+    }
+    ch = &(chans[idx]);
+    pthread_mutex_lock(&pyr_mutex);
+    if (spp >= PYR_BASE) {
+	pyr_level_t *l;
+	/* coarsest level whose buckets still fit in one column */
+	lvl = 0;
+	bsize = PYR_BASE;
+	while (lvl + 1 < PYR_LEVELS && bsize * 2 <= spp
+	    && ch->level[lvl + 1].count > 0) {
+	    lvl++;
+	    bsize *= 2;
+	}
+	l = &(ch->level[lvl]);
+	for (c = 0; c < npix; c++) {
+	    long b = (first + c * spp) / bsize;
+	    long e = (first + (c + 1) * spp) / bsize;
+	    if (b < 0) {
+		b = 0;
+	    }
+	    if (e <= b) {
+		e = b + 1;
+	    }
+	    if (e > l->count) {
+		e = l->count;
+	    }
+	    if (b >= e) {
+		break;
+	    }
+	    mn[c] = l->min[b];
+	    mx[c] = l->max[b];
+	    for (b++; b < e; b++) {
+		if (l->min[b] < mn[c]) {
+		    mn[c] = l->min[b];
+		}
+		if (l->max[b] > mx[c]) {
+		    mx[c] = l->max[b];
+		}
+	    }
+	}
+    } else {
+	/* zoomed in, read the raw records back from the file */
+	long s0 = first < 0 ? 0 : first;
+	long s1 = first + npix * spp + 1;
+	long n, nrec;
+	char *rbuf;
+
+	if (s1 > samples_flushed) {
+	    s1 = samples_flushed;
+	}
+	nrec = s1 - s0;
+	if (nrec <= 0) {
+	    pthread_mutex_unlock(&pyr_mutex);
+	    return 0;
+	}
+	rbuf = g_malloc(nrec * rec_size);
+	n = pread(fd, rbuf, nrec * rec_size, data_start + s0 * rec_size);
+	nrec = n > 0 ? n / rec_size : 0;
+	for (c = 0; c < npix; c++) {
+	    long b = (long) (first + c * spp) - s0;
+	    long e = (long) (first + (c + 1) * spp) - s0;
+	    if (b < 0) {
+		b = 0;
+	    }
+	    if (e <= b) {
+		e = b + 1;
+	    }
+	    if (e > nrec) {
+		e = nrec;
+	    }
+	    if (b >= e) {
+		break;
+	    }
+	    mn[c] = mx[c] = decode_packed(ch->type, rbuf + b * rec_size
+		+ ch->offset);
+	    for (b++; b < e; b++) {
+		double v = decode_packed(ch->type, rbuf + b * rec_size
+		    + ch->offset);
+		if (v < mn[c]) {
+		    mn[c] = v;
+		}
+		if (v > mx[c]) {
+		    mx[c] = v;
+		}
+	    }
+	}
+	g_free(rbuf);
+    }
+    pthread_mutex_unlock(&pyr_mutex);
+    return c;
+}
@@ -296,4 +296,14 @@ int set_trigger_mode(int mode);
 int set_run_mode(int mode);
 void prepare_scope_restart(void);
 void log_popup(int);
+
+/* streaming capture, see scope_stream.c */
+int stream_start(char *filename);
+void stream_stop(void);
+void stream_close(void);
+int stream_active(void);
+long stream_view_len(void);
+unsigned int stream_overruns(void);
+int stream_minmax(int idx, double first, double spp, int npix,
+    double *mn, double *mx);
 #endif /* HALSC_USR_H */
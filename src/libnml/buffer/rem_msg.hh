@@ -49,6 +49,7 @@ enum REMOTE_CMS_REQUEST_TYPE {
     REMOTE_CMS_GET_MSG_COUNT_REQUEST_TYPE,
     REMOTE_CMS_GET_QUEUE_LENGTH_REQUEST_TYPE,
     REMOTE_CMS_GET_SPACE_AVAILABLE_REQUEST_TYPE,
+    REMOTE_CMS_READ_DELTA_REQUEST_TYPE,
 
 };
 
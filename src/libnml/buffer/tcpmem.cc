@@ -46,6 +46,7 @@ extern "C" {
 #include "sendn.h"		/* sendn() */
 #include "tcp_opts.hh"		/* SET_TCP_NODELAY */
 #include "linklist.hh"          /* LinkedList */
+#include "cms_delta.hh"		/* cms_delta_apply() */
 
 int tcpmem_sigpipe_count = 0;
 int last_sig = 0;
@@ -72,6 +73,11 @@ TCPMEM::TCPMEM(const char *_bufline, const char *_procline):CMS(_bufline, _procl
     write_serial_number = 0;
     read_socket_fd = 0;
     write_socket_fd = 0;
+    delta_request_outstanding = 0;
+    delta_reply_pending = 0;
+    delta_generation = 0;
+    delta_base = NULL;
+    delta_frame = NULL;
     if (NULL != max_consecutive_timeouts_string) {
 	max_consecutive_timeouts_string += strlen("max_timeouts=");
 	if (!strncmp(max_consecutive_timeouts_string, "INF", 3)) {
@@ -431,6 +437,9 @@ void TCPMEM::reconnect()
     waiting_message_size = 0;
     waiting_message_id = 0;
     serial_number = 0;
+    delta_request_outstanding = 0;
+    delta_reply_pending = 0;
+    delta_generation = 0;
 
     rcs_print_debug(PRINT_CMS_CONFIG_INFO, "Creating socket . . .\n");
 
@@ -631,6 +640,64 @@ void TCPMEM::reconnect()
 TCPMEM::~TCPMEM()
 {
     disconnect();
+    if (NULL != delta_base) {
+	free(delta_base);
+	delta_base = NULL;
+    }
+    if (NULL != delta_frame) {
+	free(delta_frame);
+	delta_frame = NULL;
+    }
+}
+
+/* Whether the next read should ask for a delta frame.  Subscriptions and
+   subdivided buffers always get whole messages. */
+int TCPMEM::use_delta_read()
+{
+    if (!delta_encoding || subscription_type != CMS_NO_SUBSCRIPTION
+	|| total_subdivisions > 1) {
+	return 0;
+    }
+    if (NULL == delta_base) {
+	delta_base = (unsigned char *) malloc(max_encoded_message_size);
+	delta_frame = (unsigned char *)
+	    malloc(max_encoded_message_size + CMS_DELTA_FRAME_HEADER_SIZE);
+	if (NULL == delta_base || NULL == delta_frame) {
+	    rcs_print_error
+		("TCPMEM: Can't allocate delta buffers, using full reads.\n");
+	    free(delta_base);
+	    free(delta_frame);
+	    delta_base = NULL;
+	    delta_frame = NULL;
+	    delta_encoding = 0;
+	    return 0;
+	}
+	delta_generation = 0;
+    }
+    return 1;
+}
+
+char *TCPMEM::read_reply_target()
+{
+    return delta_reply_pending ? (char *) delta_frame : (char *) encoded_data;
+}
+
+/* Rebuild the message from a received delta frame into encoded_data. */
+int TCPMEM::apply_delta_reply(long frame_size)
+{
+    delta_reply_pending = 0;
+    long size = cms_delta_apply(delta_base, max_encoded_message_size,
+	delta_frame, frame_size, &delta_generation);
+    if (size < 0) {
+	rcs_print_error("TCPMEM: Received a bad delta frame for %s.\n",
+	    BufferName);
+	/* ask for a full message next time */
+	delta_generation = 0;
+	status = CMS_MISC_ERROR;
+	return -1;
+    }
+    memcpy(encoded_data, delta_base, size);
+    return 0;
 }
 
 void TCPMEM::disconnect()
@@ -717,7 +784,10 @@ CMS_STATUS TCPMEM::handle_old_replies()
 		(CMS_STATUS) ntohl(*((uint32_t *) temp_buffer + 1));
 	    timedout_request_writeid = ntohl(*((uint32_t *) temp_buffer + 3));
 	    header.was_read = ntohl(*((uint32_t *) temp_buffer + 4));
-	    if (message_size > max_encoded_message_size) {
+	    delta_reply_pending = delta_request_outstanding && message_size > 0;
+	    delta_request_outstanding = 0;
+	    if (message_size > max_encoded_message_size +
+		(delta_reply_pending ? CMS_DELTA_FRAME_HEADER_SIZE : 0)) {
 		rcs_print_error("Received message is too big. (%ld > %ld)\n",
 		    message_size, max_encoded_message_size);
 		fatal_error_occurred = 1;
@@ -729,7 +799,7 @@ CMS_STATUS TCPMEM::handle_old_replies()
 	}
 	if (message_size > 0) {
 	    if (recvn
-		(socket_fd, encoded_data, message_size, 0, timeout,
+		(socket_fd, read_reply_target(), message_size, 0, timeout,
 		    &recvd_bytes) < 0) {
 		if (recvn_timedout) {
 		    if (!waiting_for_message) {
@@ -763,6 +833,10 @@ CMS_STATUS TCPMEM::handle_old_replies()
 	    if (waiting_for_message) {
 		timedout_request_writeid = waiting_message_id;
 	    }
+	    if (delta_reply_pending && apply_delta_reply(message_size) < 0) {
+		timedout_request_writeid = 0;
+		return status;
+	    }
 	}
 	break;
 
@@ -953,8 +1027,10 @@ CMS_STATUS TCPMEM::read()
     }
     set_socket_fds(read_socket_fd);
 
+    int delta_request = use_delta_read();
     putbe32(temp_buffer, (uint32_t) serial_number);
-    putbe32(temp_buffer + 4, REMOTE_CMS_READ_REQUEST_TYPE);
+    putbe32(temp_buffer + 4, delta_request ?
+	REMOTE_CMS_READ_DELTA_REQUEST_TYPE : REMOTE_CMS_READ_REQUEST_TYPE);
     putbe32(temp_buffer + 8, (uint32_t) buffer_number);
     putbe32(temp_buffer + 12, CMS_READ_ACCESS);
     putbe32(temp_buffer + 16, in_buffer_id);
@@ -963,6 +1039,9 @@ CMS_STATUS TCPMEM::read()
     if (total_subdivisions > 1) {
 	*((uint32_t *) temp_buffer + 5) = htonl((uint32_t) current_subdivision);
 	send_header_size = 24;
+    } else if (delta_request) {
+	putbe32(temp_buffer + 20, (uint32_t) delta_generation);
+	send_header_size = 24;
     }
     if (sendn(socket_fd, temp_buffer, send_header_size, 0, timeout) < 0) {
 	rcs_print_error("TCPMEM: Can't send READ request to server.\n");
@@ -971,6 +1050,7 @@ CMS_STATUS TCPMEM::read()
 	reenable_sigpipe();
 	return (status = CMS_MISC_ERROR);
     }
+    delta_request_outstanding = delta_request;
     serial_number++;
     rcs_print_debug(PRINT_ALL_SOCKET_REQUESTS,
 	"TCPMEM sending request: fd = %d, serial_number=%ld, request_type=%d, buffer_number=%ld\n",
@@ -1016,7 +1096,10 @@ CMS_STATUS TCPMEM::read()
     message_size = ntohl(*((uint32_t *) temp_buffer + 2));
     id = ntohl(*((uint32_t *) temp_buffer + 3));
     header.was_read = ntohl(*((uint32_t *) temp_buffer + 4));
-    if (message_size > max_encoded_message_size) {
+    delta_reply_pending = delta_request_outstanding && message_size > 0;
+    delta_request_outstanding = 0;
+    if (message_size > max_encoded_message_size +
+	(delta_reply_pending ? CMS_DELTA_FRAME_HEADER_SIZE : 0)) {
 	rcs_print_error("Received message is too big. (%ld > %ld)\n",
 	    message_size, max_encoded_message_size);
 	fatal_error_occurred = 1;
@@ -1026,7 +1109,7 @@ CMS_STATUS TCPMEM::read()
     }
     if (message_size > 0) {
 	if (recvn
-	    (socket_fd, encoded_data, message_size, 0, timeout,
+	    (socket_fd, read_reply_target(), message_size, 0, timeout,
 		&recvd_bytes) < 0) {
 	    if (recvn_timedout) {
 		if (!waiting_for_message) {
@@ -1052,6 +1135,10 @@ CMS_STATUS TCPMEM::read()
 	}
     }
     recvd_bytes = 0;
+    if (delta_reply_pending && apply_delta_reply(message_size) < 0) {
+	reenable_sigpipe();
+	return status;
+    }
     check_id(id);
     reenable_sigpipe();
     return (status);
@@ -1349,8 +1436,10 @@ CMS_STATUS TCPMEM::peek()
     }
     set_socket_fds(read_socket_fd);
 
+    int delta_request = use_delta_read();
     putbe32(temp_buffer, (uint32_t) serial_number);
-    putbe32(temp_buffer + 4, REMOTE_CMS_READ_REQUEST_TYPE);
+    putbe32(temp_buffer + 4, delta_request ?
+	REMOTE_CMS_READ_DELTA_REQUEST_TYPE : REMOTE_CMS_READ_REQUEST_TYPE);
     putbe32(temp_buffer + 8, (uint32_t) buffer_number);
     putbe32(temp_buffer + 12, CMS_PEEK_ACCESS);
     putbe32(temp_buffer + 16, (uint32_t) in_buffer_id);
@@ -1358,6 +1447,9 @@ CMS_STATUS TCPMEM::peek()
     if (total_subdivisions > 1) {
 	*((uint32_t *) temp_buffer + 20) = htonl((uint32_t) current_subdivision);
 	send_header_size = 24;
+    } else if (delta_request) {
+	putbe32(temp_buffer + 20, (uint32_t) delta_generation);
+	send_header_size = 24;
     }
     if (sendn(socket_fd, temp_buffer, send_header_size, 0, timeout) < 0) {
 	rcs_print_error("TCPMEM: Can't send PEEK request to server.\n");
@@ -1365,6 +1457,7 @@ CMS_STATUS TCPMEM::peek()
 	reenable_sigpipe();
 	return (status = CMS_MISC_ERROR);
     }
+    delta_request_outstanding = delta_request;
     serial_number++;
     if (recvn(socket_fd, temp_buffer, 20, 0, timeout, &recvd_bytes) < 0) {
 	if (recvn_timedout) {
@@ -1405,7 +1498,10 @@ CMS_STATUS TCPMEM::peek()
     message_size = ntohl(*((uint32_t *) temp_buffer + 2));
     id = ntohl(*((uint32_t *) temp_buffer + 3));
     header.was_read = ntohl(*((uint32_t *) temp_buffer + 4));
-    if (message_size > max_encoded_message_size) {
+    delta_reply_pending = delta_request_outstanding && message_size > 0;
+    delta_request_outstanding = 0;
+    if (message_size > max_encoded_message_size +
+	(delta_reply_pending ? CMS_DELTA_FRAME_HEADER_SIZE : 0)) {
 	reconnect_needed = 1;
 	rcs_print_error("Received message is too big. (%ld > %ld)\n",
 	    message_size, max_encoded_message_size);
@@ -1414,7 +1510,7 @@ CMS_STATUS TCPMEM::peek()
     }
     if (message_size > 0) {
 	if (recvn
-	    (socket_fd, encoded_data, message_size, 0, timeout,
+	    (socket_fd, read_reply_target(), message_size, 0, timeout,
 		&recvd_bytes) < 0) {
 	    if (recvn_timedout) {
 		if (!waiting_for_message) {
@@ -1440,6 +1536,10 @@ CMS_STATUS TCPMEM::peek()
 	}
     }
     recvd_bytes = 0;
+    if (delta_reply_pending && apply_delta_reply(message_size) < 0) {
+	reenable_sigpipe();
+	return status;
+    }
     check_id(id);
     reenable_sigpipe();
     return (status);
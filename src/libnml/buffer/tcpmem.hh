@@ -81,6 +81,16 @@ class TCPMEM:public CMS {
     void reenable_sigpipe();
     void verify_bufname();
     int subscription_count;
+
+    /* Delta reads, see cms_delta.hh */
+    int use_delta_read();
+    char *read_reply_target();
+    int apply_delta_reply(long frame_size);
+    int delta_request_outstanding;
+    int delta_reply_pending;
+    unsigned long delta_generation;
+    unsigned char *delta_base;
+    unsigned char *delta_frame;
 };
 
 #endif
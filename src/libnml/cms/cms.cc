@@ -37,6 +37,7 @@ extern "C" {
 #include "cms_xup.hh"		/* class CMS_XDR_UPDATER */
 #include "cms_aup.hh"		/* class CMS_ASCII_UPDATER */
 #include "cms_dup.hh"		/* class CMS_DISPLAY_ASCII_UPDATER */
+#include "cms_bup.hh"		/* class CMS_BINARY_UPDATER */
 #include "rcs_print.hh"		/* rcs_print_error(), separate_words() */
 				/* rcs_print_debug() */
 #include "cmsdiag.hh"
@@ -156,6 +157,7 @@ CMS::CMS(long s)
     fatal_error_occurred = 0;
     write_just_completed = 0;
     neutral_encoding_method = CMS_XDR_ENCODING;
+    delta_encoding = 0;
     blocking_timeout = 0;
     total_subdivisions = 1;
     subdiv_size = size;
@@ -214,6 +216,7 @@ CMS::CMS(const char *bufline_in, const char *procline_in, int set_to_server)
     fatal_error_occurred = 0;
     write_just_completed = 0;
     neutral_encoding_method = CMS_XDR_ENCODING;
+    delta_encoding = 0;
     blocking_timeout = 0;
     min_compatible_version = 0;
     enc_max_size = -1;
@@ -379,6 +382,14 @@ CMS::CMS(const char *bufline_in, const char *procline_in, int set_to_server)
 	    neutral_encoding_method = CMS_XDR_ENCODING;
 	    continue;
 	}
+	if (!strcmp(word[i], "BINARY")) {
+	    neutral_encoding_method = CMS_BINARY_ENCODING;
+	    continue;
+	}
+	if (!strcmp(word[i], "DELTA")) {
+	    delta_encoding = 1;
+	    continue;
+	}
 
 	char *port_string;
 	if (NULL != (port_string = strstr(word[i], "STCP="))) {
@@ -679,6 +690,10 @@ void CMS::open(void)
 	    updater = new CMS_DISPLAY_ASCII_UPDATER(this);
 	    break;
 
+	case CMS_BINARY_ENCODING:
+	    updater = new CMS_BINARY_UPDATER(this);
+	    break;
+
 	default:
 	    updater = (CMS_UPDATER *) NULL;
 	    status = CMS_UPDATE_ERROR;
@@ -1123,6 +1138,10 @@ void CMS::set_temp_updater(CMS_NEUTRAL_ENCODING_METHOD temp_encoding_method)
 	    temp_updater = new CMS_DISPLAY_ASCII_UPDATER(this);
 	    break;
 
+	case CMS_BINARY_ENCODING:
+	    temp_updater = new CMS_BINARY_UPDATER(this);
+	    break;
+
 	default:
 	    temp_updater = (CMS_UPDATER *) NULL;
 	    status = CMS_UPDATE_ERROR;
@@ -163,7 +163,8 @@ enum CMS_NEUTRAL_ENCODING_METHOD {
     CMS_NO_ENCODING,
     CMS_XDR_ENCODING,
     CMS_ASCII_ENCODING,
-    CMS_DISPLAY_ASCII_ENCODING
+    CMS_DISPLAY_ASCII_ENCODING,
+    CMS_BINARY_ENCODING
 };
 
 /* CMS class declaration. */
@@ -407,6 +408,7 @@ class CMS {
     /* XDR of ASCII */
     CMS_NEUTRAL_ENCODING_METHOD neutral_encoding_method;
     CMS_NEUTRAL_ENCODING_METHOD temp_updater_encoding_method;
+    int delta_encoding;		/* remote reads send only changed bytes */
 
   public:
     /* Type of internal access. */
@@ -0,0 +1,388 @@
+/********************************************************************
+* Description: cms_bup.cc
+*   Provides the interface to CMS used by NML update functions
+*   including a CMS update function for all the basic C data types
+*   to convert NMLmsgs to a fixed-layout little endian binary format.
+*
+*   Unlike XDR there is no per-field library call and no padding of
+*   chars and shorts to 4 bytes; on little endian hosts most fields
+*   are a plain memcpy.
+*
+* Author:
+* License: LGPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+*
+* Last change:
+********************************************************************/
+
+extern "C" {
+#include <stdlib.h>		/* malloc(), free() */
+#include <string.h>		/* memcpy() */
+#include <stdint.h>		/* uint64_t */
+}
+
+#include "cms.hh"		/* class CMS */
+#include "cms_bup.hh"		/* class CMS_BINARY_UPDATER */
+#include "rcs_print.hh"		/* rcs_print_error() */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CMS_BINARY_NATIVE_ORDER 1
+#else
+#define CMS_BINARY_NATIVE_ORDER 0
+#endif
+
+/* Read a host integer (or the bits of a float) of the given size. */
+static uint64_t load_host(const unsigned char *p, int size, int is_signed)
+{
+    switch (size) {
+    case 1:
+	return is_signed ? (uint64_t) (int64_t) * (const int8_t *) p :
+	    *(const uint8_t *) p;
+    case 2:{
+	    uint16_t v;
+	    memcpy(&v, p, 2);
+	    return is_signed ? (uint64_t) (int64_t) (int16_t) v : v;
+	}
+    case 4:{
+	    uint32_t v;
+	    memcpy(&v, p, 4);
+	    return is_signed ? (uint64_t) (int64_t) (int32_t) v : v;
+	}
+    default:{
+	    uint64_t v;
+	    memcpy(&v, p, 8);
+	    return v;
+	}
+    }
+}
+
+static void store_host(unsigned char *p, int size, uint64_t v)
+{
+    switch (size) {
+    case 1:
+	*(uint8_t *) p = (uint8_t) v;
+	break;
+    case 2:{
+	    uint16_t w = (uint16_t) v;
+	    memcpy(p, &w, 2);
+	    break;
+	}
+    case 4:{
+	    uint32_t w = (uint32_t) v;
+	    memcpy(p, &w, 4);
+	    break;
+	}
+    default:
+	memcpy(p, &v, 8);
+	break;
+    }
+}
+
+/* Member functions for CMS_BINARY_UPDATER Class */
+CMS_BINARY_UPDATER::CMS_BINARY_UPDATER(CMS * _cms_parent):CMS_UPDATER
+    (_cms_parent, 1, 2)
+{
+    current_buffer = NULL;
+    current_buffer_size = 0;
+    current_position = 0;
+
+    /* Store and validate constructors arguments. */
+    cms_parent = _cms_parent;
+    if (NULL == cms_parent) {
+	rcs_print_error("CMS parent for updater is NULL.\n");
+	return;
+    }
+
+    /* Allocate the encoded header too large, and find out what size it
+       really is. */
+    encoded_header = malloc(neutral_size_factor * sizeof(CMS_HEADER));
+    if (encoded_header == NULL) {
+	rcs_print_error("CMS:can't malloc encoded_header");
+	status = CMS_CREATE_ERROR;
+	return;
+    }
+
+    if (cms_parent->queuing_enabled) {
+	encoded_queuing_header =
+	    malloc(neutral_size_factor * sizeof(CMS_QUEUING_HEADER));
+	if (encoded_queuing_header == NULL) {
+	    rcs_print_error("CMS:can't malloc encoded_queuing_header");
+	    status = CMS_CREATE_ERROR;
+	    return;
+	}
+    }
+}
+
+CMS_BINARY_UPDATER::~CMS_BINARY_UPDATER()
+{
+    if (NULL != encoded_data && !using_external_encoded_data) {
+	free(encoded_data);
+	encoded_data = NULL;
+    }
+    if (NULL != encoded_header) {
+	free(encoded_header);
+	encoded_header = NULL;
+    }
+    if (NULL != encoded_queuing_header) {
+	free(encoded_queuing_header);
+	encoded_queuing_header = NULL;
+    }
+}
+
+int CMS_BINARY_UPDATER::set_mode(CMS_UPDATER_MODE _mode)
+{
+    if (CMS_UPDATER::set_mode(_mode) < 0) {
+	return (-1);
+    }
+    mode = _mode;
+    current_position = 0;
+    switch (mode) {
+    case CMS_NO_UPDATE:
+	current_buffer = NULL;
+	current_buffer_size = 0;
+	break;
+
+    case CMS_ENCODE_DATA:
+    case CMS_DECODE_DATA:
+	current_buffer = (unsigned char *) encoded_data;
+	current_buffer_size = encoded_data_size;
+	if (current_buffer_size > cms_parent->max_encoded_message_size
+	    && cms_parent->max_encoded_message_size > 0) {
+	    current_buffer_size = cms_parent->max_encoded_message_size;
+	}
+	break;
+
+    case CMS_ENCODE_HEADER:
+    case CMS_DECODE_HEADER:
+	current_buffer = (unsigned char *) encoded_header;
+	current_buffer_size = neutral_size_factor * sizeof(CMS_HEADER);
+	break;
+
+    case CMS_ENCODE_QUEUING_HEADER:
+    case CMS_DECODE_QUEUING_HEADER:
+	current_buffer = (unsigned char *) encoded_queuing_header;
+	current_buffer_size =
+	    neutral_size_factor * sizeof(CMS_QUEUING_HEADER);
+	break;
+
+    default:
+	rcs_print_error("CMS updater in invalid mode.(%d)\n", mode);
+	return (-1);
+    }
+    return (0);
+}
+
+/* Repositions the data buffer to the very beginning */
+void CMS_BINARY_UPDATER::rewind()
+{
+    CMS_UPDATER::rewind();
+    current_position = 0;
+    if (NULL != cms_parent) {
+	cms_parent->format_size = 0;
+    }
+}
+
+int CMS_BINARY_UPDATER::get_encoded_msg_size()
+{
+    return ((int) current_position);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update_integer(void *x, int host_size,
+    int wire_size, int is_signed, unsigned int len)
+{
+    if (-1 == check_pointer((char *) x, (long) host_size * len)) {
+	return (CMS_UPDATE_ERROR);
+    }
+    return transfer(x, host_size, wire_size, is_signed, len);
+}
+
+/* Move 'len' values of 'host_size' bytes each between the host and
+   'wire_size' little endian bytes in the encoded buffer.  Floating
+   point values pass through here as their bit patterns. */
+CMS_STATUS CMS_BINARY_UPDATER::transfer(void *x, int host_size,
+    int wire_size, int is_signed, unsigned int len)
+{
+    long bytes = (long) wire_size * len;
+
+    if (NULL == current_buffer
+	|| current_position + bytes > current_buffer_size) {
+	rcs_print_error
+	    ("CMS_BINARY_UPDATER: Encoded message buffer full. (pos=%ld,bytes=%ld,size=%ld)\n",
+	    current_position, bytes, current_buffer_size);
+	return (status = CMS_UPDATE_ERROR);
+    }
+
+    unsigned char *wire = current_buffer + current_position;
+    unsigned char *host = (unsigned char *) x;
+    current_position += bytes;
+
+    if (CMS_BINARY_NATIVE_ORDER && host_size == wire_size) {
+	if (encoding) {
+	    memcpy(wire, host, bytes);
+	} else {
+	    memcpy(host, wire, bytes);
+	}
+	return (status);
+    }
+
+    for (unsigned int i = 0; i < len;
+	i++, host += host_size, wire += wire_size) {
+	uint64_t v;
+	int b;
+	if (encoding) {
+	    v = load_host(host, host_size, is_signed);
+	    for (b = 0; b < wire_size; b++) {
+		wire[b] = (unsigned char) (v >> (8 * b));
+	    }
+	} else {
+	    v = 0;
+	    for (b = 0; b < wire_size; b++) {
+		v |= (uint64_t) wire[b] << (8 * b);
+	    }
+	    if (is_signed && wire_size < 8
+		&& ((v >> (8 * wire_size - 1)) & 1)) {
+		v |= ~(uint64_t) 0 << (8 * wire_size);
+	    }
+	    store_host(host, host_size, v);
+	}
+    }
+    return (status);
+}
+
+/* bool and char functions */
+
+CMS_STATUS CMS_BINARY_UPDATER::update(bool &x)
+{
+    return update_integer(&x, sizeof(bool), 1, 0, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(char &x)
+{
+    return update_integer(&x, 1, 1, 1, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(char *x, unsigned int len)
+{
+    return update_integer(x, 1, 1, 1, len);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(unsigned char &x)
+{
+    return update_integer(&x, 1, 1, 0, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(unsigned char *x, unsigned int len)
+{
+    return update_integer(x, 1, 1, 0, len);
+}
+
+/* SHORT */
+
+CMS_STATUS CMS_BINARY_UPDATER::update(short int &x)
+{
+    return update_integer(&x, sizeof(short), 2, 1, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(short *x, unsigned int len)
+{
+    return update_integer(x, sizeof(short), 2, 1, len);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(unsigned short int &x)
+{
+    return update_integer(&x, sizeof(unsigned short), 2, 0, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(unsigned short *x, unsigned int len)
+{
+    return update_integer(x, sizeof(unsigned short), 2, 0, len);
+}
+
+/* INT */
+
+CMS_STATUS CMS_BINARY_UPDATER::update(int &x)
+{
+    return update_integer(&x, sizeof(int), 4, 1, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(int *x, unsigned int len)
+{
+    return update_integer(x, sizeof(int), 4, 1, len);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(unsigned int &x)
+{
+    return update_integer(&x, sizeof(unsigned int), 4, 0, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(unsigned int *x, unsigned int len)
+{
+    return update_integer(x, sizeof(unsigned int), 4, 0, len);
+}
+
+/* LONG */
+
+CMS_STATUS CMS_BINARY_UPDATER::update(long int &x)
+{
+    return update_integer(&x, sizeof(long), 8, 1, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(long *x, unsigned int len)
+{
+    return update_integer(x, sizeof(long), 8, 1, len);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(unsigned long int &x)
+{
+    return update_integer(&x, sizeof(unsigned long), 8, 0, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(unsigned long *x, unsigned int len)
+{
+    return update_integer(x, sizeof(unsigned long), 8, 0, len);
+}
+
+/* FLOAT */
+
+CMS_STATUS CMS_BINARY_UPDATER::update(float &x)
+{
+    return update_integer(&x, sizeof(float), 4, 0, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(float *x, unsigned int len)
+{
+    return update_integer(x, sizeof(float), 4, 0, len);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(double &x)
+{
+    return update_integer(&x, sizeof(double), 8, 0, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(double *x, unsigned int len)
+{
+    return update_integer(x, sizeof(double), 8, 0, len);
+}
+
+/* Long doubles are sent as doubles, as with XDR. */
+CMS_STATUS CMS_BINARY_UPDATER::update(long double &x)
+{
+    return update(&x, 1);
+}
+
+CMS_STATUS CMS_BINARY_UPDATER::update(long double *x, unsigned int len)
+{
+    if (-1 == check_pointer((char *) x, len * sizeof(long double))) {
+	return (CMS_UPDATE_ERROR);
+    }
+    for (unsigned int i = 0; i < len; i++) {
+	double y = (double) x[i];
+	if (transfer(&y, sizeof(double), 8, 0, 1) < 0) {
+	    return (CMS_UPDATE_ERROR);
+	}
+	x[i] = (long double) y;
+    }
+    return (status);
+}
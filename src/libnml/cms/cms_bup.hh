@@ -0,0 +1,67 @@
+/********************************************************************
+* Description: cms_bup.hh
+*   CMS updater for a fixed-layout little endian binary encoding.
+*   Every field has the same size and position regardless of host:
+*   char/bool 1 byte, short 2, int 4, long 8, float 4, double and
+*   long double 8.  On little endian hosts arrays of natively sized
+*   types are copied with a single memcpy.
+*
+* Author:
+* License: LGPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+*
+* Last change:
+********************************************************************/
+
+#ifndef CMS_BUP_HH
+#define CMS_BUP_HH
+
+#include "cms_up.hh"		/* class CMS_UPDATER */
+
+class CMS_BINARY_UPDATER:public CMS_UPDATER {
+  public:
+    CMS_STATUS update(bool &x);
+    CMS_STATUS update(char &x);
+    CMS_STATUS update(unsigned char &x);
+    CMS_STATUS update(short int &x);
+    CMS_STATUS update(unsigned short int &x);
+    CMS_STATUS update(int &x);
+    CMS_STATUS update(unsigned int &x);
+    CMS_STATUS update(long int &x);
+    CMS_STATUS update(unsigned long int &x);
+    CMS_STATUS update(float &x);
+    CMS_STATUS update(double &x);
+    CMS_STATUS update(long double &x);
+    CMS_STATUS update(char *x, unsigned int len);
+    CMS_STATUS update(unsigned char *x, unsigned int len);
+    CMS_STATUS update(short *x, unsigned int len);
+    CMS_STATUS update(unsigned short *x, unsigned int len);
+    CMS_STATUS update(int *x, unsigned int len);
+    CMS_STATUS update(unsigned int *x, unsigned int len);
+    CMS_STATUS update(long *x, unsigned int len);
+    CMS_STATUS update(unsigned long *x, unsigned int len);
+    CMS_STATUS update(float *x, unsigned int len);
+    CMS_STATUS update(double *x, unsigned int len);
+    CMS_STATUS update(long double *x, unsigned int len);
+    int set_mode(CMS_UPDATER_MODE);
+    void rewind();
+    int get_encoded_msg_size();
+
+  protected:
+      CMS_BINARY_UPDATER(CMS *);
+      virtual ~ CMS_BINARY_UPDATER();
+    friend class CMS;
+
+    CMS_STATUS update_integer(void *x, int host_size, int wire_size,
+	int is_signed, unsigned int len);
+    CMS_STATUS transfer(void *x, int host_size, int wire_size,
+	int is_signed, unsigned int len);
+    unsigned char *current_buffer;	/* encoded data or header */
+    long current_buffer_size;
+    long current_position;
+};
+
+#endif
+// !defined(CMS_BUP_HH)
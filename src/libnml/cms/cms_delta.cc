@@ -0,0 +1,148 @@
+/********************************************************************
+* Description: cms_delta.cc
+*   Encode and apply the delta frames used by remote reads on buffers
+*   configured with "delta".
+*
+* Author:
+* License: LGPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+*
+* Last change:
+********************************************************************/
+
+extern "C" {
+#include <string.h>		/* memcpy(), memcmp() */
+#include <stdint.h>		/* uint32_t */
+}
+
+#include "cms_delta.hh"
+
+/* Changed ranges closer together than this are sent as one, since each
+   range costs 8 bytes of offset and length. */
+#define CMS_DELTA_MIN_GAP 8
+
+static void put_word(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char) (v >> 24);
+    p[1] = (unsigned char) (v >> 16);
+    p[2] = (unsigned char) (v >> 8);
+    p[3] = (unsigned char) v;
+}
+
+static uint32_t get_word(const unsigned char *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+	((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static long encode_full(unsigned char *frame, unsigned long generation,
+    const unsigned char *data, long size)
+{
+    put_word(frame, CMS_DELTA_FRAME_FULL);
+    put_word(frame + 4, (uint32_t) generation);
+    put_word(frame + 8, (uint32_t) size);
+    memcpy(frame + CMS_DELTA_FRAME_HEADER_SIZE, data, size);
+    return CMS_DELTA_FRAME_HEADER_SIZE + size;
+}
+
+long cms_delta_encode(unsigned char *frame, unsigned long generation,
+    const unsigned char *base, long base_size,
+    const unsigned char *data, long size)
+{
+    if (NULL == base || base_size != size) {
+	return encode_full(frame, generation, data, size);
+    }
+
+    long limit = CMS_DELTA_FRAME_HEADER_SIZE + size;
+    long pos = CMS_DELTA_FRAME_HEADER_SIZE;
+    long i = 0;
+
+    while (i < size) {
+	/* Skip unchanged data a word at a time, then bytewise. */
+	while (i + 8 <= size && !memcmp(base + i, data + i, 8)) {
+	    i += 8;
+	}
+	while (i < size && base[i] == data[i]) {
+	    i++;
+	}
+	if (i >= size) {
+	    break;
+	}
+
+	long start = i;
+	long end = i + 1;
+	long j = end;
+	while (j < size && j - end < CMS_DELTA_MIN_GAP) {
+	    if (base[j] != data[j]) {
+		end = j + 1;
+	    }
+	    j++;
+	}
+
+	long len = end - start;
+	if (pos + 8 + len >= limit) {
+	    return encode_full(frame, generation, data, size);
+	}
+	put_word(frame + pos, (uint32_t) start);
+	put_word(frame + pos + 4, (uint32_t) len);
+	memcpy(frame + pos + 8, data + start, len);
+	pos += 8 + len;
+	i = j;
+    }
+
+    put_word(frame, CMS_DELTA_FRAME_RANGES);
+    put_word(frame + 4, (uint32_t) generation);
+    put_word(frame + 8, (uint32_t) size);
+    return pos;
+}
+
+long cms_delta_apply(unsigned char *base, long base_capacity,
+    const unsigned char *frame, long frame_size, unsigned long *generation)
+{
+    if (frame_size < CMS_DELTA_FRAME_HEADER_SIZE) {
+	return -1;
+    }
+
+    uint32_t kind = get_word(frame);
+    long size = (long) get_word(frame + 8);
+    const unsigned char *p = frame + CMS_DELTA_FRAME_HEADER_SIZE;
+    const unsigned char *frame_end = frame + frame_size;
+
+    if (size > base_capacity) {
+	return -1;
+    }
+
+    switch (kind) {
+    case CMS_DELTA_FRAME_FULL:
+	if (frame_end - p != size) {
+	    return -1;
+	}
+	memcpy(base, p, size);
+	break;
+
+    case CMS_DELTA_FRAME_RANGES:
+	while (p < frame_end) {
+	    if (frame_end - p < 8) {
+		return -1;
+	    }
+	    uint32_t offset = get_word(p);
+	    uint32_t len = get_word(p + 4);
+	    p += 8;
+	    if ((long) len > frame_end - p || offset > (uint32_t) size
+		|| len > (uint32_t) size - offset) {
+		return -1;
+	    }
+	    memcpy(base + offset, p, len);
+	    p += len;
+	}
+	break;
+
+    default:
+	return -1;
+    }
+
+    *generation = get_word(frame + 4);
+    return size;
+}
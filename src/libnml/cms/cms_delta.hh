@@ -0,0 +1,47 @@
+/********************************************************************
+* Description: cms_delta.hh
+*   Delta frames for remote reads.  A frame carries either a whole
+*   encoded message or only the byte ranges that differ from the
+*   previous message sent to the same client.
+*
+*   Frame layout (all words big endian):
+*     kind (0 = full, 1 = ranges), generation, full size
+*     full:   the encoded message
+*     ranges: repeated { offset, length, bytes }
+*
+* Author:
+* License: LGPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+*
+* Last change:
+********************************************************************/
+
+#ifndef CMS_DELTA_HH
+#define CMS_DELTA_HH
+
+#define CMS_DELTA_FRAME_HEADER_SIZE 12
+
+#define CMS_DELTA_FRAME_FULL 0
+#define CMS_DELTA_FRAME_RANGES 1
+
+/* Encode 'data' into 'frame', which must hold at least
+   CMS_DELTA_FRAME_HEADER_SIZE + 'size' bytes.  When 'base' is not NULL
+   and has the same size the frame lists only the changed ranges, unless
+   that would not be smaller than sending everything.  Returns the frame
+   length. */
+extern long cms_delta_encode(unsigned char *frame, unsigned long generation,
+    const unsigned char *base, long base_size,
+    const unsigned char *data, long size);
+
+/* Apply 'frame' to 'base', which holds the previous message and has room
+   for 'base_capacity' bytes.  Stores the generation of the frame in
+   '*generation' and returns the new message size, or -1 if the frame is
+   malformed. */
+extern long cms_delta_apply(unsigned char *base, long base_capacity,
+    const unsigned char *frame, long frame_size,
+    unsigned long *generation);
+
+#endif
+// !defined(CMS_DELTA_HH)
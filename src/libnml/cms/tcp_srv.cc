@@ -56,6 +56,7 @@ extern "C" {
 #include "sendn.h"		/* sendn() */
 }
 #include "physmem.hh"           // PHYSMEM_HANDLE
+#include "cms_delta.hh"		/* cms_delta_encode() */
 
 int tcpsvr_threads_created = 0;
 int tcpsvr_threads_killed = 0;
@@ -152,12 +153,18 @@ CMS_SERVER_REMOTE_PORT(_cms_server)
     select_timeout.tv_usec = 30;
     subscription_buffers = NULL;
     current_poll_interval_millis = 30000;
+    delta_frame = NULL;
+    delta_frame_size = 0;
     memset(&read_fd_set, 0, sizeof(read_fd_set));
     memset(&write_fd_set, 0, sizeof(write_fd_set));
 }
 
 CMS_SERVER_REMOTE_TCP_PORT::~CMS_SERVER_REMOTE_TCP_PORT()
 {
+    if (NULL != delta_frame) {
+	free(delta_frame);
+	delta_frame = NULL;
+    }
     if (client_ports == NULL) return;
     unregister_port();
     if (NULL != client_ports) {
@@ -727,6 +734,110 @@ void CMS_SERVER_REMOTE_TCP_PORT::handle_request(CLIENT_TCP_PORT *
     }
 }
 
+/* Reply to a delta read.  The client tells us the generation of the last
+   frame it applied; if that is still our base for this client and buffer,
+   only the byte ranges that changed since are sent. */
+void CMS_SERVER_REMOTE_TCP_PORT::send_delta_read_reply(CLIENT_TCP_PORT *
+    _client_tcp_port, CMS_SERVER * server, long buffer_number,
+    unsigned long client_generation)
+{
+    REMOTE_READ_REPLY *reply = server->read_reply;
+
+    if (NULL == reply) {
+	rcs_print_error("Server could not process request.\n");
+	putbe32(temp_buffer, _client_tcp_port->serial_number);
+	putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
+	putbe32(temp_buffer + 8, 0);
+	putbe32(temp_buffer + 12, 0);
+	putbe32(temp_buffer + 16, 0);
+	sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
+	return;
+    }
+
+    long frame_length = 0;
+    if (reply->size > 0 && NULL != reply->data) {
+	if (NULL == _client_tcp_port->delta_bases) {
+	    _client_tcp_port->delta_bases = new LinkedList;
+	}
+	TCP_DELTA_BASE *base =
+	    (TCP_DELTA_BASE *) _client_tcp_port->delta_bases->get_head();
+	while (NULL != base && base->buffer_number != buffer_number) {
+	    base =
+		(TCP_DELTA_BASE *) _client_tcp_port->delta_bases->get_next();
+	}
+	if (NULL == base) {
+	    base = new TCP_DELTA_BASE;
+	    base->buffer_number = buffer_number;
+	    _client_tcp_port->delta_bases->store_at_tail(base,
+		sizeof(*base), 0);
+	}
+
+	if (delta_frame_size < reply->size + CMS_DELTA_FRAME_HEADER_SIZE) {
+	    free(delta_frame);
+	    delta_frame_size = reply->size + CMS_DELTA_FRAME_HEADER_SIZE;
+	    delta_frame = (unsigned char *) malloc(delta_frame_size);
+	}
+	if (base->capacity < reply->size) {
+	    free(base->data);
+	    base->capacity = reply->size;
+	    base->data = (unsigned char *) malloc(base->capacity);
+	    base->generation = 0;
+	}
+	if (NULL == delta_frame || NULL == base->data) {
+	    rcs_print_error("TCPSVR: Can't allocate %d bytes for delta.\n",
+		reply->size);
+	    delta_frame_size = 0;
+	    base->capacity = 0;
+	    base->generation = 0;
+	    putbe32(temp_buffer, _client_tcp_port->serial_number);
+	    putbe32(temp_buffer + 4, CMS_SERVER_SIDE_ERROR);
+	    putbe32(temp_buffer + 8, 0);
+	    putbe32(temp_buffer + 12, 0);
+	    putbe32(temp_buffer + 16, 0);
+	    sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0, dtimeout);
+	    return;
+	}
+
+	int have_base = (client_generation != 0
+	    && client_generation == base->generation);
+	/* 0 means "no base", skip it on wraparound */
+	base->generation = (base->generation + 1) & 0xFFFFFFFFUL;
+	if (0 == base->generation) {
+	    base->generation = 1;
+	}
+	frame_length = cms_delta_encode(delta_frame, base->generation,
+	    have_base ? base->data : NULL, base->size,
+	    (const unsigned char *) reply->data, reply->size);
+	memcpy(base->data, reply->data, reply->size);
+	base->size = reply->size;
+    }
+
+    putbe32(temp_buffer, _client_tcp_port->serial_number);
+    putbe32(temp_buffer + 4, reply->status);
+    putbe32(temp_buffer + 8, frame_length);
+    putbe32(temp_buffer + 12, reply->write_id);
+    putbe32(temp_buffer + 16, reply->was_read);
+    if (frame_length > 0 && frame_length < (0x2000 - 20)) {
+	memcpy(temp_buffer + 20, delta_frame, frame_length);
+	if (sendn(_client_tcp_port->socket_fd, temp_buffer,
+		20 + frame_length, 0, dtimeout) < 0) {
+	    _client_tcp_port->errors++;
+	}
+	return;
+    }
+    if (sendn(_client_tcp_port->socket_fd, temp_buffer, 20, 0,
+	    dtimeout) < 0) {
+	_client_tcp_port->errors++;
+	return;
+    }
+    if (frame_length > 0) {
+	if (sendn(_client_tcp_port->socket_fd, delta_frame, frame_length, 0,
+		dtimeout) < 0) {
+	    _client_tcp_port->errors++;
+	}
+    }
+}
+
 void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
     _client_tcp_port,
     CMS_SERVER * server,
@@ -1179,6 +1290,28 @@ void CMS_SERVER_REMOTE_TCP_PORT::switch_function(CLIENT_TCP_PORT *
 	}
 	break;
 
+    case REMOTE_CMS_READ_DELTA_REQUEST_TYPE:
+	if (recvn
+	    (_client_tcp_port->socket_fd,
+		(char *) (((uint32_t *) temp_buffer) + 5), 4, 0, -1,
+		NULL) < 0) {
+	    rcs_print_error
+		("Can not read from client port (%d) from %s\n",
+		_client_tcp_port->socket_fd,
+		inet_ntoa(_client_tcp_port->address.sin_addr));
+	    _client_tcp_port->errors++;
+	    return;
+	}
+	server->read_req.buffer_number = buffer_number;
+	server->read_req.access_type = ntohl(*((uint32_t *) temp_buffer + 3));
+	server->read_req.last_id_read = ntohl(*((uint32_t *) temp_buffer + 4));
+	server->read_req.subdiv = 0;
+	server->read_reply =
+	    (REMOTE_READ_REPLY *) server->process_request(&server->read_req);
+	send_delta_read_reply(_client_tcp_port, server, buffer_number,
+	    ntohl(*((uint32_t *) temp_buffer + 5)));
+	break;
+
     case REMOTE_CMS_WRITE_REQUEST_TYPE:
 	server->write_req.buffer_number = buffer_number;
 	server->write_req.access_type = ntohl(*((uint32_t *) temp_buffer + 3));
@@ -1749,6 +1882,23 @@ TCP_BUFFER_SUBSCRIPTION_INFO::~TCP_BUFFER_SUBSCRIPTION_INFO()
     }
 }
 
+TCP_DELTA_BASE::TCP_DELTA_BASE()
+{
+    buffer_number = -1;
+    generation = 0;
+    size = 0;
+    capacity = 0;
+    data = NULL;
+}
+
+TCP_DELTA_BASE::~TCP_DELTA_BASE()
+{
+    if (NULL != data) {
+	free(data);
+	data = NULL;
+    }
+}
+
 TCP_CLIENT_SUBSCRIPTION_INFO::TCP_CLIENT_SUBSCRIPTION_INFO()
 {
     subscription_type = CMS_NO_SUBSCRIPTION;
@@ -1785,6 +1935,7 @@ CLIENT_TCP_PORT::CLIENT_TCP_PORT()
     address.sin_addr.s_addr = htonl(INADDR_ANY);
     socket_fd = -1;
     subscriptions = NULL;
+    delta_bases = NULL;
     tid = -1;
     pid = -1;
     blocking_read_req = NULL;
@@ -1809,6 +1960,15 @@ CLIENT_TCP_PORT::~CLIENT_TCP_PORT()
 	delete subscriptions;
 	subscriptions = NULL;
     }
+    if (NULL != delta_bases) {
+	TCP_DELTA_BASE *base = (TCP_DELTA_BASE *) delta_bases->get_head();
+	while (NULL != base) {
+	    delete base;
+	    base = (TCP_DELTA_BASE *) delta_bases->get_next();
+	}
+	delete delta_bases;
+	delta_bases = NULL;
+    }
 #ifdef NO_THREADS
     if (NULL != blocking_read_req) {
 	delete blocking_read_req;
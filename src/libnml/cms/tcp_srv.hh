@@ -73,6 +73,11 @@ class CMS_SERVER_REMOTE_TCP_PORT:public CMS_SERVER_REMOTE_PORT {
     void remove_subscription_client(CLIENT_TCP_PORT * clnt,
 	int buffer_number);
     void recalculate_polling_interval();
+    void send_delta_read_reply(CLIENT_TCP_PORT * _client_tcp_port,
+	CMS_SERVER * server, long buffer_number,
+	unsigned long client_generation);
+    unsigned char *delta_frame;
+    long delta_frame_size;
     void switch_function(CLIENT_TCP_PORT *
 	_client_tcp_port,
 	CMS_SERVER * server, long request_type, long buffer_number, long
@@ -104,6 +109,18 @@ class TCP_CLIENT_SUBSCRIPTION_INFO {
     CLIENT_TCP_PORT *clnt_port;
 };
 
+/* The last message sent to a client by a delta read of one buffer. */
+class TCP_DELTA_BASE {
+  public:
+    TCP_DELTA_BASE();
+    ~TCP_DELTA_BASE();
+    int buffer_number;
+    unsigned long generation;
+    long size;
+    long capacity;
+    unsigned char *data;
+};
+
 class TCPSVR_BLOCKING_READ_REQUEST;
 
 class CLIENT_TCP_PORT {
@@ -115,6 +132,7 @@ class CLIENT_TCP_PORT {
     struct sockaddr_in address;
     int socket_fd;
     LinkedList *subscriptions;
+    LinkedList *delta_bases;
     pid_t tid;
     pid_t pid;
     int blocking;
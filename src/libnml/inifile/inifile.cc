@@ -18,6 +18,9 @@
 #include <string.h>             /* strstr() */
 #include <ctype.h>              /* isspace() */
 #include <fcntl.h>
+#include <sys/stat.h>           /* fstat() */
+#include <vector>
+#include <boost/unordered_map.hpp>
 
 
 #include "config.h"
@@ -45,11 +48,52 @@ static bool check_line_endings(const char *s) {
     return false;
 }
 
+/* Every file opened in this process is parsed once into an Index, which
+   is shared by all IniFile objects reading it and rebuilt when the file's
+   size or modification time changes.  Files with constructs the index
+   does not model (ambiguous carriage returns, over-long lines, or
+   continuation lines next to a section header) are flagged scanOnly and
+   searched line by line as before. */
+struct IniFile::Index {
+    struct Entry {
+        std::string             value;
+        bool                    hasValue;
+        unsigned int            lineNo;
+    };
+
+    typedef boost::unordered_map<std::string, std::vector<size_t> > TagMap;
+
+    struct Section {
+        TagMap                  tags;
+        unsigned int            endLine;        // line that ended the section
+    };
+
+    dev_t                       dev;
+    ino_t                       ino;
+    off_t                       size;
+    struct timespec             mtime;
+    int                         refs;
+    bool                        scanOnly;
+    unsigned int                lineCount;
+    std::vector<Entry>          entries;
+    std::vector<Section>        sections;       // [0] is before any header
+    boost::unordered_map<std::string, size_t> firstSection;
+    TagMap                      all;            // for lookups without section
+    Index                       *next;
+
+    bool Matches(const struct stat &st) const {
+        return st.st_dev == dev && st.st_ino == ino && st.st_size == size
+            && st.st_mtim.tv_sec == mtime.tv_sec
+            && st.st_mtim.tv_nsec == mtime.tv_nsec;
+    }
+};
+
 IniFile::IniFile(int _errMask, FILE *_fp)
 {
     fp = _fp;
     errMask = _errMask;
     owned = false;
+    index = NULL;
 
     if(fp != NULL)
         LockFile();
@@ -89,6 +133,8 @@ IniFile::Close()
 {
     int                         rVal = 0;
 
+    Release();
+
     if(fp != NULL){
         lock.l_type = F_UNLCK;
         fcntl(fileno(fp), F_SETLKW, &lock);
@@ -190,6 +236,65 @@ IniFile::Find(double *result, StrDoublePair *pPair,
    @return pointer to the the variable after the '=' delimiter */
 const char *
 IniFile::Find(const char *_tag, const char *_section, int _num, int *lineno)
+{
+    // For exceptions.
+    lineNo = 0;
+    tag = _tag;
+    section = _section;
+    num = _num;
+
+    /* check valid file */
+    if(!CheckIfOpen())
+        return(NULL);
+
+    /* The index keys on the tag up to the first blank or '=', and on the
+       section name up to the first ']'; anything else is left to the
+       line scanner. */
+    if(!Refresh() || index->scanOnly || strpbrk(tag, " \t\r\n=")
+       || (section != NULL && strchr(section, ']')))
+        return(Scan(_tag, _section, _num, lineno));
+
+    const Index::TagMap         *tags;
+    unsigned int                endLine;
+
+    if(section != NULL){
+        boost::unordered_map<std::string, size_t>::const_iterator s =
+            index->firstSection.find(section);
+        if(s == index->firstSection.end()){
+            lineNo = index->lineCount;
+            ThrowException(ERR_SECTION_NOT_FOUND);
+            return(NULL);
+        }
+        tags = &index->sections[s->second].tags;
+        endLine = index->sections[s->second].endLine;
+    } else {
+        tags = &index->all;
+        endLine = index->lineCount;
+    }
+
+    Index::TagMap::const_iterator t = tags->find(tag);
+    size_t n = _num > 1 ? _num : 1;
+    if(t == tags->end() || t->second.size() < n){
+        lineNo = endLine;
+        ThrowException(ERR_TAG_NOT_FOUND);
+        return(NULL);
+    }
+
+    const Index::Entry &entry = index->entries[t->second[n - 1]];
+    lineNo = entry.lineNo;
+    if(!entry.hasValue){
+        ThrowException(ERR_TAG_NOT_FOUND);
+        return(NULL);
+    }
+    if (lineno)
+        *lineno = lineNo;
+    return(entry.value.c_str());
+}
+
+
+/*! Finds the nth tag in section by reading the file line by line. */
+const char *
+IniFile::Scan(const char *_tag, const char *_section, int _num, int *lineno)
 {
     // WTF, return a pointer to the middle of a local buffer?
     // FIX: this is totally non-reentrant.
@@ -416,6 +521,187 @@ IniFile::CheckIfOpen(void)
 }
 
 
+/*! Makes sure index describes the current contents of the open file,
+   sharing or rebuilding the process-wide index for it as needed.
+
+   @return false if the file can't be indexed and has to be scanned */
+bool
+IniFile::Refresh(void)
+{
+    static Index                *indexList = NULL;
+    struct stat                 st;
+
+    if(fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)){
+        Release();
+        return(false);
+    }
+
+    if(index != NULL && index->Matches(st))
+        return(true);
+    Release();
+
+    Index                       **prev = &indexList;
+    for(Index *i = indexList; i != NULL; prev = &i->next, i = i->next){
+        if(i->dev != st.st_dev || i->ino != st.st_ino)
+            continue;
+        if(i->Matches(st)){
+            i->refs++;
+            index = i;
+            return(true);
+        }
+        /* stale, drop the list's reference */
+        *prev = i->next;
+        if(--i->refs == 0)
+            delete i;
+        break;
+    }
+
+    if((index = BuildIndex()) == NULL)
+        return(false);
+    index->dev = st.st_dev;
+    index->ino = st.st_ino;
+    index->size = st.st_size;
+    index->mtime = st.st_mtim;
+    index->refs = 2;                    // the list's and ours
+    index->next = indexList;
+    indexList = index;
+
+    return(true);
+}
+
+
+void
+IniFile::Release(void)
+{
+    if(index != NULL){
+        if(--index->refs == 0)
+            delete index;
+        index = NULL;
+    }
+}
+
+
+/*! Reads the whole file into a new Index, splitting lines the same way
+   Scan() does. */
+IniFile::Index *
+IniFile::BuildIndex(void)
+{
+    char                        line[LINELEN + 2];
+    char                        eline[(LINELEN + 2) * (MAX_EXTEND_LINES + 1)];
+    char                        *elineptr = line;
+    char                        *elinenext = eline;
+    int                         extend_ct = 0;
+    bool                        prevContinued = false;
+    unsigned int                lines = 0;
+    size_t                      current = 0;
+    Index                       *idx = new Index;
+
+    idx->scanOnly = false;
+    idx->sections.resize(1);
+
+    rewind(fp);
+    while(fgets(line, LINELEN + 1, fp) != NULL){
+        if(check_line_endings(line)){
+            idx->scanOnly = true;
+            break;
+        }
+        lines++;
+
+        int newLinePos = strlen(line) - 1;
+        if(newLinePos < 0)
+            newLinePos = 0;
+        if(line[newLinePos] == '\n'){
+            line[newLinePos] = 0;
+        } else if(!feof(fp)){
+            /* longer than LINELEN, Scan() sees it as several lines */
+            idx->scanOnly = true;
+            break;
+        }
+
+        bool continued = newLinePos > 0 && line[newLinePos-1] == '\\';
+        char *physical = SkipWhite(line);
+        if(physical != NULL && physical[0] == '['
+           && (continued || prevContinued)){
+            /* Scan() finds sections without joining lines */
+            idx->scanOnly = true;
+            break;
+        }
+        prevContinued = continued;
+
+        // honor backslash (\) as line-end escape
+        if(continued){
+            newLinePos = newLinePos-1;
+            line[newLinePos] = 0;
+            if(!extend_ct)
+                elinenext = eline;
+            strncpy(elinenext, line, newLinePos);
+            elinenext = elinenext + newLinePos;
+            *elinenext = 0;
+            extend_ct++;
+            if(extend_ct > MAX_EXTEND_LINES){
+                idx->scanOnly = true;
+                break;
+            }
+            continue;
+        }
+        if(extend_ct){
+            strncpy(elinenext, line, newLinePos);
+            elinenext = elinenext + newLinePos;
+            *elinenext = 0;
+            elineptr = eline;
+        } else {
+            elineptr = line;
+        }
+        extend_ct = 0;
+
+        char *nonWhite = SkipWhite(elineptr);
+        if(nonWhite == NULL)
+            continue;
+
+        if(nonWhite[0] == '['){
+            idx->sections[current].endLine = lines;
+            current = idx->sections.size();
+            idx->sections.resize(current + 1);
+            const char *close = strchr(nonWhite, ']');
+            if(close != NULL){
+                std::string name(nonWhite + 1, close - nonWhite - 1);
+                if(idx->firstSection.find(name) == idx->firstSection.end())
+                    idx->firstSection[name] = current;
+            }
+            continue;
+        }
+
+        size_t len = strcspn(nonWhite, " \t\r\n=");
+        if(nonWhite[len] == 0)
+            continue;           // a bare word never matches a tag
+
+        Index::Entry entry;
+        char *valueString = AfterEqual(nonWhite + len);
+        entry.hasValue = valueString != NULL;
+        entry.lineNo = lines;
+        if(valueString != NULL){
+            char *endValueString = valueString + strlen(valueString) - 1;
+            while (*endValueString == ' ' || *endValueString == '\t'
+                   || *endValueString == '\r') {
+                *endValueString = 0;
+                endValueString--;
+            }
+            entry.value = valueString;
+        }
+
+        std::string key(nonWhite, len);
+        size_t n = idx->entries.size();
+        idx->entries.push_back(entry);
+        idx->sections[current].tags[key].push_back(n);
+        idx->all[key].push_back(n);
+    }
+    idx->sections[current].endLine = lines;
+    idx->lineCount = lines;
+
+    return(idx);
+}
+
+
 bool
 IniFile::LockFile(void)
 {
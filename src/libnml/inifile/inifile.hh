@@ -144,9 +144,12 @@ protected:
 
 
 private:
+    struct Index;
+
     FILE                        *fp;
     struct flock                lock;
     bool                        owned;
+    Index                       *index;
 
     Exception                   exception;
     int                         errMask;
@@ -158,9 +161,17 @@ private:
 
     bool                        CheckIfOpen(void);
     bool                        LockFile(void);
+    bool                        Refresh(void);
+    void                        Release(void);
+    Index *                     BuildIndex(void);
+    const char *                Scan(const char *tag, const char *section,
+                                     int num, int *lineno);
     void                        ThrowException(ErrorCode);
     char                        *AfterEqual(const char *string);
     char                        *SkipWhite(const char *string);
+
+                                IniFile(const IniFile &);  // not copyable
+    IniFile &                   operator=(const IniFile &);
 };
 #endif
 
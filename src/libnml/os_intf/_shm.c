@@ -33,6 +33,7 @@
 #include <sys/mman.h>
 #else
 #include <sys/shm.h>
+#include "rtapi_shmreg.h"	/* rtapi_shmget(), rtapi_shmreg_add() */
 #endif
 
 #include <string.h>
@@ -56,6 +57,7 @@ shm_t *rcs_shm_open(key_t key, size_t size, int oflag, /* int mode */ ...)
 
     int pid;
     int i;
+    int huge;
 #endif
 
     va_start(ap, oflag);
@@ -200,7 +202,7 @@ shm_t *rcs_shm_open(key_t key, size_t size, int oflag, /* int mode */ ...)
 
     shm->size = size;
 
-    if ((shm->id = shmget(key, (int) size, shmflg)) == -1) {
+    if ((shm->id = rtapi_shmget(key, (int) size, shmflg, &huge)) == -1) {
 	shm->create_errno = errno;
 	rcs_print_error("shmget(%d(0x%X),%zd,%d) failed: (errno = %d): %s\n",
 	    key, key, size, shmflg, errno, strerror(errno));
@@ -272,6 +274,7 @@ shm_t *rcs_shm_open(key_t key, size_t size, int oflag, /* int mode */ ...)
     shm->created = 1;
 #endif
     if (shm->created) {
+	rtapi_shmreg_add(key, shm->id, size, huge, "nml");
 	for (i = 0; i < 100; i++) {
 	    if (shmems_created_list[i] <= 0) {
 		shmems_created_list[i] = shm->key;
@@ -328,7 +331,8 @@ int rcs_shm_close(shm_t * shm)
 
     /* remove OS shmem if there are no attached processes */
     if (rcs_shm_nattch(shm) == 0) {
-	shmctl(shm->id, IPC_RMID, &shared_mem_info);
+	if (shmctl(shm->id, IPC_RMID, &shared_mem_info) == 0)
+	    rtapi_shmreg_remove(shm->key);
     }
 
     if (shm->created && shmems_created_list_initialized) {
@@ -380,7 +384,8 @@ int rcs_shm_delete(shm_t * shm)
     shmdt((char *) shm->addr);
 
     /* remove OS shmem regardless of whether there are attached processes */
-    shmctl(shm->id, IPC_RMID, &shared_mem_info);
+    if (shmctl(shm->id, IPC_RMID, &shared_mem_info) == 0)
+	rtapi_shmreg_remove(shm->key);
 #endif
 
     free(shm);
@@ -27,7 +27,9 @@
 #include <stdio.h>
 #include <stdarg.h>
 #endif
-#include "posemath.h"
+/* emit the out-of-line copies of the functions in posemath_inline.h */
+#define PM_INLINE
+#include "posemath_inline.h"
 
 #include "rtapi_math.h"
 #include <float.h>
@@ -93,23 +95,7 @@ void pmPerror(const char *s)
 
 /* Pose Math Basis Functions */
 
-/* Scalar functions */
-
-double pmSqrt(double x)
-{
-    if (x > 0.0) {
-	return sqrt(x);
-    }
-
-    if (x > SQRT_FUZZ) {
-	return 0.0;
-    }
-#ifdef PM_PRINT_ERROR
-    pmPrintError("sqrt of large negative number\n");
-#endif
-
-    return 0.0;
-}
+/* Scalar functions: pmSqrt() is in posemath_inline.h */
 
 /* Translation rep conversion functions */
 
@@ -773,7 +759,7 @@ int pmHomPoseConvert(PmHomogeneous const * const h, PmPose * const p)
     return pmErrno = r1;
 }
 
-/* PmCartesian functions */
+/* PmCartesian functions.  The arithmetic ones are in posemath_inline.h */
 
 int pmCartCartCompare(PmCartesian const * const v1, PmCartesian const * const v2)
 {
@@ -785,243 +771,6 @@ int pmCartCartCompare(PmCartesian const * const v1, PmCartesian const * const v2
     return 1;
 }
 
-int pmCartCartDot(PmCartesian const * const v1, PmCartesian const * const v2, double *d)
-{
-    *d = v1->x * v2->x + v1->y * v2->y + v1->z * v2->z;
-
-    return pmErrno = 0;
-}
-
-int pmCartCartMult(PmCartesian const * const v1, PmCartesian const * const v2,
-        PmCartesian * const out)
-{
-    out->x = v1->x * v2->x;
-    out->y = v1->y * v2->y;
-    out->z = v1->z * v2->z;
-
-    return pmErrno = 0;
-}
-
-int pmCartCartDiv(PmCartesian const * const v1, PmCartesian const * const v2,
-        PmCartesian * const out)
-{
-    out->x = v1->x / v2->x;
-    out->y = v1->y / v2->y;
-    out->z = v1->z / v2->z;
-
-    return pmErrno = 0;
-}
-
-int pmCartCartCross(PmCartesian const * const v1, PmCartesian const * const v2,
-        PmCartesian * const vout)
-{
-    if (vout == v1 || vout == v2) {
-        return pmErrno = PM_IMPL_ERR;
-    }
-    vout->x = v1->y * v2->z - v1->z * v2->y;
-    vout->y = v1->z * v2->x - v1->x * v2->z;
-    vout->z = v1->x * v2->y - v1->y * v2->x;
-
-    return pmErrno = 0;
-}
-
-int pmCartInfNorm(PmCartesian const * v, double * out)
-{
-    *out = fmax(fabs(v->x),fmax(fabs(v->y),fabs(v->z)));
-    return pmErrno = 0;
-}
-
-int pmCartMag(PmCartesian const * const v, double *d)
-{
-    *d = pmSqrt(pmSq(v->x) + pmSq(v->y) + pmSq(v->z));
-
-    return pmErrno = 0;
-}
-
-/** Find square of magnitude of a vector (useful for some calculations to save a sqrt).*/
-int pmCartMagSq(PmCartesian const * const v, double *d)
-{
-    *d = pmSq(v->x) + pmSq(v->y) + pmSq(v->z);
-
-    return pmErrno = 0;
-}
-
-int pmCartCartDisp(PmCartesian const * const v1, PmCartesian const * const v2,
-        double *d)
-{
-    *d = pmSqrt(pmSq(v2->x - v1->x) + pmSq(v2->y - v1->y) + pmSq(v2->z - v1->z));
-
-    return pmErrno = 0;
-}
-
-int pmCartCartAdd(PmCartesian const * const v1, PmCartesian const * const v2,
-        PmCartesian * const vout)
-{
-    vout->x = v1->x + v2->x;
-    vout->y = v1->y + v2->y;
-    vout->z = v1->z + v2->z;
-
-    return pmErrno = 0;
-}
-
-int pmCartCartSub(PmCartesian const * const v1, PmCartesian const * const v2,
-        PmCartesian * const vout)
-{
-    vout->x = v1->x - v2->x;
-    vout->y = v1->y - v2->y;
-    vout->z = v1->z - v2->z;
-
-    return pmErrno = 0;
-}
-
-int pmCartScalMult(PmCartesian const * const v1, double d, PmCartesian * const vout)
-{
-    if (v1 != vout) {
-        *vout = *v1;
-    }
-    return pmCartScalMultEq(vout, d);
-}
-
-int pmCartScalDiv(PmCartesian const * const v1, double d, PmCartesian * const vout)
-{
-    if (v1 != vout) {
-        *vout = *v1;
-    }
-    return pmCartScalDivEq(vout, d);
-}
-
-int pmCartNeg(PmCartesian const * const v1, PmCartesian * const vout)
-{
-    if (v1 != vout) {
-        *vout = *v1;
-    }
-
-    return pmCartNegEq(vout);
-}
-
-int pmCartNegEq(PmCartesian * const v1)
-{
-    v1->x = -v1->x;
-    v1->y = -v1->y;
-    v1->z = -v1->z;
-
-    return pmErrno = 0;
-}
-
-int pmCartInv(PmCartesian const * const v1, PmCartesian * const vout)
-{
-    if (v1 != vout) {
-        *vout = *v1;
-    }
-
-    return pmCartInvEq(vout);
-}
-
-int pmCartInvEq(PmCartesian * const v)
-{
-    double size_sq;
-    pmCartMagSq(v,&size_sq);
-
-    if (size_sq == 0.0) {
-#ifdef PM_PRINT_ERROR
-        pmPrintError(&"Zero vector in pmCartInv\n");
-#endif
-        return pmErrno = PM_NORM_ERR;
-    }
-
-    v->x /= size_sq;
-    v->y /= size_sq;
-    v->z /= size_sq;
-
-    return pmErrno = 0;
-}
-
-// This used to be called pmCartNorm.
-
-int pmCartUnit(PmCartesian const * const v, PmCartesian * const vout)
-{
-    if (vout != v) {
-        *vout = *v;
-    }
-    return pmCartUnitEq(vout);
-}
-
-int pmCartAbs(PmCartesian const * const v, PmCartesian * const vout)
-{
-
-    vout->x = fabs(v->x);
-    vout->y = fabs(v->y);
-    vout->z = fabs(v->z);
-
-    return pmErrno = 0;
-}
-
-/* Compound assign operator equivalent functions. These are to prevent issues with passing the same variable as both input (const) and output */
-
-int pmCartCartAddEq(PmCartesian * const v, PmCartesian const * const v_add)
-{
-    v->x += v_add->x;
-    v->y += v_add->y;
-    v->z += v_add->z;
-
-    return pmErrno = 0;
-}
-
-int pmCartCartSubEq(PmCartesian * const v, PmCartesian const * const v_sub)
-{
-    v->x -= v_sub->x;
-    v->y -= v_sub->y;
-    v->z -= v_sub->z;
-
-    return pmErrno = 0;
-}
-
-int pmCartScalMultEq(PmCartesian * const v, double d)
-{
-
-    v->x *= d;
-    v->y *= d;
-    v->z *= d;
-
-    return pmErrno = 0;
-}
-
-int pmCartScalDivEq(PmCartesian * const v, double d)
-{
-
-    if (d == 0.0) {
-#ifdef PM_PRINT_ERROR
-        pmPrintError(&"Divide by 0 in pmCartScalDiv\n");
-#endif
-
-        return pmErrno = PM_DIV_ERR;
-    }
-
-    v->x /= d;
-    v->y /= d;
-    v->z /= d;
-
-    return pmErrno = 0;
-}
-
-int pmCartUnitEq(PmCartesian * const v)
-{
-    double size = pmSqrt(pmSq(v->x) + pmSq(v->y) + pmSq(v->z));
-
-    if (size == 0.0) {
-#ifdef PM_PRINT_ERROR
-        pmPrintError("Zero vector in pmCartUnit\n");
-#endif
-        return pmErrno = PM_NORM_ERR;
-    }
-
-    v->x /= size;
-    v->y /= size;
-    v->z /= size;
-
-    return pmErrno = 0;
-}
-
 /*! \todo This is if 0'd out so we can find all the pmCartNorm calls that should
  be renamed pmCartUnit. 
  Later we'll put this back. */
@@ -1685,17 +1434,16 @@ int pmCartLineInit(PmCartLine * const line, PmCartesian const * const start, PmC
 
 int pmCartLinePoint(PmCartLine const * const line, double len, PmCartesian * const point)
 {
-    int r1 = 0, r2 = 0;
+    int r1 = 0;
 
     if (line->tmag_zero) {
         *point = line->end;
     } else {
         /* return start + len * uVec */
-        r1 = pmCartScalMult(&line->uVec, len, point);
-        r2 = pmCartCartAdd(&line->start, point, point);
+        r1 = pmCartScalMultAdd(&line->uVec, len, &line->start, point);
     }
 
-    return pmErrno = (r1 || r2) ? PM_NORM_ERR : 0;
+    return pmErrno = r1 ? PM_NORM_ERR : 0;
 }
 
 
@@ -1874,7 +1622,7 @@ int pmCircleInit(PmCircle * const circle,
   */
 int pmCirclePoint(PmCircle const * const circle, double angle, PmCartesian * const point)
 {
-    PmCartesian par, perp;
+    PmCartesian par;
     double scale;
 
 #ifdef PM_DEBUG
@@ -1889,10 +1637,9 @@ int pmCirclePoint(PmCircle const * const circle, double angle, PmCartesian * con
 
     /* compute components rel to center */
     pmCartScalMult(&circle->rTan, cos(angle), &par);
-    pmCartScalMult(&circle->rPerp, sin(angle), &perp);
 
     /* add to get radius vector rel to center */
-    pmCartCartAdd(&par, &perp, point);
+    pmCartScalMultAdd(&circle->rPerp, sin(angle), &par, point);
 
     /* get scale for spiral, helix interpolation */
     if (circle->angle == 0.0) {
@@ -1905,12 +1652,10 @@ int pmCirclePoint(PmCircle const * const circle, double angle, PmCartesian * con
 
     /* add scaled vector in radial dir for spiral */
     pmCartUnit(point, &par);
-    pmCartScalMult(&par, scale * circle->spiral, &par);
-    pmCartCartAdd(point, &par, point);
+    pmCartScalMultAdd(&par, scale * circle->spiral, point, point);
 
     /* add scaled vector in helix dir */
-    pmCartScalMult(&circle->rHelix, scale, &perp);
-    pmCartCartAdd(point, &perp, point);
+    pmCartScalMultAdd(&circle->rHelix, scale, point, point);
 
     /* add to center vector for final result */
     pmCartCartAdd(&circle->center, point, point);
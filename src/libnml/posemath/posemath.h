@@ -870,6 +870,9 @@ extern "C" {
     extern int pmCartScalDivEq(PmCartesian * const, double);
     extern int pmCartUnitEq(PmCartesian * const);
     extern int pmCartNegEq(PmCartesian * const);
+    // Fused operations
+    extern int pmCartScalMultAdd(PmCartesian const * const, double, PmCartesian const * const, PmCartesian * const);
+    extern int pmCartUnitMag(PmCartesian const * const, PmCartesian * const, double * const);
 /*! \todo Another #if 0 */
 #if 0
     extern int pmCartNorm(PmCartesian const * const v, PmCartesian * const vout);
@@ -0,0 +1,343 @@
+/********************************************************************
+* Description: posemath_inline.h
+*   Inline definitions of the PmCartesian functions declared in
+*   posemath.h, for callers that use them every servo cycle.
+*
+*   Including this header after posemath.h lets the compiler inline
+*   pmCartCartAdd(), pmCartMag(), pmCartUnitEq() and friends at the
+*   call site.  The names, arguments, return values and pmErrno
+*   behavior are those of posemath.h.  Any call the compiler chooses
+*   not to inline still goes to the out-of-line copy in _posemath.c,
+*   which is built from these same definitions.
+*
+*   Also provides two fused operations:
+*     pmCartScalMultAdd()  vout = v1 * d + v2
+*     pmCartUnitMag()      unit vector and magnitude with one sqrt
+*
+* Author:
+* License: LGPL Version 2
+* System: Linux
+*
+* Copyright (c) 2004 All rights reserved.
+*
+* Last change:
+********************************************************************/
+
+#ifndef POSEMATH_INLINE_H
+#define POSEMATH_INLINE_H
+
+#include "posemath.h"
+#include "rtapi_math.h"
+
+/* _posemath.c defines PM_INLINE as empty to emit the out-of-line
+   copies.  Everywhere else these are gnu_inline definitions, which are
+   only used for inlining and never emitted. */
+#ifndef PM_INLINE
+#define PM_INLINE extern inline __attribute__((__gnu_inline__))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+PM_INLINE double pmSqrt(double x)
+{
+    if (x > 0.0) {
+	return sqrt(x);
+    }
+
+    if (x > SQRT_FUZZ) {
+	return 0.0;
+    }
+#ifdef PM_PRINT_ERROR
+    pmPrintError("sqrt of large negative number\n");
+#endif
+
+    return 0.0;
+}
+
+PM_INLINE int pmCartCartDot(PmCartesian const * const v1, PmCartesian const * const v2, double *d)
+{
+    *d = v1->x * v2->x + v1->y * v2->y + v1->z * v2->z;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartCartMult(PmCartesian const * const v1, PmCartesian const * const v2,
+        PmCartesian * const out)
+{
+    out->x = v1->x * v2->x;
+    out->y = v1->y * v2->y;
+    out->z = v1->z * v2->z;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartCartDiv(PmCartesian const * const v1, PmCartesian const * const v2,
+        PmCartesian * const out)
+{
+    out->x = v1->x / v2->x;
+    out->y = v1->y / v2->y;
+    out->z = v1->z / v2->z;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartCartCross(PmCartesian const * const v1, PmCartesian const * const v2,
+        PmCartesian * const vout)
+{
+    if (vout == v1 || vout == v2) {
+        return pmErrno = PM_IMPL_ERR;
+    }
+    vout->x = v1->y * v2->z - v1->z * v2->y;
+    vout->y = v1->z * v2->x - v1->x * v2->z;
+    vout->z = v1->x * v2->y - v1->y * v2->x;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartInfNorm(PmCartesian const * v, double * out)
+{
+    *out = fmax(fabs(v->x),fmax(fabs(v->y),fabs(v->z)));
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartMag(PmCartesian const * const v, double *d)
+{
+    *d = pmSqrt(pmSq(v->x) + pmSq(v->y) + pmSq(v->z));
+
+    return pmErrno = 0;
+}
+
+/** Find square of magnitude of a vector (useful for some calculations to save a sqrt).*/
+PM_INLINE int pmCartMagSq(PmCartesian const * const v, double *d)
+{
+    *d = pmSq(v->x) + pmSq(v->y) + pmSq(v->z);
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartCartDisp(PmCartesian const * const v1, PmCartesian const * const v2,
+        double *d)
+{
+    *d = pmSqrt(pmSq(v2->x - v1->x) + pmSq(v2->y - v1->y) + pmSq(v2->z - v1->z));
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartCartAdd(PmCartesian const * const v1, PmCartesian const * const v2,
+        PmCartesian * const vout)
+{
+    vout->x = v1->x + v2->x;
+    vout->y = v1->y + v2->y;
+    vout->z = v1->z + v2->z;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartCartSub(PmCartesian const * const v1, PmCartesian const * const v2,
+        PmCartesian * const vout)
+{
+    vout->x = v1->x - v2->x;
+    vout->y = v1->y - v2->y;
+    vout->z = v1->z - v2->z;
+
+    return pmErrno = 0;
+}
+
+/* Compound assign operator equivalent functions. These are to prevent issues with passing the same variable as both input (const) and output */
+
+PM_INLINE int pmCartCartAddEq(PmCartesian * const v, PmCartesian const * const v_add)
+{
+    v->x += v_add->x;
+    v->y += v_add->y;
+    v->z += v_add->z;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartCartSubEq(PmCartesian * const v, PmCartesian const * const v_sub)
+{
+    v->x -= v_sub->x;
+    v->y -= v_sub->y;
+    v->z -= v_sub->z;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartScalMultEq(PmCartesian * const v, double d)
+{
+
+    v->x *= d;
+    v->y *= d;
+    v->z *= d;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartScalDivEq(PmCartesian * const v, double d)
+{
+
+    if (d == 0.0) {
+#ifdef PM_PRINT_ERROR
+        pmPrintError("Divide by 0 in pmCartScalDiv\n");
+#endif
+
+        return pmErrno = PM_DIV_ERR;
+    }
+
+    v->x /= d;
+    v->y /= d;
+    v->z /= d;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartUnitEq(PmCartesian * const v)
+{
+    double size = pmSqrt(pmSq(v->x) + pmSq(v->y) + pmSq(v->z));
+
+    if (size == 0.0) {
+#ifdef PM_PRINT_ERROR
+        pmPrintError("Zero vector in pmCartUnit\n");
+#endif
+        return pmErrno = PM_NORM_ERR;
+    }
+
+    v->x /= size;
+    v->y /= size;
+    v->z /= size;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartNegEq(PmCartesian * const v1)
+{
+    v1->x = -v1->x;
+    v1->y = -v1->y;
+    v1->z = -v1->z;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartInvEq(PmCartesian * const v)
+{
+    double size_sq;
+    pmCartMagSq(v,&size_sq);
+
+    if (size_sq == 0.0) {
+#ifdef PM_PRINT_ERROR
+        pmPrintError("Zero vector in pmCartInv\n");
+#endif
+        return pmErrno = PM_NORM_ERR;
+    }
+
+    v->x /= size_sq;
+    v->y /= size_sq;
+    v->z /= size_sq;
+
+    return pmErrno = 0;
+}
+
+PM_INLINE int pmCartScalMult(PmCartesian const * const v1, double d, PmCartesian * const vout)
+{
+    if (v1 != vout) {
+        *vout = *v1;
+    }
+    return pmCartScalMultEq(vout, d);
+}
+
+PM_INLINE int pmCartScalDiv(PmCartesian const * const v1, double d, PmCartesian * const vout)
+{
+    if (v1 != vout) {
+        *vout = *v1;
+    }
+    return pmCartScalDivEq(vout, d);
+}
+
+PM_INLINE int pmCartNeg(PmCartesian const * const v1, PmCartesian * const vout)
+{
+    if (v1 != vout) {
+        *vout = *v1;
+    }
+
+    return pmCartNegEq(vout);
+}
+
+PM_INLINE int pmCartInv(PmCartesian const * const v1, PmCartesian * const vout)
+{
+    if (v1 != vout) {
+        *vout = *v1;
+    }
+
+    return pmCartInvEq(vout);
+}
+
+// This used to be called pmCartNorm.
+
+PM_INLINE int pmCartUnit(PmCartesian const * const v, PmCartesian * const vout)
+{
+    if (vout != v) {
+        *vout = *v;
+    }
+    return pmCartUnitEq(vout);
+}
+
+PM_INLINE int pmCartAbs(PmCartesian const * const v, PmCartesian * const vout)
+{
+
+    vout->x = fabs(v->x);
+    vout->y = fabs(v->y);
+    vout->z = fabs(v->z);
+
+    return pmErrno = 0;
+}
+
+/* Fused operations */
+
+/** vout = v1 * d + v2.  vout may be the same as v1 or v2. */
+PM_INLINE int pmCartScalMultAdd(PmCartesian const * const v1, double d,
+        PmCartesian const * const v2, PmCartesian * const vout)
+{
+    double x = v1->x * d + v2->x;
+    double y = v1->y * d + v2->y;
+    double z = v1->z * d + v2->z;
+
+    vout->x = x;
+    vout->y = y;
+    vout->z = z;
+
+    return pmErrno = 0;
+}
+
+/** Find the unit vector in the direction of v and the magnitude of v
+ * together.  On a zero vector *mag is 0 and vout is a copy of v, as with
+ * pmCartUnit.  vout may be the same as v. */
+PM_INLINE int pmCartUnitMag(PmCartesian const * const v, PmCartesian * const vout,
+        double * const mag)
+{
+    double size = pmSqrt(pmSq(v->x) + pmSq(v->y) + pmSq(v->z));
+
+    *mag = size;
+    if (vout != v) {
+        *vout = *v;
+    }
+    if (size == 0.0) {
+#ifdef PM_PRINT_ERROR
+        pmPrintError("Zero vector in pmCartUnitMag\n");
+#endif
+        return pmErrno = PM_NORM_ERR;
+    }
+
+    vout->x /= size;
+    vout->y /= size;
+    vout->z /= size;
+
+    return pmErrno = 0;
+}
+
+#ifdef __cplusplus
+}				/* matches extern "C" for C++ */
+#endif
+
+#endif				/* #ifndef POSEMATH_INLINE_H */
@@ -45,6 +45,15 @@ enum memory_order {
 #define atomic_load_explicit(obj, order) \
     ({ (void)order; __typeof__(*(obj)) v = *(obj); __sync_synchronize(); v; })
 
+#define atomic_fetch_add_explicit(obj, arg, order) \
+    ({ (void)order; __sync_fetch_and_add((obj), (arg)); })
+
+#define atomic_fetch_sub_explicit(obj, arg, order) \
+    ({ (void)order; __sync_fetch_and_sub((obj), (arg)); })
+
+#define atomic_thread_fence(order) \
+    ({ (void)order; __sync_synchronize(); (void)0; })
+
 #endif
 
 #endif
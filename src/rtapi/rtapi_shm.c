@@ -0,0 +1,73 @@
+/********************************************************************
+* Description: rtapi_shm.c
+*   Lists the shared memory segments in the registry of
+*   rtapi_shmreg.h: the segments of HAL, motion, halscope and the NML
+*   buffers, their size, whether they are backed by hugepages, which
+*   program created them and how many processes have them attached.
+*
+* License: GPL Version 2
+* System: Linux
+********************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "rtapi_shmreg.h"
+
+int main(int argc, char **argv)
+{
+    struct rtapi_shmreg *reg;
+    unsigned long total = 0, huge = 0;
+    int id, i, n = 0;
+
+    if (argc > 1) {
+	fprintf(stderr, "Usage: %s\n"
+		"Lists the shared memory segments of rtapi and NML.\n",
+		argv[0]);
+	return 1;
+    }
+    /* only look; the registry is created by the first segment */
+    id = shmget(RTAPI_SHMREG_KEY, sizeof(struct rtapi_shmreg), 0);
+    if (id == -1
+	    || (reg = (struct rtapi_shmreg *) shmat(id, 0, SHM_RDONLY))
+		== (void *) -1
+	    || reg->magic != RTAPI_SHMREG_MAGIC) {
+	printf("no segments registered\n");
+	return 0;
+    }
+
+    printf("%-10s %8s %10s %6s %6s %7s  %s\n", "KEY", "SHMID", "SIZE",
+	    "PAGES", "NATTCH", "CREATOR", "OWNER");
+    for (i = 0; i < RTAPI_SHMREG_MAX; i++) {
+	struct rtapi_shmreg_entry e = reg->entries[i];
+	struct shmid_ds ds;
+	char nattch[16];
+
+	/* an entry whose creator died without removing the segment
+	   stays until the key is used again; skip it when the segment
+	   is gone or is another one now */
+	if (!e.used)
+	    continue;
+	if (shmctl(e.id, IPC_STAT, &ds) == 0) {
+	    if (ds.shm_perm.__key != e.key)
+		continue;
+	    snprintf(nattch, sizeof(nattch), "%lu",
+		    (unsigned long) ds.shm_nattch);
+	} else if (errno == EACCES) {
+	    strcpy(nattch, "?");
+	} else {
+	    continue;
+	}
+	printf("0x%08x %8d %10lu %6s %6s %7d  %s\n", (unsigned) e.key, e.id,
+		e.size, e.huge ? "huge" : "normal", nattch, e.pid, e.owner);
+	total += e.size;
+	if (e.huge)
+	    huge += e.size;
+	n++;
+    }
+    printf("%d segments, %lu bytes, %lu of them on hugepages\n", n, total,
+	    huge);
+    shmdt(reg);
+    return 0;
+}
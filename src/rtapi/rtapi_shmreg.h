@@ -0,0 +1,226 @@
+/********************************************************************
+* Description: rtapi_shmreg.h
+*   Hugepage backing and a registry for the System V shared memory
+*   segments that uspace rtapi and libnml create.
+*
+*   When the environment variable RTAPI_HUGEPAGES is set to a nonzero
+*   number, a segment of at least RTAPI_HUGEPAGE_MIN bytes is created
+*   with SHM_HUGETLB, so that the realtime threads walking through HAL
+*   or the motion struct take one TLB entry per 2MB instead of one per
+*   4kB.  NML buffers are mostly smaller than that; with
+*   RTAPI_HUGEPAGES=all every segment gets hugepages, at the cost of a
+*   whole hugepage each.  When no hugepages are reserved
+*   (/proc/sys/vm/nr_hugepages) or the process may not use them
+*   (/proc/sys/vm/hugetlb_shm_group), the segment is created with
+*   normal pages as before.  Processes that attach a segment by key do
+*   not need to know how it was created.
+*
+*   Every segment created is entered in a small registry segment of
+*   its own, with its size, whether it got hugepages and the program
+*   that created it; 'rtapi_shm' lists it.
+*
+*   This is a header of static inline functions, like rtapi_mutex.h,
+*   so it can be used from both the rtapi and the libnml code without
+*   a library of its own.
+*
+* License: GPL Version 2
+* System: Linux
+********************************************************************/
+#ifndef RTAPI_SHMREG_H
+#define RTAPI_SHMREG_H
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#define RTAPI_SHMREG_KEY	0x53484d52	/* "SHMR" */
+#define RTAPI_SHMREG_MAGIC	0x52454731
+#define RTAPI_SHMREG_MAX	128
+
+/* the smallest segment put on hugepages: 64 normal pages, like the
+   HAL segment, already take a good part of the TLB */
+#define RTAPI_HUGEPAGE_MIN	(256 * 1024)
+
+struct rtapi_shmreg_entry {
+    int used;
+    int key;
+    int id;			/* shmid */
+    int huge;			/* created with SHM_HUGETLB */
+    unsigned long size;		/* as asked for */
+    int pid;			/* of the creator */
+    char owner[36];		/* "rtapi" or "nml", and the program */
+};
+
+struct rtapi_shmreg {
+    int magic;
+    int lock;
+    struct rtapi_shmreg_entry entries[RTAPI_SHMREG_MAX];
+};
+
+/* The size of a hugepage in bytes, or 0 if the kernel has none. */
+static inline unsigned long rtapi_shm_hugepage_size(void)
+{
+    static unsigned long size = 1;	/* not read yet */
+    char line[128];
+    FILE *f;
+
+    if (size != 1)
+	return size;
+    size = 0;
+    f = fopen("/proc/meminfo", "r");
+    if (!f)
+	return size;
+    while (fgets(line, sizeof(line), f)) {
+	unsigned long kb;
+	if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+	    size = kb * 1024;
+	    break;
+	}
+    }
+    fclose(f);
+    return size;
+}
+
+/* SHM_HUGETLB if hugepages are asked for and a segment of 'size' bytes
+   is large enough, or if they are asked for all segments, otherwise
+   0. */
+static inline int rtapi_shm_huge_flag(unsigned long size)
+{
+#ifdef SHM_HUGETLB
+    const char *e = getenv("RTAPI_HUGEPAGES");
+    unsigned long hp;
+
+    if (!e || (strcmp(e, "all") != 0 && !atoi(e)))
+	return 0;
+    hp = rtapi_shm_hugepage_size();
+    if (!hp || (size < RTAPI_HUGEPAGE_MIN && strcmp(e, "all") != 0))
+	return 0;
+    return SHM_HUGETLB;
+#else
+    (void) size;
+    return 0;
+#endif
+}
+
+/* shmget() that creates the segment with hugepages when
+   rtapi_shm_huge_flag() asks for them, and with normal pages when
+   that fails.  *huge is set to 1 if this call created the segment with
+   hugepages, otherwise to 0. */
+static inline int rtapi_shmget(key_t key, size_t size, int flags, int *huge)
+{
+    int hflag = (flags & IPC_CREAT) ? rtapi_shm_huge_flag(size) : 0;
+    int id;
+
+    *huge = 0;
+    if (hflag) {
+	/* the kernel rounds the size up to whole hugepages */
+	id = shmget(key, size, flags | IPC_EXCL | hflag);
+	if (id != -1) {
+	    *huge = 1;
+	    return id;
+	}
+	/* an existing segment is attached below as it is; ENOMEM,
+	   EPERM and EINVAL mean no hugepages for us */
+    }
+    return shmget(key, size, flags);
+}
+
+/* The registry, created on first use, or NULL. */
+static inline struct rtapi_shmreg *rtapi_shmreg_attach(void)
+{
+    static struct rtapi_shmreg *reg;
+    int id;
+    void *p;
+
+    if (reg)
+	return reg;
+    /* readable and writable by everyone, as root (rtapi_app) and the
+       user (NML) both enter segments in it */
+    id = shmget(RTAPI_SHMREG_KEY, sizeof(struct rtapi_shmreg),
+		IPC_CREAT | 0666);
+    if (id == -1)
+	return NULL;
+    p = shmat(id, 0, 0);
+    if (p == (void *) -1)
+	return NULL;
+    reg = (struct rtapi_shmreg *) p;
+    return reg;
+}
+
+static inline void rtapi_shmreg_lock(struct rtapi_shmreg *reg)
+{
+    while (__sync_lock_test_and_set(&reg->lock, 1))
+	sched_yield();
+    if (reg->magic != RTAPI_SHMREG_MAGIC) {
+	memset(reg->entries, 0, sizeof(reg->entries));
+	reg->magic = RTAPI_SHMREG_MAGIC;
+    }
+}
+
+static inline void rtapi_shmreg_unlock(struct rtapi_shmreg *reg)
+{
+    __sync_lock_release(&reg->lock);
+}
+
+/* Enter a segment this process created.  'kind' says which code
+   created it; the program name is added from /proc. */
+static inline void rtapi_shmreg_add(int key, int id, unsigned long size,
+	int huge, const char *kind)
+{
+    struct rtapi_shmreg *reg = rtapi_shmreg_attach();
+    struct rtapi_shmreg_entry *e = NULL;
+    char comm[20] = "?";
+    FILE *f;
+    int i;
+
+    if (!reg)
+	return;
+    f = fopen("/proc/self/comm", "r");
+    if (f) {
+	if (fgets(comm, sizeof(comm), f))
+	    comm[strcspn(comm, "\n")] = 0;
+	fclose(f);
+    }
+    rtapi_shmreg_lock(reg);
+    for (i = 0; i < RTAPI_SHMREG_MAX; i++) {
+	if (reg->entries[i].used && reg->entries[i].key == key) {
+	    e = &reg->entries[i];
+	    break;
+	}
+	if (!reg->entries[i].used && !e)
+	    e = &reg->entries[i];
+    }
+    if (e) {
+	e->used = 1;
+	e->key = key;
+	e->id = id;
+	e->huge = huge;
+	e->size = size;
+	e->pid = getpid();
+	snprintf(e->owner, sizeof(e->owner), "%s %s", kind, comm);
+    }
+    rtapi_shmreg_unlock(reg);
+}
+
+/* Remove a segment that was destroyed. */
+static inline void rtapi_shmreg_remove(int key)
+{
+    struct rtapi_shmreg *reg = rtapi_shmreg_attach();
+    int i;
+
+    if (!reg)
+	return;
+    rtapi_shmreg_lock(reg);
+    for (i = 0; i < RTAPI_SHMREG_MAX; i++)
+	if (reg->entries[i].used && reg->entries[i].key == key)
+	    reg->entries[i].used = 0;
+    rtapi_shmreg_unlock(reg);
+}
+
+#endif
@@ -22,6 +22,8 @@
 #endif
 #include <unistd.h>
 #include <pthread.h>
+#include <stdarg.h>
+#include <time.h>
 #include <atomic>
 
 inline void rtapi_timespec_add(timespec &result, const timespec &ta, const timespec &tb) {
@@ -111,4 +113,14 @@ T *rtapi_get_task(int task_id) {
 extern struct rtapi_task *task_array[MAX_TASKS];
 
 #define WITH_ROOT WithRoot root
+
+/* Binary message log for realtime threads, see uspace_rtapi_log.cc.
+   rtapi_log_record() returns false if the calling thread has no ring, in
+   which case the caller must format the message itself. */
+bool rtapi_log_record(int level, const char *fmt, va_list ap);
+/* Format and write out all recorded messages.  With flush, also report
+   suppressed messages whose rate limit window has not yet ended. */
+void rtapi_log_drain(bool flush = false);
+/* Write one formatted message to the output selected by $RTAPI_LOG */
+void rtapi_log_write(int level, const struct timespec &ts, const char *msg);
 #endif
@@ -0,0 +1,109 @@
+/*
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Check that messages recorded in the uspace binary log come out the same
+   as the C library would format them, and that repeated messages are
+   rate limited. */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "rtapi.h"
+#include "rtapi_uspace.hh"
+
+static std::vector<std::string> expected;
+
+static void record(bool kept, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+static void record(bool kept, const char *fmt, ...)
+{
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if(kept) expected.push_back(buf);
+
+    va_start(ap, fmt);
+    rtapi_log_record(RTAPI_MSG_ERR, fmt, ap);
+    va_end(ap);
+}
+
+#define log(...) record(true, __VA_ARGS__)
+
+int main(void)
+{
+    char path[] = "/tmp/test_rtapi_log.XXXXXX";
+    int fd = mkstemp(path);
+    if(fd < 0) { perror("mkstemp"); return 1; }
+    close(fd);
+    setenv("RTAPI_LOG", path, 1);
+
+    char name[] = "hm2_7i92.0";
+    log("plain message\n");
+    log("%d %i %u %x %X %o %c %%\n", -42, 7, 3000000000u, 0xbeef, 0xbeef, 8, 'q');
+    log("%hhd %hd %ld %lld %zu %jd %td\n", (char)-1, (short)-2, -3L, -4LL,
+        (size_t)5, (intmax_t)6, (ptrdiff_t)7);
+    log("%hhu %hu %lu %llx\n", (unsigned char)255, (unsigned short)65535,
+        4000000000ul, 0x123456789abcdefull);
+    log("%f %.3f %10.2e %-8g| %G %a\n", 3.14159, -2.5, 12345.678, 1e-5, 1e20, 0.5);
+    log("%s: |%10s|%-10s|%.3s|\n", name, "right", "left", "truncated");
+    log("%*d|%-*d|%.*f|%.*s|\n", 6, 42, 6, 42, 2, 3.14159, 4, name);
+    log("%+d % d %#x %#o %05d\n", 5, 5, 255, 8, -42);
+    log("%Lf is formatted in place\n", 1.5L);
+    log("partial line, ");
+    log("continued\n");
+
+    /* Only the first RTAPI_LOG_BURST (20) of these are kept */
+    for(int i = 0; i < 100; i++)
+        record(i < 20, "repeated message %d\n", i);
+    expected.push_back("rtapi: 80 similar messages suppressed: "
+        "\"repeated message %d\"\n");
+
+    rtapi_log_drain(true);
+
+    /* Each line of the log file starts with the date, time and level */
+    std::string want;
+    for(const std::string &e : expected) want += e;
+
+    FILE *f = fopen(path, "r");
+    if(!f) { perror(path); return 1; }
+    char line[1024];
+    size_t pos = 0;
+    int fail = 0;
+    while(fgets(line, sizeof(line), f)) {
+        const char *text = strlen(line) > 32 ? line + 32 : "";
+        size_t nl = want.find('\n', pos);
+        std::string w = want.substr(pos, nl == std::string::npos ? nl : nl - pos + 1);
+        pos = nl == std::string::npos ? want.size() : nl + 1;
+        printf("%s", text);
+        if(w != text) {
+            fail++;
+            printf("****fail**** expected %s", w.c_str());
+        }
+    }
+    fclose(f);
+    unlink(path);
+    if(pos != want.size()) {
+        fail++;
+        printf("****fail**** missing %s", want.c_str() + pos);
+    }
+    return fail ? 1 : 0;
+}
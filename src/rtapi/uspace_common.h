@@ -28,6 +28,7 @@ static int msg_level = RTAPI_MSG_ERR;	/* message printing level */
 
 #include <sys/ipc.h>		/* IPC_* */
 #include <sys/shm.h>		/* shmget() */
+#include "rtapi_shmreg.h"	/* rtapi_shmget(), rtapi_shmreg_add() */
 /* These structs hold data associated with objects like tasks, etc. */
 /* Task handles are pointers to these structs.                      */
 
@@ -58,7 +59,7 @@ int rtapi_shmem_new(int key, int module_id, unsigned long int size)
   WITH_ROOT;
 #endif
   rtapi_shmem_handle *shmem;
-  int i;
+  int i, huge;
 
   for(i=0 ; i < MAX_SHM; i++) {
     if(shmem_array[i].magic == SHMEM_MAGIC && shmem_array[i].key == key) {
@@ -75,7 +76,7 @@ int rtapi_shmem_new(int key, int module_id, unsigned long int size)
   shmem = &shmem_array[i];
 
   /* now get shared memory block from OS */
-  shmem->id = shmget((key_t) key, (int) size, IPC_CREAT | 0600);
+  shmem->id = rtapi_shmget((key_t) key, (int) size, IPC_CREAT | 0600, &huge);
   if (shmem->id == -1) {
     rtapi_print_msg(RTAPI_MSG_ERR, "rtapi_shmem_new failed due to shmget(key=0x%08x): %s\n", key, strerror(errno));
     return -errno;
@@ -85,6 +86,13 @@ int rtapi_shmem_new(int key, int module_id, unsigned long int size)
   int res = shmctl(shmem->id, IPC_STAT, &stat);
   if(res < 0) perror("shmctl IPC_STAT");
 
+  if(res == 0 && stat.shm_cpid == getpid()) {
+    if(rtapi_shm_huge_flag(size) && !huge)
+      rtapi_print_msg(RTAPI_MSG_INFO,
+          "rtapi_shmem_new: no hugepages for key 0x%08x, using normal pages\n", key);
+    rtapi_shmreg_add(key, shmem->id, size, huge, "rtapi");
+  }
+
 #ifdef RTAPI
   /* ensure the segment is owned by user, not root */
   if(geteuid() == 0) {
@@ -184,6 +192,8 @@ int rtapi_shmem_delete(int handle, int module_id)
       r2 = shmctl(shmem->id, IPC_RMID, &d);
       if (r2 != 0)
 	      rtapi_print_msg(RTAPI_MSG_ERR, "shmctl(%d, IPC_RMID, ...): %s\n", shmem->id, strerror(errno));
+      else
+	      rtapi_shmreg_remove(shmem->key);
   }
 
   /* free the shmem structure */
@@ -92,7 +92,8 @@ RtapiApp &App();
 
 struct message_t {
     msg_level_t level;
-    char msg[1024-sizeof(level)];
+    struct timespec ts;
+    char msg[1024-sizeof(level)-sizeof(ts)];
 };
 
 boost::lockfree::queue<message_t, boost::lockfree::capacity<128>>
@@ -106,8 +107,9 @@ void *queue_function(void *arg) {
     while(1) {
         pthread_testcancel();
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, nullptr);
+        rtapi_log_drain();
         rtapi_msg_queue.consume_all([](const message_t &m) {
-            fputs(m.msg, m.level == RTAPI_MSG_ALL ? stdout : stderr);
+            rtapi_log_write(m.level, m.ts, m.msg);
         });
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, nullptr);
         struct timespec ts = {0, 10000000};
@@ -311,12 +313,33 @@ static int do_unload_cmd(string name) {
         int (*stop)(void) = DLSYM<int(*)(void)>(w, "rtapi_app_exit");
 	if(stop) stop();
 	modules.erase(modules.find(name));
+        // recorded messages may point at format strings in the module
+        rtapi_log_drain(true);
         dlclose(w);
         instance_count --;
     }
     return 0;
 }
 
+/* Load several modules in one request.  Each module name is followed by
+   its parameters; "--" separates one module from the next.  Loading stops
+   at the first module that fails, and modules loaded before it stay
+   loaded, as they would have with separate load commands. */
+static int do_load_batch_cmd(vector<string> args) {
+    vector<string>::iterator it = args.begin() + 1;
+    while(it != args.end()) {
+        vector<string>::iterator end = find(it, args.end(), string("--"));
+        if(it != end) {
+            string name = *it;
+            vector<string> modargs(it, end);
+            int result = do_load_cmd(name, modargs);
+            if(result != 0) return result;
+        }
+        it = end == args.end() ? end : end + 1;
+    }
+    return 0;
+}
+
 struct ReadError : std::exception {};
 struct WriteError : std::exception {};
 
@@ -378,6 +401,8 @@ static int handle_command(vector<string> args) {
         string name = args[1];
         args.erase(args.begin());
         return do_load_cmd(name, args);
+    } else if(args.size() >= 2 && args[0] == "load-batch") {
+        return do_load_batch_cmd(args);
     } else if(args.size() == 2 && args[0] == "unload") {
         return do_unload_cmd(args[1]);
     } else if(args.size() == 3 && args[0] == "newinst") {
@@ -456,8 +481,9 @@ static int master(int fd, vector<string> args) {
 out:
     pthread_cancel(queue_thread);
     pthread_join(queue_thread, nullptr);
+    rtapi_log_drain(true);
     rtapi_msg_queue.consume_all([](const message_t &m) {
-        fputs(m.msg, m.level == RTAPI_MSG_ALL ? stdout : stderr);
+        rtapi_log_write(m.level, m.ts, m.msg);
     });
     return result;
 }
@@ -1238,10 +1264,18 @@ long long rtapi_get_time() {
 
 void default_rtapi_msg_handler(msg_level_t level, const char *fmt, va_list ap) {
     if(main_thread && pthread_self() != main_thread) {
+        if(rtapi_log_record(level, fmt, ap)) return;
         message_t m;
         m.level = level;
+        clock_gettime(CLOCK_REALTIME, &m.ts);
         vsnprintf(m.msg, sizeof(m.msg), fmt, ap);
         rtapi_msg_queue.push(m);
+    } else if(main_thread) {
+        char msg[1024];
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        vsnprintf(msg, sizeof(msg), fmt, ap);
+        rtapi_log_write(level, ts, msg);
     } else {
         vfprintf(level == RTAPI_MSG_ALL ? stdout : stderr, fmt, ap);
     }
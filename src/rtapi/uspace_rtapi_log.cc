@@ -0,0 +1,537 @@
+/*    This is a component of LinuxCNC
+ *
+ *    This program is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Binary message log for rtapi_print in realtime threads.
+ *
+ * A realtime thread that prints does not format anything.  It stores the
+ * format pointer, the raw argument values and copies of any %s strings in
+ * a record on its own single-producer ring, then returns.  The queue
+ * thread in rtapi_app drains all the rings, formats the records with the
+ * C library printf and writes them to stdout/stderr, syslog or a file.
+ *
+ * Each ring also rate limits: at most RTAPI_LOG_BURST messages with the
+ * same format are kept per second, and the number suppressed is reported
+ * once the second is over.
+ *
+ * Because records refer to format strings inside the loaded modules, the
+ * rings must be drained before a module is unloaded.
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "rtapi.h"
+#include "rtapi_uspace.hh"
+
+namespace
+{
+const unsigned RTAPI_LOG_RINGS = 16;
+const unsigned RTAPI_LOG_RECORDS = 64;     /* per ring, power of 2 */
+const unsigned RTAPI_LOG_MAXARGS = 16;
+const unsigned RTAPI_LOG_STRINGS = 856;
+const unsigned RTAPI_LOG_RATE_SLOTS = 16;  /* power of 2 */
+const unsigned RTAPI_LOG_BURST = 20;
+const long long RTAPI_LOG_WINDOW = 1000000000LL;
+
+union log_arg {
+    long long i;
+    unsigned long long u;
+    double d;
+    const void *p;
+    unsigned s;                 /* offset into strings */
+};
+
+struct log_record {
+    const char *fmt;            /* NULL: strings holds the formatted text */
+    struct timespec ts;
+    int level;
+    unsigned nargs;
+    log_arg args[RTAPI_LOG_MAXARGS];
+    char strings[RTAPI_LOG_STRINGS];
+};
+
+static_assert(sizeof(log_record) <= 1024, "log_record grew past 1k");
+
+struct rate_slot {
+    std::atomic<const char *> fmt;
+    std::atomic<long long> window_start;
+    unsigned count;                     /* producer only */
+    std::atomic<unsigned> suppressed;
+};
+
+struct log_ring {
+    std::atomic<unsigned> head;         /* written by the producer */
+    std::atomic<unsigned> tail;         /* written by the drain */
+    std::atomic<unsigned> dropped;
+    rate_slot rate[RTAPI_LOG_RATE_SLOTS];
+    log_record records[RTAPI_LOG_RECORDS];
+};
+
+log_ring rings[RTAPI_LOG_RINGS];
+std::atomic<unsigned> rings_used{0};
+thread_local int thread_ring = -1;
+
+std::mutex drain_mutex;
+std::mutex output_mutex;
+
+enum arg_kind { ARG_NONE, ARG_SIGNED, ARG_UNSIGNED, ARG_DOUBLE,
+    ARG_STRING, ARG_POINTER, ARG_PERCENT, ARG_BAD };
+
+/* One conversion specification of a printf format, as far as this log
+   needs to understand it. */
+struct conv_spec {
+    const char *start, *end;    /* from the '%' to after the conversion */
+    bool star_width, star_precision;
+    int precision;              /* -1 if none was given */
+    char length;                /* 'H' hh, 'h', 'l', 'q' ll, 'z', 'j', 't', 'L' */
+    char conv;
+    arg_kind kind;
+};
+
+const char *parse_conv(const char *p, conv_spec &c)
+{
+    c.start = p++;
+    c.star_width = c.star_precision = false;
+    c.length = 0;
+    c.precision = -1;
+    while(*p && strchr("-+ #0'", *p)) p++;
+    if(*p == '*') { c.star_width = true; p++; }
+    else while(*p >= '0' && *p <= '9') p++;
+    if(*p == '.') {
+        p++;
+        if(*p == '*') { c.star_precision = true; p++; }
+        else for(c.precision = 0; *p >= '0' && *p <= '9'; p++)
+            c.precision = c.precision * 10 + *p - '0';
+    }
+    switch(*p) {
+    case 'h':
+        p++;
+        if(*p == 'h') { c.length = 'H'; p++; } else c.length = 'h';
+        break;
+    case 'l':
+        p++;
+        if(*p == 'l') { c.length = 'q'; p++; } else c.length = 'l';
+        break;
+    case 'z': case 'j': case 't': case 'L':
+        c.length = *p++;
+        break;
+    }
+    c.conv = *p;
+    switch(*p) {
+    case 'd': case 'i':
+        c.kind = ARG_SIGNED; break;
+    case 'u': case 'o': case 'x': case 'X':
+        c.kind = ARG_UNSIGNED; break;
+    case 'c':
+        c.kind = c.length ? ARG_BAD : ARG_SIGNED; break;
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A':
+        c.kind = c.length == 'L' ? ARG_BAD : ARG_DOUBLE; break;
+    case 's':
+        c.kind = c.length ? ARG_BAD : ARG_STRING; break;
+    case 'p':
+        c.kind = ARG_POINTER; break;
+    case '%':
+        c.kind = ARG_PERCENT; break;
+    default:
+        c.kind = ARG_BAD;
+    }
+    if(*p) p++;
+    c.end = p;
+    return p;
+}
+
+long long read_signed(char length, va_list &ap)
+{
+    switch(length) {
+    case 'H': return (signed char)va_arg(ap, int);
+    case 'h': return (short)va_arg(ap, int);
+    case 'l': return va_arg(ap, long);
+    case 'q': return va_arg(ap, long long);
+    case 'z': return va_arg(ap, ssize_t);
+    case 'j': return va_arg(ap, intmax_t);
+    case 't': return va_arg(ap, ptrdiff_t);
+    default: return va_arg(ap, int);
+    }
+}
+
+unsigned long long read_unsigned(char length, va_list &ap)
+{
+    switch(length) {
+    case 'H': return (unsigned char)va_arg(ap, unsigned);
+    case 'h': return (unsigned short)va_arg(ap, unsigned);
+    case 'l': return va_arg(ap, unsigned long);
+    case 'q': return va_arg(ap, unsigned long long);
+    case 'z': return va_arg(ap, size_t);
+    case 'j': return va_arg(ap, uintmax_t);
+    case 't': return va_arg(ap, ptrdiff_t);
+    default: return va_arg(ap, unsigned);
+    }
+}
+
+/* Store the arguments of fmt in r.  Returns false if the format uses
+   something that cannot be stored, in which case the caller formats the
+   message in place instead. */
+bool capture_args(log_record &r, const char *fmt, va_list &ap)
+{
+    unsigned n = 0, used = 0;
+    const char *p = fmt;
+    while((p = strchr(p, '%'))) {
+        conv_spec c;
+        p = parse_conv(p, c);
+        if(c.kind == ARG_PERCENT) continue;
+        if(c.kind == ARG_BAD) return false;
+        if(n + c.star_width + c.star_precision + 1 > RTAPI_LOG_MAXARGS)
+            return false;
+        if(c.star_width) r.args[n++].i = va_arg(ap, int);
+        if(c.star_precision) c.precision = r.args[n++].i = va_arg(ap, int);
+        log_arg &a = r.args[n++];
+        switch(c.kind) {
+        case ARG_SIGNED: a.i = read_signed(c.length, ap); break;
+        case ARG_UNSIGNED: a.u = read_unsigned(c.length, ap); break;
+        case ARG_DOUBLE: a.d = va_arg(ap, double); break;
+        case ARG_POINTER: a.p = va_arg(ap, void *); break;
+        case ARG_STRING: {
+            const char *s = va_arg(ap, const char *);
+            if(!s) s = "(null)";
+            size_t len = strnlen(s, c.precision >= 0 ?
+                std::min((unsigned)c.precision, RTAPI_LOG_STRINGS) :
+                RTAPI_LOG_STRINGS);
+            if(used + len + 1 > RTAPI_LOG_STRINGS) return false;
+            memcpy(r.strings + used, s, len);
+            r.strings[used + len] = 0;
+            a.s = used;
+            used += len + 1;
+            break;
+        }
+        default: break;
+        }
+    }
+    r.nargs = n;
+    return true;
+}
+
+void append_format(std::string &out, const char *spec, ...)
+    __attribute__((format(printf, 2, 3)));
+
+void append_format(std::string &out, const char *spec, ...)
+{
+    char buf[256];
+    va_list ap;
+    va_start(ap, spec);
+    int len = vsnprintf(buf, sizeof(buf), spec, ap);
+    va_end(ap);
+    if(len < 0) return;
+    if((size_t)len < sizeof(buf)) { out.append(buf, len); return; }
+    std::vector<char> big(len + 1);
+    va_start(ap, spec);
+    vsnprintf(big.data(), big.size(), spec, ap);
+    va_end(ap);
+    out.append(big.data(), len);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+std::string format_record(const log_record &r)
+{
+    if(!r.fmt) return std::string(r.strings);
+
+    std::string out;
+    const char *p = r.fmt;
+    unsigned n = 0;
+    while(*p) {
+        const char *q = strchr(p, '%');
+        if(!q) { out.append(p); break; }
+        out.append(p, q - p);
+
+        conv_spec c;
+        p = parse_conv(q, c);
+        if(c.kind == ARG_PERCENT) { out.push_back('%'); continue; }
+
+        /* Rebuild the specification with any '*' replaced by its value and
+           the length modifier replaced by the one the stored value has. */
+        std::string spec;
+        for(const char *s = c.start; s < c.end - 1; s++) {
+            if(*s == '*') spec += std::to_string(r.args[n++].i);
+            else if(!strchr("hlzjtL", *s)) spec.push_back(*s);
+        }
+        const log_arg &a = r.args[n++];
+        switch(c.kind) {
+        case ARG_SIGNED:
+            if(c.conv == 'c') {
+                spec.push_back('c');
+                append_format(out, spec.c_str(), (int)a.i);
+            } else {
+                spec += "ll"; spec.push_back(c.conv);
+                append_format(out, spec.c_str(), a.i);
+            }
+            break;
+        case ARG_UNSIGNED:
+            spec += "ll"; spec.push_back(c.conv);
+            append_format(out, spec.c_str(), a.u);
+            break;
+        case ARG_DOUBLE:
+            spec.push_back(c.conv);
+            append_format(out, spec.c_str(), a.d);
+            break;
+        case ARG_POINTER:
+            spec.push_back('p');
+            append_format(out, spec.c_str(), a.p);
+            break;
+        case ARG_STRING:
+            spec.push_back('s');
+            append_format(out, spec.c_str(), r.strings + a.s);
+            break;
+        default:
+            break;
+        }
+    }
+    return out;
+}
+#pragma GCC diagnostic pop
+
+/* Returns true if this message is within the burst for its format. */
+bool rate_check(log_ring &ring, const char *fmt, long long now)
+{
+    size_t h = ((uintptr_t)fmt >> 3) * 0x9e3779b97f4a7c15ull >> 40;
+    rate_slot &s = ring.rate[h & (RTAPI_LOG_RATE_SLOTS - 1)];
+    if(s.fmt.load(std::memory_order_relaxed) != fmt) {
+        /* The slot is shared with another format; only take it over once
+           its suppressed count has been reported. */
+        if(s.suppressed.load(std::memory_order_acquire)) return true;
+        s.fmt.store(fmt, std::memory_order_relaxed);
+        s.window_start.store(now, std::memory_order_relaxed);
+        s.count = 1;
+        return true;
+    }
+    if(now - s.window_start.load(std::memory_order_relaxed) >= RTAPI_LOG_WINDOW
+            && !s.suppressed.load(std::memory_order_acquire)) {
+        s.window_start.store(now, std::memory_order_relaxed);
+        s.count = 1;
+        return true;
+    }
+    if(s.count < RTAPI_LOG_BURST) {
+        s.count++;
+        return true;
+    }
+    s.suppressed.fetch_add(1, std::memory_order_release);
+    return false;
+}
+
+long long to_ns(const struct timespec &ts)
+{
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct log_output {
+    enum { STDIO, SYSLOG, LOGFILE } kind;
+    ::FILE *f;
+    bool line_start;
+};
+
+log_output &output()
+{
+    static log_output out = [] {
+        log_output o{log_output::STDIO, nullptr, true};
+        const char *dest = getenv("RTAPI_LOG");
+        if(!dest || !*dest) return o;
+        if(!strcmp(dest, "syslog")) {
+            openlog("rtapi_app", LOG_PID, LOG_USER);
+            o.kind = log_output::SYSLOG;
+            return o;
+        }
+        o.f = fopen(dest, "a");
+        if(!o.f) {
+            fprintf(stderr, "rtapi_app: RTAPI_LOG: %s: %s\n", dest,
+                strerror(errno));
+            return o;
+        }
+        setvbuf(o.f, nullptr, _IOLBF, 0);
+        o.kind = log_output::LOGFILE;
+        return o;
+    }();
+    return out;
+}
+
+const char *level_name(int level)
+{
+    switch(level) {
+    case RTAPI_MSG_ERR: return "ERR";
+    case RTAPI_MSG_WARN: return "WARN";
+    case RTAPI_MSG_INFO: return "INFO";
+    case RTAPI_MSG_DBG: return "DBG";
+    default: return "ALL";
+    }
+}
+
+int syslog_priority(int level)
+{
+    switch(level) {
+    case RTAPI_MSG_ERR: return LOG_ERR;
+    case RTAPI_MSG_WARN: return LOG_WARNING;
+    case RTAPI_MSG_INFO: return LOG_INFO;
+    case RTAPI_MSG_DBG: return LOG_DEBUG;
+    default: return LOG_NOTICE;
+    }
+}
+
+struct pending_message {
+    struct timespec ts;
+    int level;
+    std::string text;
+};
+
+void report_suppressed(log_ring &ring, long long now, bool flush,
+        std::vector<pending_message> &out)
+{
+    for(rate_slot &s : ring.rate) {
+        if(!s.suppressed.load(std::memory_order_acquire)) continue;
+        long long start = s.window_start.load(std::memory_order_relaxed);
+        if(!flush && now - start < RTAPI_LOG_WINDOW) continue;
+        const char *fmt = s.fmt.load(std::memory_order_relaxed);
+        unsigned n = s.suppressed.exchange(0, std::memory_order_acq_rel);
+        if(!n) continue;
+        std::string first(fmt, strcspn(fmt, "\n"));
+        pending_message m;
+        m.ts.tv_sec = now / 1000000000LL;
+        m.ts.tv_nsec = now % 1000000000LL;
+        m.level = RTAPI_MSG_WARN;
+        m.text = "rtapi: " + std::to_string(n) +
+            " similar messages suppressed: \"" + first + "\"\n";
+        out.push_back(std::move(m));
+    }
+}
+}
+
+bool rtapi_log_record(int level, const char *fmt, va_list ap)
+{
+    if(thread_ring == -1) {
+        unsigned idx = rings_used.fetch_add(1);
+        thread_ring = idx < RTAPI_LOG_RINGS ? (int)idx : -2;
+    }
+    if(thread_ring < 0) return false;
+
+    log_ring &ring = rings[thread_ring];
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if(!rate_check(ring, fmt, to_ns(ts))) return true;
+
+    unsigned head = ring.head.load(std::memory_order_relaxed);
+    unsigned tail = ring.tail.load(std::memory_order_acquire);
+    if(head - tail >= RTAPI_LOG_RECORDS) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    log_record &r = ring.records[head & (RTAPI_LOG_RECORDS - 1)];
+    r.ts = ts;
+    r.level = level;
+    r.fmt = fmt;
+    va_list aq;
+    va_copy(aq, ap);
+    if(!capture_args(r, fmt, aq)) {
+        r.fmt = nullptr;
+        r.nargs = 0;
+        vsnprintf(r.strings, sizeof(r.strings), fmt, ap);
+    }
+    va_end(aq);
+    ring.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void rtapi_log_write(int level, const struct timespec &ts, const char *msg)
+{
+    std::lock_guard<std::mutex> lock(output_mutex);
+    log_output &o = output();
+    switch(o.kind) {
+    case log_output::STDIO:
+        fputs(msg, level == RTAPI_MSG_ALL ? stdout : stderr);
+        break;
+    case log_output::SYSLOG: {
+        size_t len = strlen(msg);
+        while(len && msg[len-1] == '\n') len--;
+        if(len) syslog(syslog_priority(level), "%.*s", (int)len, msg);
+        break;
+    }
+    case log_output::LOGFILE:
+        /* Each line gets the time of the message that started it */
+        for(const char *p = msg; *p; ) {
+            if(o.line_start) {
+                struct tm tm;
+                char stamp[32];
+                localtime_r(&ts.tv_sec, &tm);
+                strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+                fprintf(o.f, "%s.%06ld %-4s ", stamp, ts.tv_nsec / 1000,
+                    level_name(level));
+            }
+            const char *nl = strchr(p, '\n');
+            size_t len = nl ? nl - p + 1 : strlen(p);
+            fwrite(p, 1, len, o.f);
+            o.line_start = nl != nullptr;
+            p += len;
+        }
+        break;
+    }
+}
+
+void rtapi_log_drain(bool flush)
+{
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    struct timespec now_ts;
+    clock_gettime(CLOCK_REALTIME, &now_ts);
+    long long now = to_ns(now_ts);
+
+    std::vector<pending_message> messages;
+    unsigned nrings = std::min(rings_used.load(), RTAPI_LOG_RINGS);
+    for(unsigned i = 0; i < nrings; i++) {
+        log_ring &ring = rings[i];
+        unsigned tail = ring.tail.load(std::memory_order_relaxed);
+        unsigned head = ring.head.load(std::memory_order_acquire);
+        for(; tail != head; tail++) {
+            const log_record &r = ring.records[tail & (RTAPI_LOG_RECORDS - 1)];
+            messages.push_back({r.ts, r.level, format_record(r)});
+        }
+        ring.tail.store(tail, std::memory_order_release);
+
+        unsigned dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+        if(dropped) {
+            messages.push_back({now_ts, RTAPI_MSG_ERR,
+                "rtapi: " + std::to_string(dropped) +
+                " messages lost, log ring full\n"});
+        }
+        report_suppressed(ring, now, flush, messages);
+    }
+
+    std::stable_sort(messages.begin(), messages.end(),
+        [](const pending_message &a, const pending_message &b) {
+            return rtapi_timespec_less(a.ts, b.ts);
+        });
+    for(const pending_message &m : messages)
+        rtapi_log_write(m.level, m.ts, m.text.c_str());
+}
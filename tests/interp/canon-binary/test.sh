@@ -0,0 +1,16 @@
+#!/bin/bash
+# compile the program, then replay the compiled stream through canterp;
+# checkresult compares the replay with the canon calls of the program
+set -e
+rm -f prog.ncb probe.ncb
+rs274 -g prog.ngc | awk '{$1=$2=""; print}' > direct
+rs274 -g -c prog.ncb prog.ngc
+
+# probing depends on the machine, so it must not compile
+if rs274 -g -c probe.ncb probe.ngc 2>/dev/null || [ -e probe.ncb ]; then
+    echo "probe.ngc compiled" 1>&2
+    exit 1
+fi
+
+rs274 -p ../../../lib/libcanterp.so -g prog.ncb | awk '{$1=$2=""; print}'
+exit ${PIPESTATUS[0]}
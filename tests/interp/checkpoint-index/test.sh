@@ -0,0 +1,37 @@
+#!/bin/bash
+# scan a long program in one process and in four; the indexes must be
+# the same byte for byte
+set -e
+rm -f prog.ngc prog.ngc.ckpt serial.ckpt probe.ngc.ckpt
+
+# 30000 lines in three operations, each setting its own modes, with
+# state carried from one to the next (G91, #100, the feed)
+{
+    echo "G21 G90 G17 G54"
+    echo "#100 = 0"
+    for op in 1 2 3; do
+        echo "T$op M6"
+        echo "G0 Z5"
+        [ $op = 2 ] && echo "G91"
+        echo "F[100 * $op + #100]"
+        for i in $(seq 1 10000); do
+            echo "G1 X[$i MOD 17] Y[$i MOD 13]"
+        done
+        echo "G90"
+        echo "#100 = [#100 + $op]"
+    done
+    echo "M2"
+} > prog.ngc
+
+rs274 -g -x 1 prog.ngc > /dev/null
+mv prog.ngc.ckpt serial.ckpt
+rs274 -g -x 4 prog.ngc > /dev/null
+cmp serial.ckpt prog.ngc.ckpt
+
+# probing depends on the machine, so there is no index for it
+if rs274 -g -x 1 probe.ngc 2>/dev/null || [ -e probe.ngc.ckpt ]; then
+    echo "probe.ngc was scanned" 1>&2
+    exit 1
+fi
+rm -f prog.ngc serial.ckpt prog.ngc.ckpt
+echo "same index"
@@ -0,0 +1,3 @@
+#!/bin/bash
+rs274 -t test.tbl -j 2 a.ngc b.ngc 2>/dev/null | sort
+exit ${PIPESTATUS[0]}
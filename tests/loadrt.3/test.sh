@@ -0,0 +1,3 @@
+#!/bin/sh
+
+halrun -b loadrt.hal
@@ -0,0 +1,80 @@
+#!/usr/bin/env python
+# Minimal Modbus/TCP slave for the mb2hal test.
+#
+# usage: modbus_sim.py LOGFILE PORTFILE
+#
+# Listens on a free localhost port and writes its number to PORTFILE.
+# Holding register n reads 100+n, input register n reads 2000+n, and
+# discrete input n is set when n is a multiple of 3.  Every request is
+# logged to LOGFILE as "fnct addr count batch", where batch is how many
+# requests were waiting in the socket when this one was read.
+
+import socket
+import struct
+import sys
+
+log = open(sys.argv[1], "w")
+srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+srv.bind(("127.0.0.1", 0))
+srv.listen(1)
+f = open(sys.argv[2], "w")
+f.write("%d\n" % srv.getsockname()[1])
+f.close()
+
+holding = {}
+
+def handle(fnct, pdu):
+    if fnct in (2, 3, 4):
+        addr, count = struct.unpack(">HH", pdu[:4])
+        if fnct == 2:
+            data = bytearray((count + 7) // 8)
+            for i in range(count):
+                if (addr + i) % 3 == 0:
+                    data[i // 8] |= 1 << (i % 8)
+        elif fnct == 3:
+            data = bytearray(struct.pack(">%dH" % count,
+                *[holding.get(addr + i, 100 + addr + i) for i in range(count)]))
+        else:
+            data = bytearray(struct.pack(">%dH" % count,
+                *[2000 + addr + i for i in range(count)]))
+        return addr, count, bytearray([fnct, len(data)]) + data
+    if fnct == 6:
+        addr, value = struct.unpack(">HH", pdu[:4])
+        holding[addr] = value
+        return addr, value, bytearray([fnct]) + pdu[:4]
+    if fnct in (15, 16):
+        addr, count = struct.unpack(">HH", pdu[:4])
+        if fnct == 16:
+            for i in range(count):
+                holding[addr + i] = struct.unpack(">H", bytes(pdu[5 + 2 * i:7 + 2 * i]))[0]
+        return addr, count, bytearray([fnct]) + pdu[:4]
+    return 0, 0, bytearray([fnct | 0x80, 1])
+
+while True:
+    conn, peer = srv.accept()
+    buf = bytearray()
+    while True:
+        try:
+            chunk = conn.recv(4096)
+        except socket.error:
+            break
+        if not chunk:
+            break
+        buf += bytearray(chunk)
+        frames = []
+        while len(buf) >= 7:
+            tid, proto, length, unit = struct.unpack(">HHHB", bytes(buf[:7]))
+            if len(buf) < 6 + length:
+                break
+            frames.append((tid, unit, buf[7:6 + length]))
+            buf = buf[6 + length:]
+        reply = bytearray()
+        for tid, unit, pdu in frames:
+            fnct = pdu[0]
+            addr, count, rsp = handle(fnct, pdu[1:])
+            log.write("%02d %d %d %d\n" % (fnct, addr, count, len(frames)))
+            reply += bytearray(struct.pack(">HHHB", tid, 0, len(rsp) + 1, unit)) + rsp
+        log.flush()
+        conn.sendall(bytes(reply))
+    conn.close()
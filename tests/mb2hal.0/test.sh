@@ -0,0 +1,23 @@
+#!/bin/bash
+# Run mb2hal against a local Modbus/TCP simulator for two seconds, then
+# print its pins and a count of the requests the simulator received.
+rm -f requests.log port mb2hal.ini
+python modbus_sim.py requests.log port &
+SIM=$!
+for i in $(seq 50); do
+    test -s port && break
+    sleep 0.1
+done
+sed "s/@PORT@/$(cat port)/" mb2hal.ini.in > mb2hal.ini
+
+realtime start
+halcmd loadusr -W mb2hal config=mb2hal.ini
+halcmd setp mb2hal.write_a.00 1234
+sleep 2
+halcmd -s show pin mb2hal | awk '{print $5, $4}'
+halcmd unload all
+realtime stop
+kill $SIM
+
+echo "requests"
+sort requests.log | uniq -c
@@ -0,0 +1,489 @@
+/* Check the all-channel step generator and encoder cores against the
+   per-channel code they replaced, on random input.
+
+   Run with --bench to instead print the base thread cost per channel of
+   both versions. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "greatest.h"
+#include "rtapi.h"
+#include "stepgen_batch.h"
+#include "encoder_batch.h"
+
+GREATEST_MAIN_DEFS();
+
+#define PICKOFF STEPGEN_PICKOFF
+#define NCHAN STEPGEN_BATCH_MAX_CHAN
+#define NENC ENCODER_BATCH_MAX_CHAN
+
+static const unsigned char quad_lut[4] = {1, 3, 2, 0};
+
+typedef void (*make_pulses_t)(stepgen_batch_t *b, int num_chan, long periodns);
+
+static void make_pulses_scalar(stepgen_batch_t *b, int num_chan, long periodns)
+{
+    stepgen_batch_make_pulses_scalar(b, num_chan, periodns);
+}
+
+/* The make_pulses() inner loop as it was before the batch version, with
+   the phase pins replaced by outbits. */
+
+typedef struct {
+    unsigned int timer1, timer2, timer3;
+    int hold_dds;
+    long addval;
+    long long accum;
+    int curr_dir;
+    int state;
+    int enable;
+    long target_addval;
+    long deltalim;
+    unsigned int step_len, dir_hold_dly, dir_setup;
+    int step_type;
+    int cycle_max;
+    const unsigned char *lut;
+    unsigned char outbits;
+} ref_stepgen_t;
+
+static void ref_make_pulses(ref_stepgen_t *stepgen, int num_chan, long periodns)
+{
+    long old_addval, target_addval, new_addval, step_now;
+    int n;
+
+    for (n = 0; n < num_chan; n++, stepgen++) {
+	if ( stepgen->timer1 > 0 ) {
+	    if ( stepgen->timer1 > periodns ) {
+		stepgen->timer1 -= periodns;
+	    } else {
+		stepgen->timer1 = 0;
+	    }
+	}
+	if ( stepgen->timer2 > 0 ) {
+	    if ( stepgen->timer2 > periodns ) {
+		stepgen->timer2 -= periodns;
+	    } else {
+		stepgen->timer2 = 0;
+	    }
+	}
+	if ( stepgen->timer3 > 0 ) {
+	    if ( stepgen->timer3 > periodns ) {
+		stepgen->timer3 -= periodns;
+	    } else {
+		stepgen->timer3 = 0;
+		stepgen->hold_dds = 0;
+	    }
+	}
+	if ( !stepgen->hold_dds && stepgen->enable ) {
+	    old_addval = stepgen->addval;
+	    target_addval = stepgen->target_addval;
+	    if (stepgen->deltalim != 0) {
+		if (target_addval > (old_addval + stepgen->deltalim)) {
+		    new_addval = old_addval + stepgen->deltalim;
+		} else if (target_addval < (old_addval - stepgen->deltalim)) {
+		    new_addval = old_addval - stepgen->deltalim;
+		} else {
+		    new_addval = target_addval;
+		}
+	    } else {
+		new_addval = target_addval;
+	    }
+	    stepgen->addval = new_addval;
+	    if (((new_addval >= 0) && (old_addval < 0)) ||
+		((new_addval < 0) && (old_addval >= 0))) {
+		if ( stepgen->timer3 != 0 ) {
+		    stepgen->hold_dds = 1;
+		}
+	    }
+	}
+	if ( !stepgen->hold_dds && stepgen->enable ) {
+	    step_now = stepgen->accum;
+	    stepgen->accum += stepgen->addval;
+	    step_now ^= stepgen->accum;
+	    step_now &= (1L << PICKOFF);
+	} else {
+	    step_now = 0;
+	}
+	if ( stepgen->timer2 == 0 ) {
+	    if ( stepgen->addval > 0 ) {
+		stepgen->curr_dir = 1;
+	    } else if ( stepgen->addval < 0 ) {
+		stepgen->curr_dir = -1;
+	    }
+	}
+	if ( step_now ) {
+	    stepgen->timer1 = stepgen->step_len;
+	    stepgen->timer2 = stepgen->timer1 + stepgen->dir_hold_dly;
+	    stepgen->timer3 = stepgen->timer2 + stepgen->dir_setup;
+	    if ( stepgen->step_type >= 2 ) {
+		stepgen->state += stepgen->curr_dir;
+		if ( stepgen->state < 0 ) {
+		    stepgen->state = stepgen->cycle_max;
+		} else if ( stepgen->state > stepgen->cycle_max ) {
+		    stepgen->state = 0;
+		}
+	    }
+	}
+	if (stepgen->step_type == 0) {
+	    stepgen->outbits = (stepgen->timer1 != 0) | (stepgen->curr_dir < 0) << 1;
+	} else if (stepgen->step_type == 1) {
+	    if ( stepgen->timer1 != 0 ) {
+		stepgen->outbits = stepgen->curr_dir < 0 ? 2 : 1;
+	    } else {
+		stepgen->outbits = 0;
+	    }
+	} else {
+	    stepgen->outbits = (stepgen->lut)[stepgen->state];
+	}
+    }
+}
+
+/* The update() inner loop as it was, with the capture buffer replaced by
+   event flags. */
+
+static const unsigned char lut_x4[16] = {
+    0x00, 0x44, 0x88, 0x0C, 0x80, 0x04, 0x08, 0x4C,
+    0x40, 0x04, 0x08, 0x8C, 0x00, 0x84, 0x48, 0x0C
+};
+static const unsigned char lut_x1[16] = {
+    0x00, 0x44, 0x08, 0x0C, 0x80, 0x04, 0x08, 0x0C,
+    0x00, 0x04, 0x08, 0x0C, 0x00, 0x04, 0x08, 0x0C
+};
+static const unsigned char lut_ctr[16] = {
+   0x00, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+   0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+typedef struct {
+    unsigned char state, oldZ, Zmask, old_latch;
+    int phaseA, phaseB, phaseZ, latch_in;
+    int x4_mode, counter_mode, latch_rising, latch_falling;
+    rtapi_s32 raw_counts;
+    unsigned char events;
+} ref_counter_t;
+
+static void ref_update(ref_counter_t *cntr, int num_chan)
+{
+    int n;
+    unsigned char state;
+    int latch, old_latch, rising, falling;
+
+    for (n = 0; n < num_chan; n++, cntr++) {
+	cntr->events = 0;
+	state = cntr->state;
+	if (cntr->phaseA) {
+	    state |= SM_PHASE_A_MASK;
+	}
+	if (cntr->phaseB) {
+	    state |= SM_PHASE_B_MASK;
+	}
+	if ( cntr->counter_mode ) {
+	    state = lut_ctr[state & (SM_LOOKUP_MASK & ~SM_PHASE_B_MASK)];
+	} else if ( cntr->x4_mode ) {
+	    state = lut_x4[state & SM_LOOKUP_MASK];
+	} else {
+	    state = lut_x1[state & SM_LOOKUP_MASK];
+	}
+	if (state & SM_CNT_UP_MASK) {
+	    cntr->raw_counts++;
+	    cntr->events |= ENC_EV_COUNT;
+	} else if (state & SM_CNT_DN_MASK) {
+	    cntr->raw_counts--;
+	    cntr->events |= ENC_EV_COUNT;
+	}
+	cntr->state = state;
+	state = cntr->oldZ << 1;
+	if (cntr->phaseZ) {
+	    state |= 1;
+	}
+	cntr->oldZ = state & 3;
+	if ((state & cntr->Zmask) == 1) {
+	    cntr->events |= ENC_EV_INDEX;
+	    cntr->Zmask = 0;
+	}
+	latch = cntr->latch_in, old_latch = cntr->old_latch;
+	rising = latch && !old_latch;
+	falling = !latch && old_latch;
+	if ((rising && cntr->latch_rising)
+		|| (falling && cntr->latch_falling)) {
+	    cntr->events |= ENC_EV_LATCH;
+	}
+	cntr->old_latch = latch;
+    }
+}
+
+/* set up channel n of both step generators with the given step type */
+static void stepgen_init(ref_stepgen_t *r, stepgen_batch_t *b, int n, int type)
+{
+    memset(&r[n], 0, sizeof(r[n]));
+    r[n].accum = 1 << (PICKOFF-1);
+    r[n].step_type = type;
+    b->timer1[n] = b->timer2[n] = b->timer3[n] = 0;
+    b->hold_dds[n] = b->addval[n] = b->curr_dir[n] = b->state[n] = 0;
+    b->accum[n] = r[n].accum;
+    b->use_state[n] = type >= 2;
+    if (type == 0) {
+	b->lut[n] = stepgen_lut_step_dir;
+    } else if (type == 1) {
+	b->lut[n] = stepgen_lut_up_down;
+    } else {
+	r[n].lut = b->lut[n] = quad_lut;
+	r[n].cycle_max = 3;
+    }
+    b->cycle_max[n] = r[n].cycle_max;
+}
+
+/* random new commands for channel n, now and then */
+static void stepgen_stimulus(ref_stepgen_t *r, stepgen_batch_t *b, int n,
+    long period)
+{
+    if (rand() % 500 == 0) {
+	r[n].enable = rand() % 8 != 0;
+    }
+    if (rand() % 50 == 0) {
+	r[n].target_addval = (rand() % 2000001 - 1000000) * 64L;
+    }
+    if (rand() % 2000 == 0) {
+	r[n].deltalim = rand() % 3 ? rand() % 4000 : 0;
+	r[n].step_len = period * (1 + rand() % 3);
+	r[n].dir_hold_dly = period * (rand() % 4);
+	r[n].dir_setup = period * (rand() % 4);
+    }
+    b->enable[n] = r[n].enable;
+    b->target_addval[n] = r[n].target_addval;
+    b->deltalim[n] = r[n].deltalim;
+    b->step_len[n] = r[n].step_len;
+    b->dir_hold_dly[n] = r[n].dir_hold_dly;
+    b->dir_setup[n] = r[n].dir_setup;
+}
+
+/* 13 channels, so the vector version has a partly used last vector */
+#define TEST_CHAN 13
+
+TEST stepgen_matches_reference(make_pulses_t make_pulses)
+{
+    static ref_stepgen_t ref[NCHAN];
+    static stepgen_batch_t b;
+    long period = 25000;
+    int n, i, steps = 0;
+
+    srand(1);
+    for (n = 0; n < TEST_CHAN; n++) {
+	stepgen_init(ref, &b, n, n % 3);
+    }
+    for (i = 0; i < 200000; i++) {
+	for (n = 0; n < TEST_CHAN; n++) {
+	    stepgen_stimulus(ref, &b, n, period);
+	}
+	ref_make_pulses(ref, TEST_CHAN, period);
+	make_pulses(&b, TEST_CHAN, period);
+	for (n = 0; n < TEST_CHAN; n++) {
+	    ASSERT_EQ_FMT(ref[n].accum, (long long)b.accum[n], "%lld");
+	    ASSERT_EQ_FMT(ref[n].addval, (long)b.addval[n], "%ld");
+	    ASSERT_EQ_FMT((long long)ref[n].timer1, (long long)b.timer1[n], "%lld");
+	    ASSERT_EQ_FMT((long long)ref[n].timer3, (long long)b.timer3[n], "%lld");
+	    ASSERT_EQ_FMT(ref[n].hold_dds, (int)b.hold_dds[n], "%d");
+	    ASSERT_EQ_FMT(ref[n].curr_dir, (int)b.curr_dir[n], "%d");
+	    ASSERT_EQ_FMT(ref[n].state, (int)b.state[n], "%d");
+	    ASSERT_EQ_FMT(ref[n].outbits, b.outbits[n], "%d");
+	    steps += (ref[n].outbits & 1) && ref[n].timer1 == ref[n].step_len;
+	}
+    }
+    /* make sure the stimulus actually exercised the pulse generator */
+    ASSERT(steps > 10000);
+    PASS();
+}
+
+TEST encoder_matches_reference(void)
+{
+    static ref_counter_t ref[NENC];
+    static encoder_batch_t b;
+    int n, i, counts = 0;
+
+    srand(2);
+    memset(ref, 0, sizeof(ref));
+    memset(&b, 0, sizeof(b));
+    for (i = 0; i < 200000; i++) {
+	for (n = 0; n < NENC; n++) {
+	    ref_counter_t *r = &ref[n];
+	    /* a quadrature signal of varying speed with occasional glitches */
+	    int phase = (i * (n + 1) / 7) & 3;
+	    r->phaseA = (phase == 1 || phase == 2) ^ (rand() % 100 == 0);
+	    r->phaseB = phase >= 2;
+	    r->phaseZ = rand() % 40 == 0;
+	    r->latch_in = rand() % 30 == 0 ? !r->latch_in : r->latch_in;
+	    if (rand() % 1000 == 0) {
+		r->x4_mode = rand() & 1;
+		r->counter_mode = rand() % 4 == 0;
+		r->latch_rising = rand() & 1;
+		r->latch_falling = rand() & 1;
+	    }
+	    if (rand() % 100 == 0) {
+		/* capture() setting index-enable */
+		r->Zmask = b.Zmask[n] = 3;
+	    }
+	    b.in[n] = (r->phaseA ? ENC_IN_A : 0) | (r->phaseB ? ENC_IN_B : 0)
+		| (r->phaseZ ? ENC_IN_Z : 0) | (r->latch_in ? ENC_IN_LATCH : 0)
+		| (r->x4_mode ? ENC_IN_X4 : 0)
+		| (r->counter_mode ? ENC_IN_CTR : 0)
+		| (r->latch_rising ? ENC_IN_RISING : 0)
+		| (r->latch_falling ? ENC_IN_FALLING : 0);
+	}
+	ref_update(ref, NENC);
+	encoder_batch_update(&b, NENC);
+	for (n = 0; n < NENC; n++) {
+	    ASSERT_EQ_FMT(ref[n].raw_counts, b.raw_counts[n], "%d");
+	    ASSERT_EQ_FMT(ref[n].state, b.state[n], "%d");
+	    ASSERT_EQ_FMT(ref[n].Zmask, b.Zmask[n], "%d");
+	    ASSERT_EQ_FMT(ref[n].events, b.events[n], "%d");
+	    counts += ref[n].events != 0;
+	}
+    }
+    ASSERT(counts > 100000);
+    PASS();
+}
+
+SUITE(stepgen_encoder) {
+    RUN_TEST1(stepgen_matches_reference, make_pulses_scalar);
+#ifdef STEPGEN_BATCH_HAVE_AVX2
+    if (stepgen_batch_have_avx2()) {
+	RUN_TEST1(stepgen_matches_reference, stepgen_batch_make_pulses_avx2);
+    } else {
+	printf("no AVX2, vector stepgen not tested\n");
+    }
+#endif
+    RUN_TEST(encoder_matches_reference);
+}
+
+/* Benchmark */
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#define BENCH_PERIODS 1000000
+#define BENCH_RUNS 5
+
+/* Commands for the benchmark: each channel gets a new random velocity,
+   sometimes reversing, every 1000 periods, so the step pattern is
+   irregular. */
+static long bench_target[BENCH_PERIODS / 1000][NCHAN];
+
+static void bench_stepgen(const char *name, make_pulses_t make_pulses,
+    long period)
+{
+    static ref_stepgen_t ref[NCHAN];
+    static stepgen_batch_t b;
+    double t0, best = 1e9;
+    int n, i, run;
+
+    for (run = 0; run < BENCH_RUNS; run++) {
+	for (n = 0; n < NCHAN; n++) {
+	    stepgen_init(ref, &b, n, n % 3);
+	    ref[n].enable = b.enable[n] = 1;
+	    ref[n].deltalim = b.deltalim[n] = 2000;
+	    ref[n].step_len = b.step_len[n] = period;
+	    ref[n].dir_hold_dly = b.dir_hold_dly[n] = period;
+	    ref[n].dir_setup = b.dir_setup[n] = period;
+	}
+	t0 = now();
+	for (i = 0; i < BENCH_PERIODS; i++) {
+	    if (i % 1000 == 0) {
+		for (n = 0; n < NCHAN; n++) {
+		    ref[n].target_addval = b.target_addval[n]
+			= bench_target[i / 1000][n];
+		}
+	    }
+	    if (make_pulses) {
+		make_pulses(&b, NCHAN, period);
+	    } else {
+		ref_make_pulses(ref, NCHAN, period);
+	    }
+	}
+	t0 = now() - t0;
+	best = t0 < best ? t0 : best;
+    }
+    printf("stepgen, %d channels, %s: %.2f ns per channel per period\n",
+	NCHAN, name,
+	best * 1e9 / BENCH_PERIODS / NCHAN);
+}
+
+static void bench_encoder(int batch)
+{
+    static ref_counter_t rc[NENC];
+    static encoder_batch_t eb;
+    static unsigned char in[4096][NENC];
+    double t0, best = 1e9;
+    int n, i, run;
+
+    /* quadrature at a different rate on each channel, with jitter */
+    for (i = 0; i < 4096; i++) {
+	for (n = 0; n < NENC; n++) {
+	    int phase = (i * (n + 2) / 5 + (rand() % 8 == 0)) & 3;
+	    in[i][n] = ENC_IN_X4 | ENC_IN_RISING
+		| (phase == 1 || phase == 2 ? ENC_IN_A : 0)
+		| (phase >= 2 ? ENC_IN_B : 0);
+	}
+    }
+    for (run = 0; run < BENCH_RUNS; run++) {
+	memset(rc, 0, sizeof(rc));
+	memset(&eb, 0, sizeof(eb));
+	t0 = now();
+	for (i = 0; i < BENCH_PERIODS; i++) {
+	    const unsigned char *p = in[i & 4095];
+	    if (batch) {
+		memcpy(eb.in, p, NENC);
+		encoder_batch_update(&eb, NENC);
+	    } else {
+		for (n = 0; n < NENC; n++) {
+		    rc[n].phaseA = p[n] & ENC_IN_A;
+		    rc[n].phaseB = p[n] & ENC_IN_B;
+		    rc[n].x4_mode = 1;
+		    rc[n].latch_rising = 1;
+		}
+		ref_update(rc, NENC);
+	    }
+	}
+	t0 = now() - t0;
+	best = t0 < best ? t0 : best;
+    }
+    printf("encoder, %d channels, %s: %.2f ns per channel per period\n",
+	NENC, batch ? "batch" : "before",
+	best * 1e9 / BENCH_PERIODS / NENC);
+}
+
+static void bench(void)
+{
+    int i, n;
+
+    srand(3);
+    for (i = 0; i < BENCH_PERIODS / 1000; i++) {
+	for (n = 0; n < NCHAN; n++) {
+	    bench_target[i][n] = (rand() % 2000001 - 1000000) * 64L;
+	}
+    }
+    bench_stepgen("before", 0, 25000);
+    bench_stepgen("arrays", make_pulses_scalar, 25000);
+#ifdef STEPGEN_BATCH_HAVE_AVX2
+    if (stepgen_batch_have_avx2()) {
+	bench_stepgen("avx2", stepgen_batch_make_pulses_avx2, 25000);
+    }
+#endif
+    bench_encoder(0);
+    bench_encoder(1);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+	bench();
+	return 0;
+    }
+    GREATEST_MAIN_BEGIN();
+    RUN_SUITE(stepgen_encoder);
+    GREATEST_MAIN_END();
+}
@@ -0,0 +1,80 @@
+#include "tp_debug.h"
+#include "greatest.h"
+#include "tc.h"
+#include "tp_types.h"
+#include "math.h"
+#include "rtapi.h"
+
+/* Expand to all the definitions that need to be in
+   the test runner's main file. */
+GREATEST_MAIN_DEFS();
+
+// KLUDGE fix link error the ugly way
+void rtapi_print_msg(msg_level_t level, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    printf(fmt, args);
+    va_end(args);
+}
+
+static void setupLine(TC_STRUCT *tc, double x, double a, double feed_limit)
+{
+    EmcPose start = {{0,0,0},0,0,0,0,0,0};
+    EmcPose end = {{x,0,0},a,0,0,0,0,0};
+
+    memset(tc, 0, sizeof(*tc));
+    tc->motion_type = TC_LINEAR;
+    pmLine9Init(&tc->coords.line, &start, &end);
+    tc->maxvel = 100.0;
+    tc->feed_limit = feed_limit;
+}
+
+TEST tcClampVelocityByFeedLimit_limits() {
+    TC_STRUCT tc;
+
+    setupLine(&tc, 10.0, 0.0, 20.0);
+    ASSERT_EQ(TP_ERR_OK, tcClampVelocityByFeedLimit(&tc));
+    ASSERT_IN_RANGE(20.0, tc.maxvel, 1e-12);
+
+    // A limit above the machine limit changes nothing
+    setupLine(&tc, 10.0, 0.0, 200.0);
+    tcClampVelocityByFeedLimit(&tc);
+    ASSERT_IN_RANGE(100.0, tc.maxvel, 1e-12);
+
+    // 0 is no limit
+    setupLine(&tc, 10.0, 0.0, 0.0);
+    tcClampVelocityByFeedLimit(&tc);
+    ASSERT_IN_RANGE(100.0, tc.maxvel, 1e-12);
+
+    PASS();
+}
+
+TEST tcClampVelocityByFeedLimit_exempt() {
+    TC_STRUCT tc;
+
+    // The limit is cartesian, so it does not apply to pure rotary moves
+    setupLine(&tc, 0.0, 90.0, 20.0);
+    tcClampVelocityByFeedLimit(&tc);
+    ASSERT_IN_RANGE(100.0, tc.maxvel, 1e-12);
+
+    // Position-synced moves have to follow the spindle
+    setupLine(&tc, 10.0, 0.0, 20.0);
+    tc.synchronized = TC_SYNC_POSITION;
+    tcClampVelocityByFeedLimit(&tc);
+    ASSERT_IN_RANGE(100.0, tc.maxvel, 1e-12);
+
+    PASS();
+}
+
+ SUITE(tc_feed_limit) {
+     RUN_TEST(tcClampVelocityByFeedLimit_limits);
+     RUN_TEST(tcClampVelocityByFeedLimit_exempt);
+ }
+
+int main(int argc, char **argv) {
+    GREATEST_MAIN_BEGIN();      /* command-line arguments, initialization. */
+    RUN_SUITE(tc_feed_limit);   /* run a suite */
+    GREATEST_MAIN_END();        /* display results */
+ }